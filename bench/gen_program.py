@@ -0,0 +1,300 @@
+#!/usr/bin/env python3
+"""
+Synthetic program generator for keccc front-end throughput benchmarks.
+
+The generated programs only use the dialect keccc accepts today:
+int/char* globals, int arrays, parameterless int functions that take one
+(ignored) call argument, if/else, for loops, assignments and calls to the
+runtime print routines. Expressions are shaped so that they never need more
+than the four scratch registers of the NASM backend.
+"""
+from __future__ import annotations
+
+import argparse
+import random
+import sys
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Optional, Sequence, TextIO
+
+# keccc has a fixed-size symbol table (NSYMBOLS in src/defs.h). Globals,
+# functions and locals all share it, and the runtime functions take 3 slots.
+SYMBOL_TABLE_SIZE = 1024
+RUNTIME_SYMBOLS = 3
+
+# Number of functions that never call other functions. Only these are valid
+# call targets, so the run time of a generated program stays linear in size.
+LEAF_FUNCTIONS = 8
+
+# Per-function locals: one loop counter per nesting level and one accumulator.
+LOOP_COUNTERS = 3
+LOCALS_PER_FUNCTION = LOOP_COUNTERS + 1
+
+ARRAY_LENGTH = 64
+
+WORDS = ["alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf",
+         "hotel", "india", "juliet", "kilo", "lima", "mike", "november"]
+
+
+@dataclass(frozen=True)
+class Knobs:
+    functions: int
+    statements: int
+    depth: int
+    symbols: int
+    strings: int
+    nesting: int
+    seed: int
+    size: Optional[int]  # target size in bytes, overrides statements
+
+
+def parse_size(text: str) -> int:
+    """
+    Parses a byte count with an optional K/M/G suffix (powers of 1024).
+    """
+    text = text.strip().upper().rstrip("B")
+    scale = 1
+    if text and text[-1] in "KMG":
+        scale = 1024 ** ("KMG".index(text[-1]) + 1)
+        text = text[:-1]
+    return int(float(text) * scale)
+
+
+class ProgramGenerator:
+    """
+    Emits one keccc translation unit according to the given knobs.
+    """
+
+    def __init__(self, knobs: Knobs, out: TextIO) -> None:
+        self.knobs = knobs
+        self.out = out
+        self.rng = random.Random(knobs.seed)
+        self.bytes_written = 0
+
+        self.int_globals = [f"g{i}" for i in range(max(1, knobs.symbols - knobs.symbols // 8))]
+        self.arrays = [f"a{i}" for i in range(max(1, knobs.symbols // 8))]
+        self.string_globals = [f"s{i}" for i in range(knobs.strings)]
+
+    # ------------------------------------------------------------------
+    # Output helpers
+
+    def emit(self, text: str) -> None:
+        self.out.write(text)
+        self.bytes_written += len(text)
+
+    # ------------------------------------------------------------------
+    # Expressions
+
+    def leaf(self, locals_: Sequence[str]) -> str:
+        """
+        A single register-sized operand: a variable or an integer literal.
+        """
+        choice = self.rng.random()
+        if choice < 0.45:
+            return self.rng.choice(self.int_globals)
+        if choice < 0.75:
+            return self.rng.choice(locals_)
+        return str(self.rng.randint(0, 1000))
+
+    def expression(self, locals_: Sequence[str], depth: int) -> str:
+        """
+        A left-deep chain of `depth` operators. Operands on the right may be
+        a parenthesised pair, which peaks at four live registers.
+        """
+        if self.rng.random() < 0.2:
+            array = self.rng.choice(self.arrays)
+            parts = [f"{array}[{self.leaf(locals_)} & {ARRAY_LENGTH - 1}]"]
+        else:
+            parts = [self.leaf(locals_)]
+
+        for _ in range(depth):
+            op = self.rng.choice(["+", "-", "*", "+", "-"])
+            if self.rng.random() < 0.25:
+                inner = self.rng.choice(["&", "|", "^", "+", "-"])
+                operand = f"({self.leaf(locals_)} {inner} {self.leaf(locals_)})"
+            elif self.rng.random() < 0.1:
+                op = "/"
+                operand = str(self.rng.randint(1, 97))
+            else:
+                operand = self.leaf(locals_)
+            parts.append(f"{op} {operand}")
+        return " ".join(parts)
+
+    def condition(self, locals_: Sequence[str]) -> str:
+        comparison = self.rng.choice(["<", ">", "<=", ">=", "==", "!="])
+        return (f"{self.expression(locals_, max(0, self.knobs.depth // 2))} "
+                f"{comparison} {self.leaf(locals_)}")
+
+    # ------------------------------------------------------------------
+    # Statements
+
+    def statement(self, function: int, locals_: Sequence[str], level: int,
+                  indent: str) -> str:
+        depth = self.knobs.depth
+        choice = self.rng.random()
+
+        if level < self.knobs.nesting and choice < 0.08:
+            counter = f"f{function}_i{level}"
+            body = self.block(function, locals_, level + 1, indent, 2)
+            bound = self.rng.randint(2, 8)
+            return (f"{indent}for ({counter}= 0; {counter} < {bound}; "
+                    f"{counter}= {counter} + 1) {body}\n")
+
+        if level < self.knobs.nesting and choice < 0.18:
+            then_body = self.block(function, locals_, level + 1, indent, 2)
+            text = f"{indent}if ({self.condition(locals_)}) {then_body}"
+            if self.rng.random() < 0.5:
+                else_body = self.block(function, locals_, level + 1, indent, 2)
+                text += f" else {else_body}"
+            return text + "\n"
+
+        if choice < 0.28:
+            array = self.rng.choice(self.arrays)
+            return (f"{indent}{array}[{self.leaf(locals_)} & {ARRAY_LENGTH - 1}]= "
+                    f"{self.expression(locals_, depth)};\n")
+
+        if self.string_globals and choice < 0.33:
+            word = self.rng.choice(WORDS)
+            return (f"{indent}{self.rng.choice(self.string_globals)}= "
+                    f"\"{word} {self.rng.randint(0, 99999)}\\n\";\n")
+
+        if level == 0 and function >= LEAF_FUNCTIONS and choice < 0.38:
+            # Calls don't preserve scratch registers, so the call has to be
+            # the whole right-hand side.
+            callee = self.rng.randrange(LEAF_FUNCTIONS)
+            target = self.rng.choice(self.int_globals)
+            return (f"{indent}{target}= f{callee}("
+                    f"{self.expression(locals_, min(depth, 2))});\n")
+
+        target = self.rng.choice(self.int_globals + [f"f{function}_t"])
+        return f"{indent}{target}= {self.expression(locals_, depth)};\n"
+
+    def block(self, function: int, locals_: Sequence[str], level: int,
+              indent: str, count: int) -> str:
+        inner = indent + "  "
+        body = "".join(self.statement(function, locals_, level, inner)
+                       for _ in range(max(1, count)))
+        return "{\n" + body + indent + "}"
+
+    # ------------------------------------------------------------------
+    # Top level
+
+    def function(self, index: int, budget_bytes: Optional[int]) -> None:
+        counters = [f"f{index}_i{i}" for i in range(LOOP_COUNTERS)]
+        accumulator = f"f{index}_t"
+        locals_ = [accumulator] + counters
+
+        self.emit(f"int f{index}() {{\n")
+        for name in locals_:
+            self.emit(f"  int {name};\n")
+        for name in locals_:
+            self.emit(f"  {name}= 0;\n")
+
+        start = self.bytes_written
+        emitted = 0
+        while True:
+            if budget_bytes is None:
+                if emitted >= self.knobs.statements:
+                    break
+            elif self.bytes_written - start >= budget_bytes:
+                break
+            self.emit(self.statement(index, locals_, 0, "  "))
+            emitted += 1
+
+        self.emit(f"  return({accumulator});\n}}\n\n")
+
+    def main_function(self) -> None:
+        self.emit("int main() {\n  int chk;\n  int ret;\n  chk= 0;\n")
+        for index in range(self.knobs.functions):
+            self.emit(f"  ret= f{index}({index});\n  chk= chk + ret;\n")
+        for name in self.int_globals:
+            self.emit(f"  chk= chk ^ {name};\n")
+        self.emit("  printint(chk);\n")
+        for name in self.string_globals:
+            self.emit(f"  printstring({name});\n")
+        self.emit("  return(0);\n}\n")
+
+    def generate(self) -> None:
+        knobs = self.knobs
+
+        # NOTE: keccc has no comment syntax, so the knobs are not recorded
+        # in the generated file itself.
+        for name in self.int_globals:
+            self.emit(f"int {name};\n")
+        for name in self.arrays:
+            self.emit(f"int {name}[{ARRAY_LENGTH}];\n")
+        for name in self.string_globals:
+            self.emit(f"char *{name};\n")
+        self.emit("\n")
+
+        budget = None
+        if knobs.size is not None:
+            budget = max(1, (knobs.size - self.bytes_written) // knobs.functions)
+
+        for index in range(knobs.functions):
+            self.function(index, budget)
+        self.main_function()
+
+
+def symbols_required(knobs: Knobs) -> int:
+    """
+    Number of symbol table slots the generated program will occupy.
+    """
+    return (RUNTIME_SYMBOLS + knobs.symbols + knobs.strings +
+            (knobs.functions + 1) * (LOCALS_PER_FUNCTION + 1) + 1)
+
+
+def generate_program(knobs: Knobs, path: Path) -> int:
+    """
+    Writes a generated program to `path` and returns its size in bytes.
+    """
+    with path.open("w", buffering=1 << 20) as out:
+        generator = ProgramGenerator(knobs, out)
+        generator.generate()
+        return generator.bytes_written
+
+
+def main(argv: Sequence[str]) -> int:
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--functions", type=int, default=64,
+                        help="number of functions besides main")
+    parser.add_argument("--statements", type=int, default=100,
+                        help="top-level statements per function")
+    parser.add_argument("--depth", type=int, default=4,
+                        help="binary operators per expression")
+    parser.add_argument("--symbols", type=int, default=256,
+                        help="number of global variables and arrays")
+    parser.add_argument("--strings", type=int, default=16,
+                        help="number of global string pointers")
+    parser.add_argument("--nesting", type=int, default=2,
+                        help=f"maximum if/for nesting (<= {LOOP_COUNTERS})")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--size", type=parse_size, default=None,
+                        help="target size (e.g. 1M); overrides --statements")
+    parser.add_argument("--output", "-o", required=True)
+    args = parser.parse_args(list(argv))
+
+    knobs = Knobs(
+        functions=max(1, args.functions),
+        statements=max(1, args.statements),
+        depth=max(0, args.depth),
+        symbols=max(1, args.symbols),
+        strings=max(0, args.strings),
+        nesting=min(max(0, args.nesting), LOOP_COUNTERS),
+        seed=args.seed,
+        size=args.size,
+    )
+
+    required = symbols_required(knobs)
+    if required > SYMBOL_TABLE_SIZE:
+        print(f"[FATAL] knobs need {required} symbol table slots, "
+              f"keccc only has {SYMBOL_TABLE_SIZE}")
+        return 1
+
+    size = generate_program(knobs, Path(args.output))
+    print(f"Generated {args.output}: {size} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main(sys.argv[1:]))
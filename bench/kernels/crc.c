@@ -0,0 +1,47 @@
+int data[4096];
+long poly;
+long mask;
+long crc;
+
+int fill() {
+  int i;
+  int seed;
+  seed= 1;
+  for (i= 0; i < 4096; i= i + 1) {
+    seed= seed * 1103515245 + 12345;
+    data[i]= (seed >> 16) & 255;
+  }
+  return(0);
+}
+
+int crc32() {
+  int i;
+  int bit;
+  crc= mask;
+  for (i= 0; i < 4096; i= i + 1) {
+    crc= crc ^ data[i];
+    for (bit= 0; bit < 8; bit= bit + 1) {
+      if (crc & 1) {
+        crc= (crc >> 1) ^ poly;
+      } else {
+        crc= crc >> 1;
+      }
+    }
+  }
+  crc= crc ^ mask;
+  return(0);
+}
+
+int main() {
+  int round;
+  poly= 60856;
+  poly= poly * 65536 + 33568;
+  mask= 65536;
+  mask= mask * 65536 - 1;
+  fill(0);
+  for (round= 0; round < 250; round= round + 1) {
+    crc32(round);
+  }
+  printint(crc);
+  return(0);
+}
@@ -0,0 +1,34 @@
+long result;
+int n;
+
+int fib() {
+  long a;
+  long b;
+  long t;
+  int i;
+  a= 0;
+  b= 1;
+  for (i= 0; i < n; i= i + 1) {
+    t= a + b;
+    a= b;
+    b= t;
+  }
+  result= a;
+  return(0);
+}
+
+int main() {
+  int round;
+  long sum;
+  sum= 0;
+  for (round= 0; round < 600000; round= round + 1) {
+    n= 40 + (round & 31);
+    fib(round);
+    sum= sum + (result & 1023);
+  }
+  printint(sum);
+  n= 90;
+  fib(0);
+  printint(result);
+  return(0);
+}
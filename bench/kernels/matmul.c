@@ -0,0 +1,51 @@
+int a[4096];
+int b[4096];
+int c[4096];
+
+int fill() {
+  int i;
+  for (i= 0; i < 4096; i= i + 1) {
+    a[i]= (i * 7 + 3) & 15;
+    b[i]= (i * 13 + 5) & 15;
+  }
+  return(0);
+}
+
+int multiply() {
+  int i;
+  int j;
+  int k;
+  int ik;
+  int kj;
+  int sum;
+  for (i= 0; i < 64; i= i + 1) {
+    for (j= 0; j < 64; j= j + 1) {
+      sum= 0;
+      for (k= 0; k < 64; k= k + 1) {
+        ik= i * 64 + k;
+        kj= k * 64 + j;
+        sum= sum + a[ik] * b[kj];
+      }
+      c[i * 64 + j]= sum;
+    }
+  }
+  return(0);
+}
+
+int main() {
+  int round;
+  int i;
+  long checksum;
+  fill(0);
+  for (round= 0; round < 40; round= round + 1) {
+    multiply(round);
+  }
+  checksum= 0;
+  for (i= 0; i < 4096; i= i + 1) {
+    checksum= checksum + c[i] * (i & 7);
+  }
+  printint(checksum);
+  printint(c[0]);
+  printint(c[4095]);
+  return(0);
+}
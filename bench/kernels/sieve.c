@@ -0,0 +1,35 @@
+char flags[100000];
+int count;
+
+int sieve() {
+  int i;
+  int j;
+  for (i= 0; i < 100000; i= i + 1) {
+    flags[i]= 1;
+  }
+  flags[0]= 0;
+  flags[1]= 0;
+  for (i= 2; i * i < 100000; i= i + 1) {
+    if (flags[i]) {
+      for (j= i * i; j < 100000; j= j + i) {
+        flags[j]= 0;
+      }
+    }
+  }
+  count= 0;
+  for (i= 0; i < 100000; i= i + 1) {
+    if (flags[i]) {
+      count= count + 1;
+    }
+  }
+  return(count);
+}
+
+int main() {
+  int round;
+  for (round= 0; round < 80; round= round + 1) {
+    sieve(round);
+  }
+  printint(count);
+  return(0);
+}
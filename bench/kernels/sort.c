@@ -0,0 +1,56 @@
+int keys[4000];
+
+int fill() {
+  int i;
+  int seed;
+  seed= 42;
+  for (i= 0; i < 4000; i= i + 1) {
+    seed= seed * 1103515245 + 12345;
+    keys[i]= (seed >> 16) & 32767;
+  }
+  return(0);
+}
+
+int sort() {
+  int i;
+  int j;
+  int key;
+  for (i= 1; i < 4000; i= i + 1) {
+    key= keys[i];
+    j= i - 1;
+    while (j >= 0) {
+      if (keys[j] <= key) {
+        j= -2 - j;
+      } else {
+        keys[j + 1]= keys[j];
+        j= j - 1;
+      }
+    }
+    if (j < -1) {
+      j= -2 - j;
+    }
+    keys[j + 1]= key;
+  }
+  return(0);
+}
+
+int main() {
+  int round;
+  int i;
+  int sorted;
+  for (round= 0; round < 5; round= round + 1) {
+    fill(round);
+    sort(round);
+  }
+  sorted= 1;
+  for (i= 1; i < 4000; i= i + 1) {
+    if (keys[i - 1] > keys[i]) {
+      sorted= 0;
+    }
+  }
+  printint(sorted);
+  printint(keys[0]);
+  printint(keys[2000]);
+  printint(keys[3999]);
+  return(0);
+}
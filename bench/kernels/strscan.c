@@ -0,0 +1,44 @@
+char *text;
+int spaces;
+int vowels;
+int words;
+
+int scan() {
+  char *p;
+  char c;
+  int inword;
+  inword= 0;
+  for (p= text; *p; p++) {
+    c= *p;
+    if (c == ' ') {
+      spaces= spaces + 1;
+      inword= 0;
+    } else {
+      if (inword == 0) {
+        words= words + 1;
+      }
+      inword= 1;
+    }
+    if (c == 'a') { vowels= vowels + 1; }
+    if (c == 'e') { vowels= vowels + 1; }
+    if (c == 'i') { vowels= vowels + 1; }
+    if (c == 'o') { vowels= vowels + 1; }
+    if (c == 'u') { vowels= vowels + 1; }
+  }
+  return(0);
+}
+
+int main() {
+  int round;
+  text= "the quick brown fox jumps over the lazy dog while a compiler emits code for every statement it sees and the benchmark counts words spaces and vowels in this sentence over and over again so that scanning dominates the run time of the program";
+  spaces= 0;
+  vowels= 0;
+  words= 0;
+  for (round= 0; round < 60000; round= round + 1) {
+    scan(round);
+  }
+  printint(spaces);
+  printint(vowels);
+  printint(words);
+  return(0);
+}
@@ -0,0 +1,409 @@
+#!/usr/bin/env python3
+"""
+Generated-code benchmark runner: compiles every kernel under bench/kernels/
+for the requested targets, checks its output, and measures
+
+  * compile_time: best keccc wall-clock time over a few compiles of a
+                  generated 1 MB program (see gen_program.py), reported as
+                  the "compile-1M" benchmark: the kernels themselves compile
+                  in about a millisecond, below process start-up noise;
+  * code_size:    bytes of executable sections in the kernel's object file;
+  * runtime:      x86-64 only, wall-clock run time over repeated trials,
+                  with a confidence interval for the mean;
+  * insns:        aarch64 only, the dynamic instruction count under
+                  qemu-aarch64, using the TCG `libinsn.so` plugin.
+
+Results are compared against bench/baselines.json. With --check the run
+fails when a metric regresses beyond its noise threshold, and
+--update-baselines records the current results as the new baselines.
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import math
+import os
+import re
+import statistics
+import struct
+import subprocess
+import sys
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Optional, Sequence
+
+# The kernels are built exactly like the end-to-end tests.
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent / "tests"))
+from run_tests import (  # noqa: E402
+    RUNTIME_LIBRARY,
+    TestCase,
+    discover_tests,
+    ensure_empty_dir,
+    find_tools,
+    print_output_diff,
+    run_single_test_aarch64,
+    run_single_test_nasm,
+)
+
+from gen_program import Knobs, generate_program, parse_size  # noqa: E402
+
+METRICS = ["compile_time", "runtime", "insns", "code_size"]
+
+# The compile-time input: gen_program.py's default knobs at 1 MB
+COMPILE_BENCHMARK = "compile-1M"
+COMPILE_KNOBS = Knobs(functions=64, statements=1, depth=4, symbols=256,
+                      strings=16, nesting=2, seed=1, size=parse_size("1M"))
+
+# Relative change tolerated before --check reports a regression. Overridden
+# by the "thresholds" object of the baseline file and then by --threshold.
+DEFAULT_THRESHOLDS = {
+    "compile_time": 0.50,
+    "runtime": 0.10,
+    "insns": 0.0,
+    "code_size": 0.0,
+}
+
+# Two-sided 95% Student t quantiles by degrees of freedom.
+T_95 = {1: 12.706, 2: 4.303, 3: 3.182, 4: 2.776, 5: 2.571, 6: 2.447,
+        7: 2.365, 8: 2.306, 9: 2.262, 10: 2.228, 12: 2.179, 15: 2.131,
+        20: 2.086, 30: 2.042}
+Z_95 = 1.960
+
+# libinsn prints "insns: N" (qemu < 8.1) or "total insns: N".
+INSNS_PATTERN = re.compile(r"insns:\s*(\d+)")
+
+SHF_EXECINSTR = 0x4
+
+
+@dataclass
+class Result:
+    name: str
+    target: str
+    metrics: dict[str, float] = field(default_factory=dict)
+    # Half-width of the 95% confidence interval of metrics["runtime"]
+    runtime_ci: float = 0.0
+
+
+def t_quantile(dof: int) -> float:
+    """
+    Returns the 95% t quantile for `dof` degrees of freedom, rounding down
+    to the nearest tabulated value (a slightly wider interval).
+    """
+    if dof > max(T_95):
+        return Z_95
+    return T_95[max(k for k in T_95 if k <= dof)]
+
+
+def confidence_interval(samples: Sequence[float]) -> tuple[float, float]:
+    """
+    Returns the mean of `samples` and the half-width of its 95% confidence
+    interval.
+    """
+    mean = statistics.fmean(samples)
+    if len(samples) < 2:
+        return mean, math.inf
+    stdev = statistics.stdev(samples)
+    return mean, t_quantile(len(samples) - 1) * stdev / math.sqrt(len(samples))
+
+
+def time_binary(binary: Path, trials: int, warmup: int) -> list[float]:
+    """
+    Runs `binary` `warmup + trials` times and returns the wall-clock time of
+    the last `trials` runs in seconds.
+    """
+    timings: list[float] = []
+    for index in range(warmup + trials):
+        start = time.perf_counter()
+        subprocess.run([str(binary)], stdout=subprocess.DEVNULL,
+                       stderr=subprocess.DEVNULL, check=False)
+        elapsed = time.perf_counter() - start
+        if index >= warmup:
+            timings.append(elapsed)
+    return timings
+
+
+def compile_input(workdir: Path) -> Path:
+    """
+    Returns the generated program that compile_time is measured on,
+    generating it on first use.
+    """
+    source = workdir / f"{COMPILE_BENCHMARK}.c"
+    if not source.exists():
+        workdir.mkdir(parents=True, exist_ok=True)
+        partial = source.with_suffix(".tmp")
+        generate_program(COMPILE_KNOBS, partial)
+        partial.rename(source)
+    return source
+
+
+def time_compile(keccc: Path, source: Path, target: str,
+                 repeat: int) -> Optional[float]:
+    """
+    Returns the best wall-clock time of `repeat` compiles of `source`, or
+    None if keccc fails.
+    """
+    command = [str(keccc), "--target", target, "--output", "/dev/null", str(source)]
+    best = math.inf
+    for _ in range(repeat):
+        start = time.perf_counter()
+        process = subprocess.run(command, stdout=subprocess.DEVNULL,
+                                 stderr=subprocess.DEVNULL, check=False)
+        if process.returncode != 0:
+            return None
+        best = min(best, time.perf_counter() - start)
+    return best
+
+
+def executable_bytes(object_file: Path) -> int:
+    """
+    Returns the total size of the executable sections of an ELF64
+    little-endian object file.
+    """
+    data = object_file.read_bytes()
+    if data[:4] != b"\x7fELF" or data[4] != 2 or data[5] != 1:
+        raise ValueError(f"{object_file}: not an ELF64 little-endian object")
+    shoff, = struct.unpack_from("<Q", data, 0x28)
+    shentsize, shnum = struct.unpack_from("<HH", data, 0x3A)
+    total = 0
+    for index in range(shnum):
+        header = shoff + index * shentsize
+        flags, = struct.unpack_from("<Q", data, header + 0x08)
+        size, = struct.unpack_from("<Q", data, header + 0x20)
+        if flags & SHF_EXECINSTR:
+            total += size
+    return total
+
+
+def count_insns(qemu: str, plugin: Path, binary: Path, workdir: Path) -> Optional[int]:
+    """
+    Runs `binary` under qemu with the libinsn plugin and returns the number of
+    guest instructions executed, or None if the plugin reported nothing.
+    """
+    log = workdir / "insns.log"
+    subprocess.run([qemu, "-plugin", f"{plugin},inline=on", "-d", "plugin",
+                    "-D", str(log), str(binary)],
+                   cwd=workdir, stdout=subprocess.DEVNULL,
+                   stderr=subprocess.DEVNULL, check=False)
+    if not log.exists():
+        return None
+    match = INSNS_PATTERN.search(log.read_text())
+    return int(match.group(1)) if match else None
+
+
+def build_and_check(kernel: TestCase, target: str, workdir: Path,
+                    keccc: Path, runtime_lib: Path, tools: dict[str, str]) -> Optional[Path]:
+    """
+    Compiles, links and runs one kernel once, and checks its output.
+    Returns the path of the linked binary, or None on failure.
+    """
+    ensure_empty_dir(workdir)
+    if target == "nasm":
+        ok, stdout = run_single_test_nasm(kernel, workdir, keccc, runtime_lib,
+                                          tools["nasm"], tools["ld"])
+        binary = workdir / "out"
+    else:
+        ok, stdout = run_single_test_aarch64(kernel, workdir, keccc, runtime_lib,
+                                             tools["as"], tools["ld"], tools["qemu"])
+        binary = workdir / "out_aarch64"
+    if not ok:
+        return None
+
+    expected = kernel.expected.read_text()
+    if stdout.strip() != expected.strip():
+        print_output_diff(expected, stdout, f"{kernel.name} ({target})")
+        return None
+    return binary
+
+
+def parse_thresholds(values: Sequence[str], thresholds: dict[str, float]) -> None:
+    """
+    Applies --threshold overrides: either `METRIC=FRACTION` or a bare
+    FRACTION that applies to every metric.
+    """
+    for value in values:
+        metric, _, fraction = value.rpartition("=")
+        if metric and metric not in METRICS:
+            raise SystemExit(f"[FATAL] unknown metric in --threshold: {metric}")
+        for name in ([metric] if metric else METRICS):
+            thresholds[name] = float(fraction)
+
+
+def format_value(metric: str, value: Optional[float]) -> str:
+    if value is None:
+        return "-"
+    if metric in ("compile_time", "runtime"):
+        return f"{value * 1000:.2f} ms"
+    return f"{int(value):,}"
+
+
+def compare(results: list[Result], baselines: dict,
+            thresholds: dict[str, float]) -> bool:
+    """
+    Prints a table of every measured metric against its baseline.
+    Returns False if any metric regressed beyond its threshold.
+    """
+    rows = [("benchmark", "target", "metric", "baseline", "current", "change", "status")]
+    ok = True
+    for result in results:
+        stored = baselines.get(result.target, {}).get(result.name, {})
+        for metric in METRICS:
+            if metric not in result.metrics:
+                continue
+            current = result.metrics[metric]
+            baseline = stored.get(metric)
+            current_text = format_value(metric, current)
+            if metric == "runtime":
+                current_text += f" ± {result.runtime_ci * 1000:.2f}"
+
+            if not baseline:
+                change, status = "", "new"
+            else:
+                change = f"{(current - baseline) / baseline * 100:+.1f}%"
+                limit = baseline * (1 + thresholds[metric])
+                # Only flag run time when the whole confidence interval is
+                # above the limit.
+                low = current - result.runtime_ci if metric == "runtime" else current
+                if low > limit:
+                    status = "REGRESSED"
+                    ok = False
+                elif current < baseline * (1 - thresholds[metric]):
+                    status = "improved"
+                else:
+                    status = "ok"
+            rows.append((result.name, result.target, metric,
+                         format_value(metric, baseline), current_text, change, status))
+
+    widths = [max(len(row[column]) for row in rows) for column in range(len(rows[0]))]
+    for index, row in enumerate(rows):
+        print("  " + "  ".join(text.ljust(width) for text, width in zip(row, widths)).rstrip())
+        if index == 0:
+            print("  " + "  ".join("-" * width for width in widths))
+    return ok
+
+
+def update_baselines(path: Path, document: dict, results: list[Result]) -> None:
+    """
+    Records the metrics of `results` in the baseline file. Entries for
+    benchmarks, targets and metrics that were not measured are kept.
+    """
+    baselines = document.setdefault("baselines", {})
+    for result in results:
+        entry = baselines.setdefault(result.target, {}).setdefault(result.name, {})
+        for metric, value in result.metrics.items():
+            entry[metric] = round(value, 6) if isinstance(value, float) else value
+    path.write_text(json.dumps(document, indent=2, sort_keys=True) + "\n")
+    print(f"Updated {path}")
+
+
+def main(argv: Sequence[str]) -> int:
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--target", default="all", choices=["nasm", "aarch64", "all"])
+    parser.add_argument("--trials", type=int, default=10,
+                        help="timed runs per kernel on x86-64")
+    parser.add_argument("--warmup", type=int, default=1)
+    parser.add_argument("--compile-repeat", type=int, default=5,
+                        help="compiles of the generated program; the best time "
+                             "is kept")
+    parser.add_argument("--insn-plugin",
+                        default=os.environ.get("KECCC_QEMU_INSN_PLUGIN"),
+                        help="path to qemu's tests/plugin/libinsn.so "
+                             "(default: $KECCC_QEMU_INSN_PLUGIN)")
+    parser.add_argument("--baselines", default=None,
+                        help="baseline JSON (default: bench/baselines.json)")
+    parser.add_argument("--check", action="store_true",
+                        help="fail if a metric regresses beyond its threshold")
+    parser.add_argument("--threshold", action="append", default=[],
+                        metavar="[METRIC=]FRACTION",
+                        help="noise threshold, e.g. runtime=0.15 or 0.05 for all")
+    parser.add_argument("--update-baselines", action="store_true",
+                        help="store the current results as the new baselines")
+    parser.add_argument("source_root")
+    parser.add_argument("build_root")
+    args = parser.parse_args(list(argv))
+
+    source_root = Path(args.source_root).resolve()
+    build_root = Path(args.build_root).resolve()
+    keccc = build_root / "src" / "keccc"
+    if not keccc.exists():
+        print(f"[FATAL] keccc not found at {keccc}")
+        return 1
+
+    baselines_path = (Path(args.baselines) if args.baselines
+                      else source_root / "bench" / "baselines.json")
+    document = json.loads(baselines_path.read_text()) if baselines_path.exists() else {}
+    thresholds = dict(DEFAULT_THRESHOLDS)
+    thresholds.update(document.get("thresholds", {}))
+    parse_thresholds(args.threshold, thresholds)
+
+    kernels = discover_tests(source_root / "bench" / "kernels")
+    targets = ["nasm", "aarch64"] if args.target == "all" else [args.target]
+
+    all_ok = True
+    results: list[Result] = []
+    for target in targets:
+        runtime_lib = build_root / RUNTIME_LIBRARY[target]
+        if not runtime_lib.exists():
+            print(f"[FATAL] runtime library not found at {runtime_lib}")
+            return 1
+        tools = find_tools(target)
+        if target == "aarch64" and not args.insn_plugin:
+            print("[WARN] no qemu insn plugin given; "
+                  "aarch64 instruction counts are skipped")
+
+        for kernel in kernels:
+            print(f"== Running {target} kernel: {kernel.name}")
+            workdir = build_root / "bench-work" / target / kernel.name
+            binary = build_and_check(kernel, target, workdir, keccc,
+                                     runtime_lib, tools)
+            if binary is None:
+                all_ok = False
+                continue
+
+            result = Result(kernel.name, target)
+            result.metrics["code_size"] = executable_bytes(workdir / "out.o")
+            if target == "nasm":
+                samples = time_binary(binary, max(1, args.trials), max(0, args.warmup))
+                result.metrics["runtime"], result.runtime_ci = confidence_interval(samples)
+            elif args.insn_plugin:
+                insns = count_insns(tools["qemu"], Path(args.insn_plugin),
+                                    binary, workdir)
+                if insns is None:
+                    print(f"[FAIL] {kernel.name}: no instruction count from plugin")
+                    all_ok = False
+                else:
+                    result.metrics["insns"] = insns
+            results.append(result)
+
+        print(f"== Timing {target} compile: {COMPILE_BENCHMARK}")
+        compile_time = time_compile(keccc, compile_input(build_root / "bench-work"),
+                                    target, max(1, args.compile_repeat))
+        if compile_time is None:
+            print(f"[FAIL] {COMPILE_BENCHMARK}: keccc failed")
+            all_ok = False
+        else:
+            result = Result(COMPILE_BENCHMARK, target)
+            result.metrics["compile_time"] = compile_time
+            results.append(result)
+
+    print()
+    regressed = not compare(results, document.get("baselines", {}), thresholds)
+
+    if args.update_baselines:
+        if not all_ok:
+            print("[FATAL] not updating baselines: some kernels failed")
+            return 1
+        update_baselines(baselines_path, document, results)
+        return 0
+
+    if regressed:
+        print("\nPerformance regressed beyond the noise threshold. If this is "
+              "intended, rerun with --update-baselines.")
+        if args.check:
+            all_ok = False
+
+    return 0 if all_ok else 1
+
+
+if __name__ == "__main__":
+    raise SystemExit(main(sys.argv[1:]))
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+Front-end throughput benchmark: times keccc on a generated program and
+reports tokens per second and lines per second.
+"""
+from __future__ import annotations
+
+import argparse
+import re
+import statistics
+import subprocess
+import sys
+import time
+from pathlib import Path
+from typing import Sequence, Tuple
+
+from gen_program import Knobs, generate_program, parse_size
+
+# Mirrors the token classes recognised by scan() in src/scan.c
+TOKEN_PATTERN = re.compile(
+    rb'"(?:\\.|[^"\\])*"'          # string literal
+    rb"|'(?:\\.|[^'\\])'"          # character literal
+    rb"|[A-Za-z_][A-Za-z0-9_]*"    # identifier or keyword
+    rb"|[0-9]+"                    # integer literal
+    rb"|\+\+|--|==|!=|<=|>=|<<|>>|&&|\|\|"
+    rb"|[^\s]"                     # single-character token
+)
+
+
+def count_tokens_and_lines(path: Path) -> Tuple[int, int]:
+    """
+    Counts the tokens and lines of a source file without loading it at once.
+    Generated programs never split a token across lines.
+    """
+    tokens = 0
+    lines = 0
+    with path.open("rb") as source:
+        for line in source:
+            lines += 1
+            tokens += sum(1 for _ in TOKEN_PATTERN.finditer(line))
+    return tokens, lines
+
+
+def time_compile(keccc: Path, source: Path, target: str, repeat: int) -> list[float]:
+    """
+    Compiles `source` `repeat` times, discarding the generated assembly.
+    Returns the wall-clock time of every run in seconds.
+    """
+    command = [str(keccc), "--target", target, "--output", "/dev/null", str(source)]
+    timings: list[float] = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        process = subprocess.run(command, stdout=subprocess.DEVNULL,
+                                 stderr=subprocess.PIPE, text=True)
+        elapsed = time.perf_counter() - start
+        if process.returncode != 0:
+            print(f"[FAIL] keccc exited with {process.returncode}")
+            print("  Command:", " ".join(command))
+            if process.stderr:
+                print("  STDERR:\n" + process.stderr)
+            raise SystemExit(1)
+        timings.append(elapsed)
+    return timings
+
+
+def main(argv: Sequence[str]) -> int:
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--keccc", required=True, help="path to the keccc binary")
+    parser.add_argument("--workdir", required=True,
+                        help="directory for the generated inputs (cached)")
+    parser.add_argument("--size", type=parse_size, required=True,
+                        help="input size, e.g. 1M, 10M, 100M")
+    parser.add_argument("--target", default="nasm", choices=["nasm", "aarch64"])
+    parser.add_argument("--repeat", type=int, default=3)
+    parser.add_argument("--functions", type=int, default=64)
+    parser.add_argument("--depth", type=int, default=4)
+    parser.add_argument("--symbols", type=int, default=256)
+    parser.add_argument("--strings", type=int, default=16)
+    parser.add_argument("--nesting", type=int, default=2)
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args(list(argv))
+
+    keccc = Path(args.keccc).resolve()
+    workdir = Path(args.workdir).resolve()
+    workdir.mkdir(parents=True, exist_ok=True)
+
+    knobs = Knobs(
+        functions=args.functions,
+        statements=1,
+        depth=args.depth,
+        symbols=args.symbols,
+        strings=args.strings,
+        nesting=args.nesting,
+        seed=args.seed,
+        size=args.size,
+    )
+
+    # Generating 100 MB takes a while; reuse inputs across benchmark runs.
+    source = workdir / (f"synth-{args.size}-f{knobs.functions}-d{knobs.depth}-"
+                        f"s{knobs.symbols}-str{knobs.strings}-n{knobs.nesting}-"
+                        f"seed{knobs.seed}.c")
+    if not source.exists():
+        partial = source.with_suffix(".tmp")
+        generate_program(knobs, partial)
+        partial.rename(source)
+
+    tokens, lines = count_tokens_and_lines(source)
+    size_bytes = source.stat().st_size
+
+    timings = time_compile(keccc, source, args.target, max(1, args.repeat))
+    best = min(timings)
+    median = statistics.median(timings)
+
+    print(f"== keccc throughput ({args.target}): {source.name}")
+    print(f"  input:   {size_bytes} bytes, {lines} lines, {tokens} tokens")
+    print(f"  runs:    {len(timings)}, best {best:.3f}s, median {median:.3f}s")
+    print(f"  tokens/s {tokens / best:,.0f}")
+    print(f"  lines/s  {lines / best:,.0f}")
+    print(f"  MB/s     {size_bytes / best / (1 << 20):.2f}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main(sys.argv[1:]))
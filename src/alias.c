@@ -0,0 +1,149 @@
+// src/alias.c
+//
+// Alias analysis: decides whether two loads or stores may touch the same
+// memory. It combines what the AST says about each access (which variable
+// or pointer it goes through, and at what offset) with the size of the
+// accessed type and the const/volatile/restrict qualifiers.
+
+#include "data.h"
+#include "decl.h"
+#include "defs.h"
+
+/**
+ * describeMemoryAccess - Describe the memory that an AST node loads from
+ * or stores to.
+ *
+ * NOTE:
+ * - A scalar variable ("x", "x++") is an object access at offset 0.
+ * - An array element or struct member ("a[2]", "s.x", "grid[i][j]") is an
+ *   object access of the array or struct. Constant indices and member
+ *   offsets are already folded into the displacement; a run-time index
+ *   makes the offset unknown.
+ * - "*p" and "p->x" are pointer accesses through the value of p.
+ * - Anything else (e.g. "**pp", "pp->next->x") is an unknown access.
+ *
+ * @param n The AST node.
+ * @param a Where to store the description.
+ *
+ * @return bool True if n accesses memory.
+ */
+bool describeMemoryAccess(struct ASTnode *n, struct memoryAccess *a) {
+    struct ASTnode *address;
+    int id;
+
+    switch (n->op) {
+    case A_IDENTIFIER:
+    case A_POSTINCREMENT:
+    case A_POSTDECREMENT:
+        id = n->v.identifierIndex;
+        if (SymbolTable[id].structuralType != S_VARIABLE) {
+            return false;
+        }
+        *a = (struct memoryAccess){ACCESS_OBJECT, id, 0, true,
+                                   getSymbolSize(id),
+                                   SymbolTable[id].qualifiers};
+        return true;
+    case A_DEREFERENCE:
+        break;
+    default:
+        return false;
+    }
+
+    *a = (struct memoryAccess){ACCESS_UNKNOWN, 0, n->v.offset, true,
+                               getTypeSize(n->primitiveType), 0};
+
+    // Run-time indices are added on the left of the base address
+    address = n->left;
+    while (address->op == A_ADD) {
+        a->isOffsetKnown = false;
+        address = address->left;
+    }
+
+    switch (address->op) {
+    case A_ADDRESSOF:
+        a->kind = ACCESS_OBJECT;
+        a->id = address->v.identifierIndex;
+        a->qualifiers = SymbolTable[a->id].qualifiers;
+        break;
+    case A_IDENTIFIER:
+        // The pointed-to type's qualifiers, and the pointer's "restrict"
+        a->kind = ACCESS_POINTER;
+        a->id = address->v.identifierIndex;
+        a->qualifiers = SymbolTable[a->id].targetQualifiers |
+                        (SymbolTable[a->id].qualifiers & Q_RESTRICT);
+        break;
+    }
+    return true;
+}
+
+/**
+ * isPointerReachable - Check whether a pointer may point into a variable.
+ * (helper function)
+ *
+ * NOTE:
+ * Only a local whose address is never taken is known to be out of reach:
+ * the whole function has been parsed, so no later '&' can appear. A
+ * global may be reached from another file, or by name from asm text.
+ *
+ * @param id Symbol table ID of the variable.
+ *
+ * @return bool True unless no pointer can reach the variable.
+ */
+static bool isPointerReachable(int id) {
+    return SymbolTable[id].class != C_LOCAL ||
+           SymbolTable[id].structuralType != S_VARIABLE ||
+           SymbolTable[id].isAddressTaken;
+}
+
+/**
+ * mayAlias - Check whether two memory accesses may overlap.
+ *
+ * NOTE:
+ * Two pointer accesses through the same pointer variable are assumed to
+ * use the same pointer value, i.e. the variable does not change between
+ * them. The rules, in order:
+ * - Type-based: accesses of different sizes are of incompatible types and
+ *   cannot overlap, unless one of them is a char access (which may alias
+ *   anything) or a vector access (which may alias its lanes).
+ * - Two objects overlap only if they are the same variable and their
+ *   byte ranges meet (distinct arrays and globals never alias).
+ * - An object and a pointer overlap unless the pointer is restrict, or
+ *   the object is a local that no pointer can reach.
+ * - Two pointers with distinct variables overlap unless both are
+ *   restrict.
+ *
+ * @param a The first access.
+ * @param b The second access.
+ *
+ * @return bool False if the accesses are known not to overlap.
+ */
+bool mayAlias(struct memoryAccess *a, struct memoryAccess *b) {
+    struct memoryAccess *object;
+    struct memoryAccess *pointer;
+
+    if (a->size != b->size && a->size != 1 && b->size != 1 &&
+        a->size != VECTORSIZE && b->size != VECTORSIZE) {
+        return false;
+    }
+    if (a->kind == ACCESS_UNKNOWN || b->kind == ACCESS_UNKNOWN) {
+        return true;
+    }
+
+    if (a->kind == b->kind) {
+        if (a->id != b->id) {
+            return a->kind == ACCESS_POINTER &&
+                   !((a->qualifiers & Q_RESTRICT) &&
+                     (b->qualifiers & Q_RESTRICT));
+        }
+        if (!a->isOffsetKnown || !b->isOffsetKnown) {
+            return true;
+        }
+        return a->offset < b->offset + b->size &&
+               b->offset < a->offset + a->size;
+    }
+
+    object = (a->kind == ACCESS_OBJECT) ? a : b;
+    pointer = (a->kind == ACCESS_OBJECT) ? b : a;
+    return !(pointer->qualifiers & Q_RESTRICT) &&
+           isPointerReachable(object->id);
+}
@@ -12,6 +12,7 @@
 #include "defs.h"
 
 #include <limits.h>
+#include <string.h>
 
 static int aarch64PrimitiveSizeInBytes[] = {
     0, // P_NONE
@@ -19,9 +20,13 @@ static int aarch64PrimitiveSizeInBytes[] = {
     1, // P_CHAR
     4, // P_INT
     8, // P_LONG
-    8, // P_CHARPTR
-    8, // P_INTPTR
-    8  // P_LONGPTR
+    1, // P_UCHAR
+    4, // P_UINT
+    8, // P_ULONG
+    2, // P_SHORT
+    2, // P_USHORT
+    4, // P_FLOAT
+    8, // P_DOUBLE
 };
 
 /**
@@ -32,7 +37,7 @@ static int aarch64PrimitiveSizeInBytes[] = {
  * @return Size in bytes of the primitive type.
  */
 int aarch64GetPrimitiveTypeSize(int type) {
-    if (type < P_NONE || type > P_LONGPTR) {
+    if (type < P_NONE || type > P_DOUBLE) {
         fprintf(
             stderr,
             "Error: Invalid primitive type %d in aarch64GetPrimitiveTypeSize\n",
@@ -51,6 +56,8 @@ int aarch64GetPrimitiveTypeSize(int type) {
  *
  * NOTE:
  * For AArch64, type is not used since all integers are treated as 64-bit.
+ * `mov` only takes a 16-bit (optionally inverted) immediate, so wider
+ * values are built 16 bits at a time in the w-register and sign-extended.
  *
  * @return Index of the register containing the loaded integer.
  */
@@ -58,7 +65,55 @@ int aarch64LoadImmediateInt(int value, int primitiveType) {
     int r = aarch64AllocateRegister();
     (void)primitiveType; // unused (all are represented as 64-bit)
 
-    fprintf(Outfile, "\tmov\t%s, #%d\n", aarch64QwordRegisterList[r], value);
+    if (value > -65536 && value < 65536) {
+        aarch64Emit(INSN_ALU, "\tmov\t%s, #%d\n", aarch64QwordRegisterList[r],
+                    value);
+        return r;
+    }
+
+    unsigned int bits = (unsigned int)value;
+    aarch64Emit(INSN_ALU, "\tmov\t%s, #%u\n", aarch64DwordRegisterList[r],
+                bits & 0xffff);
+    aarch64Emit(INSN_ALU, "\tmovk\t%s, #%u, lsl #16\n",
+                aarch64DwordRegisterList[r], bits >> 16);
+    aarch64Emit(INSN_ALU, "\tsxtw\t%s, %s\n", aarch64QwordRegisterList[r],
+                aarch64DwordRegisterList[r]);
+    return r;
+}
+
+/**
+ * aarch64LoadImmediateFloat - Generates code to load a floating-point
+ * constant into a SIMD&FP register.
+ *
+ * NOTE:
+ * `fmov` only takes a few immediates, so the bits of the value are built
+ * 16 bits at a time in x0 and moved across (zero comes from xzr). Every
+ * floating-point value is held as a double in a register; a float constant
+ * is already rounded to float.
+ *
+ * @param value The constant to load.
+ * @param primitiveType The primitive type of the constant (unused).
+ *
+ * @return Index of the register containing the loaded value.
+ */
+int aarch64LoadImmediateFloat(double value, int primitiveType) {
+    int r = aarch64AllocateFloatRegister();
+    unsigned long bits;
+    (void)primitiveType;
+
+    memcpy(&bits, &value, sizeof(bits));
+    if (bits == 0) {
+        aarch64Emit(INSN_ALU, "\tfmov\t%s, xzr\n", aarch64DoubleRegister(r));
+        return r;
+    }
+    aarch64Emit(INSN_ALU, "\tmov\tx0, #%lu\n", bits & 0xffff);
+    for (int shift = 16; shift < 64; shift += 16) {
+        if ((bits >> shift) & 0xffff) {
+            aarch64Emit(INSN_ALU, "\tmovk\tx0, #%lu, lsl #%d\n",
+                        (bits >> shift) & 0xffff, shift);
+        }
+    }
+    aarch64Emit(INSN_ALU, "\tfmov\t%s, x0\n", aarch64DoubleRegister(r));
     return r;
 }
 
@@ -73,8 +128,8 @@ static void aarch64LoadGlobalAddressIntoX0(const char *name) {
     // PC-relative addressing:
     //   adrp x0, name
     //   add  x0, x0, :lo12:name
-    fprintf(Outfile, "\tadrp\tx0, %s\n", name);
-    fprintf(Outfile, "\tadd\tx0, x0, :lo12:%s\n", name);
+    aarch64Emit(INSN_ALU, "\tadrp\tx0, %s\n", name);
+    aarch64Emit(INSN_ALU, "\tadd\tx0, x0, :lo12:%s\n", name);
 }
 
 /**
@@ -86,9 +141,98 @@ static void aarch64LoadGlobalAddressIntoX0(const char *name) {
 static void aarch64LoadLocalAddressIntoX0(int id) {
     int offset = SymbolTable[id].offset;
     if (offset >= 0) {
-        fprintf(Outfile, "\tadd\tx0, x29, #%d\n", offset);
+        aarch64Emit(INSN_ALU, "\tadd\tx0, x29, #%d\n", offset);
+    } else {
+        aarch64Emit(INSN_ALU, "\tsub\tx0, x29, #%d\n", -offset);
+    }
+}
+
+/**
+ * aarch64LoadWord - Generates code to load the 32-bit value at [x0] into a
+ * register, sign-extended for int and zero-extended for unsigned int.
+ * (helper function)
+ *
+ * @param r Index of the destination register.
+ * @param primitiveType P_INT or P_UINT.
+ */
+static void aarch64LoadWord(int r, int primitiveType) {
+    if (primitiveType == P_UINT) {
+        // ldr wN clears the upper 32 bits of xN
+        aarch64Emit(INSN_LOAD, "\tldr\t%s, [x0]\n",
+                    aarch64DwordRegisterList[r]);
+    } else {
+        aarch64Emit(INSN_LOAD, "\tldrsw\t%s, [x0]\n",
+                    aarch64QwordRegisterList[r]);
+    }
+}
+
+/**
+ * aarch64LoadHalfword - Generates code to load the 16-bit value at [x0] into
+ * a register, sign-extended for short and zero-extended for unsigned short.
+ * (helper function)
+ *
+ * @param r Index of the destination register.
+ * @param primitiveType P_SHORT or P_USHORT.
+ */
+static void aarch64LoadHalfword(int r, int primitiveType) {
+    if (primitiveType == P_USHORT) {
+        aarch64Emit(INSN_LOAD, "\tldrh\t%s, [x0]\n",
+                    aarch64DwordRegisterList[r]);
+    } else {
+        aarch64Emit(INSN_LOAD, "\tldrsh\t%s, [x0]\n",
+                    aarch64QwordRegisterList[r]);
+    }
+}
+
+/**
+ * aarch64LoadFloatMemory - Generates code to load a float or double from a
+ * memory operand into a new SIMD&FP register, as a double.
+ * (helper function)
+ *
+ * @param address The memory operand (e.g. "[x0]" or "[x9, #8]").
+ * @param primitiveType P_FLOAT or P_DOUBLE.
+ *
+ * @return Index of the register containing the loaded value.
+ */
+static int aarch64LoadFloatMemory(const char *address, int primitiveType) {
+    int r = aarch64AllocateFloatRegister();
+
+    if (primitiveType == P_FLOAT) {
+        aarch64Emit(INSN_LOAD, "\tldr\t%s, %s\n", aarch64SingleRegister(r),
+                    address);
+        aarch64Emit(INSN_ALU, "\tfcvt\t%s, %s\n", aarch64DoubleRegister(r),
+                    aarch64SingleRegister(r));
+    } else {
+        aarch64Emit(INSN_LOAD, "\tldr\t%s, %s\n", aarch64DoubleRegister(r),
+                    address);
+    }
+    return r;
+}
+
+/**
+ * aarch64StoreFloatMemory - Generates code to store a SIMD&FP register into
+ * a float or double memory operand. (helper function)
+ *
+ * NOTE:
+ * A float store rounds the register to float first and leaves the rounded
+ * value in the register, since that is the value of the assignment.
+ *
+ * @param r Index of the register containing the value to store.
+ * @param address The memory operand (e.g. "[x0]" or "[x9, #8]").
+ * @param primitiveType P_FLOAT or P_DOUBLE.
+ */
+static void aarch64StoreFloatMemory(int r, const char *address,
+                                    int primitiveType) {
+    if (primitiveType == P_FLOAT) {
+        aarch64Emit(INSN_ALU, "\tfcvt\t%s, %s\n", aarch64SingleRegister(r),
+                    aarch64DoubleRegister(r));
+        aarch64Emit(INSN_STORE, "\tstr\t%s, %s\n", aarch64SingleRegister(r),
+                    address);
+        aarch64Emit(INSN_ALU, "\tfcvt\t%s, %s\n", aarch64DoubleRegister(r),
+                    aarch64SingleRegister(r));
     } else {
-        fprintf(Outfile, "\tsub\tx0, x29, #%d\n", -offset);
+        aarch64Emit(INSN_STORE, "\tstr\t%s, %s\n", aarch64DoubleRegister(r),
+                    address);
     }
 }
 
@@ -102,110 +246,145 @@ static void aarch64LoadLocalAddressIntoX0(int id) {
  * @return Index of the register containing the loaded value.
  */
 int aarch64LoadGlobalSymbol(int id, int op) {
-    int r = aarch64AllocateRegister();
-    int primitiveType = SymbolTable[id].primitiveType;
+    int r;
+    int primitiveType = getMemoryAccessType(SymbolTable[id].primitiveType);
     char *name = SymbolTable[id].name;
 
     int tmpReg = -1; // optional temp for post-inc/dec
 
     aarch64LoadGlobalAddressIntoX0(name);
+    if (isFloatType(primitiveType)) {
+        return aarch64LoadFloatMemory("[x0]", primitiveType);
+    }
+    r = aarch64AllocateRegister();
 
     switch (primitiveType) {
     case P_CHAR:
+    case P_UCHAR:
         // Pre-increment/decrement: update memory before load
         if (op == A_PREINCREMENT || op == A_PREDECREMENT) {
-            fprintf(Outfile, "\tldrb\t%s, [x0]\n", aarch64DwordRegisterList[r]);
-            if (op == A_PREINCREMENT) {
-                fprintf(Outfile, "\tadd\t%s, %s, #1\n",
-                        aarch64DwordRegisterList[r],
+            aarch64Emit(INSN_LOAD, "\tldrb\t%s, [x0]\n",
                         aarch64DwordRegisterList[r]);
+            if (op == A_PREINCREMENT) {
+                aarch64Emit(INSN_ALU, "\tadd\t%s, %s, #1\n",
+                            aarch64DwordRegisterList[r],
+                            aarch64DwordRegisterList[r]);
             } else {
-                fprintf(Outfile, "\tsub\t%s, %s, #1\n",
-                        aarch64DwordRegisterList[r],
-                        aarch64DwordRegisterList[r]);
+                aarch64Emit(INSN_ALU, "\tsub\t%s, %s, #1\n",
+                            aarch64DwordRegisterList[r],
+                            aarch64DwordRegisterList[r]);
             }
-            fprintf(Outfile, "\tstrb\t%s, [x0]\n", aarch64DwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstrb\t%s, [x0]\n",
+                        aarch64DwordRegisterList[r]);
         }
 
         // Load (zero-extend byte into w-reg)
-        fprintf(Outfile, "\tldrb\t%s, [x0]\n", aarch64DwordRegisterList[r]);
+        aarch64Emit(INSN_LOAD, "\tldrb\t%s, [x0]\n",
+                    aarch64DwordRegisterList[r]);
 
         // Post-increment/decrement: update memory after load, keep r intact
         if (op == A_POSTINCREMENT || op == A_POSTDECREMENT) {
             tmpReg = aarch64AllocateRegister();
-            fprintf(Outfile, "\t%s\t%s, %s, #1\n",
-                    (op == A_POSTINCREMENT) ? "add" : "sub",
-                    aarch64DwordRegisterList[tmpReg],
-                    aarch64DwordRegisterList[r]);
-            fprintf(Outfile, "\tstrb\t%s, [x0]\n",
-                    aarch64DwordRegisterList[tmpReg]);
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_POSTINCREMENT) ? "add" : "sub",
+                        aarch64DwordRegisterList[tmpReg],
+                        aarch64DwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstrb\t%s, [x0]\n",
+                        aarch64DwordRegisterList[tmpReg]);
+            aarch64FreeRegister(tmpReg);
+        }
+        break;
+    case P_SHORT:
+    case P_USHORT:
+        if (op == A_PREINCREMENT || op == A_PREDECREMENT) {
+            aarch64LoadHalfword(r, primitiveType);
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_PREINCREMENT) ? "add" : "sub",
+                        aarch64QwordRegisterList[r],
+                        aarch64QwordRegisterList[r]);
+            // Store back the low 16 bits
+            aarch64Emit(INSN_STORE, "\tstrh\t%s, [x0]\n",
+                        aarch64DwordRegisterList[r]);
+        }
+
+        aarch64LoadHalfword(r, primitiveType);
+
+        if (op == A_POSTINCREMENT || op == A_POSTDECREMENT) {
+            tmpReg = aarch64AllocateRegister();
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_POSTINCREMENT) ? "add" : "sub",
+                        aarch64QwordRegisterList[tmpReg],
+                        aarch64QwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstrh\t%s, [x0]\n",
+                        aarch64DwordRegisterList[tmpReg]);
             aarch64FreeRegister(tmpReg);
         }
         break;
     case P_INT:
+    case P_UINT:
         if (op == A_PREINCREMENT || op == A_PREDECREMENT) {
             // Sign-extend 32-bit int into 64-bit register so subsequent
             // operations and calls (e.g. printint) observe signed values.
-            fprintf(Outfile, "\tldrsw\t%s, [x0]\n",
-                    aarch64QwordRegisterList[r]);
+            aarch64LoadWord(r, primitiveType);
             if (op == A_PREINCREMENT) {
-                fprintf(Outfile, "\tadd\t%s, %s, #1\n",
-                        aarch64QwordRegisterList[r],
-                        aarch64QwordRegisterList[r]);
+                aarch64Emit(INSN_ALU, "\tadd\t%s, %s, #1\n",
+                            aarch64QwordRegisterList[r],
+                            aarch64QwordRegisterList[r]);
             } else {
-                fprintf(Outfile, "\tsub\t%s, %s, #1\n",
-                        aarch64QwordRegisterList[r],
-                        aarch64QwordRegisterList[r]);
+                aarch64Emit(INSN_ALU, "\tsub\t%s, %s, #1\n",
+                            aarch64QwordRegisterList[r],
+                            aarch64QwordRegisterList[r]);
             }
             // Store back as 32-bit int.
-            fprintf(Outfile, "\tstr\t%s, [x0]\n", aarch64DwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                        aarch64DwordRegisterList[r]);
         }
 
-        // Normal load: sign-extend into 64-bit register.
-        fprintf(Outfile, "\tldrsw\t%s, [x0]\n", aarch64QwordRegisterList[r]);
+        // Normal load: sign-extend (zero-extend for unsigned) into 64-bit
+        // register.
+        aarch64LoadWord(r, primitiveType);
 
         if (op == A_POSTINCREMENT || op == A_POSTDECREMENT) {
             tmpReg = aarch64AllocateRegister();
-            fprintf(Outfile, "\t%s\t%s, %s, #1\n",
-                    (op == A_POSTINCREMENT) ? "add" : "sub",
-                    aarch64QwordRegisterList[tmpReg],
-                    aarch64QwordRegisterList[r]);
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_POSTINCREMENT) ? "add" : "sub",
+                        aarch64QwordRegisterList[tmpReg],
+                        aarch64QwordRegisterList[r]);
             // Store back as 32-bit int.
-            fprintf(Outfile, "\tstr\t%s, [x0]\n",
-                    aarch64DwordRegisterList[tmpReg]);
+            aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                        aarch64DwordRegisterList[tmpReg]);
             aarch64FreeRegister(tmpReg);
         }
         break;
     case P_LONG:
-    // NOTE:
-    // pointer types are treated as long (64 bits) in AArch64
-    case P_CHARPTR:
-    case P_INTPTR:
-    case P_LONGPTR:
+    case P_ULONG:
         if (op == A_PREINCREMENT || op == A_PREDECREMENT) {
-            fprintf(Outfile, "\tldr\t%s, [x0]\n", aarch64QwordRegisterList[r]);
-            if (op == A_PREINCREMENT) {
-                fprintf(Outfile, "\tadd\t%s, %s, #1\n",
-                        aarch64QwordRegisterList[r],
+            aarch64Emit(INSN_LOAD, "\tldr\t%s, [x0]\n",
                         aarch64QwordRegisterList[r]);
+            if (op == A_PREINCREMENT) {
+                aarch64Emit(INSN_ALU, "\tadd\t%s, %s, #1\n",
+                            aarch64QwordRegisterList[r],
+                            aarch64QwordRegisterList[r]);
             } else {
-                fprintf(Outfile, "\tsub\t%s, %s, #1\n",
-                        aarch64QwordRegisterList[r],
-                        aarch64QwordRegisterList[r]);
+                aarch64Emit(INSN_ALU, "\tsub\t%s, %s, #1\n",
+                            aarch64QwordRegisterList[r],
+                            aarch64QwordRegisterList[r]);
             }
-            fprintf(Outfile, "\tstr\t%s, [x0]\n", aarch64QwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                        aarch64QwordRegisterList[r]);
         }
 
-        fprintf(Outfile, "\tldr\t%s, [x0]\n", aarch64QwordRegisterList[r]);
+        aarch64Emit(INSN_LOAD, "\tldr\t%s, [x0]\n",
+                    aarch64QwordRegisterList[r]);
 
         if (op == A_POSTINCREMENT || op == A_POSTDECREMENT) {
             tmpReg = aarch64AllocateRegister();
-            fprintf(Outfile, "\t%s\t%s, %s, #1\n",
-                    (op == A_POSTINCREMENT) ? "add" : "sub",
-                    aarch64QwordRegisterList[tmpReg],
-                    aarch64QwordRegisterList[r]);
-            fprintf(Outfile, "\tstr\t%s, [x0]\n",
-                    aarch64QwordRegisterList[tmpReg]);
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_POSTINCREMENT) ? "add" : "sub",
+                        aarch64QwordRegisterList[tmpReg],
+                        aarch64QwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                        aarch64QwordRegisterList[tmpReg]);
             aarch64FreeRegister(tmpReg);
         }
         break;
@@ -225,83 +404,123 @@ int aarch64LoadGlobalSymbol(int id, int op) {
  * Uses the same pre/post inc/dec semantics as the global-symbol path.
  */
 int aarch64LoadLocalSymbol(int id, int op) {
-    int r = aarch64AllocateRegister();
-    int primitiveType = SymbolTable[id].primitiveType;
+    int r;
+    int primitiveType = getMemoryAccessType(SymbolTable[id].primitiveType);
 
     int tmpReg = -1;
 
     aarch64LoadLocalAddressIntoX0(id);
+    if (isFloatType(primitiveType)) {
+        return aarch64LoadFloatMemory("[x0]", primitiveType);
+    }
+    r = aarch64AllocateRegister();
 
     switch (primitiveType) {
     case P_CHAR:
+    case P_UCHAR:
         if (op == A_PREINCREMENT || op == A_PREDECREMENT) {
-            fprintf(Outfile, "\tldrb\t%s, [x0]\n", aarch64DwordRegisterList[r]);
-            fprintf(Outfile, "\t%s\t%s, %s, #1\n",
-                    (op == A_PREINCREMENT) ? "add" : "sub",
-                    aarch64DwordRegisterList[r], aarch64DwordRegisterList[r]);
-            fprintf(Outfile, "\tstrb\t%s, [x0]\n", aarch64DwordRegisterList[r]);
+            aarch64Emit(INSN_LOAD, "\tldrb\t%s, [x0]\n",
+                        aarch64DwordRegisterList[r]);
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_PREINCREMENT) ? "add" : "sub",
+                        aarch64DwordRegisterList[r],
+                        aarch64DwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstrb\t%s, [x0]\n",
+                        aarch64DwordRegisterList[r]);
         }
 
-        fprintf(Outfile, "\tldrb\t%s, [x0]\n", aarch64DwordRegisterList[r]);
+        aarch64Emit(INSN_LOAD, "\tldrb\t%s, [x0]\n",
+                    aarch64DwordRegisterList[r]);
 
         if (op == A_POSTINCREMENT || op == A_POSTDECREMENT) {
             tmpReg = aarch64AllocateRegister();
-            fprintf(Outfile, "\t%s\t%s, %s, #1\n",
-                    (op == A_POSTINCREMENT) ? "add" : "sub",
-                    aarch64DwordRegisterList[tmpReg],
-                    aarch64DwordRegisterList[r]);
-            fprintf(Outfile, "\tstrb\t%s, [x0]\n",
-                    aarch64DwordRegisterList[tmpReg]);
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_POSTINCREMENT) ? "add" : "sub",
+                        aarch64DwordRegisterList[tmpReg],
+                        aarch64DwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstrb\t%s, [x0]\n",
+                        aarch64DwordRegisterList[tmpReg]);
+            aarch64FreeRegister(tmpReg);
+        }
+        break;
+
+    case P_SHORT:
+    case P_USHORT:
+        if (op == A_PREINCREMENT || op == A_PREDECREMENT) {
+            aarch64LoadHalfword(r, primitiveType);
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_PREINCREMENT) ? "add" : "sub",
+                        aarch64QwordRegisterList[r],
+                        aarch64QwordRegisterList[r]);
+            // Store back the low 16 bits
+            aarch64Emit(INSN_STORE, "\tstrh\t%s, [x0]\n",
+                        aarch64DwordRegisterList[r]);
+        }
+
+        aarch64LoadHalfword(r, primitiveType);
+
+        if (op == A_POSTINCREMENT || op == A_POSTDECREMENT) {
+            tmpReg = aarch64AllocateRegister();
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_POSTINCREMENT) ? "add" : "sub",
+                        aarch64QwordRegisterList[tmpReg],
+                        aarch64QwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstrh\t%s, [x0]\n",
+                        aarch64DwordRegisterList[tmpReg]);
             aarch64FreeRegister(tmpReg);
         }
         break;
 
     case P_INT:
+    case P_UINT:
         if (op == A_PREINCREMENT || op == A_PREDECREMENT) {
-            fprintf(Outfile, "\tldrsw\t%s, [x0]\n",
-                    aarch64QwordRegisterList[r]);
-            fprintf(Outfile, "\t%s\t%s, %s, #1\n",
-                    (op == A_PREINCREMENT) ? "add" : "sub",
-                    aarch64QwordRegisterList[r], aarch64QwordRegisterList[r]);
-            fprintf(Outfile, "\tstr\t%s, [x0]\n", aarch64DwordRegisterList[r]);
+            aarch64LoadWord(r, primitiveType);
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_PREINCREMENT) ? "add" : "sub",
+                        aarch64QwordRegisterList[r],
+                        aarch64QwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                        aarch64DwordRegisterList[r]);
         }
 
-        fprintf(Outfile, "\tldrsw\t%s, [x0]\n", aarch64QwordRegisterList[r]);
+        aarch64LoadWord(r, primitiveType);
 
         if (op == A_POSTINCREMENT || op == A_POSTDECREMENT) {
             tmpReg = aarch64AllocateRegister();
-            fprintf(Outfile, "\t%s\t%s, %s, #1\n",
-                    (op == A_POSTINCREMENT) ? "add" : "sub",
-                    aarch64QwordRegisterList[tmpReg],
-                    aarch64QwordRegisterList[r]);
-            fprintf(Outfile, "\tstr\t%s, [x0]\n",
-                    aarch64DwordRegisterList[tmpReg]);
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_POSTINCREMENT) ? "add" : "sub",
+                        aarch64QwordRegisterList[tmpReg],
+                        aarch64QwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                        aarch64DwordRegisterList[tmpReg]);
             aarch64FreeRegister(tmpReg);
         }
         break;
 
     case P_LONG:
-    case P_CHARPTR:
-    case P_INTPTR:
-    case P_LONGPTR:
+    case P_ULONG:
         if (op == A_PREINCREMENT || op == A_PREDECREMENT) {
-            fprintf(Outfile, "\tldr\t%s, [x0]\n", aarch64QwordRegisterList[r]);
-            fprintf(Outfile, "\t%s\t%s, %s, #1\n",
-                    (op == A_PREINCREMENT) ? "add" : "sub",
-                    aarch64QwordRegisterList[r], aarch64QwordRegisterList[r]);
-            fprintf(Outfile, "\tstr\t%s, [x0]\n", aarch64QwordRegisterList[r]);
+            aarch64Emit(INSN_LOAD, "\tldr\t%s, [x0]\n",
+                        aarch64QwordRegisterList[r]);
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_PREINCREMENT) ? "add" : "sub",
+                        aarch64QwordRegisterList[r],
+                        aarch64QwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                        aarch64QwordRegisterList[r]);
         }
 
-        fprintf(Outfile, "\tldr\t%s, [x0]\n", aarch64QwordRegisterList[r]);
+        aarch64Emit(INSN_LOAD, "\tldr\t%s, [x0]\n",
+                    aarch64QwordRegisterList[r]);
 
         if (op == A_POSTINCREMENT || op == A_POSTDECREMENT) {
             tmpReg = aarch64AllocateRegister();
-            fprintf(Outfile, "\t%s\t%s, %s, #1\n",
-                    (op == A_POSTINCREMENT) ? "add" : "sub",
-                    aarch64QwordRegisterList[tmpReg],
-                    aarch64QwordRegisterList[r]);
-            fprintf(Outfile, "\tstr\t%s, [x0]\n",
-                    aarch64QwordRegisterList[tmpReg]);
+            aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #1\n",
+                        (op == A_POSTINCREMENT) ? "add" : "sub",
+                        aarch64QwordRegisterList[tmpReg],
+                        aarch64QwordRegisterList[r]);
+            aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                        aarch64QwordRegisterList[tmpReg]);
             aarch64FreeRegister(tmpReg);
         }
         break;
@@ -328,9 +547,9 @@ int aarch64LoadLocalSymbol(int id, int op) {
 int aarch64LoadGlobalString(int id) {
     int r = aarch64AllocateRegister();
 
-    fprintf(Outfile, "\tadrp\t%s, L%d\n", aarch64QwordRegisterList[r], id);
-    fprintf(Outfile, "\tadd\t%s, %s, :lo12:L%d\n", aarch64QwordRegisterList[r],
-            aarch64QwordRegisterList[r], id);
+    aarch64Emit(INSN_ALU, "\tadrp\t%s, L%d\n", aarch64QwordRegisterList[r], id);
+    aarch64Emit(INSN_ALU, "\tadd\t%s, %s, :lo12:L%d\n",
+                aarch64QwordRegisterList[r], aarch64QwordRegisterList[r], id);
 
     return r;
 }
@@ -345,24 +564,37 @@ int aarch64LoadGlobalString(int id) {
  * @return Index of the register that was stored.
  */
 int aarch64StoreGlobalSymbol(int r, int id) {
-    int primitiveType = SymbolTable[id].primitiveType;
+    int primitiveType = getMemoryAccessType(SymbolTable[id].primitiveType);
     char *name = SymbolTable[id].name;
 
     aarch64LoadGlobalAddressIntoX0(name);
+    if (isFloatType(primitiveType)) {
+        aarch64StoreFloatMemory(r, "[x0]", primitiveType);
+        return r;
+    }
 
     switch (primitiveType) {
     case P_CHAR:
+    case P_UCHAR:
         // NOTE: Store Register Byte
-        fprintf(Outfile, "\tstrb\t%s, [x0]\n", aarch64DwordRegisterList[r]);
+        aarch64Emit(INSN_STORE, "\tstrb\t%s, [x0]\n",
+                    aarch64DwordRegisterList[r]);
+        break;
+    case P_SHORT:
+    case P_USHORT:
+        // NOTE: Store Register Halfword
+        aarch64Emit(INSN_STORE, "\tstrh\t%s, [x0]\n",
+                    aarch64DwordRegisterList[r]);
         break;
     case P_INT:
-        fprintf(Outfile, "\tstr\t%s, [x0]\n", aarch64DwordRegisterList[r]);
+    case P_UINT:
+        aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                    aarch64DwordRegisterList[r]);
         break;
     case P_LONG:
-    case P_CHARPTR:
-    case P_INTPTR:
-    case P_LONGPTR:
-        fprintf(Outfile, "\tstr\t%s, [x0]\n", aarch64QwordRegisterList[r]);
+    case P_ULONG:
+        aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                    aarch64QwordRegisterList[r]);
         break;
     default:
         fprintf(stderr,
@@ -380,22 +612,34 @@ int aarch64StoreGlobalSymbol(int r, int id) {
  * symbol.
  */
 int aarch64StoreLocalSymbol(int r, int id) {
-    int primitiveType = SymbolTable[id].primitiveType;
+    int primitiveType = getMemoryAccessType(SymbolTable[id].primitiveType);
 
     aarch64LoadLocalAddressIntoX0(id);
+    if (isFloatType(primitiveType)) {
+        aarch64StoreFloatMemory(r, "[x0]", primitiveType);
+        return r;
+    }
 
     switch (primitiveType) {
     case P_CHAR:
-        fprintf(Outfile, "\tstrb\t%s, [x0]\n", aarch64DwordRegisterList[r]);
+    case P_UCHAR:
+        aarch64Emit(INSN_STORE, "\tstrb\t%s, [x0]\n",
+                    aarch64DwordRegisterList[r]);
+        break;
+    case P_SHORT:
+    case P_USHORT:
+        aarch64Emit(INSN_STORE, "\tstrh\t%s, [x0]\n",
+                    aarch64DwordRegisterList[r]);
         break;
     case P_INT:
-        fprintf(Outfile, "\tstr\t%s, [x0]\n", aarch64DwordRegisterList[r]);
+    case P_UINT:
+        aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                    aarch64DwordRegisterList[r]);
         break;
     case P_LONG:
-    case P_CHARPTR:
-    case P_INTPTR:
-    case P_LONGPTR:
-        fprintf(Outfile, "\tstr\t%s, [x0]\n", aarch64QwordRegisterList[r]);
+    case P_ULONG:
+        aarch64Emit(INSN_STORE, "\tstr\t%s, [x0]\n",
+                    aarch64QwordRegisterList[r]);
         break;
     default:
         fprintf(
@@ -417,8 +661,10 @@ int aarch64StoreLocalSymbol(int r, int id) {
  */
 static int aarch64P2AlignFor(int alignmentBytes) {
     // returns log2(alignmentBytes) for .p2align
-    // clamp to 0..4-ish if you want, but 0..3 is enough for 1/2/4/8
+    // 0..4 covers 1/2/4/8 and 16-byte vectors
     switch (alignmentBytes) {
+    case 16:
+        return 4;
     case 8:
         return 3;
     case 4:
@@ -445,8 +691,11 @@ void aarch64DeclareGlobalSymbol(int id) {
     }
 
     int primitiveType = SymbolTable[id].primitiveType;
+    if (SymbolTable[id].structuralType == S_ARRAY) {
+        primitiveType = TypeTable[primitiveType].base;
+    }
 
-    int elementSize = aarch64GetPrimitiveTypeSize(primitiveType);
+    int elementSize = getTypeSize(primitiveType);
     if (elementSize <= 0) {
         fprintf(stderr,
                 "Error: Invalid element size %d for symbol %s in "
@@ -473,15 +722,33 @@ void aarch64DeclareGlobalSymbol(int id) {
 
     long long totalBytesRequired = (long long)elementSize * (long long)count;
 
-    int alignment = (elementSize >= 8)   ? 8
-                    : (elementSize >= 4) ? 4
-                    : (elementSize >= 2) ? 2
-                                         : 1;
-    int p2 = aarch64P2AlignFor(alignment);
+    int p2 = aarch64P2AlignFor(getSymbolAlignment(id));
+
+    // A variable with an initial value lives in the data section, and one
+    // that is never stored to in the read-only data section
+    if (SymbolTable[id].isInitialized || SymbolTable[id].isReadOnly) {
+        static const char *dataDirectives[] = {
+            [1] = ".byte", [2] = ".hword", [4] = ".word", [8] = ".quad"};
+        fprintf(Outfile, SymbolTable[id].isReadOnly ? "\t.section\t.rodata\n"
+                                                   : "\t.data\n");
+        if (SymbolTable[id].class == C_GLOBAL) {
+            fprintf(Outfile, "\t.globl\t%s\n", SymbolTable[id].name);
+        }
+        if (p2 >= 0) {
+            fprintf(Outfile, "\t.p2align\t%d\n", p2);
+        }
+        fprintf(Outfile, "%s:\n", SymbolTable[id].name);
+        fprintf(Outfile, "\t%s\t%ld\n", dataDirectives[elementSize],
+                SymbolTable[id].initialValue);
+        return;
+    }
 
     // Prefer BSS for zero-initialized storage
     fprintf(Outfile, "\t.section\t.bss\n");
-    fprintf(Outfile, "\t.globl\t%s\n", SymbolTable[id].name);
+    // Statics stay local to the object file
+    if (SymbolTable[id].class == C_GLOBAL) {
+        fprintf(Outfile, "\t.globl\t%s\n", SymbolTable[id].name);
+    }
     if (p2 >= 0) {
         fprintf(Outfile, "\t.p2align\t%d\n", p2);
     }
@@ -547,6 +814,21 @@ void aarch64DeclareGlobalString(int labelIndex, char *stringValue) {
     fprintf(Outfile, "\t.byte\t0\n");
 }
 
+/**
+ * aarch64FloatOp - Generates a three-operand floating-point instruction
+ * (dst = src1 op src2) on double registers. (helper function)
+ *
+ * @param insn The instruction (e.g. "fadd").
+ * @param dst Index of the destination register.
+ * @param src1 Index of the first source register.
+ * @param src2 Index of the second source register.
+ */
+static void aarch64FloatOp(const char *insn, int dst, int src1, int src2) {
+    aarch64Emit(INSN_ALU, "\t%s\t%s, %s, %s\n", insn,
+                aarch64DoubleRegister(dst), aarch64DoubleRegister(src1),
+                aarch64DoubleRegister(src2));
+}
+
 /**
  * aarch64AddRegs - Generates code to add values in two registers.
  * (r2 = r2 + r1, free r1)
@@ -557,10 +839,15 @@ void aarch64DeclareGlobalString(int labelIndex, char *stringValue) {
  * @return Index of the register containing the result.
  */
 int aarch64AddRegs(int r1, int r2) {
-    fprintf(Outfile, "\tadd\t%s, %s, %s\n",
-            aarch64QwordRegisterList[r2], // destination
-            aarch64QwordRegisterList[r2], // source 1
-            aarch64QwordRegisterList[r1]  // source 2
+    if (aarch64IsFloatRegister(r1)) {
+        aarch64FloatOp("fadd", r2, r2, r1);
+        aarch64FreeRegister(r1);
+        return r2;
+    }
+    aarch64Emit(INSN_ALU, "\tadd\t%s, %s, %s\n",
+                aarch64QwordRegisterList[r2], // destination
+                aarch64QwordRegisterList[r2], // source 1
+                aarch64QwordRegisterList[r1]  // source 2
     );
     aarch64FreeRegister(r1);
     return r2;
@@ -576,10 +863,15 @@ int aarch64AddRegs(int r1, int r2) {
  * @return Index of the register containing the result.
  */
 int aarch64SubRegs(int r1, int r2) {
-    fprintf(Outfile, "\tsub\t%s, %s, %s\n",
-            aarch64QwordRegisterList[r1], // destination
-            aarch64QwordRegisterList[r1], // minuend
-            aarch64QwordRegisterList[r2]  // subtrahend
+    if (aarch64IsFloatRegister(r1)) {
+        aarch64FloatOp("fsub", r1, r1, r2);
+        aarch64FreeRegister(r2);
+        return r1;
+    }
+    aarch64Emit(INSN_ALU, "\tsub\t%s, %s, %s\n",
+                aarch64QwordRegisterList[r1], // destination
+                aarch64QwordRegisterList[r1], // minuend
+                aarch64QwordRegisterList[r2]  // subtrahend
     );
     aarch64FreeRegister(r2);
     return r1;
@@ -595,10 +887,15 @@ int aarch64SubRegs(int r1, int r2) {
  * @return Index of the register containing the result.
  */
 int aarch64MulRegs(int r1, int r2) {
-    fprintf(Outfile, "\tmul\t%s, %s, %s\n",
-            aarch64QwordRegisterList[r2], // destination
-            aarch64QwordRegisterList[r2], // source 1
-            aarch64QwordRegisterList[r1]  // source 2
+    if (aarch64IsFloatRegister(r1)) {
+        aarch64FloatOp("fmul", r2, r2, r1);
+        aarch64FreeRegister(r1);
+        return r2;
+    }
+    aarch64Emit(INSN_ALU, "\tmul\t%s, %s, %s\n",
+                aarch64QwordRegisterList[r2], // destination
+                aarch64QwordRegisterList[r2], // source 1
+                aarch64QwordRegisterList[r1]  // source 2
     );
     aarch64FreeRegister(r1);
     return r2;
@@ -606,7 +903,7 @@ int aarch64MulRegs(int r1, int r2) {
 
 /**
  * aarch64DivRegsSigned - Generates code to divide values in two registers.
- * (r1 = r1 / r2, free r2)
+ * (r1 = r1 / r2, free r2) Floating-point values are divided here as well.
  *
  * @param r1 Index of the dividend register.
  * @param r2 Index of the divisor register.
@@ -614,10 +911,34 @@ int aarch64MulRegs(int r1, int r2) {
  * @return Index of the register containing the result (quotient).
  */
 int aarch64DivRegsSigned(int r1, int r2) {
-    fprintf(Outfile, "\tsdiv\t%s, %s, %s\n",
-            aarch64QwordRegisterList[r1], // destination
-            aarch64QwordRegisterList[r1], // dividend
-            aarch64QwordRegisterList[r2]  // divisor
+    if (aarch64IsFloatRegister(r1)) {
+        aarch64FloatOp("fdiv", r1, r1, r2);
+        aarch64FreeRegister(r2);
+        return r1;
+    }
+    aarch64Emit(INSN_ALU, "\tsdiv\t%s, %s, %s\n",
+                aarch64QwordRegisterList[r1], // destination
+                aarch64QwordRegisterList[r1], // dividend
+                aarch64QwordRegisterList[r2]  // divisor
+    );
+    aarch64FreeRegister(r2);
+    return r1;
+}
+
+/**
+ * aarch64DivRegsUnsigned - Generates code to divide values in two registers
+ * as unsigned integers. (r1 = r1 / r2, free r2)
+ *
+ * @param r1 Index of the dividend register.
+ * @param r2 Index of the divisor register.
+ *
+ * @return Index of the register containing the result (quotient).
+ */
+int aarch64DivRegsUnsigned(int r1, int r2) {
+    aarch64Emit(INSN_ALU, "\tudiv\t%s, %s, %s\n",
+                aarch64QwordRegisterList[r1], // destination
+                aarch64QwordRegisterList[r1], // dividend
+                aarch64QwordRegisterList[r2]  // divisor
     );
     aarch64FreeRegister(r2);
     return r1;
@@ -633,8 +954,8 @@ int aarch64DivRegsSigned(int r1, int r2) {
  * @return Index of the register containing the shifted value.
  */
 int aarch64ShiftLeftConst(int reg, int shiftAmount) {
-    fprintf(Outfile, "\tlsl\t%s, %s, #%d\n", aarch64QwordRegisterList[reg],
-            aarch64QwordRegisterList[reg], shiftAmount);
+    aarch64Emit(INSN_ALU, "\tlsl\t%s, %s, #%d\n", aarch64QwordRegisterList[reg],
+                aarch64QwordRegisterList[reg], shiftAmount);
     return reg;
 }
 
@@ -648,24 +969,46 @@ int aarch64ShiftLeftConst(int reg, int shiftAmount) {
  * @return Index of the register containing the shifted value.
  */
 int aarch64ShiftLeftRegs(int dstReg, int srcReg) {
-    fprintf(Outfile, "\tlsl\t%s, %s, %s\n", aarch64QwordRegisterList[dstReg],
-            aarch64QwordRegisterList[dstReg], aarch64QwordRegisterList[srcReg]);
+    aarch64Emit(INSN_ALU, "\tlsl\t%s, %s, %s\n",
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[srcReg]);
     aarch64FreeRegister(srcReg);
     return dstReg;
 }
 
 /**
- * aarch64ShiftRightConst - Generates code to shift a register right by a
- * constant amount.
+ * aarch64ShiftRightRegsSigned - Generates code to shift a signed value right
+ * (arithmetic shift) by an amount held in another register.
  *
- * @param reg Index of the register to shift.
- * @param shiftAmount The constant amount to shift right.
+ * @param dstReg Index of the register to shift.
+ * @param srcReg Index of the register containing the shift amount.
  *
  * @return Index of the register containing the shifted value.
  */
-int aarch64ShiftRightRegs(int dstReg, int srcReg) {
-    fprintf(Outfile, "\tlsr\t%s, %s, %s\n", aarch64QwordRegisterList[dstReg],
-            aarch64QwordRegisterList[dstReg], aarch64QwordRegisterList[srcReg]);
+int aarch64ShiftRightRegsSigned(int dstReg, int srcReg) {
+    aarch64Emit(INSN_ALU, "\tasr\t%s, %s, %s\n",
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[srcReg]);
+    aarch64FreeRegister(srcReg);
+    return dstReg;
+}
+
+/**
+ * aarch64ShiftRightRegsUnsigned - Generates code to shift an unsigned value
+ * right (logical shift) by an amount held in another register.
+ *
+ * @param dstReg Index of the register to shift.
+ * @param srcReg Index of the register containing the shift amount.
+ *
+ * @return Index of the register containing the shifted value.
+ */
+int aarch64ShiftRightRegsUnsigned(int dstReg, int srcReg) {
+    aarch64Emit(INSN_ALU, "\tlsr\t%s, %s, %s\n",
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[srcReg]);
     aarch64FreeRegister(srcReg);
     return dstReg;
 }
@@ -678,8 +1021,13 @@ int aarch64ShiftRightRegs(int dstReg, int srcReg) {
  * @return Index of the register containing the negated value.
  */
 int aarch64ArithmeticNegate(int reg) {
-    fprintf(Outfile, "\tneg\t%s, %s\n", aarch64QwordRegisterList[reg],
-            aarch64QwordRegisterList[reg]);
+    if (aarch64IsFloatRegister(reg)) {
+        aarch64Emit(INSN_ALU, "\tfneg\t%s, %s\n", aarch64DoubleRegister(reg),
+                    aarch64DoubleRegister(reg));
+        return reg;
+    }
+    aarch64Emit(INSN_ALU, "\tneg\t%s, %s\n", aarch64QwordRegisterList[reg],
+                aarch64QwordRegisterList[reg]);
     return reg;
 }
 
@@ -691,11 +1039,31 @@ int aarch64ArithmeticNegate(int reg) {
  * @return Index of the register containing the inverted value.
  */
 int aarch64LogicalInvert(int reg) {
-    fprintf(Outfile, "\tmvn\t%s, %s\n", aarch64QwordRegisterList[reg],
-            aarch64QwordRegisterList[reg]);
+    aarch64Emit(INSN_ALU, "\tmvn\t%s, %s\n", aarch64QwordRegisterList[reg],
+                aarch64QwordRegisterList[reg]);
     return reg;
 }
 
+/**
+ * aarch64FloatIsNonZero - Generates code to set a general-purpose register
+ * to 1 if a floating-point register is non-zero (a NaN is non-zero) and to
+ * 0 otherwise. (helper function)
+ *
+ * @param reg Index of the floating-point register, which is freed.
+ *
+ * @return Index of the register containing 0 or 1.
+ */
+static int aarch64FloatIsNonZero(int reg) {
+    int outReg = aarch64AllocateRegister();
+
+    // Unordered (NaN) compares as "ne"
+    aarch64Emit(INSN_ALU, "\tfcmp\t%s, #0.0\n", aarch64DoubleRegister(reg));
+    aarch64Emit(INSN_ALU, "\tcset\t%s, ne\n",
+                aarch64DwordRegisterList[outReg]);
+    aarch64FreeRegister(reg);
+    return outReg;
+}
+
 /**
  * aarch64LogicalNot - Generates code to logical-NOT a register (1 if zero,
  * else 0).
@@ -705,8 +1073,11 @@ int aarch64LogicalInvert(int reg) {
  * @return Index of the register containing the boolean result.
  */
 int aarch64LogicalNot(int reg) {
-    fprintf(Outfile, "\tcmp\t%s, #0\n", aarch64QwordRegisterList[reg]);
-    fprintf(Outfile, "\tcset\t%s, eq\n", aarch64DwordRegisterList[reg]);
+    if (aarch64IsFloatRegister(reg)) {
+        reg = aarch64FloatIsNonZero(reg);
+    }
+    aarch64Emit(INSN_ALU, "\tcmp\t%s, #0\n", aarch64QwordRegisterList[reg]);
+    aarch64Emit(INSN_ALU, "\tcset\t%s, eq\n", aarch64DwordRegisterList[reg]);
     return reg;
 }
 
@@ -714,8 +1085,10 @@ int aarch64LogicalNot(int reg) {
  * aarch64BitwiseAndRegs - Bitwise AND two registers (dst &= src).
  */
 int aarch64BitwiseAndRegs(int dstReg, int srcReg) {
-    fprintf(Outfile, "\tand\t%s, %s, %s\n", aarch64QwordRegisterList[dstReg],
-            aarch64QwordRegisterList[dstReg], aarch64QwordRegisterList[srcReg]);
+    aarch64Emit(INSN_ALU, "\tand\t%s, %s, %s\n",
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[srcReg]);
     aarch64FreeRegister(srcReg);
     return dstReg;
 }
@@ -724,8 +1097,10 @@ int aarch64BitwiseAndRegs(int dstReg, int srcReg) {
  * aarch64BitwiseOrRegs - Bitwise OR two registers (dst |= src).
  */
 int aarch64BitwiseOrRegs(int dstReg, int srcReg) {
-    fprintf(Outfile, "\torr\t%s, %s, %s\n", aarch64QwordRegisterList[dstReg],
-            aarch64QwordRegisterList[dstReg], aarch64QwordRegisterList[srcReg]);
+    aarch64Emit(INSN_ALU, "\torr\t%s, %s, %s\n",
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[srcReg]);
     aarch64FreeRegister(srcReg);
     return dstReg;
 }
@@ -734,8 +1109,10 @@ int aarch64BitwiseOrRegs(int dstReg, int srcReg) {
  * aarch64BitwiseXorRegs - Bitwise XOR two registers (dst ^= src).
  */
 int aarch64BitwiseXorRegs(int dstReg, int srcReg) {
-    fprintf(Outfile, "\teor\t%s, %s, %s\n", aarch64QwordRegisterList[dstReg],
-            aarch64QwordRegisterList[dstReg], aarch64QwordRegisterList[srcReg]);
+    aarch64Emit(INSN_ALU, "\teor\t%s, %s, %s\n",
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[dstReg],
+                aarch64QwordRegisterList[srcReg]);
     aarch64FreeRegister(srcReg);
     return dstReg;
 }
@@ -743,19 +1120,56 @@ int aarch64BitwiseXorRegs(int dstReg, int srcReg) {
 /**
  * aarch64ToBoolean - Convert a register to boolean, optionally branching.
  *
- * If op is A_IF/A_WHILE, branch to label when zero. Otherwise, set reg to
- * 0/1 based on non-zeroness.
+ * If op is A_IF/A_WHILE, branch to label when zero; if op is A_DOWHILE,
+ * branch to label when non-zero. Otherwise, set reg to 0/1 based on
+ * non-zeroness. A floating-point value gives its 0/1 in a general-purpose
+ * register.
  */
 int aarch64ToBoolean(int reg, int op, int label) {
-    fprintf(Outfile, "\tcmp\t%s, #0\n", aarch64QwordRegisterList[reg]);
+    if (aarch64IsFloatRegister(reg)) {
+        reg = aarch64FloatIsNonZero(reg);
+    }
+    aarch64Emit(INSN_ALU, "\tcmp\t%s, #0\n", aarch64QwordRegisterList[reg]);
     if (op == A_IF || op == A_WHILE) {
-        fprintf(Outfile, "\tbeq\tL%d\n", label);
+        aarch64Emit(INSN_BRANCH, "\tbeq\tL%d\n", label);
+    } else if (op == A_DOWHILE) {
+        aarch64Emit(INSN_BRANCH, "\tbne\tL%d\n", label);
     } else {
-        fprintf(Outfile, "\tcset\t%s, ne\n", aarch64DwordRegisterList[reg]);
+        aarch64Emit(INSN_ALU, "\tcset\t%s, ne\n",
+                    aarch64DwordRegisterList[reg]);
     }
     return reg;
 }
 
+/**
+ * aarch64FloatCondition - Returns the condition code that is true after
+ * "fcmp r1, r2" when the comparison holds. (helper function)
+ *
+ * NOTE:
+ * An unordered compare (a NaN operand) sets C and V, so "mi" and "ls" are
+ * used for "<" and "<=": they are false for a NaN, like "gt" and "ge".
+ *
+ * @param ASTop The AST operation code representing the comparison.
+ *
+ * @return The condition code.
+ */
+static const char *aarch64FloatCondition(int ASTop) {
+    switch (ASTop) {
+    case A_EQ:
+        return "eq";
+    case A_NE:
+        return "ne";
+    case A_LT:
+        return "mi";
+    case A_LE:
+        return "ls";
+    case A_GT:
+        return "gt";
+    default: // A_GE
+        return "ge";
+    }
+}
+
 /**
  * aarch64CompareAndSet - Generates code to compare two registers and set a
  * third register based on the comparison result. (Compare and set 0/1 in r2,
@@ -764,10 +1178,13 @@ int aarch64ToBoolean(int reg, int op, int label) {
  * @param ASTop The AST operation code representing the comparison.
  * @param r1 Index of the first register.
  * @param r2 Index of the second register.
+ * @param primitiveType The type of the compared values.
  *
  * @return Index of the register containing the comparison result (0 or 1).
  */
-int aarch64CompareAndSet(int ASTop, int r1, int r2) {
+int aarch64CompareAndSet(int ASTop, int r1, int r2, int primitiveType) {
+    bool isUnsigned = isUnsignedType(primitiveType);
+
     if (!((ASTop == A_EQ) || (ASTop == A_NE) || (ASTop == A_LT) ||
           (ASTop == A_LE) || (ASTop == A_GT) || (ASTop == A_GE))) {
         fprintf(stderr,
@@ -776,8 +1193,20 @@ int aarch64CompareAndSet(int ASTop, int r1, int r2) {
         exit(1);
     }
 
-    fprintf(Outfile, "\tcmp\t%s, %s\n", aarch64QwordRegisterList[r1],
-            aarch64QwordRegisterList[r2]);
+    if (isFloatType(primitiveType)) {
+        int outReg = aarch64AllocateRegister();
+        aarch64Emit(INSN_ALU, "\tfcmp\t%s, %s\n", aarch64DoubleRegister(r1),
+                    aarch64DoubleRegister(r2));
+        aarch64Emit(INSN_ALU, "\tcset\t%s, %s\n",
+                    aarch64DwordRegisterList[outReg],
+                    aarch64FloatCondition(ASTop));
+        aarch64FreeRegister(r1);
+        aarch64FreeRegister(r2);
+        return outReg;
+    }
+
+    aarch64Emit(INSN_ALU, "\tcmp\t%s, %s\n", aarch64QwordRegisterList[r1],
+                aarch64QwordRegisterList[r2]);
 
     const char *condition = NULL;
     switch (ASTop) {
@@ -788,16 +1217,16 @@ int aarch64CompareAndSet(int ASTop, int r1, int r2) {
         condition = "ne";
         break;
     case A_LT:
-        condition = "lt";
-        break; // signed
+        condition = isUnsigned ? "lo" : "lt";
+        break;
     case A_LE:
-        condition = "le";
+        condition = isUnsigned ? "ls" : "le";
         break;
     case A_GT:
-        condition = "gt";
+        condition = isUnsigned ? "hi" : "gt";
         break;
     case A_GE:
-        condition = "ge";
+        condition = isUnsigned ? "hs" : "ge";
         break;
     default:
         fprintf(stderr,
@@ -807,8 +1236,8 @@ int aarch64CompareAndSet(int ASTop, int r1, int r2) {
     }
 
     // cset wN, condition => wN = 0 or 1, high bits of xN are zeroed.
-    fprintf(Outfile, "\tcset\t%s, %s\n", aarch64DwordRegisterList[r2],
-            condition);
+    aarch64Emit(INSN_ALU, "\tcset\t%s, %s\n", aarch64DwordRegisterList[r2],
+                condition);
 
     aarch64FreeRegister(r1);
     return r2;
@@ -816,18 +1245,94 @@ int aarch64CompareAndSet(int ASTop, int r1, int r2) {
 
 /**
  * aarch64WidenPrimitiveType - In AArch64, all integer types are treated as
- * 64-bit, so no action is needed.
+ * 64-bit and loads already sign- or zero-extend, so only conversions from and
+ * to unsigned int need work: they clear bits 32-63 of the register. A
+ * negative short becomes an unsigned int the same way. A conversion to a
+ * narrower type truncates the value and extends it again, as a load of
+ * that type would.
+ *
+ * Conversions to and from floating-point types move the value between a
+ * general-purpose and a SIMD&FP register. Floating-point values are held as
+ * doubles, so float <-> double needs no code; an integer converted to float
+ * is rounded to float once, and a conversion to an integer truncates.
  *
- * @param r Index of the register containing the value. (ignored)
- * @param oldPrimitiveType The original primitive type. (ignored)
- * @param newPrimitiveType The new primitive type. (ignored)
+ * @param r Index of the register containing the value.
+ * @param oldPrimitiveType The original primitive type.
+ * @param newPrimitiveType The new primitive type.
  *
  * @return Index of the register containing the value.
  */
 int aarch64WidenPrimitiveType(int r, int oldPrimitiveType,
                               int newPrimitiveType) {
-    (void)oldPrimitiveType;
-    (void)newPrimitiveType;
+    int outReg;
+
+    if (isFloatType(oldPrimitiveType)) {
+        if (isFloatType(newPrimitiveType)) {
+            return r;
+        }
+        outReg = aarch64AllocateRegister();
+        aarch64Emit(INSN_ALU, "\tfcvtzs\t%s, %s\n",
+                    aarch64QwordRegisterList[outReg], aarch64DoubleRegister(r));
+        aarch64FreeRegister(r);
+        return outReg;
+    }
+    if (isFloatType(newPrimitiveType)) {
+        // Registers hold integers sign- or zero-extended to 64 bits
+        outReg = aarch64AllocateFloatRegister();
+        aarch64Emit(INSN_ALU, "\t%s\t%s, %s\n",
+                    (oldPrimitiveType == P_ULONG) ? "ucvtf" : "scvtf",
+                    (newPrimitiveType == P_FLOAT)
+                        ? aarch64SingleRegister(outReg)
+                        : aarch64DoubleRegister(outReg),
+                    aarch64QwordRegisterList[r]);
+        if (newPrimitiveType == P_FLOAT) {
+            aarch64Emit(INSN_ALU, "\tfcvt\t%s, %s\n",
+                        aarch64DoubleRegister(outReg),
+                        aarch64SingleRegister(outReg));
+        }
+        aarch64FreeRegister(r);
+        return outReg;
+    }
+
+    if (getTypeSize(newPrimitiveType) < getTypeSize(oldPrimitiveType)) {
+        switch (newPrimitiveType) {
+        case P_CHAR:
+        case P_UCHAR:
+            aarch64Emit(INSN_ALU, "\tuxtb\t%s, %s\n",
+                        aarch64DwordRegisterList[r],
+                        aarch64DwordRegisterList[r]);
+            break;
+        case P_SHORT:
+            aarch64Emit(INSN_ALU, "\tsxth\t%s, %s\n",
+                        aarch64QwordRegisterList[r],
+                        aarch64DwordRegisterList[r]);
+            break;
+        case P_USHORT:
+            aarch64Emit(INSN_ALU, "\tuxth\t%s, %s\n",
+                        aarch64DwordRegisterList[r],
+                        aarch64DwordRegisterList[r]);
+            break;
+        case P_INT:
+            aarch64Emit(INSN_ALU, "\tsxtw\t%s, %s\n",
+                        aarch64QwordRegisterList[r],
+                        aarch64DwordRegisterList[r]);
+            break;
+        default: // P_UINT
+            aarch64Emit(INSN_ALU, "\tmov\t%s, %s\n",
+                        aarch64DwordRegisterList[r],
+                        aarch64DwordRegisterList[r]);
+            break;
+        }
+        return r;
+    }
+
+    if (oldPrimitiveType == P_UINT ||
+        ((oldPrimitiveType == P_INT || oldPrimitiveType == P_SHORT) &&
+         newPrimitiveType == P_UINT)) {
+        // Writing a w-register zeroes the upper half of the x-register
+        aarch64Emit(INSN_ALU, "\tmov\t%s, %s\n", aarch64DwordRegisterList[r],
+                    aarch64DwordRegisterList[r]);
+    }
     return r;
 }
 
@@ -842,11 +1347,11 @@ int aarch64AddressOfSymbol(int id) {
     if (SymbolTable[id].class == C_LOCAL) {
         int offset = SymbolTable[id].offset;
         if (offset >= 0) {
-            fprintf(Outfile, "\tadd\t%s, x29, #%d\n",
-                    aarch64QwordRegisterList[r], offset);
+            aarch64Emit(INSN_ALU, "\tadd\t%s, x29, #%d\n",
+                        aarch64QwordRegisterList[r], offset);
         } else {
-            fprintf(Outfile, "\tsub\t%s, x29, #%d\n",
-                    aarch64QwordRegisterList[r], -offset);
+            aarch64Emit(INSN_ALU, "\tsub\t%s, x29, #%d\n",
+                        aarch64QwordRegisterList[r], -offset);
         }
         return r;
     }
@@ -854,38 +1359,105 @@ int aarch64AddressOfSymbol(int id) {
     // PC-relative addressing:
     //   adrp xN, name             ; compute page address
     //   add  xN, xN, :lo12:name   ; add page offset
-    fprintf(Outfile, "\tadrp\t%s, %s\n", aarch64QwordRegisterList[r],
-            SymbolTable[id].name);
-    fprintf(Outfile, "\tadd\t%s, %s, :lo12:%s\n", aarch64QwordRegisterList[r],
-            aarch64QwordRegisterList[r], SymbolTable[id].name);
+    aarch64Emit(INSN_ALU, "\tadrp\t%s, %s\n", aarch64QwordRegisterList[r],
+                SymbolTable[id].name);
+    aarch64Emit(INSN_ALU, "\tadd\t%s, %s, :lo12:%s\n",
+                aarch64QwordRegisterList[r], aarch64QwordRegisterList[r],
+                SymbolTable[id].name);
     return r;
 }
 
+/**
+ * aarch64IndirectOperand - Formats the memory operand addressing a pointer
+ * register plus a constant displacement (e.g. "[x9]" or "[x9, #12]").
+ *
+ * NOTE:
+ * ldr/str take an unsigned 12-bit offset scaled by the access size. Struct
+ * members are naturally aligned, so only the range needs checking.
+ * Returns a static buffer that is overwritten by the next call.
+ *
+ * @param pointerReg Index of the register containing the pointer.
+ * @param offset Constant byte displacement.
+ * @param accessSize Size of the loaded or stored value in bytes.
+ *
+ * @return The memory operand.
+ */
+static const char *aarch64IndirectOperand(int pointerReg, int offset,
+                                          int accessSize) {
+    static char operand[32];
+
+    if (offset == 0) {
+        snprintf(operand, sizeof(operand), "[%s]",
+                 aarch64QwordRegisterList[pointerReg]);
+        return operand;
+    }
+
+    if (offset < 0 || offset % accessSize != 0 ||
+        offset / accessSize > 4095) {
+        logFatald("Member offset out of range for aarch64 ldr/str: ",
+                  offset);
+    }
+    snprintf(operand, sizeof(operand), "[%s, #%d]",
+             aarch64QwordRegisterList[pointerReg], offset);
+    return operand;
+}
+
 /**
  * aarch64DereferencePointer - Generates code to dereference a pointer in a
  * register and load the value into the same register.
  *
  * @param pointerReg Index of the register containing the pointer.
+ * @param offset Constant byte displacement added to the pointer.
  * @param primitiveType The primitive type of the value being loaded.
  *
  * @return Index of the register containing the loaded value.
  */
-int aarch64DereferencePointer(int pointerReg, int primitiveType) {
+int aarch64DereferencePointer(int pointerReg, int offset, int primitiveType) {
     const char *x = aarch64QwordRegisterList[pointerReg];
     const char *w = aarch64DwordRegisterList[pointerReg];
+    int r;
 
-    switch (primitiveType) {
-    case P_CHARPTR:
+    if (isFloatType(primitiveType)) {
+        r = aarch64LoadFloatMemory(
+            aarch64IndirectOperand(pointerReg, offset,
+                                   aarch64GetPrimitiveTypeSize(primitiveType)),
+            primitiveType);
+        aarch64FreeRegister(pointerReg);
+        return r;
+    }
+
+    switch (getMemoryAccessType(primitiveType)) {
+    case P_CHAR:
+    case P_UCHAR:
         // zero-extend byte into wN (upper bites cleared)
-        fprintf(Outfile, "\tldrb\t%s, [%s]\n", w, x);
+        aarch64Emit(INSN_LOAD, "\tldrb\t%s, %s\n", w,
+                    aarch64IndirectOperand(pointerReg, offset, 1));
+        break;
+    case P_SHORT:
+        // sign-extend 16-bit into xN
+        aarch64Emit(INSN_LOAD, "\tldrsh\t%s, %s\n", x,
+                    aarch64IndirectOperand(pointerReg, offset, 2));
+        break;
+    case P_USHORT:
+        // zero-extend 16-bit into wN (upper bits cleared)
+        aarch64Emit(INSN_LOAD, "\tldrh\t%s, %s\n", w,
+                    aarch64IndirectOperand(pointerReg, offset, 2));
+        break;
+    case P_INT:
+        // sign-extend 32-bit into xN
+        aarch64Emit(INSN_LOAD, "\tldrsw\t%s, %s\n", x,
+                    aarch64IndirectOperand(pointerReg, offset, 4));
         break;
-    case P_INTPTR:
+    case P_UINT:
         // loads 32-bit into wN (upper bits cleared)
-        fprintf(Outfile, "\tldr\t%s, [%s]\n", w, x);
+        aarch64Emit(INSN_LOAD, "\tldr\t%s, %s\n", w,
+                    aarch64IndirectOperand(pointerReg, offset, 4));
         break;
-    case P_LONGPTR:
+    case P_LONG:
+    case P_ULONG:
         // loads 64-bit into xN
-        fprintf(Outfile, "\tldr\t%s, [%s]\n", x, x);
+        aarch64Emit(INSN_LOAD, "\tldr\t%s, %s\n", x,
+                    aarch64IndirectOperand(pointerReg, offset, 8));
         break;
     default:
         fprintf(stderr,
@@ -904,35 +1476,53 @@ int aarch64DereferencePointer(int pointerReg, int primitiveType) {
  *
  * @param valueReg Index of the register containing the value to store.
  * @param pointerReg Index of the register containing the pointer (address).
+ * @param offset Constant byte displacement added to the pointer.
  * @param primitiveType The primitive type of the value being stored.
  *
  * @return Index of the register that was stored.
  */
-int aarch64StoreDereferencedPointer(int valueReg, int pointerReg,
+int aarch64StoreDereferencedPointer(int valueReg, int pointerReg, int offset,
                                     int primitiveType) {
-    switch (primitiveType) {
+    if (isFloatType(primitiveType)) {
+        aarch64StoreFloatMemory(
+            valueReg,
+            aarch64IndirectOperand(pointerReg, offset,
+                                   aarch64GetPrimitiveTypeSize(primitiveType)),
+            primitiveType);
+        return valueReg;
+    }
+
+    switch (getMemoryAccessType(primitiveType)) {
     case P_CHAR:
+    case P_UCHAR:
         // Store 1 byte: uses W register, low 8 bits written.
-        fprintf(Outfile, "\tstrb\t%s, [%s]\n",
-                aarch64DwordRegisterList[valueReg],  // source (wN)
-                aarch64QwordRegisterList[pointerReg] // address (xM)
-        );
+        aarch64Emit(INSN_STORE, "\tstrb\t%s, %s\n",
+                    aarch64DwordRegisterList[valueReg], // source (wN)
+                    aarch64IndirectOperand(pointerReg, offset, 1));
+        break;
+
+    case P_SHORT:
+    case P_USHORT:
+        // Store 2 bytes: STRH Wt, [Xn, #imm]
+        aarch64Emit(INSN_STORE, "\tstrh\t%s, %s\n",
+                    aarch64DwordRegisterList[valueReg], // source (wN)
+                    aarch64IndirectOperand(pointerReg, offset, 2));
         break;
 
     case P_INT:
-        // Store 4 bytes: STR Wt, [Xn]
-        fprintf(Outfile, "\tstr\t%s, [%s]\n",
-                aarch64DwordRegisterList[valueReg],  // source (wN)
-                aarch64QwordRegisterList[pointerReg] // address (xM)
-        );
+    case P_UINT:
+        // Store 4 bytes: STR Wt, [Xn, #imm]
+        aarch64Emit(INSN_STORE, "\tstr\t%s, %s\n",
+                    aarch64DwordRegisterList[valueReg], // source (wN)
+                    aarch64IndirectOperand(pointerReg, offset, 4));
         break;
 
     case P_LONG:
-        // Store 8 bytes: STR Xt, [Xn]
-        fprintf(Outfile, "\tstr\t%s, [%s]\n",
-                aarch64QwordRegisterList[valueReg],  // source (xN)
-                aarch64QwordRegisterList[pointerReg] // address (xM)
-        );
+    case P_ULONG:
+        // Store 8 bytes: STR Xt, [Xn, #imm]
+        aarch64Emit(INSN_STORE, "\tstr\t%s, %s\n",
+                    aarch64QwordRegisterList[valueReg], // source (xN)
+                    aarch64IndirectOperand(pointerReg, offset, 8));
         break;
 
     default:
@@ -945,3 +1535,695 @@ int aarch64StoreDereferencedPointer(int valueReg, int pointerReg,
 
     return valueReg;
 }
+
+/**
+ * aarch64VectorArrangement - Returns the NEON arrangement specifier that
+ * views a 128-bit register as the lanes of a vector type. (helper function)
+ *
+ * @param vectorType The vector type.
+ *
+ * @return "16b", "8h", "4s" or "2d".
+ */
+static const char *aarch64VectorArrangement(int vectorType) {
+    switch (getTypeSize(TypeTable[vectorType].base)) {
+    case 1:
+        return "16b";
+    case 2:
+        return "8h";
+    case 4:
+        return "4s";
+    default:
+        return "2d";
+    }
+}
+
+/**
+ * aarch64LoadVectorMemory - Generates code to load a vector from a memory
+ * operand into a new SIMD&FP register. (helper function)
+ *
+ * @param address The memory operand (e.g. "[x0]" or "[x9, #16]").
+ *
+ * @return Index of the register containing the vector.
+ */
+static int aarch64LoadVectorMemory(const char *address) {
+    int r = aarch64AllocateFloatRegister();
+
+    aarch64Emit(INSN_LOAD, "\tldr\t%s, %s\n", aarch64QuadRegister(r),
+                address);
+    return r;
+}
+
+/**
+ * aarch64VectorLoad - Generates code to load a vector through a pointer.
+ *
+ * @param pointerReg Index of the register containing the (16-byte
+ *                   aligned) address; it is freed.
+ * @param offset Constant byte displacement added to the pointer.
+ * @param vectorType The vector type.
+ *
+ * @return Index of the SIMD&FP register containing the vector.
+ */
+int aarch64VectorLoad(int pointerReg, int offset, int vectorType) {
+    int r = aarch64LoadVectorMemory(aarch64IndirectOperand(
+        pointerReg, offset, getTypeSize(vectorType)));
+
+    aarch64FreeRegister(pointerReg);
+    return r;
+}
+
+/**
+ * aarch64VectorStore - Generates code to store a vector through a pointer.
+ *
+ * @param valueReg Index of the SIMD&FP register containing the vector.
+ * @param pointerReg Index of the register containing the (16-byte
+ *                   aligned) address; it is freed.
+ * @param offset Constant byte displacement added to the pointer.
+ * @param vectorType The vector type.
+ *
+ * @return Index of the register that was stored.
+ */
+int aarch64VectorStore(int valueReg, int pointerReg, int offset,
+                       int vectorType) {
+    aarch64Emit(INSN_STORE, "\tstr\t%s, %s\n", aarch64QuadRegister(valueReg),
+                aarch64IndirectOperand(pointerReg, offset,
+                                       getTypeSize(vectorType)));
+    aarch64FreeRegister(pointerReg);
+    return valueReg;
+}
+
+/**
+ * aarch64VectorBinary - Generates code for a lane-by-lane operation on two
+ * vectors, or for a shift of every lane of a vector.
+ *
+ * NOTE:
+ * NEON has no shift of all lanes by a register count, only by a vector
+ * of counts: the count is duplicated into every lane and used with
+ * sshl/ushl, negated first for a right shift (a negative count shifts
+ * right, arithmetically for sshl and logically for ushl).
+ *
+ * @param ASTop The operation (see isVectorOperationSupported()).
+ * @param r1 Index of the SIMD&FP register of the left vector.
+ * @param r2 Index of the SIMD&FP register of the right vector, or of the
+ *           general-purpose register of a shift count.
+ * @param vectorType The vector type.
+ *
+ * @return Index of the register containing the result (r1).
+ */
+int aarch64VectorBinary(int ASTop, int r1, int r2, int vectorType) {
+    int lane = TypeTable[vectorType].base;
+    const char *arrangement = aarch64VectorArrangement(vectorType);
+    const char *insn;
+    int count;
+    int v1 = aarch64VectorRegisterNumber(r1);
+
+    if (ASTop == A_LSHIFT || ASTop == A_RSHIFT) {
+        count = aarch64AllocateFloatRegister();
+        aarch64Emit(INSN_ALU, "\tdup\tv%d.%s, %s\n",
+                    aarch64VectorRegisterNumber(count), arrangement,
+                    getTypeSize(lane) == 8 ? aarch64QwordRegisterList[r2]
+                                           : aarch64DwordRegisterList[r2]);
+        if (ASTop == A_RSHIFT) {
+            aarch64Emit(INSN_ALU, "\tneg\tv%d.%s, v%d.%s\n",
+                        aarch64VectorRegisterNumber(count), arrangement,
+                        aarch64VectorRegisterNumber(count), arrangement);
+        }
+        aarch64Emit(INSN_ALU, "\t%s\tv%d.%s, v%d.%s, v%d.%s\n",
+                    isUnsignedType(lane) ? "ushl" : "sshl", v1, arrangement,
+                    v1, arrangement, aarch64VectorRegisterNumber(count),
+                    arrangement);
+        aarch64FreeRegister(count);
+        aarch64FreeRegister(r2);
+        return r1;
+    }
+
+    switch (ASTop) {
+    case A_ADD:
+        insn = isFloatType(lane) ? "fadd" : "add";
+        break;
+    case A_SUBTRACT:
+        insn = isFloatType(lane) ? "fsub" : "sub";
+        break;
+    case A_MULTIPLY:
+        insn = isFloatType(lane) ? "fmul" : "mul";
+        break;
+    case A_DIVIDE:
+        insn = "fdiv";
+        break;
+    case A_BITWISEAND:
+        insn = "and";
+        arrangement = "16b";
+        break;
+    case A_BITWISEOR:
+        insn = "orr";
+        arrangement = "16b";
+        break;
+    default:
+        insn = "eor";
+        arrangement = "16b";
+        break;
+    }
+
+    aarch64Emit(INSN_ALU, "\t%s\tv%d.%s, v%d.%s, v%d.%s\n", insn, v1,
+                arrangement, v1, arrangement, aarch64VectorRegisterNumber(r2),
+                arrangement);
+    aarch64FreeRegister(r2);
+    return r1;
+}
+
+/**
+ * aarch64VectorSplat - Generates code to copy a scalar into every lane of
+ * a vector.
+ *
+ * NOTE:
+ * An integer is duplicated from its general-purpose register. A
+ * floating-point scalar is already in a SIMD&FP register as a double; it
+ * is rounded to float first for float lanes, then duplicated from lane 0.
+ *
+ * @param reg Index of the register containing the scalar.
+ * @param vectorType The vector type.
+ *
+ * @return Index of the SIMD&FP register containing the vector.
+ */
+int aarch64VectorSplat(int reg, int vectorType) {
+    int lane = TypeTable[vectorType].base;
+    const char *arrangement = aarch64VectorArrangement(vectorType);
+    int v;
+
+    if (lane == P_FLOAT) {
+        aarch64Emit(INSN_ALU, "\tfcvt\t%s, %s\n", aarch64SingleRegister(reg),
+                    aarch64DoubleRegister(reg));
+    }
+    if (isFloatType(lane)) {
+        v = aarch64VectorRegisterNumber(reg);
+        aarch64Emit(INSN_ALU, "\tdup\tv%d.%s, v%d.%s[0]\n", v, arrangement, v,
+                    lane == P_FLOAT ? "s" : "d");
+        return reg;
+    }
+
+    v = aarch64AllocateFloatRegister();
+    aarch64Emit(INSN_ALU, "\tdup\tv%d.%s, %s\n",
+                aarch64VectorRegisterNumber(v), arrangement,
+                getTypeSize(lane) == 8 ? aarch64QwordRegisterList[reg]
+                                       : aarch64DwordRegisterList[reg]);
+    aarch64FreeRegister(reg);
+    return v;
+}
+
+/**
+ * aarch64CompoundAssign - Generates code for "memory = memory op value".
+ *
+ * NOTE:
+ * AArch64 has no memory-destination arithmetic, so this is a load, one
+ * operation and a store through the same, already computed, address.
+ * Small "+=" / "-=" constants and constant shift counts are encoded as
+ * immediates; other constants are loaded into a register first.
+ * Floating-point values and vectors are loaded, operated on and stored
+ * back; their value is always in a register.
+ *
+ * @param ASTop The binary operation (e.g. A_ADD).
+ * @param reg Index of the register holding the value, or NOREG.
+ * @param immediate The value when reg is NOREG.
+ * @param address The memory operand (e.g. "[x0]" or "[x9, #4]").
+ * @param primitiveType The primitive type of the value in memory.
+ */
+static void aarch64CompoundAssign(int ASTop, int reg, int immediate,
+                                  const char *address, int primitiveType) {
+    int type = getMemoryAccessType(primitiveType);
+    const char *insn = NULL;
+    int tmp;
+    const char *x;
+    const char *w;
+
+    if (isVectorType(type)) {
+        tmp = aarch64LoadVectorMemory(address);
+        tmp = aarch64VectorBinary(ASTop, tmp, reg, type);
+        aarch64Emit(INSN_STORE, "\tstr\t%s, %s\n", aarch64QuadRegister(tmp),
+                    address);
+        aarch64FreeRegister(tmp);
+        return;
+    }
+    if (isFloatType(type)) {
+        static const char *floatInsns[] = {[A_ADD] = "fadd",
+                                           [A_SUBTRACT] = "fsub",
+                                           [A_MULTIPLY] = "fmul",
+                                           [A_DIVIDE] = "fdiv"};
+        tmp = aarch64LoadFloatMemory(address, type);
+        aarch64FloatOp(floatInsns[ASTop], tmp, tmp, reg);
+        aarch64StoreFloatMemory(tmp, address, type);
+        aarch64FreeRegister(tmp);
+        aarch64FreeRegister(reg);
+        return;
+    }
+
+    tmp = aarch64AllocateRegister();
+    x = aarch64QwordRegisterList[tmp];
+    w = aarch64DwordRegisterList[tmp];
+
+    switch (type) {
+    case P_CHAR:
+    case P_UCHAR:
+        aarch64Emit(INSN_LOAD, "\tldrb\t%s, %s\n", w, address);
+        break;
+    case P_SHORT:
+        aarch64Emit(INSN_LOAD, "\tldrsh\t%s, %s\n", x, address);
+        break;
+    case P_USHORT:
+        aarch64Emit(INSN_LOAD, "\tldrh\t%s, %s\n", w, address);
+        break;
+    case P_INT:
+        aarch64Emit(INSN_LOAD, "\tldrsw\t%s, %s\n", x, address);
+        break;
+    case P_UINT:
+        aarch64Emit(INSN_LOAD, "\tldr\t%s, %s\n", w, address);
+        break;
+    default:
+        aarch64Emit(INSN_LOAD, "\tldr\t%s, %s\n", x, address);
+        break;
+    }
+
+    switch (ASTop) {
+    case A_ADD:
+        insn = "add";
+        break;
+    case A_SUBTRACT:
+        insn = "sub";
+        break;
+    case A_MULTIPLY:
+        insn = "mul";
+        break;
+    case A_DIVIDE:
+        insn = isUnsignedType(type) ? "udiv" : "sdiv";
+        break;
+    case A_BITWISEAND:
+        insn = "and";
+        break;
+    case A_BITWISEOR:
+        insn = "orr";
+        break;
+    case A_BITWISEXOR:
+        insn = "eor";
+        break;
+    case A_LSHIFT:
+        insn = "lsl";
+        break;
+    case A_RSHIFT:
+        insn = isUnsignedType(type) ? "lsr" : "asr";
+        break;
+    default:
+        logFatald("Bad operation in aarch64CompoundAssign: ", ASTop);
+    }
+
+    if (reg == NOREG &&
+        (((ASTop == A_ADD || ASTop == A_SUBTRACT) && immediate >= 0 &&
+          immediate <= 4095) ||
+         ((ASTop == A_LSHIFT || ASTop == A_RSHIFT) && immediate >= 0 &&
+          immediate <= 63))) {
+        aarch64Emit(INSN_ALU, "\t%s\t%s, %s, #%d\n", insn, x, x, immediate);
+    } else {
+        if (reg == NOREG) {
+            reg = aarch64LoadImmediateInt(immediate, type);
+        }
+        aarch64Emit(INSN_ALU, "\t%s\t%s, %s, %s\n", insn, x, x,
+                    aarch64QwordRegisterList[reg]);
+        aarch64FreeRegister(reg);
+    }
+
+    switch (type) {
+    case P_CHAR:
+    case P_UCHAR:
+        aarch64Emit(INSN_STORE, "\tstrb\t%s, %s\n", w, address);
+        break;
+    case P_SHORT:
+    case P_USHORT:
+        aarch64Emit(INSN_STORE, "\tstrh\t%s, %s\n", w, address);
+        break;
+    case P_INT:
+    case P_UINT:
+        aarch64Emit(INSN_STORE, "\tstr\t%s, %s\n", w, address);
+        break;
+    default:
+        aarch64Emit(INSN_STORE, "\tstr\t%s, %s\n", x, address);
+        break;
+    }
+    aarch64FreeRegister(tmp);
+}
+
+/**
+ * aarch64CompoundAssignSymbol - Generates code for a compound assignment to
+ * a local or global scalar variable, addressed once through x0.
+ *
+ * @param ASTop The binary operation (e.g. A_ADD).
+ * @param reg Index of the register holding the value, or NOREG.
+ * @param immediate The value when reg is NOREG.
+ * @param id The ID of the symbol in the symbol table.
+ */
+void aarch64CompoundAssignSymbol(int ASTop, int reg, int immediate, int id) {
+    if (SymbolTable[id].class == C_LOCAL) {
+        aarch64LoadLocalAddressIntoX0(id);
+    } else {
+        aarch64LoadGlobalAddressIntoX0(SymbolTable[id].name);
+    }
+    aarch64CompoundAssign(ASTop, reg, immediate, "[x0]",
+                          SymbolTable[id].primitiveType);
+}
+
+/**
+ * aarch64CompoundAssignDereferencedPointer - Generates code for a compound
+ * assignment through a pointer. The pointer register is left intact.
+ *
+ * @param ASTop The binary operation (e.g. A_ADD).
+ * @param reg Index of the register holding the value, or NOREG.
+ * @param immediate The value when reg is NOREG.
+ * @param pointerReg Index of the register containing the pointer.
+ * @param offset Constant byte displacement added to the pointer.
+ * @param primitiveType The primitive type of the value in memory.
+ */
+void aarch64CompoundAssignDereferencedPointer(int ASTop, int reg,
+                                              int immediate, int pointerReg,
+                                              int offset, int primitiveType) {
+    char address[32];
+
+    // Copy the operand: aarch64IndirectOperand() reuses its buffer
+    snprintf(address, sizeof(address), "%s",
+             aarch64IndirectOperand(pointerReg, offset,
+                                    getTypeSize(primitiveType)));
+    aarch64CompoundAssign(ASTop, reg, immediate, address, primitiveType);
+}
+
+/**
+ * aarch64AtomicRegister - Name of a register at the width of an atomic int
+ * or long object. (helper function)
+ *
+ * @param reg Index of the register.
+ * @param primitiveType The type of the object.
+ *
+ * @return The wN or xN register name.
+ */
+static char *aarch64AtomicRegister(int reg, int primitiveType) {
+    return (getTypeSize(primitiveType) == 4) ? aarch64DwordRegisterList[reg]
+                                             : aarch64QwordRegisterList[reg];
+}
+
+/**
+ * aarch64SignExtendAtomicInt - Generates code to sign-extend an int that a
+ * 32-bit atomic access left zero-extended in a register, as an int is
+ * kept in registers. (helper function)
+ *
+ * @param reg Index of the register.
+ * @param primitiveType The type of the object.
+ */
+static void aarch64SignExtendAtomicInt(int reg, int primitiveType) {
+    if (primitiveType == P_INT) {
+        aarch64Emit(INSN_ALU, "\tsxtw\t%s, %s\n",
+                    aarch64QwordRegisterList[reg],
+                    aarch64DwordRegisterList[reg]);
+    }
+}
+
+/**
+ * aarch64IsAcquireOrder - Check whether a memory order acquires.
+ * (helper function)
+ *
+ * @param order The memory order (MO_*).
+ *
+ * @return bool True for acquire, acq_rel and seq_cst.
+ */
+static bool aarch64IsAcquireOrder(int order) {
+    return order == MO_ACQUIRE || order == MO_ACQ_REL || order == MO_SEQ_CST;
+}
+
+/**
+ * aarch64IsReleaseOrder - Check whether a memory order releases.
+ * (helper function)
+ *
+ * @param order The memory order (MO_*).
+ *
+ * @return bool True for release, acq_rel and seq_cst.
+ */
+static bool aarch64IsReleaseOrder(int order) {
+    return order == MO_RELEASE || order == MO_ACQ_REL || order == MO_SEQ_CST;
+}
+
+/**
+ * aarch64LSEOrderSuffix - Returns the suffix giving an LSE atomic
+ * instruction (ldadd, swp, cas) the ordering of a memory order.
+ * (helper function)
+ *
+ * @param order The memory order (MO_*).
+ *
+ * @return "", "a" (acquire), "l" (release) or "al".
+ */
+static const char *aarch64LSEOrderSuffix(int order) {
+    if (aarch64IsAcquireOrder(order)) {
+        return aarch64IsReleaseOrder(order) ? "al" : "a";
+    }
+    return aarch64IsReleaseOrder(order) ? "l" : "";
+}
+
+/**
+ * aarch64AtomicLoad - Generates code for an atomic load through a pointer.
+ *
+ * NOTE:
+ * A relaxed load is a plain ldr; the others use the load-acquire ldar,
+ * which is also sequentially consistent with stlr stores.
+ *
+ * @param pointerReg Index of the register containing the pointer.
+ * @param primitiveType The type of the object (a 4- or 8-byte integer).
+ * @param order The memory order (MO_*).
+ *
+ * @return Index of the register containing the loaded value.
+ */
+int aarch64AtomicLoad(int pointerReg, int primitiveType, int order) {
+    if (order == MO_RELAXED) {
+        return aarch64DereferencePointer(pointerReg, 0, primitiveType);
+    }
+    aarch64Emit(INSN_LOAD, "\tldar\t%s, [%s]\n",
+                aarch64AtomicRegister(pointerReg, primitiveType),
+                aarch64QwordRegisterList[pointerReg]);
+    aarch64SignExtendAtomicInt(pointerReg, primitiveType);
+    return pointerReg;
+}
+
+/**
+ * aarch64AtomicStore - Generates code for an atomic store through a
+ * pointer.
+ *
+ * NOTE:
+ * A relaxed store is a plain str; the others use the store-release stlr.
+ *
+ * @param valueReg Index of the register containing the value; it is freed.
+ * @param pointerReg Index of the register containing the pointer; it is
+ *                   freed.
+ * @param primitiveType The type of the object (a 4- or 8-byte integer).
+ * @param order The memory order (MO_*).
+ */
+void aarch64AtomicStore(int valueReg, int pointerReg, int primitiveType,
+                        int order) {
+    aarch64Emit(INSN_STORE, "\t%s\t%s, [%s]\n",
+                (order == MO_RELAXED) ? "str" : "stlr",
+                aarch64AtomicRegister(valueReg, primitiveType),
+                aarch64QwordRegisterList[pointerReg]);
+    aarch64FreeRegister(valueReg);
+    aarch64FreeRegister(pointerReg);
+}
+
+/**
+ * aarch64AtomicReadModifyWrite - Generates code for an atomic
+ * fetch-and-add or exchange through a pointer.
+ *
+ * NOTE:
+ * With LSE atomics (--march=armv8.1-a or later) this is one ldadd or swp
+ * instruction. Otherwise the old value is loaded exclusively, and the new
+ * one stored exclusively until no other access came in between. The
+ * memory order picks the acquire and release forms of the instructions.
+ *
+ * @param ASTop A_ATOMICFETCHADD or A_ATOMICEXCHANGE.
+ * @param valueReg Index of the register containing the operand; it is
+ *                 freed.
+ * @param pointerReg Index of the register containing the pointer; it is
+ *                   freed.
+ * @param primitiveType The type of the object (a 4- or 8-byte integer).
+ * @param order The memory order (MO_*).
+ *
+ * @return Index of the register containing the old value.
+ */
+int aarch64AtomicReadModifyWrite(int ASTop, int valueReg, int pointerReg,
+                                 int primitiveType, int order) {
+    int old = aarch64AllocateRegister();
+    int updated;
+    int status;
+    int label;
+
+    if (Option_march == MARCH_LSE) {
+        aarch64Emit(INSN_STORE, "\t%s%s\t%s, %s, [%s]\n",
+                    (ASTop == A_ATOMICFETCHADD) ? "ldadd" : "swp",
+                    aarch64LSEOrderSuffix(order),
+                    aarch64AtomicRegister(valueReg, primitiveType),
+                    aarch64AtomicRegister(old, primitiveType),
+                    aarch64QwordRegisterList[pointerReg]);
+    } else {
+        updated = valueReg;
+        status = aarch64AllocateRegister();
+        label = codegenGetLabelNumber();
+        aarch64Label(label);
+        aarch64Emit(INSN_LOAD, "\t%s\t%s, [%s]\n",
+                    aarch64IsAcquireOrder(order) ? "ldaxr" : "ldxr",
+                    aarch64AtomicRegister(old, primitiveType),
+                    aarch64QwordRegisterList[pointerReg]);
+        if (ASTop == A_ATOMICFETCHADD) {
+            updated = aarch64AllocateRegister();
+            aarch64Emit(INSN_ALU, "\tadd\t%s, %s, %s\n",
+                        aarch64AtomicRegister(updated, primitiveType),
+                        aarch64AtomicRegister(old, primitiveType),
+                        aarch64AtomicRegister(valueReg, primitiveType));
+        }
+        aarch64Emit(INSN_STORE, "\t%s\t%s, %s, [%s]\n",
+                    aarch64IsReleaseOrder(order) ? "stlxr" : "stxr",
+                    aarch64DwordRegisterList[status],
+                    aarch64AtomicRegister(updated, primitiveType),
+                    aarch64QwordRegisterList[pointerReg]);
+        aarch64Emit(INSN_BRANCH, "\tcbnz\t%s, L%d\n",
+                    aarch64DwordRegisterList[status], label);
+        if (updated != valueReg) {
+            aarch64FreeRegister(updated);
+        }
+        aarch64FreeRegister(status);
+    }
+
+    aarch64SignExtendAtomicInt(old, primitiveType);
+    aarch64FreeRegister(valueReg);
+    aarch64FreeRegister(pointerReg);
+    return old;
+}
+
+/**
+ * aarch64AtomicCompareExchange - Generates code for an atomic compare and
+ * exchange through a pointer.
+ *
+ * NOTE:
+ * With LSE atomics this is one cas instruction, which leaves the value
+ * found in memory in its first register. Otherwise the value is loaded
+ * exclusively and, if it is the expected one, the desired value is
+ * stored exclusively until no other access came in between. Either way
+ * the value found is written back to the expected value on failure.
+ *
+ * @param pointerReg Index of the register containing the pointer; it is
+ *                   freed.
+ * @param expectedPointerReg Index of the register containing the pointer
+ *                           to the expected value; it is freed.
+ * @param desiredReg Index of the register containing the desired value.
+ * @param primitiveType The type of the object (a 4- or 8-byte integer).
+ * @param order The memory order (MO_*).
+ *
+ * @return Index of the register containing 1 if the desired value was
+ *         stored, 0 otherwise (desiredReg).
+ */
+int aarch64AtomicCompareExchange(int pointerReg, int expectedPointerReg,
+                                 int desiredReg, int primitiveType,
+                                 int order) {
+    int expected = aarch64AllocateRegister();
+    int found = aarch64AllocateRegister();
+    char *e = aarch64AtomicRegister(expected, primitiveType);
+    char *f = aarch64AtomicRegister(found, primitiveType);
+    char *d = aarch64AtomicRegister(desiredReg, primitiveType);
+    char *x = aarch64QwordRegisterList[pointerReg];
+    int labelRetry;
+    int labelFail;
+    int labelDone = codegenGetLabelNumber();
+    int status;
+
+    aarch64Emit(INSN_LOAD, "\tldr\t%s, [%s]\n", e,
+                aarch64QwordRegisterList[expectedPointerReg]);
+    if (Option_march == MARCH_LSE) {
+        aarch64Emit(INSN_ALU, "\tmov\t%s, %s\n", f, e);
+        aarch64Emit(INSN_STORE, "\tcas%s\t%s, %s, [%s]\n",
+                    aarch64LSEOrderSuffix(order), f, d, x);
+        aarch64Emit(INSN_ALU, "\tcmp\t%s, %s\n", f, e);
+    } else {
+        labelRetry = codegenGetLabelNumber();
+        labelFail = codegenGetLabelNumber();
+        status = aarch64AllocateRegister();
+        aarch64Label(labelRetry);
+        aarch64Emit(INSN_LOAD, "\t%s\t%s, [%s]\n",
+                    aarch64IsAcquireOrder(order) ? "ldaxr" : "ldxr", f, x);
+        aarch64Emit(INSN_ALU, "\tcmp\t%s, %s\n", f, e);
+        aarch64Emit(INSN_BRANCH, "\tb.ne\tL%d\n", labelFail);
+        aarch64Emit(INSN_STORE, "\t%s\t%s, %s, [%s]\n",
+                    aarch64IsReleaseOrder(order) ? "stlxr" : "stxr",
+                    aarch64DwordRegisterList[status], d, x);
+        aarch64Emit(INSN_BRANCH, "\tcbnz\t%s, L%d\n",
+                    aarch64DwordRegisterList[status], labelRetry);
+        aarch64Label(labelFail);
+        aarch64FreeRegister(status);
+    }
+
+    // The flags still hold the comparison of the found value
+    aarch64Emit(INSN_ALU, "\tcset\t%s, eq\n",
+                aarch64DwordRegisterList[desiredReg]);
+    aarch64Emit(INSN_BRANCH, "\tb.eq\tL%d\n", labelDone);
+    aarch64Emit(INSN_STORE, "\tstr\t%s, [%s]\n", f,
+                aarch64QwordRegisterList[expectedPointerReg]);
+    aarch64Label(labelDone);
+
+    aarch64FreeRegister(expected);
+    aarch64FreeRegister(found);
+    aarch64FreeRegister(pointerReg);
+    aarch64FreeRegister(expectedPointerReg);
+    return desiredReg;
+}
+
+/**
+ * aarch64AtomicFence - Generates code for an atomic thread fence.
+ *
+ * NOTE:
+ * An acquire fence only orders earlier loads (dmb ishld); release,
+ * acq_rel and seq_cst fences order every earlier access (dmb ish).
+ *
+ * @param order The memory order (MO_*).
+ */
+void aarch64AtomicFence(int order) {
+    if (order == MO_ACQUIRE) {
+        aarch64Emit(INSN_ALU, "\tdmb\tishld\n");
+    } else if (order != MO_RELAXED) {
+        aarch64Emit(INSN_ALU, "\tdmb\tish\n");
+    }
+}
+
+/**
+ * aarch64Prefetch - Generates a software prefetch of the cache line
+ * holding a pointer plus a displacement.
+ *
+ * NOTE:
+ * prfm names the access (pld for a read, pst for a write), the level
+ * (locality 3 to 1 keep the line in L1 to L3) and the policy (locality 0
+ * streams it through L1). Its offset is an unsigned 12-bit multiple of 8;
+ * prfum takes any 9-bit signed one, and other offsets are built in w0.
+ * A prefetch never faults.
+ *
+ * @param pointerReg Index of the register containing the pointer.
+ * @param offset Constant byte displacement added to the pointer.
+ * @param hint The locality (0-3), plus PREFETCH_WRITE.
+ */
+void aarch64Prefetch(int pointerReg, int offset, int hint) {
+    static const char *targets[] = {"l1strm", "l3keep", "l2keep", "l1keep"};
+    const char *x = aarch64QwordRegisterList[pointerReg];
+    const char *access = (hint & PREFETCH_WRITE) ? "pst" : "pld";
+    const char *target = targets[hint & ~PREFETCH_WRITE];
+    unsigned int bits = (unsigned int)offset;
+
+    if (offset == 0) {
+        aarch64Emit(INSN_LOAD, "\tprfm\t%s%s, [%s]\n", access, target, x);
+    } else if (offset > 0 && offset <= 32760 && offset % 8 == 0) {
+        aarch64Emit(INSN_LOAD, "\tprfm\t%s%s, [%s, #%d]\n", access, target,
+                    x, offset);
+    } else if (offset >= -256 && offset < 256) {
+        aarch64Emit(INSN_LOAD, "\tprfum\t%s%s, [%s, #%d]\n", access, target,
+                    x, offset);
+    } else {
+        aarch64Emit(INSN_ALU, "\tmov\tw0, #%u\n", bits & 0xffff);
+        aarch64Emit(INSN_ALU, "\tmovk\tw0, #%u, lsl #16\n", bits >> 16);
+        aarch64Emit(INSN_LOAD, "\tprfm\t%s%s, [%s, w0, sxtw]\n", access,
+                    target, x);
+    }
+    aarch64FreeRegister(pointerReg);
+}
@@ -13,24 +13,31 @@ const struct CodegenOps aarch64Ops = {
     .functionPreamble = aarch64FunctionPreamble,
     .returnFromFunction = aarch64ReturnFromFunction,
     .functionPostamble = aarch64FunctionPostamble,
+    .textSection = aarch64TextSection,
 
     .declareGlobalSymbol = aarch64DeclareGlobalSymbol,
     .declareGlobalString = aarch64DeclareGlobalString,
 
     .loadImmediateInt = aarch64LoadImmediateInt,
+    .loadImmediateFloat = aarch64LoadImmediateFloat,
     .loadGlobalSymbol = aarch64LoadGlobalSymbol,
     .loadLocalSymbol = aarch64LoadLocalSymbol,
     .storeGlobalSymbol = aarch64StoreGlobalSymbol,
     .storeLocalSymbol = aarch64StoreLocalSymbol,
+    .compoundAssignSymbol = aarch64CompoundAssignSymbol,
+    .compoundAssignDereferencedPointer =
+        aarch64CompoundAssignDereferencedPointer,
     .loadGlobalString = aarch64LoadGlobalString,
 
     .addRegs = aarch64AddRegs,
     .subRegs = aarch64SubRegs,
     .mulRegs = aarch64MulRegs,
     .divRegsSigned = aarch64DivRegsSigned,
+    .divRegsUnsigned = aarch64DivRegsUnsigned,
     .shiftLeftConst = aarch64ShiftLeftConst,
     .shiftLeftRegs = aarch64ShiftLeftRegs,
-    .shiftRightRegs = aarch64ShiftRightRegs,
+    .shiftRightRegsSigned = aarch64ShiftRightRegsSigned,
+    .shiftRightRegsUnsigned = aarch64ShiftRightRegsUnsigned,
 
     .ArithmeticNegate = aarch64ArithmeticNegate,
     .logicalInvert = aarch64LogicalInvert,
@@ -53,6 +60,21 @@ const struct CodegenOps aarch64Ops = {
     .dereferencePointer = aarch64DereferencePointer,
     .storeDereferencedPointer = aarch64StoreDereferencedPointer,
 
+    .vectorLoad = aarch64VectorLoad,
+    .vectorStore = aarch64VectorStore,
+    .vectorBinary = aarch64VectorBinary,
+    .vectorSplat = aarch64VectorSplat,
+
+    .atomicLoad = aarch64AtomicLoad,
+    .atomicStore = aarch64AtomicStore,
+    .atomicReadModifyWrite = aarch64AtomicReadModifyWrite,
+    .atomicCompareExchange = aarch64AtomicCompareExchange,
+    .atomicFence = aarch64AtomicFence,
+    .prefetch = aarch64Prefetch,
+
+    .asmReserveClobbers = aarch64AsmReserveClobbers,
+    .inlineAsm = aarch64InlineAsm,
+
     .resetLocalOffset = aarch64ResetLocalOffset,
     .getLocalOffset = aarch64GetLocalOffset,
 };
@@ -11,6 +11,14 @@
 // anything survives a call except x0 return).
 static bool aarch64FreeRegisters[8];
 
+// Floating-point values live in the caller-saved SIMD&FP registers
+// v16-v31, used as dN (double), sN (float) or qN (vector). Their indices
+// start at FIRSTFPREG (see defs.h).
+static bool aarch64FreeFloatRegisters[16];
+
+// Registers the current function's code writes (bit r for register index r)
+static unsigned long aarch64WrittenRegisters;
+
 char *aarch64QwordRegisterList[8] = {"x9", // 64-bit GPR
                                      "x10", "x11", "x12", "x13",
                                      "x14", "x15", "x16"};
@@ -26,6 +34,21 @@ char *aarch64DwordRegisterList[8] = {"w9", // low 32 bits of x9
 char *aarch64ByteRegisterList[8] = {"w9",  "w10", "w11", "w12",
                                     "w13", "w14", "w15", "w16"};
 
+char *aarch64DoubleRegisterList[16] = {
+    "d16", "d17", "d18", "d19", "d20", "d21", "d22", "d23",
+    "d24", "d25", "d26", "d27", "d28", "d29", "d30", "d31",
+};
+
+char *aarch64SingleRegisterList[16] = {
+    "s16", "s17", "s18", "s19", "s20", "s21", "s22", "s23",
+    "s24", "s25", "s26", "s27", "s28", "s29", "s30", "s31",
+};
+
+char *aarch64QuadRegisterList[16] = {
+    "q16", "q17", "q18", "q19", "q20", "q21", "q22", "q23",
+    "q24", "q25", "q26", "q27", "q28", "q29", "q30", "q31",
+};
+
 /**
  * aarch64ResetRegisterPool - Reset the aarch64 register pool, marking all
  * registers as free.
@@ -35,6 +58,9 @@ void aarch64ResetRegisterPool(void) {
     for (int i = 0; i < n; i++) {
         aarch64FreeRegisters[i] = true;
     }
+    for (int i = 0; i < 16; i++) {
+        aarch64FreeFloatRegisters[i] = true;
+    }
 }
 
 /**
@@ -47,6 +73,7 @@ int aarch64AllocateRegister(void) {
     for (int i = 0; i < n; i++) {
         if (aarch64FreeRegisters[i]) {
             aarch64FreeRegisters[i] = false;
+            aarch64WrittenRegisters |= 1UL << i;
             return i;
         }
     }
@@ -55,12 +82,115 @@ int aarch64AllocateRegister(void) {
     exit(1);
 }
 
+/**
+ * aarch64AllocateFloatRegister - Allocate a free floating-point register
+ * from the pool.
+ *
+ * @return The index of the allocated register (FIRSTFPREG and up).
+ */
+int aarch64AllocateFloatRegister(void) {
+    for (int i = 0; i < 16; i++) {
+        if (aarch64FreeFloatRegisters[i]) {
+            aarch64FreeFloatRegisters[i] = false;
+            aarch64WrittenRegisters |= 1UL << (FIRSTFPREG + i);
+            return FIRSTFPREG + i;
+        }
+    }
+
+    fprintf(stderr, "Error: No free aarch64 FP registers available\n");
+    exit(1);
+}
+
+/**
+ * aarch64ReserveRegister - Mark a register of the pool as used, for a
+ * register an asm statement clobbers.
+ *
+ * @param r The index of the register to reserve.
+ */
+void aarch64ReserveRegister(int r) {
+    bool *isFree = aarch64IsFloatRegister(r)
+                       ? &aarch64FreeFloatRegisters[r - FIRSTFPREG]
+                       : &aarch64FreeRegisters[r];
+
+    if (!*isFree) {
+        fprintf(stderr, "Error: aarch64 register %s is already in use\n",
+                aarch64IsFloatRegister(r) ? aarch64DoubleRegister(r)
+                                          : aarch64QwordRegisterList[r]);
+        exit(1);
+    }
+    *isFree = false;
+    aarch64WrittenRegisters |= 1UL << r;
+}
+
+/**
+ * aarch64IsFloatRegister - Check whether a register index names a
+ * floating-point register.
+ *
+ * @param r The register index.
+ *
+ * @return true for a floating-point register.
+ */
+bool aarch64IsFloatRegister(int r) { return r >= FIRSTFPREG; }
+
+/**
+ * aarch64DoubleRegister - Name of a floating-point register as a double.
+ *
+ * @param r The register index (FIRSTFPREG and up).
+ *
+ * @return The register name (e.g. "d16").
+ */
+char *aarch64DoubleRegister(int r) {
+    return aarch64DoubleRegisterList[r - FIRSTFPREG];
+}
+
+/**
+ * aarch64SingleRegister - Name of a floating-point register as a float.
+ *
+ * @param r The register index (FIRSTFPREG and up).
+ *
+ * @return The register name (e.g. "s16").
+ */
+char *aarch64SingleRegister(int r) {
+    return aarch64SingleRegisterList[r - FIRSTFPREG];
+}
+
+/**
+ * aarch64QuadRegister - Name of a floating-point register as a 128-bit
+ * SIMD vector.
+ *
+ * @param r The register index (FIRSTFPREG and up).
+ *
+ * @return The register name (e.g. "q16").
+ */
+char *aarch64QuadRegister(int r) {
+    return aarch64QuadRegisterList[r - FIRSTFPREG];
+}
+
+/**
+ * aarch64VectorRegisterNumber - Number of a floating-point register in the
+ * SIMD&FP register file, for vector operands such as "v16.4s".
+ *
+ * @param r The register index (FIRSTFPREG and up).
+ *
+ * @return The register number (16-31).
+ */
+int aarch64VectorRegisterNumber(int r) { return 16 + r - FIRSTFPREG; }
+
 /**
  * aarch64FreeRegister - Free a previously allocated aarch64 register.
  *
  * @param r The index of the register to free.
  */
 void aarch64FreeRegister(int r) {
+    if (aarch64IsFloatRegister(r)) {
+        if (aarch64FreeFloatRegisters[r - FIRSTFPREG]) {
+            fprintf(stderr, "Error: aarch64 register %s is already free\n",
+                    aarch64DoubleRegister(r));
+            exit(1);
+        }
+        aarch64FreeFloatRegisters[r - FIRSTFPREG] = true;
+        return;
+    }
     if (aarch64FreeRegisters[r]) {
         fprintf(stderr, "Error: aarch64 register %s is already free\n",
                 aarch64QwordRegisterList[r]);
@@ -68,3 +198,51 @@ void aarch64FreeRegister(int r) {
     }
     aarch64FreeRegisters[r] = true;
 }
+
+/**
+ * aarch64LiveRegisters - Return the registers of the pool in use.
+ *
+ * @return The registers (bit r for register index r).
+ */
+unsigned long aarch64LiveRegisters(void) {
+    unsigned long registers = 0;
+
+    for (int i = 0; i < 8; i++) {
+        if (!aarch64FreeRegisters[i]) {
+            registers |= 1UL << i;
+        }
+    }
+    for (int i = 0; i < 16; i++) {
+        if (!aarch64FreeFloatRegisters[i]) {
+            registers |= 1UL << (FIRSTFPREG + i);
+        }
+    }
+    return registers;
+}
+
+/**
+ * aarch64ResetWrittenRegisters - Start recording the registers of the pool
+ * a function's code writes.
+ */
+void aarch64ResetWrittenRegisters(void) { aarch64WrittenRegisters = 0; }
+
+/**
+ * aarch64MarkRegistersWritten - Record registers of the pool the current
+ * function's code writes other than by allocating them, e.g. through a
+ * call.
+ *
+ * @param registers The registers (bit r for register index r).
+ */
+void aarch64MarkRegistersWritten(unsigned long registers) {
+    aarch64WrittenRegisters |= registers;
+}
+
+/**
+ * aarch64GetWrittenRegisters - Return the registers of the pool the current
+ * function's code has written so far.
+ *
+ * @return The registers (bit r for register index r).
+ */
+unsigned long aarch64GetWrittenRegisters(void) {
+    return aarch64WrittenRegisters;
+}
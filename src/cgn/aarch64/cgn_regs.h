@@ -8,7 +8,23 @@
 extern char *aarch64QwordRegisterList[8];
 extern char *aarch64DwordRegisterList[8];
 extern char *aarch64ByteRegisterList[8];
+extern char *aarch64DoubleRegisterList[16];
+extern char *aarch64SingleRegisterList[16];
+extern char *aarch64QuadRegisterList[16];
 
 void aarch64ResetRegisterPool(void);
 int aarch64AllocateRegister(void);
+int aarch64AllocateFloatRegister(void);
+void aarch64ReserveRegister(int r);
+bool aarch64IsFloatRegister(int r);
+char *aarch64DoubleRegister(int r);
+char *aarch64SingleRegister(int r);
+char *aarch64QuadRegister(int r);
+int aarch64VectorRegisterNumber(int r);
 void aarch64FreeRegister(int r);
+
+// Register usage (bit r for register index r), for the callers' summaries
+unsigned long aarch64LiveRegisters(void);
+void aarch64ResetWrittenRegisters(void);
+void aarch64MarkRegistersWritten(unsigned long registers);
+unsigned long aarch64GetWrittenRegisters(void);
@@ -11,26 +11,63 @@
 #include "decl.h"
 #include "defs.h"
 
+#include <stdarg.h>
+
 // Position of next local variable relative to frame pointer (x29).
 // We track local allocation size as a positive number of bytes.
 static int localOffset;
 static int stackOffset;
 
+/**
+ * aarch64Emit - Outputs one instruction and accounts for it in the size
+ * report. Every AArch64 instruction is 4 bytes long.
+ *
+ * @param insnClass Instruction class (INSN_*).
+ * @param format printf-style format of the instruction line.
+ */
+void aarch64Emit(int insnClass, const char *format, ...) {
+    va_list args;
+
+    va_start(args, format);
+    vfprintf(Outfile, format, args);
+    va_end(args);
+    sizeReportCountInstruction(insnClass, 4);
+}
+
+/**
+ * aarch64TextSection - Outputs the declaration of a text section.
+ *
+ * @param section The text section (TS_*).
+ */
+void aarch64TextSection(int section) {
+    static char *sectionDeclarations[] = {
+        [TS_NORMAL] = ".text",
+        [TS_HOT] = ".section\t.text.hot,\"ax\",@progbits",
+        [TS_UNLIKELY] = ".section\t.text.unlikely,\"ax\",@progbits",
+    };
+
+    fprintf(Outfile, "\t%s\n", sectionDeclarations[section]);
+}
+
 void aarch64ResetLocalOffset(void) {
     localOffset = 0;
     stackOffset = 0;
 }
 
-int aarch64GetLocalOffset(int type, bool isFunctionParameter) {
+int aarch64GetLocalOffset(int id, bool isFunctionParameter) {
     (void)isFunctionParameter;
 
-    int size = aarch64GetPrimitiveTypeSize(type);
+    int size = getSymbolSize(id);
+    int alignment = getSymbolAlignment(id);
     if (size <= 0) {
-        logFatald("Bad type size in aarch64GetLocalOffset: ", type);
+        logFatals("Bad type size in aarch64GetLocalOffset: ",
+                  SymbolTable[id].name);
     }
 
-    // Keep at least 4-byte alignment for locals, like the NASM backend.
+    // Keep at least 4-byte alignment for locals, like the NASM backend,
+    // and align the slot for its type (x29 itself is 16-byte aligned).
     localOffset += (size > 4) ? size : 4;
+    localOffset = (localOffset + alignment - 1) & ~(alignment - 1);
     return -localOffset;
 }
 
@@ -40,10 +77,17 @@ int aarch64GetLocalOffset(int type, bool isFunctionParameter) {
 void aarch64Preamble(void) {
     aarch64ResetRegisterPool();
 
+    // Let the assembler accept the LSE atomics (ldadd, swp, cas)
+    if (Option_march == MARCH_LSE) {
+        fputs("\t.arch_extension\tlse\n", Outfile);
+    }
     fputs("\t.text\n", Outfile);
     fputs("\t.extern\tprintint\n", Outfile);
     fputs("\t.extern\tprintchar\n", Outfile);
     fputs("\t.extern\tprintstring\n", Outfile);
+    fputs("\t.extern\tprintdouble\n", Outfile);
+    fputs("\t.extern\tthread_spawn\n", Outfile);
+    fputs("\t.extern\tthread_join\n", Outfile);
 }
 
 /**
@@ -56,25 +100,312 @@ void aarch64Preamble(void) {
 void aarch64Postamble(void) {}
 
 /**
- * aarch64FunctionCall - Generates code to call a function with an argument in a
- * register.
+ * aarch64MoveSavedRegisters - Save registers of the pool in a stack area
+ * before a call, or restore them after it. (helper function)
+ *
+ * NOTE:
+ * A SIMD&FP register takes 16 bytes, as it may hold a vector, and the area
+ * is a multiple of 16 bytes so that sp stays aligned.
+ *
+ * @param registers The registers (bit r for register index r).
+ * @param isSave    True to save them, false to restore them.
+ */
+static void aarch64MoveSavedRegisters(unsigned long registers, bool isSave) {
+    int size = 0;
+    int slots = 0;
+
+    for (int r = 0; r < FIRSTFPREG + 16; r++) {
+        if (registers & (1UL << r)) {
+            size += aarch64IsFloatRegister(r) ? 16 : 8;
+            slots++;
+        }
+    }
+    if (size == 0) {
+        return;
+    }
+    size = (size + 15) & ~15;
+
+    if (isSave) {
+        sizeReportCountSpillSlots(slots);
+        aarch64Emit(INSN_ALU, "\tsub\tsp, sp, #%d\n", size);
+    }
+    // Vector registers first, so that their slots are 16-byte aligned
+    int offset = 0;
+    for (int r = FIRSTFPREG; r < FIRSTFPREG + 16; r++) {
+        if (!(registers & (1UL << r))) {
+            continue;
+        }
+        aarch64Emit(isSave ? INSN_STORE : INSN_LOAD, "\t%s\t%s, [sp, #%d]\n",
+                    isSave ? "str" : "ldr", aarch64QuadRegister(r), offset);
+        offset += 16;
+    }
+    for (int r = 0; r < FIRSTFPREG; r++) {
+        if (!(registers & (1UL << r))) {
+            continue;
+        }
+        aarch64Emit(isSave ? INSN_STORE : INSN_LOAD, "\t%s\t%s, [sp, #%d]\n",
+                    isSave ? "str" : "ldr", aarch64QwordRegisterList[r],
+                    offset);
+        offset += 8;
+    }
+    if (!isSave) {
+        aarch64Emit(INSN_ALU, "\tadd\tsp, sp, #%d\n", size);
+    }
+}
+
+/**
+ * aarch64FunctionCall - Generates code to call a function with one or two
+ * arguments in registers.
+ *
+ * NOTE:
+ * As in AAPCS64, floating-point arguments are passed in d0 and d1 and
+ * integer ones in x0 and x1, each class in order; a float result comes
+ * back in s0 and a double one in d0.
+ * The registers of the pool that hold values across the call are saved
+ * around it, but only those the callee may write: a function defined
+ * earlier in the file has a summary of the registers its code writes,
+ * calls included (see aarch64FunctionPostamble()). Any other function may
+ * write them all, and x16 is always written, as a linker veneer may use it.
  *
  * @param r Index of the register containing the argument.
+ * @param second Index of the register containing the second argument, or
+ *               NOREG.
  * @param functionSymbolId The function's symbol table ID.
  *
  * @return Index of the register containing the function's return value.
  */
-int aarch64FunctionCall(int r, int functionSymbolId) {
-    int out = aarch64AllocateRegister();
+int aarch64FunctionCall(int r, int second, int functionSymbolId) {
+    int returnType =
+        TypeTable[SymbolTable[functionSymbolId].primitiveType].base;
+    bool isFirstFloat = aarch64IsFloatRegister(r);
+    unsigned long clobbered =
+        SymbolTable[functionSymbolId].clobberedRegisters | (1UL << 7); // x16
+    unsigned long saved;
+
+    aarch64MarkRegistersWritten(clobbered);
+
+    // The arguments are consumed by the call
+    saved = aarch64LiveRegisters() & clobbered & ~(1UL << r);
+    if (second != NOREG) {
+        saved &= ~(1UL << second);
+    }
+    aarch64MoveSavedRegisters(saved, true);
+
+    int out = isFloatType(returnType) ? aarch64AllocateFloatRegister()
+                                      : aarch64AllocateRegister();
 
-    fprintf(Outfile, "\tmov\tx0, %s\n", aarch64QwordRegisterList[r]);
-    fprintf(Outfile, "\tbl\t%s\n", SymbolTable[functionSymbolId].name);
-    fprintf(Outfile, "\tmov\t%s, x0\n", aarch64QwordRegisterList[out]);
+    if (isFirstFloat) {
+        aarch64Emit(INSN_ALU, "\tfmov\td0, %s\n", aarch64DoubleRegister(r));
+    } else {
+        aarch64Emit(INSN_ALU, "\tmov\tx0, %s\n", aarch64QwordRegisterList[r]);
+    }
+    if (second != NOREG) {
+        if (aarch64IsFloatRegister(second)) {
+            aarch64Emit(INSN_ALU, "\tfmov\t%s, %s\n",
+                        isFirstFloat ? "d1" : "d0",
+                        aarch64DoubleRegister(second));
+        } else {
+            aarch64Emit(INSN_ALU, "\tmov\t%s, %s\n",
+                        isFirstFloat ? "x0" : "x1",
+                        aarch64QwordRegisterList[second]);
+        }
+        aarch64FreeRegister(second);
+    }
+    aarch64Emit(INSN_CALL, "\tbl\t%s\n", SymbolTable[functionSymbolId].name);
+    if (returnType == P_FLOAT) {
+        aarch64Emit(INSN_ALU, "\tfcvt\t%s, s0\n", aarch64DoubleRegister(out));
+    } else if (returnType == P_DOUBLE) {
+        aarch64Emit(INSN_ALU, "\tfmov\t%s, d0\n", aarch64DoubleRegister(out));
+    } else {
+        aarch64Emit(INSN_ALU, "\tmov\t%s, x0\n",
+                    aarch64QwordRegisterList[out]);
+    }
 
     aarch64FreeRegister(r);
+    aarch64MoveSavedRegisters(saved, false);
     return out;
 }
 
+/**
+ * aarch64ClobberRegister - Splits the name of a register an asm statement
+ * clobbers into its kind and number. (helper function)
+ *
+ * @param name The register name (e.g. "x19", "w3", "v8", "d16", "lr").
+ * @param kind Where to store 'x' for a general-purpose register (also
+ *             named wN) or 'v' for a SIMD&FP one (also named dN, sN,
+ *             qN, hN or bN).
+ *
+ * @return The register number, or -1 if name is no register.
+ */
+static int aarch64ClobberRegister(char *name, char *kind) {
+    char *end;
+    long number;
+
+    if (!strcmp(name, "lr")) {
+        *kind = 'x';
+        return 30;
+    }
+    if (*name == '\0' || strchr("xwvdsqhb", *name) == NULL ||
+        !isdigit((unsigned char)name[1])) {
+        return -1;
+    }
+    number = strtol(name + 1, &end, 10);
+    *kind = (*name == 'x' || *name == 'w') ? 'x' : 'v';
+    if (*end != '\0' || number > (*kind == 'x' ? 30 : 31)) {
+        return -1;
+    }
+    return (int)number;
+}
+
+/**
+ * aarch64AsmReserveClobbers - Reserve the pool registers an asm statement
+ * clobbers, and check the names of the other clobbers.
+ *
+ * NOTE:
+ * "memory" and "cc" need nothing: every asm statement is emitted in place,
+ * and nothing is kept in the flags or in registers across a statement.
+ *
+ * @param a The asm statement.
+ */
+void aarch64AsmReserveClobbers(struct asmStatement *a) {
+    char *name;
+    char kind;
+    int number;
+
+    for (int i = 0; i < a->clobberCount; i++) {
+        name = a->clobbers[i];
+        a->clobberRegs[i] = NOREG;
+        if (!strcmp(name, "memory") || !strcmp(name, "cc")) {
+            continue;
+        }
+        if (!strcmp(name, "fp") || !strcmp(name, "sp") ||
+            !strcmp(name, "x29") || !strcmp(name, "w29")) {
+            logFatals("asm statement cannot clobber ", name);
+        }
+        if ((number = aarch64ClobberRegister(name, &kind)) < 0) {
+            logFatals("Unknown register in asm clobber list: ", name);
+        }
+        if (kind == 'x' && number >= 9 && number <= 16) {
+            a->clobberRegs[i] = number - 9;
+        } else if (kind == 'v' && number >= 16) {
+            a->clobberRegs[i] = FIRSTFPREG + number - 16;
+        } else {
+            continue;
+        }
+        aarch64ReserveRegister(a->clobberRegs[i]);
+    }
+}
+
+/**
+ * aarch64AsmOperandText - Format an operand of an asm statement.
+ * (helper function)
+ *
+ * NOTE:
+ * A register operand is named xN by default, or wN with the modifier w.
+ * A memory operand is the address in brackets.
+ *
+ * @param op       The operand.
+ * @param modifier The modifier letter, or 0.
+ *
+ * @return The text (in a static buffer).
+ */
+static char *aarch64AsmOperandText(struct asmOperand *op, int modifier) {
+    static char text[32];
+
+    switch (op->constraint) {
+    case 'i':
+        snprintf(text, sizeof(text), "%ld", op->value);
+        return text;
+    case 'm':
+        if (op->offset == 0) {
+            snprintf(text, sizeof(text), "[%s]",
+                     aarch64QwordRegisterList[op->reg]);
+        } else {
+            snprintf(text, sizeof(text), "[%s, #%d]",
+                     aarch64QwordRegisterList[op->reg], op->offset);
+        }
+        return text;
+    }
+
+    switch (modifier) {
+    case 0:
+    case 'x':
+        return aarch64QwordRegisterList[op->reg];
+    case 'w':
+        return aarch64DwordRegisterList[op->reg];
+    default:
+        logFatalc("Unknown asm operand modifier", modifier);
+        return NULL;
+    }
+}
+
+/**
+ * aarch64InlineAsm - Output the text of an asm statement, with its operands
+ * substituted in.
+ *
+ * NOTE:
+ * The operands' expressions are already in registers. Each register output
+ * gets a register of its own here, which stays allocated until it is
+ * stored; every other operand's register and the reserved clobbers are
+ * freed afterwards. Clobbered callee-saved registers (x19-x28, and the low
+ * halves d8-d15 of v8-v15) are saved on the stack around the text.
+ *
+ * @param a The asm statement.
+ */
+void aarch64InlineAsm(struct asmStatement *a) {
+    struct asmOperand *op;
+    bool isSaved[NASMCLOBBERS];
+    char kind = 'x';
+    int number;
+    char *text;
+    char *line;
+    int i;
+
+    for (i = 0; i < a->operandCount; i++) {
+        op = &a->operands[i];
+        if (op->constraint == 'r' && op->isOutput && op->reg == NOREG) {
+            op->reg = aarch64AllocateRegister();
+        }
+    }
+
+    text = codegenExpandAsmText(a, aarch64AsmOperandText);
+    for (i = 0; i < a->clobberCount; i++) {
+        number = aarch64ClobberRegister(a->clobbers[i], &kind);
+        isSaved[i] = kind == 'x' ? number >= 19 && number <= 28
+                                 : number >= 8 && number <= 15;
+        if (isSaved[i]) {
+            aarch64Emit(INSN_STORE, "\tstr\t%c%d, [sp, #-16]!\n",
+                        kind == 'x' ? 'x' : 'd', number);
+        }
+    }
+    for (line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        line += strspn(line, " \t");
+        if (*line != '\0') {
+            aarch64Emit(INSN_ALU, "\t%s\n", line);
+        }
+    }
+    for (i = a->clobberCount - 1; i >= 0; i--) {
+        if (isSaved[i]) {
+            number = aarch64ClobberRegister(a->clobbers[i], &kind);
+            aarch64Emit(INSN_LOAD, "\tldr\t%c%d, [sp], #16\n",
+                        kind == 'x' ? 'x' : 'd', number);
+        }
+    }
+    free(text);
+
+    for (i = 0; i < a->operandCount; i++) {
+        op = &a->operands[i];
+        if (op->reg != NOREG && !(op->constraint == 'r' && op->isOutput)) {
+            aarch64FreeRegister(op->reg);
+        }
+    }
+    for (i = 0; i < a->clobberCount; i++) {
+        if (a->clobberRegs[i] != NOREG) {
+            aarch64FreeRegister(a->clobberRegs[i]);
+        }
+    }
+}
+
 /**
  * aarch64FunctionPreamble - Outputs the assembly code function preamble.
  *
@@ -86,36 +417,63 @@ void aarch64FunctionPreamble(int id) {
     // Allocate locals already recorded via aarch64GetLocalOffset().
     // Keep 16-byte stack alignment.
     stackOffset = (localOffset + 15) & ~15;
+    sizeReportBeginFunction(id, stackOffset);
 
-    fprintf(Outfile, "\t.text\n");
-    fprintf(Outfile, "\t.global\t%s\n", functionName);
+    aarch64TextSection(SymbolTable[id].textSection);
+    if (SymbolTable[id].class == C_GLOBAL) {
+        fprintf(Outfile, "\t.global\t%s\n", functionName);
+    }
     fprintf(Outfile, "%s:\n", functionName);
-    fprintf(Outfile, "\tstp\tx29, x30, [sp, -16]!\n");
-    fprintf(Outfile, "\tmov\tx29, sp\n");
+    aarch64Emit(INSN_STORE, "\tstp\tx29, x30, [sp, -16]!\n");
+    aarch64Emit(INSN_ALU, "\tmov\tx29, sp\n");
 
     if (stackOffset > 0) {
-        fprintf(Outfile, "\tsub\tsp, sp, #%d\n", stackOffset);
+        aarch64Emit(INSN_ALU, "\tsub\tsp, sp, #%d\n", stackOffset);
     }
+    // Nothing is live yet: the previous function may end without freeing
+    // its return value
+    aarch64ResetRegisterPool();
+    aarch64ResetWrittenRegisters();
 }
 
 /**
  * aarch64ReturnFromFunction - Generates code to return a value from a function.
+ * A float is returned in s0 and a double in d0.
  *
  * @param reg Index of the register containing the return value.
  * @param id The function's symbol table ID.
  */
 void aarch64ReturnFromFunction(int reg, int id) {
-    int primitiveType = SymbolTable[id].primitiveType;
+    // The function type's base is its return type
+    int primitiveType =
+        getMemoryAccessType(TypeTable[SymbolTable[id].primitiveType].base);
 
     switch (primitiveType) {
     case P_CHAR:
-        fprintf(Outfile, "\tmov\tw0, %s\n", aarch64DwordRegisterList[reg]);
+    case P_UCHAR:
+        aarch64Emit(INSN_ALU, "\tmov\tw0, %s\n", aarch64DwordRegisterList[reg]);
+        break;
+    case P_SHORT:
+        aarch64Emit(INSN_ALU, "\tsxth\tx0, %s\n",
+                    aarch64DwordRegisterList[reg]);
+        break;
+    case P_USHORT:
+        aarch64Emit(INSN_ALU, "\tuxth\tw0, %s\n",
+                    aarch64DwordRegisterList[reg]);
         break;
     case P_INT:
-        fprintf(Outfile, "\tmov\tw0, %s\n", aarch64DwordRegisterList[reg]);
+    case P_UINT:
+        aarch64Emit(INSN_ALU, "\tmov\tw0, %s\n", aarch64DwordRegisterList[reg]);
         break;
     case P_LONG:
-        fprintf(Outfile, "\tmov\tx0, %s\n", aarch64QwordRegisterList[reg]);
+    case P_ULONG:
+        aarch64Emit(INSN_ALU, "\tmov\tx0, %s\n", aarch64QwordRegisterList[reg]);
+        break;
+    case P_FLOAT:
+        aarch64Emit(INSN_ALU, "\tfcvt\ts0, %s\n", aarch64DoubleRegister(reg));
+        break;
+    case P_DOUBLE:
+        aarch64Emit(INSN_ALU, "\tfmov\td0, %s\n", aarch64DoubleRegister(reg));
         break;
     default:
         logFatald(
@@ -124,7 +482,7 @@ void aarch64ReturnFromFunction(int reg, int id) {
     }
 
     // After moving return value to x0, branch to function end label.
-    fprintf(Outfile, "\tb\tL%d\n", SymbolTable[id].endLabel);
+    aarch64Emit(INSN_BRANCH, "\tb\tL%d\n", SymbolTable[id].endLabel);
 }
 
 /**
@@ -133,16 +491,17 @@ void aarch64ReturnFromFunction(int reg, int id) {
  * @param id The function's symbol table ID.
  */
 void aarch64FunctionPostamble(int id) {
-    (void)id;
     // end label is emitted by aarch64Label from gen.c
     // (we’ll call aarch64Label(SymbolTable[id].endLabel) there)
     // and then we output epilogue:
     aarch64Label(SymbolTable[id].endLabel);
     // Discard local stack space.
-    fprintf(Outfile, "\tmov\tsp, x29\n");
-    fputs("\tldp\tx29, x30, [sp], 16\n"
-          "\tret\n",
-          Outfile);
+    aarch64Emit(INSN_ALU, "\tmov\tsp, x29\n");
+    aarch64Emit(INSN_LOAD, "\tldp\tx29, x30, [sp], 16\n");
+    aarch64Emit(INSN_BRANCH, "\tret\n");
+
+    // The callers compiled from now on save only what this function writes
+    SymbolTable[id].clobberedRegisters = aarch64GetWrittenRegisters();
 }
 
 /**
@@ -157,7 +516,7 @@ void aarch64Label(int label) { fprintf(Outfile, "L%d:\n", label); }
  *
  * @param label The label number to jump to.
  */
-void aarch64Jump(int label) { fprintf(Outfile, "\tb\tL%d\n", label); }
+void aarch64Jump(int label) { aarch64Emit(INSN_BRANCH, "\tb\tL%d\n", label); }
 
 /**
  * aarch64CompareAndJump - Generates code to compare two registers and jump to a
@@ -167,10 +526,14 @@ void aarch64Jump(int label) { fprintf(Outfile, "\tb\tL%d\n", label); }
  * @param r1 Index of the first register.
  * @param r2 Index of the second register.
  * @param label The label number to jump to if the comparison is true.
+ * @param primitiveType The type of the compared values.
  *
  * @return NOREG (indicating no register is returned).
  */
-int aarch64CompareAndJump(int ASTop, int r1, int r2, int label) {
+int aarch64CompareAndJump(int ASTop, int r1, int r2, int label,
+                          int primitiveType) {
+    bool isUnsigned = isUnsignedType(primitiveType);
+
     if (!((ASTop == A_EQ) || (ASTop == A_NE) || (ASTop == A_LT) ||
           (ASTop == A_LE) || (ASTop == A_GT) || (ASTop == A_GE))) {
         fprintf(stderr,
@@ -179,8 +542,20 @@ int aarch64CompareAndJump(int ASTop, int r1, int r2, int label) {
         exit(1);
     }
 
-    fprintf(Outfile, "\tcmp\t%s, %s\n", aarch64QwordRegisterList[r1],
-            aarch64QwordRegisterList[r2]);
+    if (isFloatType(primitiveType)) {
+        // Jump when false; a comparison with a NaN is false (except "!=")
+        static const char *floatBranches[] = {
+            [A_EQ] = "bne", [A_NE] = "beq", [A_LT] = "bpl",
+            [A_LE] = "bhi", [A_GT] = "ble", [A_GE] = "blt"};
+        aarch64Emit(INSN_ALU, "\tfcmp\t%s, %s\n", aarch64DoubleRegister(r1),
+                    aarch64DoubleRegister(r2));
+        aarch64Emit(INSN_BRANCH, "\t%s\tL%d\n", floatBranches[ASTop], label);
+        aarch64ResetRegisterPool();
+        return NOREG;
+    }
+
+    aarch64Emit(INSN_ALU, "\tcmp\t%s, %s\n", aarch64QwordRegisterList[r1],
+                aarch64QwordRegisterList[r2]);
 
     const char *branch = NULL;
     // We invert condition, same as NASM cgn_* code:
@@ -193,16 +568,16 @@ int aarch64CompareAndJump(int ASTop, int r1, int r2, int label) {
         branch = "beq";
         break; // ==
     case A_LT:
-        branch = "bge";
+        branch = isUnsigned ? "bhs" : "bge";
         break; // >=
     case A_LE:
-        branch = "bgt";
+        branch = isUnsigned ? "bhi" : "bgt";
         break; // >
     case A_GT:
-        branch = "ble";
+        branch = isUnsigned ? "bls" : "ble";
         break; // <=
     case A_GE:
-        branch = "blt";
+        branch = isUnsigned ? "blo" : "blt";
         break; // <
     default:
         fprintf(stderr,
@@ -211,7 +586,7 @@ int aarch64CompareAndJump(int ASTop, int r1, int r2, int label) {
         exit(1);
     }
 
-    fprintf(Outfile, "\t%s\tL%d\n", branch, label);
+    aarch64Emit(INSN_BRANCH, "\t%s\tL%d\n", branch, label);
 
     aarch64ResetRegisterPool();
     return NOREG;
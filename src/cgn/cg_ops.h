@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 
+struct asmStatement;
+
 struct CodegenOps {
     // Register pool
     void (*declareDataSegment)(void);
@@ -14,10 +16,12 @@ struct CodegenOps {
     void (*postamble)(void);
 
     // Functions
-    int (*functionCall)(int reg, int funcSymId);
+    int (*functionCall)(int reg, int secondReg, int funcSymId);
     void (*functionPreamble)(int funcSymId);
     void (*returnFromFunction)(int reg, int funcSymId);
     void (*functionPostamble)(int funcSymId);
+    // Places the code that follows in a text section (TS_*)
+    void (*textSection)(int section);
 
     // Data
     void (*declareGlobalSymbol)(int symId);
@@ -25,20 +29,30 @@ struct CodegenOps {
 
     // Expressions / loads / stores
     int (*loadImmediateInt)(int value, int primitiveType);
+    int (*loadImmediateFloat)(double value, int primitiveType);
     int (*loadGlobalSymbol)(int symId, int op);
     int (*loadLocalSymbol)(int symId, int op);
     int (*loadGlobalString)(int symId);
     int (*storeGlobalSymbol)(int reg, int symId);
     int (*storeLocalSymbol)(int reg, int symId);
 
+    // Compound assignment: memory = memory <astOp> (reg, or immediate if
+    // reg is NOREG), read and written through a single address
+    void (*compoundAssignSymbol)(int astOp, int reg, int immediate, int symId);
+    void (*compoundAssignDereferencedPointer)(int astOp, int reg,
+                                              int immediate, int pointerReg,
+                                              int offset, int primitiveType);
+
     // Arithmetic
     int (*addRegs)(int r1, int r2);
     int (*subRegs)(int r1, int r2);
     int (*mulRegs)(int r1, int r2);
     int (*divRegsSigned)(int r1, int r2);
+    int (*divRegsUnsigned)(int r1, int r2);
     int (*shiftLeftConst)(int reg, int shiftAmount);
     int (*shiftLeftRegs)(int dstReg, int srcReg);
-    int (*shiftRightRegs)(int dstReg, int srcReg);
+    int (*shiftRightRegsSigned)(int dstReg, int srcReg);
+    int (*shiftRightRegsUnsigned)(int dstReg, int srcReg);
 
     // Bitwise and logical operations
     int (*ArithmeticNegate)(int reg);
@@ -50,8 +64,9 @@ struct CodegenOps {
     int (*toBoolean)(int reg, int astOp, int label);
 
     // Comparisons
-    int (*compareAndSet)(int astOp, int r1, int r2);
-    int (*compareAndJump)(int astOp, int r1, int r2, int label);
+    int (*compareAndSet)(int astOp, int r1, int r2, int primitiveType);
+    int (*compareAndJump)(int astOp, int r1, int r2, int label,
+                          int primitiveType);
 
     // Control flow helpers
     void (*label)(int label);
@@ -63,13 +78,43 @@ struct CodegenOps {
 
     // Pointers
     int (*addressOfSymbol)(int symId);
-    int (*dereferencePointer)(int pointerReg, int primitiveType);
-    int (*storeDereferencedPointer)(int valueReg, int pointerReg,
+    int (*dereferencePointer)(int pointerReg, int offset, int primitiveType);
+    int (*storeDereferencedPointer)(int valueReg, int pointerReg, int offset,
                                     int primitiveType);
 
+    // SIMD vectors: VECTORSIZE bytes in one floating-point register,
+    // loaded and stored at aligned addresses
+    int (*vectorLoad)(int pointerReg, int offset, int vectorType);
+    int (*vectorStore)(int valueReg, int pointerReg, int offset,
+                       int vectorType);
+    int (*vectorBinary)(int astOp, int r1, int r2, int vectorType);
+    int (*vectorSplat)(int reg, int vectorType);
+
+    // Atomics on int and long objects: memory orders are MO_*, and
+    // the read-modify-write astOp is A_ATOMICFETCHADD or A_ATOMICEXCHANGE
+    int (*atomicLoad)(int pointerReg, int primitiveType, int order);
+    void (*atomicStore)(int valueReg, int pointerReg, int primitiveType,
+                        int order);
+    int (*atomicReadModifyWrite)(int astOp, int valueReg, int pointerReg,
+                                 int primitiveType, int order);
+    int (*atomicCompareExchange)(int pointerReg, int expectedPointerReg,
+                                 int desiredReg, int primitiveType,
+                                 int order);
+    void (*atomicFence)(int order);
+
+    // Software prefetch of the cache line at pointer + offset: hint is the
+    // locality of __builtin_prefetch, plus PREFETCH_WRITE
+    void (*prefetch)(int pointerReg, int offset, int hint);
+
+    // Inline assembly: the pool registers an asm statement clobbers are
+    // reserved before its operands are generated; inlineAsm then emits
+    // the text and frees every register but those of the outputs
+    void (*asmReserveClobbers)(struct asmStatement *a);
+    void (*inlineAsm)(struct asmStatement *a);
+
     // Offset
     void (*resetLocalOffset)(void);
-    int (*getLocalOffset)(int type, bool isFunctionParameter);
+    int (*getLocalOffset)(int id, bool isFunctionParameter);
 };
 
 // Selected backend-specific operation table
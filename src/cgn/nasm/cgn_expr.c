@@ -27,11 +27,13 @@ static int primitiveSizeInBytes[] = {
     8, // P_LONG
        // NOTE: Long is 8 bytes (64 bits) in x86_64
        // Later, we can add support 32 bits long(x86) if needed
-
-    8, // P_CHARPTR
-    8, // P_INTPTR
-    8, // P_LONGPTR
-    8  // Extra entry for safety/P_LONGPTR if enum values shifted
+    1, // P_UCHAR
+    4, // P_UINT
+    8, // P_ULONG
+    2, // P_SHORT
+    2, // P_USHORT
+    4, // P_FLOAT
+    8, // P_DOUBLE
 };
 
 /**
@@ -42,7 +44,7 @@ static int primitiveSizeInBytes[] = {
  * @return Size in bytes of the primitive type.
  */
 int nasmGetPrimitiveTypeSize(int type) {
-    if ((type < P_NONE) || (type > P_LONGPTR)) {
+    if ((type < P_NONE) || (type > P_DOUBLE)) {
         fprintf(
             stderr,
             "Error: Invalid primitive type %d in nasmGetPrimitiveTypeSize\n",
@@ -67,11 +69,92 @@ int nasmGetPrimitiveTypeSize(int type) {
 int nasmLoadImmediateInt(int value, int primitiveType) {
     int registerIndex = allocateRegister();
 
-    fprintf(Outfile, "\tmov\t%s, %d\n", qwordRegisterList[registerIndex],
-            value);
+    nasmEmit(INSN_ALU, 7, "\tmov\t%s, %d\n", qwordRegisterList[registerIndex],
+             value);
     return registerIndex;
 }
 
+/**
+ * nasmLoadImmediateFloat - Generates code to load a floating-point constant
+ * into an SSE register.
+ *
+ * NOTE:
+ * SSE has no immediate operands, so the bits of the value go through rax
+ * (zero is cleared with xorpd instead). Every floating-point value is held
+ * as a double in a register; a float constant is already rounded to float.
+ *
+ * @param value The constant to load.
+ * @param primitiveType The primitive type of the constant (unused).
+ *
+ * @return Index of the register containing the loaded value.
+ */
+int nasmLoadImmediateFloat(double value, int primitiveType) {
+    int reg = allocateFloatRegister();
+    long bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    if (bits == 0) {
+        nasmEmit(INSN_ALU, 4, "\txorpd\t%s, %s\n", floatRegisterName(reg),
+                 floatRegisterName(reg));
+        return reg;
+    }
+    nasmEmit(INSN_ALU, 10, "\tmov\trax, %ld\n", bits);
+    nasmEmit(INSN_ALU, 5, "\tmovq\t%s, rax\n", floatRegisterName(reg));
+    return reg;
+}
+
+/**
+ * nasmLoadFloatMemory - Generates code to load a float or double from a
+ * memory operand into a new SSE register, as a double.
+ *
+ * @param address The memory operand (e.g. "[r8+4]" or "[rbp-8]").
+ * @param primitiveType P_FLOAT or P_DOUBLE.
+ * @param bytes Estimated encoded length of a plain load of address.
+ *
+ * @return Index of the register containing the loaded value.
+ */
+static int nasmLoadFloatMemory(const char *address, int primitiveType,
+                               int bytes) {
+    int reg = allocateFloatRegister();
+
+    if (primitiveType == P_FLOAT) {
+        nasmEmit(INSN_LOAD, bytes + 1, "\tcvtss2sd\t%s, DWORD %s\n",
+                 floatRegisterName(reg), address);
+    } else {
+        nasmEmit(INSN_LOAD, bytes + 1, "\tmovsd\t%s, QWORD %s\n",
+                 floatRegisterName(reg), address);
+    }
+    return reg;
+}
+
+/**
+ * nasmStoreFloatMemory - Generates code to store an SSE register into a
+ * float or double memory operand.
+ *
+ * NOTE:
+ * A float store rounds the register to float first and leaves the rounded
+ * value in the register, since that is the value of the assignment.
+ *
+ * @param reg Index of the register containing the value to store.
+ * @param address The memory operand (e.g. "[r8+4]" or "[rbp-8]").
+ * @param primitiveType P_FLOAT or P_DOUBLE.
+ * @param bytes Estimated encoded length of a plain store to address.
+ */
+static void nasmStoreFloatMemory(int reg, const char *address,
+                                 int primitiveType, int bytes) {
+    char *name = floatRegisterName(reg);
+
+    if (primitiveType == P_FLOAT) {
+        nasmEmit(INSN_ALU, 4, "\tcvtsd2ss\t%s, %s\n", name, name);
+        nasmEmit(INSN_STORE, bytes + 1, "\tmovss\tDWORD %s, %s\n", address,
+                 name);
+        nasmEmit(INSN_ALU, 4, "\tcvtss2sd\t%s, %s\n", name, name);
+    } else {
+        nasmEmit(INSN_STORE, bytes + 1, "\tmovsd\tQWORD %s, %s\n", address,
+                 name);
+    }
+}
+
 /**
  * nasmLoadGlobalSymbol - Generates code to load a global symbol's value into a
  *                        register.
@@ -85,100 +168,150 @@ int nasmLoadImmediateInt(int value, int primitiveType) {
  * @return Index of the register containing the loaded value.
  */
 int nasmLoadGlobalSymbol(int id, int op) {
-    int registerIndex = allocateRegister();
-    int primitiveType = SymbolTable[id].primitiveType;
+    int registerIndex;
+    int primitiveType = getMemoryAccessType(SymbolTable[id].primitiveType);
+    char address[TEXTLEN + 8];
+
+    if (isFloatType(primitiveType)) {
+        snprintf(address, sizeof(address), "[%s]", SymbolTable[id].name);
+        return nasmLoadFloatMemory(address, primitiveType, 8);
+    }
+    registerIndex = allocateRegister();
 
     switch (primitiveType) {
     case P_CHAR:
+    case P_UCHAR:
         if (op == A_PREINCREMENT) {
             // Increase first, then load
-            fprintf(Outfile, "\tinc\tBYTE [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 7, "\tinc\tBYTE [%s]\n", SymbolTable[id].name);
         }
         if (op == A_PREDECREMENT) {
             // Decrease first, then load
-            fprintf(Outfile, "\tdec\tBYTE [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 7, "\tdec\tBYTE [%s]\n", SymbolTable[id].name);
         }
 
-        // Load
-        fprintf(Outfile, "\tmovzx\t%s, BYTE [%s]\n", // Zero-extend for char
-                qwordRegisterList[registerIndex],    // destination register
-                SymbolTable[id].name                 // source global symbol
+        // Load (zero-extend for char)
+        nasmEmit(INSN_LOAD, 9, "\tmovzx\t%s, BYTE [%s]\n",
+                 qwordRegisterList[registerIndex], // destination register
+                 SymbolTable[id].name              // source global symbol
+        );
+
+        if (op == A_POSTINCREMENT) {
+            // Load first, then increase
+            nasmEmit(INSN_STORE, 7, "\tinc\tBYTE [%s]\n", SymbolTable[id].name);
+        }
+        if (op == A_POSTDECREMENT) {
+            // Load first, then decrease
+            nasmEmit(INSN_STORE, 7, "\tdec\tBYTE [%s]\n", SymbolTable[id].name);
+        }
+
+        break;
+
+    case P_SHORT:
+    case P_USHORT:
+        if (op == A_PREINCREMENT) {
+            // Increase first, then load
+            nasmEmit(INSN_STORE, 8, "\tinc\tWORD [%s]\n", SymbolTable[id].name);
+        }
+        if (op == A_PREDECREMENT) {
+            // Decrease first, then load
+            nasmEmit(INSN_STORE, 8, "\tdec\tWORD [%s]\n", SymbolTable[id].name);
+        }
+
+        // Load (sign-extend short, zero-extend unsigned short)
+        nasmEmit(INSN_LOAD, 9, "\t%s\t%s, WORD [%s]\n",
+                 primitiveType == P_SHORT ? "movsx" : "movzx",
+                 qwordRegisterList[registerIndex], // destination register
+                 SymbolTable[id].name              // source global symbol
         );
 
         if (op == A_POSTINCREMENT) {
             // Load first, then increase
-            fprintf(Outfile, "\tinc\tBYTE [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 8, "\tinc\tWORD [%s]\n", SymbolTable[id].name);
         }
         if (op == A_POSTDECREMENT) {
             // Load first, then decrease
-            fprintf(Outfile, "\tdec\tBYTE [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 8, "\tdec\tWORD [%s]\n", SymbolTable[id].name);
         }
 
         break;
 
     case P_INT:
+    case P_UINT:
         if (op == A_PREINCREMENT) {
             // Increase first, then load
-            fprintf(Outfile, "\tinc\tDWORD [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 7, "\tinc\tDWORD [%s]\n",
+                     SymbolTable[id].name);
         }
         if (op == A_PREDECREMENT) {
             // Decrease first, then load
-            fprintf(Outfile, "\tdec\tDWORD [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 7, "\tdec\tDWORD [%s]\n",
+                     SymbolTable[id].name);
         }
 
         // Load
-        fprintf(Outfile, "\txor\t%s, %s\n",       // Clear upper 32 bits
-                qwordRegisterList[registerIndex], // destination register
-                qwordRegisterList[registerIndex]  // source register
-        );
-        fprintf(Outfile, "\tmov\t%s, DWORD [%s]\n",
-                dwordRegisterList[registerIndex], // lower 32 bits
-                SymbolTable[id].name              // source global symbol
-        );
-        fprintf(Outfile, "\tmovsxd\t%s, %s\n",
-                qwordRegisterList[registerIndex], // dest
-                dwordRegisterList[registerIndex]  // Sign-extend to 64 bits
-        );
+        if (primitiveType == P_UINT) {
+            // Writing a 32-bit register zero-extends it to 64 bits
+            nasmEmit(INSN_LOAD, 8, "\tmov\t%s, DWORD [%s]\n",
+                     dwordRegisterList[registerIndex], // lower 32 bits
+                     SymbolTable[id].name              // source global symbol
+            );
+        } else {
+            nasmEmit(INSN_ALU, 3, "\txor\t%s, %s\n", // Clear upper 32 bits
+                     qwordRegisterList[registerIndex], // destination register
+                     qwordRegisterList[registerIndex]  // source register
+            );
+            nasmEmit(INSN_LOAD, 8, "\tmov\t%s, DWORD [%s]\n",
+                     dwordRegisterList[registerIndex], // lower 32 bits
+                     SymbolTable[id].name              // source global symbol
+            );
+            nasmEmit(INSN_ALU, 3, "\tmovsxd\t%s, %s\n",
+                     qwordRegisterList[registerIndex], // dest
+                     dwordRegisterList[registerIndex]  // Sign-extend to 64 bits
+            );
+        }
 
         if (op == A_POSTINCREMENT) {
             // Load first, then increase
-            fprintf(Outfile, "\tinc\tDWORD [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 7, "\tinc\tDWORD [%s]\n",
+                     SymbolTable[id].name);
         }
         if (op == A_POSTDECREMENT) {
             // Load first, then decrease
-            fprintf(Outfile, "\tdec\tDWORD [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 7, "\tdec\tDWORD [%s]\n",
+                     SymbolTable[id].name);
         }
 
         break;
 
     case P_LONG:
-    // NOTE:
-    // pointer types are treated as long (64 bits) in x86_64
-    case P_CHARPTR:
-    case P_INTPTR:
-    case P_LONGPTR:
+    case P_ULONG:
         if (op == A_PREINCREMENT) {
             // Increase first, then load
-            fprintf(Outfile, "\tinc\tQWORD [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 8, "\tinc\tQWORD [%s]\n",
+                     SymbolTable[id].name);
         }
         if (op == A_PREDECREMENT) {
             // Decrease first, then load
-            fprintf(Outfile, "\tdec\tQWORD [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 8, "\tdec\tQWORD [%s]\n",
+                     SymbolTable[id].name);
         }
 
         // Load
-        fprintf(Outfile, "\tmov\t%s, [%s]\n",
-                qwordRegisterList[registerIndex], // destination register
-                SymbolTable[id].name              // source global symbol
+        nasmEmit(INSN_LOAD, 8, "\tmov\t%s, [%s]\n",
+                 qwordRegisterList[registerIndex], // destination register
+                 SymbolTable[id].name              // source global symbol
         );
 
         if (op == A_POSTINCREMENT) {
             // Load first, then increase
-            fprintf(Outfile, "\tinc\tQWORD [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 8, "\tinc\tQWORD [%s]\n",
+                     SymbolTable[id].name);
         }
         if (op == A_POSTDECREMENT) {
             // Load first, then decrease
-            fprintf(Outfile, "\tdec\tQWORD [%s]\n", SymbolTable[id].name);
+            nasmEmit(INSN_STORE, 8, "\tdec\tQWORD [%s]\n",
+                     SymbolTable[id].name);
         }
 
         break;
@@ -206,103 +339,147 @@ int nasmLoadGlobalSymbol(int id, int op) {
  * @return Index of the register containing the loaded value.
  */
 int nasmLoadLocalSymbol(int id, int op) {
-    int registerIndex = allocateRegister();
+    int registerIndex;
     int offset = SymbolTable[id].offset;
+    int primitiveType = getMemoryAccessType(SymbolTable[id].primitiveType);
+    char address[32];
 
-    switch (SymbolTable[id].primitiveType) {
+    if (isFloatType(primitiveType)) {
+        snprintf(address, sizeof(address), "[rbp%+d]", offset);
+        return nasmLoadFloatMemory(address, primitiveType, 4);
+    }
+    registerIndex = allocateRegister();
+
+    switch (primitiveType) {
     case P_CHAR:
+    case P_UCHAR:
         if (op == A_PREINCREMENT) {
             // Increment first, then load the value
-            fprintf(Outfile, "\tinc\tbyte\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 3, "\tinc\tbyte\t[rbp+%d]\n", offset);
         }
         if (op == A_PREDECREMENT) {
             // Decrement first, then load the value
-            fprintf(Outfile, "\tdec\tbyte\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 3, "\tdec\tbyte\t[rbp+%d]\n", offset);
         }
 
-        fprintf(Outfile, "\tmovzx\t%s, byte\t[rbp+%d]\n",
-                qwordRegisterList[registerIndex], // destination register
-                offset                            // source local symbol
+        nasmEmit(INSN_LOAD, 5, "\tmovzx\t%s, byte\t[rbp+%d]\n",
+                 qwordRegisterList[registerIndex], // destination register
+                 offset                            // source local symbol
         );
 
         if (op == A_POSTINCREMENT) {
             // Load first, then increment
-            fprintf(Outfile, "\tinc\tbyte\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 3, "\tinc\tbyte\t[rbp+%d]\n", offset);
         }
         if (op == A_POSTDECREMENT) {
             // Load first, then decrement
-            fprintf(Outfile, "\tdec\tbyte\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 3, "\tdec\tbyte\t[rbp+%d]\n", offset);
         }
 
         break;
 
-    case P_INT:
+    case P_SHORT:
+    case P_USHORT:
         if (op == A_PREINCREMENT) {
             // Increment first, then load the value
-            fprintf(Outfile, "\tinc\tDWORD\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 4, "\tinc\tWORD\t[rbp+%d]\n", offset);
         }
         if (op == A_PREDECREMENT) {
             // Decrement first, then load the value
-            fprintf(Outfile, "\tdec\tDWORD\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 4, "\tdec\tWORD\t[rbp+%d]\n", offset);
         }
 
-        fprintf(Outfile, "\txor\t%s, %s\n",       // Clear upper 32 bits
-                qwordRegisterList[registerIndex], // destination register
-                qwordRegisterList[registerIndex]  // source register
-        );
-        fprintf(Outfile, "\tmov\t%s, DWORD\t[rbp+%d]\n",
-                dwordRegisterList[registerIndex], // lower 32 bits
-                offset                            // source local symbol
-        );
-        fprintf(Outfile, "\tmovsxd\t%s, %s\n",
-                qwordRegisterList[registerIndex], // dest
-                dwordRegisterList[registerIndex]  // Sign-extend to 64 bits
+        // Sign-extend short, zero-extend unsigned short
+        nasmEmit(INSN_LOAD, 5, "\t%s\t%s, WORD\t[rbp+%d]\n",
+                 primitiveType == P_SHORT ? "movsx" : "movzx",
+                 qwordRegisterList[registerIndex], // destination register
+                 offset                            // source local symbol
         );
 
         if (op == A_POSTINCREMENT) {
             // Load first, then increment
-            fprintf(Outfile, "\tinc\tDWORD\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 4, "\tinc\tWORD\t[rbp+%d]\n", offset);
+        }
+        if (op == A_POSTDECREMENT) {
+            // Load first, then decrement
+            nasmEmit(INSN_STORE, 4, "\tdec\tWORD\t[rbp+%d]\n", offset);
+        }
+
+        break;
+
+    case P_INT:
+    case P_UINT:
+        if (op == A_PREINCREMENT) {
+            // Increment first, then load the value
+            nasmEmit(INSN_STORE, 3, "\tinc\tDWORD\t[rbp+%d]\n", offset);
+        }
+        if (op == A_PREDECREMENT) {
+            // Decrement first, then load the value
+            nasmEmit(INSN_STORE, 3, "\tdec\tDWORD\t[rbp+%d]\n", offset);
+        }
+
+        if (primitiveType == P_UINT) {
+            // Writing a 32-bit register zero-extends it to 64 bits
+            nasmEmit(INSN_LOAD, 4, "\tmov\t%s, DWORD\t[rbp+%d]\n",
+                     dwordRegisterList[registerIndex], // lower 32 bits
+                     offset                            // source local symbol
+            );
+        } else {
+            nasmEmit(INSN_ALU, 3, "\txor\t%s, %s\n", // Clear upper 32 bits
+                     qwordRegisterList[registerIndex], // destination register
+                     qwordRegisterList[registerIndex]  // source register
+            );
+            nasmEmit(INSN_LOAD, 4, "\tmov\t%s, DWORD\t[rbp+%d]\n",
+                     dwordRegisterList[registerIndex], // lower 32 bits
+                     offset                            // source local symbol
+            );
+            nasmEmit(INSN_ALU, 3, "\tmovsxd\t%s, %s\n",
+                     qwordRegisterList[registerIndex], // dest
+                     dwordRegisterList[registerIndex]  // Sign-extend to 64 bits
+            );
+        }
+
+        if (op == A_POSTINCREMENT) {
+            // Load first, then increment
+            nasmEmit(INSN_STORE, 3, "\tinc\tDWORD\t[rbp+%d]\n", offset);
         }
         if (op == A_POSTDECREMENT) {
             // Load first, then decrement
-            fprintf(Outfile, "\tdec\tDWORD\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 3, "\tdec\tDWORD\t[rbp+%d]\n", offset);
         }
 
         break;
 
     case P_LONG:
-    case P_CHARPTR:
-    case P_INTPTR:
-    case P_LONGPTR:
+    case P_ULONG:
         if (op == A_PREINCREMENT) {
             // Increase first, then load
-            fprintf(Outfile, "\tinc\tQWORD\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 4, "\tinc\tQWORD\t[rbp+%d]\n", offset);
         }
         if (op == A_PREDECREMENT) {
             // Decrease first, then load
-            fprintf(Outfile, "\tdec\tQWORD\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 4, "\tdec\tQWORD\t[rbp+%d]\n", offset);
         }
 
         // Load
-        fprintf(Outfile, "\tmov\t%s, QWORD\t[rbp+%d]\n",
-                qwordRegisterList[registerIndex], // destination register
-                offset                            // source local symbol
+        nasmEmit(INSN_LOAD, 4, "\tmov\t%s, QWORD\t[rbp+%d]\n",
+                 qwordRegisterList[registerIndex], // destination register
+                 offset                            // source local symbol
         );
 
         if (op == A_POSTINCREMENT) {
             // Load first, then increment
-            fprintf(Outfile, "\tinc\tQWORD\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 4, "\tinc\tQWORD\t[rbp+%d]\n", offset);
         }
         if (op == A_POSTDECREMENT) {
             // Load first, then decrement
-            fprintf(Outfile, "\tdec\tQWORD\t[rbp+%d]\n", offset);
+            nasmEmit(INSN_STORE, 4, "\tdec\tQWORD\t[rbp+%d]\n", offset);
         }
 
         break;
 
     default:
-        logFatald("Bad type in nasmLoadLocalSymbol: ",
-                  SymbolTable[id].primitiveType);
+        logFatald("Bad type in nasmLoadLocalSymbol: ", primitiveType);
     }
 
     return registerIndex;
@@ -319,9 +496,9 @@ int nasmLoadLocalSymbol(int id, int op) {
 int nasmLoadGlobalString(int id) {
     int registerIndex = allocateRegister();
 
-    fprintf(Outfile, "\tlea\t%s, [rel L%d]\n",
-            qwordRegisterList[registerIndex], // destination register
-            id                                // string label
+    nasmEmit(INSN_ALU, 7, "\tlea\t%s, [rel L%d]\n",
+             qwordRegisterList[registerIndex], // destination register
+             id                                // string label
     );
     return registerIndex;
 }
@@ -336,30 +513,42 @@ int nasmLoadGlobalString(int id) {
  * @return Index of the register that was stored.
  */
 int nasmStoreGlobalSymbol(int registerIndex, int id) {
-    int primitiveType = SymbolTable[id].primitiveType;
+    int primitiveType = getMemoryAccessType(SymbolTable[id].primitiveType);
+    char address[TEXTLEN + 8];
+
+    if (isFloatType(primitiveType)) {
+        snprintf(address, sizeof(address), "[%s]", SymbolTable[id].name);
+        nasmStoreFloatMemory(registerIndex, address, primitiveType, 8);
+        return registerIndex;
+    }
 
     switch (primitiveType) {
     case P_CHAR:
-        fprintf(
-            Outfile, "\tmov\t[%s], BYTE %s\n",
-            SymbolTable[id].name,           // destination global symbol
-            byteRegisterList[registerIndex] // source register (lower 8 bits)
+    case P_UCHAR:
+        nasmEmit(INSN_STORE, 8, "\tmov\t[%s], BYTE %s\n",
+                 SymbolTable[id].name,           // destination global symbol
+                 byteRegisterList[registerIndex] // source (lower 8 bits)
+        );
+        break;
+    case P_SHORT:
+    case P_USHORT:
+        nasmEmit(INSN_STORE, 9, "\tmov\t[%s], WORD %s\n",
+                 SymbolTable[id].name,           // destination global symbol
+                 wordRegisterList[registerIndex] // source (lower 16 bits)
         );
         break;
     case P_INT:
-        fprintf(
-            Outfile, "\tmov\t[%s], DWORD %s\n",
-            SymbolTable[id].name,            // destination global symbol
-            dwordRegisterList[registerIndex] // source register (lower 32 bits)
+    case P_UINT:
+        nasmEmit(INSN_STORE, 8, "\tmov\t[%s], DWORD %s\n",
+                 SymbolTable[id].name,            // destination global symbol
+                 dwordRegisterList[registerIndex] // source (lower 32 bits)
         );
         break;
     case P_LONG:
-    case P_CHARPTR:
-    case P_INTPTR:
-    case P_LONGPTR:
-        fprintf(Outfile, "\tmov\t[%s], QWORD %s\n",
-                SymbolTable[id].name,            // destination global symbol
-                qwordRegisterList[registerIndex] // source register
+    case P_ULONG:
+        nasmEmit(INSN_STORE, 8, "\tmov\t[%s], QWORD %s\n",
+                 SymbolTable[id].name,            // destination global symbol
+                 qwordRegisterList[registerIndex] // source register
         );
         break;
     default:
@@ -383,21 +572,35 @@ int nasmStoreGlobalSymbol(int registerIndex, int id) {
  * @return Index of the register that was stored.
  */
 int nasmStoreLocalSymbol(int registerIndex, int id) {
-    switch (SymbolTable[id].primitiveType) {
+    int primitiveType = getMemoryAccessType(SymbolTable[id].primitiveType);
+    char address[32];
+
+    if (isFloatType(primitiveType)) {
+        snprintf(address, sizeof(address), "[rbp%+d]", SymbolTable[id].offset);
+        nasmStoreFloatMemory(registerIndex, address, primitiveType, 4);
+        return registerIndex;
+    }
+
+    switch (primitiveType) {
     case P_CHAR:
-        fprintf(Outfile, "\tmov\tBYTE\t[rbp+%d], %s\n", SymbolTable[id].offset,
-                byteRegisterList[registerIndex]);
+    case P_UCHAR:
+        nasmEmit(INSN_STORE, 4, "\tmov\tBYTE\t[rbp+%d], %s\n",
+                 SymbolTable[id].offset, byteRegisterList[registerIndex]);
+        break;
+    case P_SHORT:
+    case P_USHORT:
+        nasmEmit(INSN_STORE, 5, "\tmov\tWORD\t[rbp+%d], %s\n",
+                 SymbolTable[id].offset, wordRegisterList[registerIndex]);
         break;
     case P_INT:
-        fprintf(Outfile, "\tmov\tDWORD\t[rbp+%d], %s\n", SymbolTable[id].offset,
-                dwordRegisterList[registerIndex]);
+    case P_UINT:
+        nasmEmit(INSN_STORE, 4, "\tmov\tDWORD\t[rbp+%d], %s\n",
+                 SymbolTable[id].offset, dwordRegisterList[registerIndex]);
         break;
     case P_LONG:
-    case P_CHARPTR:
-    case P_INTPTR:
-    case P_LONGPTR:
-        fprintf(Outfile, "\tmov\tQWORD\t[rbp+%d], %s\n", SymbolTable[id].offset,
-                qwordRegisterList[registerIndex]);
+    case P_ULONG:
+        nasmEmit(INSN_STORE, 4, "\tmov\tQWORD\t[rbp+%d], %s\n",
+                 SymbolTable[id].offset, qwordRegisterList[registerIndex]);
         break;
     default:
         logFatald("Bad type in nasmStoreLocalSymbol: ",
@@ -408,15 +611,18 @@ int nasmStoreLocalSymbol(int registerIndex, int id) {
 }
 
 /**
- * nasmAlignPow2 - Returns the largest power-of-two alignment <= n, capped at 8.
- * (e.g. 1->1, 2->2, 3->2, 4->4, 5->4, 8->8, 16->8, etc.)
+ * nasmAlignPow2 - Returns the largest power-of-two alignment <= n, capped at
+ * 16 (the alignment of vectors).
+ * (e.g. 1->1, 2->2, 3->2, 4->4, 5->4, 8->8, 16->16, 32->16, etc.)
  *
  * @param n The requested alignment in bytes.
  *
  * @return The aligned power-of-two value.
  */
 static int nasmAlignPow2(int n) {
-    if (n >= 8) {
+    if (n >= 16) {
+        return 16;
+    } else if (n >= 8) {
         return 8;
     } else if (n >= 4) {
         return 4;
@@ -442,8 +648,11 @@ void nasmDeclareGlobalSymbol(int id) {
     }
 
     int primitiveType = SymbolTable[id].primitiveType;
+    if (SymbolTable[id].structuralType == S_ARRAY) {
+        primitiveType = TypeTable[primitiveType].base;
+    }
 
-    int elementSize = nasmGetPrimitiveTypeSize(primitiveType);
+    int elementSize = getTypeSize(primitiveType);
     if (elementSize <= 0) {
         fprintf(stderr, "Error: bad elemSize %d for symbol %s\n", elementSize,
                 SymbolTable[id].name);
@@ -468,12 +677,35 @@ void nasmDeclareGlobalSymbol(int id) {
 
     long long totalBytesRequired = (long long)elementSize * (long long)count;
 
-    int alignment = nasmAlignPow2(elementSize);
+    int alignment = nasmAlignPow2(getSymbolAlignment(id));
+
+    // A variable with an initial value lives in the data segment, and one
+    // that is never stored to in the read-only data segment
+    if (SymbolTable[id].isInitialized || SymbolTable[id].isReadOnly) {
+        static const char *dataDirectives[] = {
+            [1] = "db", [2] = "dw", [4] = "dd", [8] = "dq"};
+        if (SymbolTable[id].isReadOnly) {
+            nasmDeclareRodataSegment();
+        } else {
+            nasmDeclareDataSegment();
+        }
+        fprintf(Outfile, "\talign\t%d\n", alignment);
+        if (SymbolTable[id].class == C_GLOBAL) {
+            fprintf(Outfile, "\tglobal\t%s\n", SymbolTable[id].name);
+        }
+        fprintf(Outfile, "%s:\n", SymbolTable[id].name);
+        fprintf(Outfile, "\t%s\t%ld\n", dataDirectives[elementSize],
+                SymbolTable[id].initialValue);
+        return;
+    }
 
     // Prefer BSS for zero-initialized storage
-    fprintf(Outfile, "\tsection\t.bss\n");
+    nasmDeclareBssSegment();
     fprintf(Outfile, "\talign\t%d\n", alignment);
-    fprintf(Outfile, "\tglobal\t%s\n", SymbolTable[id].name);
+    // Statics stay local to the object file
+    if (SymbolTable[id].class == C_GLOBAL) {
+        fprintf(Outfile, "\tglobal\t%s\n", SymbolTable[id].name);
+    }
     fprintf(Outfile, "%s:\n", SymbolTable[id].name);
 
     // Reserve storage: choose the directive that matches element width.
@@ -509,7 +741,7 @@ void nasmDeclareGlobalSymbol(int id) {
 void nasmDeclareGlobalString(int labelIndex, char *stringValue) {
     const unsigned char *s = (const unsigned char *)stringValue;
 
-    fprintf(Outfile, "\tsection .rodata\n");
+    nasmDeclareRodataSegment();
     nasmLabel(labelIndex);
 
     fprintf(Outfile, "\tdb ");
@@ -564,8 +796,14 @@ void nasmDeclareGlobalString(int labelIndex, char *stringValue) {
  * @return Index of the register containing the result.
  */
 int nasmAddRegs(int r1, int r2) {
-    fprintf(Outfile, "\tadd\t%s, %s\n", qwordRegisterList[r2],
-            qwordRegisterList[r1]);
+    if (isFloatRegister(r1)) {
+        nasmEmit(INSN_ALU, 4, "\taddsd\t%s, %s\n", floatRegisterName(r2),
+                 floatRegisterName(r1));
+        freeRegister(r1);
+        return r2;
+    }
+    nasmEmit(INSN_ALU, 3, "\tadd\t%s, %s\n", qwordRegisterList[r2],
+             qwordRegisterList[r1]);
     freeRegister(r1);
 
     return r2;
@@ -580,8 +818,14 @@ int nasmAddRegs(int r1, int r2) {
  * @return Index of the register containing the result.
  */
 int nasmSubRegs(int r1, int r2) {
-    fprintf(Outfile, "\tsub\t%s, %s\n", qwordRegisterList[r1],
-            qwordRegisterList[r2]);
+    if (isFloatRegister(r1)) {
+        nasmEmit(INSN_ALU, 4, "\tsubsd\t%s, %s\n", floatRegisterName(r1),
+                 floatRegisterName(r2));
+        freeRegister(r2);
+        return r1;
+    }
+    nasmEmit(INSN_ALU, 3, "\tsub\t%s, %s\n", qwordRegisterList[r1],
+             qwordRegisterList[r2]);
     freeRegister(r2);
 
     return r1;
@@ -596,8 +840,14 @@ int nasmSubRegs(int r1, int r2) {
  * @return Index of the register containing the result.
  */
 int nasmMulRegs(int r1, int r2) {
-    fprintf(Outfile, "\timul\t%s, %s\n", qwordRegisterList[r2],
-            qwordRegisterList[r1]);
+    if (isFloatRegister(r1)) {
+        nasmEmit(INSN_ALU, 4, "\tmulsd\t%s, %s\n", floatRegisterName(r2),
+                 floatRegisterName(r1));
+        freeRegister(r1);
+        return r2;
+    }
+    nasmEmit(INSN_ALU, 4, "\timul\t%s, %s\n", qwordRegisterList[r2],
+             qwordRegisterList[r1]);
     freeRegister(r1);
 
     return r2;
@@ -605,6 +855,7 @@ int nasmMulRegs(int r1, int r2) {
 
 /**
  * nasmDivRegsSigned - Generates code to divide values in two registers.
+ * Floating-point values are divided here as well.
  *
  * @param r1 Index of the dividend register.
  * @param r2 Index of the divisor register.
@@ -612,10 +863,35 @@ int nasmMulRegs(int r1, int r2) {
  * @return Index of the register containing the result (quotient).
  */
 int nasmDivRegsSigned(int r1, int r2) {
-    fprintf(Outfile, "\tmov\trax, %s\n", qwordRegisterList[r1]);
-    fprintf(Outfile, "\tcqo\n"); // Sign-extend rax into rdx:rax
-    fprintf(Outfile, "\tidiv\t%s\n", qwordRegisterList[r2]);
-    fprintf(Outfile, "\tmov\t%s, rax\n", qwordRegisterList[r1]);
+    if (isFloatRegister(r1)) {
+        nasmEmit(INSN_ALU, 4, "\tdivsd\t%s, %s\n", floatRegisterName(r1),
+                 floatRegisterName(r2));
+        freeRegister(r2);
+        return r1;
+    }
+    nasmEmit(INSN_ALU, 3, "\tmov\trax, %s\n", qwordRegisterList[r1]);
+    nasmEmit(INSN_ALU, 2, "\tcqo\n"); // Sign-extend rax into rdx:rax
+    nasmEmit(INSN_ALU, 3, "\tidiv\t%s\n", qwordRegisterList[r2]);
+    nasmEmit(INSN_ALU, 3, "\tmov\t%s, rax\n", qwordRegisterList[r1]);
+    freeRegister(r2);
+
+    return r1;
+}
+
+/**
+ * nasmDivRegsUnsigned - Generates code to divide values in two registers as
+ * unsigned integers.
+ *
+ * @param r1 Index of the dividend register.
+ * @param r2 Index of the divisor register.
+ *
+ * @return Index of the register containing the result (quotient).
+ */
+int nasmDivRegsUnsigned(int r1, int r2) {
+    nasmEmit(INSN_ALU, 3, "\tmov\trax, %s\n", qwordRegisterList[r1]);
+    nasmEmit(INSN_ALU, 2, "\txor\tedx, edx\n"); // Zero-extend into rdx:rax
+    nasmEmit(INSN_ALU, 3, "\tdiv\t%s\n", qwordRegisterList[r2]);
+    nasmEmit(INSN_ALU, 3, "\tmov\t%s, rax\n", qwordRegisterList[r1]);
     freeRegister(r2);
 
     return r1;
@@ -629,7 +905,14 @@ int nasmDivRegsSigned(int r1, int r2) {
  * @return Index of the register containing the negated value.
  */
 int nasmArithmeticNegate(int reg) {
-    fprintf(Outfile, "\tneg\t%s\n", qwordRegisterList[reg]);
+    if (isFloatRegister(reg)) {
+        // Flip the sign bit
+        nasmEmit(INSN_ALU, 5, "\tmovq\trax, %s\n", floatRegisterName(reg));
+        nasmEmit(INSN_ALU, 5, "\tbtc\trax, 63\n");
+        nasmEmit(INSN_ALU, 5, "\tmovq\t%s, rax\n", floatRegisterName(reg));
+        return reg;
+    }
+    nasmEmit(INSN_ALU, 3, "\tneg\t%s\n", qwordRegisterList[reg]);
 
     return reg;
 }
@@ -643,11 +926,40 @@ int nasmArithmeticNegate(int reg) {
  * @return Index of the register containing the inverted value.
  */
 int nasmLogicalInvert(int reg) {
-    fprintf(Outfile, "\tnot\t%s\n", qwordRegisterList[reg]);
+    nasmEmit(INSN_ALU, 3, "\tnot\t%s\n", qwordRegisterList[reg]);
 
     return reg;
 }
 
+/**
+ * nasmFloatIsNonZero - Generates code to set a general-purpose register to 1
+ * if an SSE register is non-zero (a NaN is non-zero) and to 0 otherwise.
+ * (helper function)
+ *
+ * @param reg Index of the SSE register, which is freed.
+ *
+ * @return Index of the register containing 0 or 1.
+ */
+static int nasmFloatIsNonZero(int reg) {
+    int zeroReg = allocateFloatRegister();
+    int outReg = allocateRegister();
+
+    nasmEmit(INSN_ALU, 4, "\txorpd\t%s, %s\n", floatRegisterName(zeroReg),
+             floatRegisterName(zeroReg));
+    nasmEmit(INSN_ALU, 4, "\tucomisd\t%s, %s\n", floatRegisterName(reg),
+             floatRegisterName(zeroReg));
+    // Unordered (NaN) sets ZF and PF
+    nasmEmit(INSN_ALU, 4, "\tsetne\t%s\n", byteRegisterList[outReg]);
+    nasmEmit(INSN_ALU, 3, "\tsetp\tal\n");
+    nasmEmit(INSN_ALU, 3, "\tor\t%s, al\n", byteRegisterList[outReg]);
+    nasmEmit(INSN_ALU, 4, "\tmovzx\t%s, %s\n", qwordRegisterList[outReg],
+             byteRegisterList[outReg]);
+    freeRegister(zeroReg);
+    freeRegister(reg);
+
+    return outReg;
+}
+
 /**
  * nasmLogicalNot - Generates code to logically NOT a register's value.
  * (i.e., set to 1 if zero, else set to 0)
@@ -657,11 +969,14 @@ int nasmLogicalInvert(int reg) {
  * @return Index of the register containing the NOTed value.
  */
 int nasmLogicalNot(int reg) {
-    fprintf(Outfile, "\ttest\t%s, %s\n", qwordRegisterList[reg],
-            qwordRegisterList[reg]);
-    fprintf(Outfile, "\tsete\t%s\n", byteRegisterList[reg]);
-    fprintf(Outfile, "\tmovzx\t%s, %s\n", qwordRegisterList[reg],
-            byteRegisterList[reg]);
+    if (isFloatRegister(reg)) {
+        reg = nasmFloatIsNonZero(reg);
+    }
+    nasmEmit(INSN_ALU, 3, "\ttest\t%s, %s\n", qwordRegisterList[reg],
+             qwordRegisterList[reg]);
+    nasmEmit(INSN_ALU, 4, "\tsete\t%s\n", byteRegisterList[reg]);
+    nasmEmit(INSN_ALU, 4, "\tmovzx\t%s, %s\n", qwordRegisterList[reg],
+             byteRegisterList[reg]);
 
     return reg;
 }
@@ -670,24 +985,30 @@ int nasmLogicalNot(int reg) {
  * nasmToBoolean - Generates code to convert a register's value to boolean.
  *
  * If used in an A_IF or A_WHILE operation, generates a jump to the given
- * label if the value is zero. Otherwise, sets the register to 0 or 1 based on
- * its truthiness.
+ * label if the value is zero; in an A_DOWHILE, jumps if it is non-zero.
+ * Otherwise, sets the register to 0 or 1 based on its truthiness.
+ * A floating-point value gives its 0 or 1 in a general-purpose register.
  *
  * @param reg Index of the register to convert.
  * @param op The AST operation code (A_IF, A_WHILE, etc.)
- * @param label The label to jump to if the value is zero (for A_IF/A_WHILE).
+ * @param label The label to jump to (for A_IF/A_WHILE/A_DOWHILE).
  *
  * @return Index of the register containing the boolean value (0 or 1).
  */
 int nasmToBoolean(int reg, int op, int label) {
-    fprintf(Outfile, "\ttest\t%s, %s\n", qwordRegisterList[reg],
-            qwordRegisterList[reg]);
+    if (isFloatRegister(reg)) {
+        reg = nasmFloatIsNonZero(reg);
+    }
+    nasmEmit(INSN_ALU, 3, "\ttest\t%s, %s\n", qwordRegisterList[reg],
+             qwordRegisterList[reg]);
     if (op == A_IF || op == A_WHILE) {
-        fprintf(Outfile, "\tje\tL%d\n", label);
+        nasmEmit(INSN_BRANCH, 6, "\tje\tL%d\n", label);
+    } else if (op == A_DOWHILE) {
+        nasmEmit(INSN_BRANCH, 6, "\tjne\tL%d\n", label);
     } else {
-        fprintf(Outfile, "\tsetnz\t%s\n", byteRegisterList[reg]);
-        fprintf(Outfile, "\tmovzx\t%s, %s\n", qwordRegisterList[reg],
-                byteRegisterList[reg]);
+        nasmEmit(INSN_ALU, 4, "\tsetnz\t%s\n", byteRegisterList[reg]);
+        nasmEmit(INSN_ALU, 4, "\tmovzx\t%s, %s\n", qwordRegisterList[reg],
+                 byteRegisterList[reg]);
     }
 
     return reg;
@@ -703,8 +1024,8 @@ int nasmToBoolean(int reg, int op, int label) {
  * @return Index of the register containing the result.
  */
 int nasmBitwiseAndRegs(int dstReg, int srcReg) {
-    fprintf(Outfile, "\tand\t%s, %s\n", qwordRegisterList[dstReg],
-            qwordRegisterList[srcReg]);
+    nasmEmit(INSN_ALU, 3, "\tand\t%s, %s\n", qwordRegisterList[dstReg],
+             qwordRegisterList[srcReg]);
     freeRegister(srcReg);
 
     return dstReg;
@@ -720,8 +1041,8 @@ int nasmBitwiseAndRegs(int dstReg, int srcReg) {
  * @return Index of the register containing the result.
  */
 int nasmBitwiseOrRegs(int dstReg, int srcReg) {
-    fprintf(Outfile, "\tor\t%s, %s\n", qwordRegisterList[dstReg],
-            qwordRegisterList[srcReg]);
+    nasmEmit(INSN_ALU, 3, "\tor\t%s, %s\n", qwordRegisterList[dstReg],
+             qwordRegisterList[srcReg]);
     freeRegister(srcReg);
 
     return dstReg;
@@ -737,8 +1058,8 @@ int nasmBitwiseOrRegs(int dstReg, int srcReg) {
  * @return Index of the register containing the result.
  */
 int nasmBitwiseXorRegs(int dstReg, int srcReg) {
-    fprintf(Outfile, "\txor\t%s, %s\n", qwordRegisterList[dstReg],
-            qwordRegisterList[srcReg]);
+    nasmEmit(INSN_ALU, 3, "\txor\t%s, %s\n", qwordRegisterList[dstReg],
+             qwordRegisterList[srcReg]);
     freeRegister(srcReg);
 
     return dstReg;
@@ -754,7 +1075,8 @@ int nasmBitwiseXorRegs(int dstReg, int srcReg) {
  * @return Index of the register containing the shifted value.
  */
 int nasmShiftLeftConst(int reg, int shiftAmount) {
-    fprintf(Outfile, "\tshl\t%s, %d\n", qwordRegisterList[reg], shiftAmount);
+    nasmEmit(INSN_ALU, 4, "\tshl\t%s, %d\n", qwordRegisterList[reg],
+             shiftAmount);
     return reg;
 }
 
@@ -768,30 +1090,99 @@ int nasmShiftLeftConst(int reg, int shiftAmount) {
  * @return Index of the register containing the shifted value.
  */
 int nasmShiftLeftRegs(int dstReg, int srcReg) {
-    fprintf(Outfile, "\tmov\tcl, %s\n", byteRegisterList[srcReg]);
-    fprintf(Outfile, "\tshl\t%s, cl\n", qwordRegisterList[dstReg]);
+    nasmEmit(INSN_ALU, 3, "\tmov\tcl, %s\n", byteRegisterList[srcReg]);
+    nasmEmit(INSN_ALU, 3, "\tshl\t%s, cl\n", qwordRegisterList[dstReg]);
     freeRegister(srcReg);
 
     return dstReg;
 }
 
 /**
- * nasmShiftRightConst - Generates code to shift a register's value right by a
- * constant amount.
+ * nasmShiftRightRegsSigned - Generates code to shift a signed value right
+ * (arithmetic shift) by an amount specified in another register.
  *
- * @param reg Index of the register to shift.
- * @param shiftAmount The constant amount to shift right.
+ * @param dstReg Index of the register to shift.
+ * @param srcReg Index of the register containing the shift amount.
  *
  * @return Index of the register containing the shifted value.
  */
-int nasmShiftRightRegs(int dstReg, int srcReg) {
-    fprintf(Outfile, "\tmov\tcl, %s\n", byteRegisterList[srcReg]);
-    fprintf(Outfile, "\tshr\t%s, cl\n", qwordRegisterList[dstReg]);
+int nasmShiftRightRegsSigned(int dstReg, int srcReg) {
+    nasmEmit(INSN_ALU, 3, "\tmov\tcl, %s\n", byteRegisterList[srcReg]);
+    nasmEmit(INSN_ALU, 3, "\tsar\t%s, cl\n", qwordRegisterList[dstReg]);
     freeRegister(srcReg);
 
     return dstReg;
 }
 
+/**
+ * nasmShiftRightRegsUnsigned - Generates code to shift an unsigned value right
+ * (logical shift) by an amount specified in another register.
+ *
+ * @param dstReg Index of the register to shift.
+ * @param srcReg Index of the register containing the shift amount.
+ *
+ * @return Index of the register containing the shifted value.
+ */
+int nasmShiftRightRegsUnsigned(int dstReg, int srcReg) {
+    nasmEmit(INSN_ALU, 3, "\tmov\tcl, %s\n", byteRegisterList[srcReg]);
+    nasmEmit(INSN_ALU, 3, "\tshr\t%s, cl\n", qwordRegisterList[dstReg]);
+    freeRegister(srcReg);
+
+    return dstReg;
+}
+
+/**
+ * nasmCompareFloatsAndSet - Generates code to compare two SSE registers and
+ * set a general-purpose register to the result. (helper function)
+ *
+ * NOTE:
+ * ucomisd sets the flags like an unsigned compare, and sets ZF, PF and CF
+ * when an operand is a NaN. "<" and "<=" swap the operands and test ">" and
+ * ">=", which are false for a NaN; "==" and "!=" also check PF.
+ *
+ * @param ASTop The AST operation code representing the comparison.
+ * @param r1 Index of the first register.
+ * @param r2 Index of the second register.
+ *
+ * @return Index of the register containing the comparison result (0 or 1).
+ */
+static int nasmCompareFloatsAndSet(int ASTop, int r1, int r2) {
+    int outReg = allocateRegister();
+    char *byteRegister = byteRegisterList[outReg];
+    bool isSwapped = (ASTop == A_LT || ASTop == A_LE);
+
+    nasmEmit(INSN_ALU, 4, "\tucomisd\t%s, %s\n",
+             floatRegisterName(isSwapped ? r2 : r1),
+             floatRegisterName(isSwapped ? r1 : r2));
+
+    switch (ASTop) {
+    case A_EQ:
+        nasmEmit(INSN_ALU, 4, "\tsete\t%s\n", byteRegister);
+        nasmEmit(INSN_ALU, 3, "\tsetnp\tal\n");
+        nasmEmit(INSN_ALU, 3, "\tand\t%s, al\n", byteRegister);
+        break;
+    case A_NE:
+        nasmEmit(INSN_ALU, 4, "\tsetne\t%s\n", byteRegister);
+        nasmEmit(INSN_ALU, 3, "\tsetp\tal\n");
+        nasmEmit(INSN_ALU, 3, "\tor\t%s, al\n", byteRegister);
+        break;
+    case A_LT:
+    case A_GT:
+        nasmEmit(INSN_ALU, 4, "\tseta\t%s\n", byteRegister);
+        break;
+    default: // A_LE, A_GE
+        nasmEmit(INSN_ALU, 4, "\tsetae\t%s\n", byteRegister);
+        break;
+    }
+
+    nasmEmit(INSN_ALU, 4, "\tmovzx\t%s, %s\n", qwordRegisterList[outReg],
+             byteRegister);
+    freeRegister(r1);
+    freeRegister(r2);
+
+    return outReg;
+}
+
 /**
  * nasmCompareAndSet - Generates code to compare two registers and set a
  * third register based on the comparison result.
@@ -799,10 +1190,13 @@ int nasmShiftRightRegs(int dstReg, int srcReg) {
  * @param ASTop The AST operation code representing the comparison.
  * @param r1 Index of the first register.
  * @param r2 Index of the second register.
+ * @param primitiveType The type of the compared values.
  *
  * @return Index of the register containing the comparison result (0 or 1).
  */
-int nasmCompareAndSet(int ASTop, int r1, int r2) {
+int nasmCompareAndSet(int ASTop, int r1, int r2, int primitiveType) {
+    bool isUnsigned = isUnsignedType(primitiveType);
+
     if (!((ASTop == A_EQ) || (ASTop == A_NE) || (ASTop == A_LT) ||
           (ASTop == A_LE) || (ASTop == A_GT) || (ASTop == A_GE))) {
         fprintf(stderr,
@@ -811,29 +1205,37 @@ int nasmCompareAndSet(int ASTop, int r1, int r2) {
         exit(1);
     }
 
-    fprintf(Outfile, "\tcmp\t%s, %s\n", qwordRegisterList[r1],
-            qwordRegisterList[r2]);
+    if (isFloatType(primitiveType)) {
+        return nasmCompareFloatsAndSet(ASTop, r1, r2);
+    }
+
+    nasmEmit(INSN_ALU, 3, "\tcmp\t%s, %s\n", qwordRegisterList[r1],
+             qwordRegisterList[r2]);
 
     // Set the lower 8 bits of r1 based on the comparison
     char *byteRegister = byteRegisterList[r2];
     switch (ASTop) {
     case A_EQ:
-        fprintf(Outfile, "\tsete\t%s\n", byteRegister);
+        nasmEmit(INSN_ALU, 4, "\tsete\t%s\n", byteRegister);
         break;
     case A_NE:
-        fprintf(Outfile, "\tsetne\t%s\n", byteRegister);
+        nasmEmit(INSN_ALU, 4, "\tsetne\t%s\n", byteRegister);
         break;
     case A_LT:
-        fprintf(Outfile, "\tsetl\t%s\n", byteRegister);
+        nasmEmit(INSN_ALU, 4, "\t%s\t%s\n", isUnsigned ? "setb" : "setl",
+                 byteRegister);
         break;
     case A_LE:
-        fprintf(Outfile, "\tsetle\t%s\n", byteRegister);
+        nasmEmit(INSN_ALU, 4, "\t%s\t%s\n", isUnsigned ? "setbe" : "setle",
+                 byteRegister);
         break;
     case A_GT:
-        fprintf(Outfile, "\tsetg\t%s\n", byteRegister);
+        nasmEmit(INSN_ALU, 4, "\t%s\t%s\n", isUnsigned ? "seta" : "setg",
+                 byteRegister);
         break;
     case A_GE:
-        fprintf(Outfile, "\tsetge\t%s\n", byteRegister);
+        nasmEmit(INSN_ALU, 4, "\t%s\t%s\n", isUnsigned ? "setae" : "setge",
+                 byteRegister);
         break;
     default:
         fprintf(stderr,
@@ -843,13 +1245,69 @@ int nasmCompareAndSet(int ASTop, int r1, int r2) {
     }
 
     // Zero-extend the result to the full register
-    fprintf(Outfile, "\tmovzx\t%s, %s\n", qwordRegisterList[r2], byteRegister);
+    nasmEmit(INSN_ALU, 4, "\tmovzx\t%s, %s\n", qwordRegisterList[r2],
+             byteRegister);
 
     freeRegister(r1);
 
     return r2;
 }
 
+/**
+ * nasmConvertIntegerToFloat - Generates code to convert an integer register
+ * to a float or double in a new SSE register. (helper function)
+ *
+ * NOTE:
+ * cvtsi2sd/cvtsi2ss only take signed integers. An unsigned long with the
+ * top bit set is halved first (keeping the lowest bit so that it rounds
+ * the same way), converted and doubled back. A float is converted with
+ * cvtsi2ss, so that it is rounded once, and then held as a double.
+ *
+ * @param r Index of the integer register, which is freed.
+ * @param oldPrimitiveType The integer type.
+ * @param newPrimitiveType P_FLOAT or P_DOUBLE.
+ *
+ * @return Index of the SSE register containing the converted value.
+ */
+static int nasmConvertIntegerToFloat(int r, int oldPrimitiveType,
+                                     int newPrimitiveType) {
+    int outReg = allocateFloatRegister();
+    char *out = floatRegisterName(outReg);
+    char *suffix = (newPrimitiveType == P_FLOAT) ? "ss" : "sd";
+    int labelSigned;
+    int labelDone;
+
+    nasmEmit(INSN_ALU, 4, "\txorpd\t%s, %s\n", out, out);
+    if (oldPrimitiveType != P_ULONG) {
+        // Registers hold integers sign- or zero-extended to 64 bits
+        nasmEmit(INSN_ALU, 5, "\tcvtsi2%s\t%s, %s\n", suffix, out,
+                 qwordRegisterList[r]);
+    } else {
+        labelSigned = codegenGetLabelNumber();
+        labelDone = codegenGetLabelNumber();
+        nasmEmit(INSN_ALU, 3, "\ttest\t%s, %s\n", qwordRegisterList[r],
+                 qwordRegisterList[r]);
+        nasmEmit(INSN_BRANCH, 6, "\tjns\tL%d\n", labelSigned);
+        nasmEmit(INSN_ALU, 3, "\tmov\trax, %s\n", qwordRegisterList[r]);
+        nasmEmit(INSN_ALU, 3, "\tshr\trax, 1\n");
+        nasmEmit(INSN_ALU, 4, "\tand\t%s, 1\n", qwordRegisterList[r]);
+        nasmEmit(INSN_ALU, 3, "\tor\trax, %s\n", qwordRegisterList[r]);
+        nasmEmit(INSN_ALU, 5, "\tcvtsi2%s\t%s, rax\n", suffix, out);
+        nasmEmit(INSN_ALU, 4, "\tadd%s\t%s, %s\n", suffix, out, out);
+        nasmJump(labelDone);
+        nasmLabel(labelSigned);
+        nasmEmit(INSN_ALU, 5, "\tcvtsi2%s\t%s, %s\n", suffix, out,
+                 qwordRegisterList[r]);
+        nasmLabel(labelDone);
+    }
+    if (newPrimitiveType == P_FLOAT) {
+        nasmEmit(INSN_ALU, 4, "\tcvtss2sd\t%s, %s\n", out, out);
+    }
+    freeRegister(r);
+
+    return outReg;
+}
+
 /**
  * nasmWidenPrimitiveType - Handles widening of primitive types.
  *
@@ -858,12 +1316,71 @@ int nasmCompareAndSet(int ASTop, int r1, int r2) {
  * @param newPrimitiveType The target primitive type.
  *
  * NOTE:
- * For x86_64, no action is needed since all integers are treated as 64-bit.
+ * For x86_64, all integers are treated as 64-bit and loads already sign- or
+ * zero-extend, so only conversions from and to unsigned int need work: they
+ * clear bits 32-63 (writing a 32-bit register zero-extends it). A negative
+ * short becomes an unsigned int the same way. A conversion to a narrower
+ * type truncates the value and extends it again, as a load of that type
+ * would.
+ *
+ * Conversions to and from floating-point types move the value between a
+ * general-purpose and an SSE register. Floating-point values are held as
+ * doubles, so float <-> double needs no code: stores and returns round to
+ * float. A conversion to an integer truncates towards zero.
  *
  * @return Index of the register containing the (possibly widened) value.
  */
 int nasmWidenPrimitiveType(int r, int oldPrimitiveType, int newPrimitiveType) {
-    // No action needed for x86_64 as all integers are treated as 64-bit
+    int outReg;
+
+    if (isFloatType(oldPrimitiveType)) {
+        if (isFloatType(newPrimitiveType)) {
+            return r;
+        }
+        outReg = allocateRegister();
+        nasmEmit(INSN_ALU, 5, "\tcvttsd2si\t%s, %s\n",
+                 qwordRegisterList[outReg], floatRegisterName(r));
+        freeRegister(r);
+        return outReg;
+    }
+    if (isFloatType(newPrimitiveType)) {
+        return nasmConvertIntegerToFloat(r, oldPrimitiveType,
+                                         newPrimitiveType);
+    }
+
+    if (getTypeSize(newPrimitiveType) < getTypeSize(oldPrimitiveType)) {
+        switch (newPrimitiveType) {
+        case P_CHAR:
+        case P_UCHAR:
+            nasmEmit(INSN_ALU, 4, "\tmovzx\t%s, %s\n", dwordRegisterList[r],
+                     byteRegisterList[r]);
+            break;
+        case P_SHORT:
+            nasmEmit(INSN_ALU, 4, "\tmovsx\t%s, %s\n", qwordRegisterList[r],
+                     wordRegisterList[r]);
+            break;
+        case P_USHORT:
+            nasmEmit(INSN_ALU, 3, "\tmovzx\t%s, %s\n", dwordRegisterList[r],
+                     wordRegisterList[r]);
+            break;
+        case P_INT:
+            nasmEmit(INSN_ALU, 3, "\tmovsxd\t%s, %s\n", qwordRegisterList[r],
+                     dwordRegisterList[r]);
+            break;
+        default: // P_UINT
+            nasmEmit(INSN_ALU, 2, "\tmov\t%s, %s\n", dwordRegisterList[r],
+                     dwordRegisterList[r]);
+            break;
+        }
+        return r;
+    }
+
+    if (oldPrimitiveType == P_UINT ||
+        ((oldPrimitiveType == P_INT || oldPrimitiveType == P_SHORT) &&
+         newPrimitiveType == P_UINT)) {
+        nasmEmit(INSN_ALU, 2, "\tmov\t%s, %s\n", dwordRegisterList[r],
+                 dwordRegisterList[r]);
+    }
     return r;
 }
 
@@ -880,54 +1397,171 @@ int nasmAddressOfSymbol(int id) {
     int r = allocateRegister();
 
     if (SymbolTable[id].class == C_LOCAL) {
-        fprintf(Outfile, "\tlea\t%s, [rbp+%d]\n",
-                qwordRegisterList[r],  // destination register
-                SymbolTable[id].offset // stack offset (usually negative)
+        nasmEmit(INSN_ALU, 4, "\tlea\t%s, [rbp+%d]\n",
+                 qwordRegisterList[r],  // destination register
+                 SymbolTable[id].offset // stack offset (usually negative)
         );
         return r;
     }
 
     // Global symbol
-    fprintf(Outfile, "\tlea\t%s, [rel %s]\n",
-            qwordRegisterList[r], // destination register
-            SymbolTable[id].name  // source global symbol
+    nasmEmit(INSN_ALU, 7, "\tlea\t%s, [rel %s]\n",
+             qwordRegisterList[r], // destination register
+             SymbolTable[id].name  // source global symbol
     );
 
     return r;
 }
 
 /**
- * nasmDereferencePointer - Generates code to dereference a pointer stored
- * in a register.
+ * nasmIndirectOperand - Formats the memory operand addressing a pointer
+ * register plus a constant displacement (e.g. "[r8]" or "[r8+12]").
+ *
+ * NOTE:
+ * Returns a static buffer that is overwritten by the next call.
  *
  * @param pointerReg Index of the register containing the pointer.
- * @param primitiveType The primitive type of the value being pointed to.
+ * @param offset Constant byte displacement.
  *
- * @return Index of the register containing the dereferenced value.
+ * @return The memory operand.
  */
-int nasmDereferencePointer(int pointerReg, int primitiveType) {
-    switch (primitiveType) {
-    case P_CHARPTR:
-        fprintf(Outfile, "\tmovzx\t%s, BYTE [%s]\n",
-                qwordRegisterList[pointerReg], // destination register
-                qwordRegisterList[pointerReg]  // source pointer register
+static const char *nasmIndirectOperand(int pointerReg, int offset) {
+    static char operand[32];
+
+    if (offset == 0) {
+        snprintf(operand, sizeof(operand), "[%s]",
+                 qwordRegisterList[pointerReg]);
+    } else {
+        snprintf(operand, sizeof(operand), "[%s%+d]",
+                 qwordRegisterList[pointerReg], offset);
+    }
+    return operand;
+}
+
+/**
+ * nasmLoadMemory - Generates code to load a value from a memory operand into
+ * a register, extended to 64 bits for its type.
+ *
+ * @param reg Index of the destination register.
+ * @param address The memory operand (e.g. "[r8+4]" or "[rbp-8]").
+ * @param primitiveType The primitive type of the value being loaded.
+ * @param bytes Estimated encoded length of the instruction.
+ */
+static void nasmLoadMemory(int reg, const char *address, int primitiveType,
+                           int bytes) {
+    switch (getMemoryAccessType(primitiveType)) {
+    case P_CHAR:
+    case P_UCHAR:
+        nasmEmit(INSN_LOAD, bytes + 1, "\tmovzx\t%s, BYTE %s\n",
+                 qwordRegisterList[reg], // destination register
+                 address                 // source address
+        );
+        break;
+    case P_SHORT:
+        nasmEmit(INSN_LOAD, bytes + 1, "\tmovsx\t%s, WORD %s\n",
+                 qwordRegisterList[reg], // destination register
+                 address                 // source address
+        );
+        break;
+    case P_USHORT:
+        nasmEmit(INSN_LOAD, bytes + 1, "\tmovzx\t%s, WORD %s\n",
+                 qwordRegisterList[reg], // destination register
+                 address                 // source address
+        );
+        break;
+    case P_INT:
+        nasmEmit(INSN_LOAD, bytes, "\tmovsxd\t%s, DWORD %s\n",
+                 qwordRegisterList[reg], // destination register
+                 address                 // source address
+        );
+        break;
+    case P_UINT:
+        // Writing a 32-bit register zero-extends it to 64 bits
+        nasmEmit(INSN_LOAD, bytes, "\tmov\t%s, DWORD %s\n",
+                 dwordRegisterList[reg], // destination register
+                 address                 // source address
+        );
+        break;
+    case P_LONG:
+    case P_ULONG:
+        nasmEmit(INSN_LOAD, bytes, "\tmov\t%s, QWORD %s\n",
+                 qwordRegisterList[reg], // destination register
+                 address                 // source address
+        );
+        break;
+    default:
+        logFatald("Bad type in nasmLoadMemory: ", primitiveType);
+    }
+}
+
+/**
+ * nasmStoreMemory - Generates code to store the low bytes of a register into
+ * a memory operand.
+ *
+ * @param reg Index of the register containing the value to store.
+ * @param address The memory operand (e.g. "[r8+4]" or "[rbp-8]").
+ * @param primitiveType The primitive type of the value being stored.
+ * @param bytes Estimated encoded length of the instruction.
+ */
+static void nasmStoreMemory(int reg, const char *address, int primitiveType,
+                            int bytes) {
+    switch (getMemoryAccessType(primitiveType)) {
+    case P_CHAR:
+    case P_UCHAR:
+        nasmEmit(INSN_STORE, bytes, "\tmov\tBYTE %s, %s\n",
+                 address,              // destination address
+                 byteRegisterList[reg] // source (lower 8 bits)
         );
         break;
-    case P_INTPTR:
-        fprintf(Outfile, "\tmov\t%s, DWORD [%s]\n",
-                dwordRegisterList[pointerReg], // destination register
-                qwordRegisterList[pointerReg]  // source pointer register
+    case P_SHORT:
+    case P_USHORT:
+        nasmEmit(INSN_STORE, bytes + 1, "\tmov\tWORD %s, %s\n",
+                 address,              // destination address
+                 wordRegisterList[reg] // source (lower 16 bits)
         );
         break;
-    case P_VOIDPTR:
-    case P_LONGPTR:
-        fprintf(Outfile, "\tmov\t%s, QWORD [%s]\n",
-                qwordRegisterList[pointerReg], // destination register
-                qwordRegisterList[pointerReg]  // source pointer register
+    case P_INT:
+    case P_UINT:
+        nasmEmit(INSN_STORE, bytes, "\tmov\tDWORD %s, %s\n",
+                 address,               // destination address
+                 dwordRegisterList[reg] // source (lower 32 bits)
         );
         break;
+    case P_LONG:
+    case P_ULONG:
+        nasmEmit(INSN_STORE, bytes, "\tmov\tQWORD %s, %s\n",
+                 address,               // destination address
+                 qwordRegisterList[reg] // source register
+        );
+        break;
+    default:
+        logFatald("Bad type in nasmStoreMemory: ", primitiveType);
     }
+}
 
+/**
+ * nasmDereferencePointer - Generates code to dereference a pointer stored
+ * in a register.
+ *
+ * @param pointerReg Index of the register containing the pointer.
+ * @param offset Constant byte displacement added to the pointer.
+ * @param primitiveType The primitive type of the value being loaded.
+ *
+ * @return Index of the register containing the dereferenced value.
+ */
+int nasmDereferencePointer(int pointerReg, int offset, int primitiveType) {
+    // A displacement makes the encoding longer
+    int bytes = (offset == 0) ? 3 : (offset >= -128 && offset < 128) ? 4 : 7;
+    int reg;
+
+    if (isFloatType(primitiveType)) {
+        reg = nasmLoadFloatMemory(nasmIndirectOperand(pointerReg, offset),
+                                  primitiveType, bytes);
+        freeRegister(pointerReg);
+        return reg;
+    }
+    nasmLoadMemory(pointerReg, nasmIndirectOperand(pointerReg, offset),
+                   primitiveType, bytes);
     return pointerReg;
 }
 
@@ -937,39 +1571,682 @@ int nasmDereferencePointer(int pointerReg, int primitiveType) {
  *
  * @param valueReg Index of the register containing the value to store.
  * @param pointerReg Index of the register containing the pointer.
+ * @param offset Constant byte displacement added to the pointer.
  * @param primitiveType The primitive type of the value being stored.
  *
  * @return Index of the register that was stored.
  */
-int nasmStoreDereferencedPointer(int valueReg, int pointerReg,
+int nasmStoreDereferencedPointer(int valueReg, int pointerReg, int offset,
                                  int primitiveType) {
-    switch (primitiveType) {
-    case P_CHAR:
-        fprintf(Outfile, "\tmov\tBYTE [%s], %s\n",
-                qwordRegisterList[pointerReg], // destination pointer register
-                byteRegisterList[valueReg]     // source register (lower 8 bits)
-        );
+    // A displacement makes the encoding longer
+    int bytes = (offset == 0) ? 3 : (offset >= -128 && offset < 128) ? 4 : 7;
+
+    if (isFloatType(primitiveType)) {
+        nasmStoreFloatMemory(valueReg, nasmIndirectOperand(pointerReg, offset),
+                             primitiveType, bytes);
+        return valueReg;
+    }
+    nasmStoreMemory(valueReg, nasmIndirectOperand(pointerReg, offset),
+                    primitiveType, bytes);
+    return valueReg;
+}
+
+/**
+ * nasmVectorMoveInstruction - Returns the aligned 16-byte move instruction
+ * for a vector type. (helper function)
+ *
+ * NOTE:
+ * The three moves do the same, but staying in the integer or the
+ * floating-point domain of the lanes avoids a bypass delay on some cores.
+ *
+ * @param vectorType The vector type.
+ *
+ * @return "movdqa", "movaps" or "movapd".
+ */
+static const char *nasmVectorMoveInstruction(int vectorType) {
+    switch (TypeTable[vectorType].base) {
+    case P_FLOAT:
+        return "movaps";
+    case P_DOUBLE:
+        return "movapd";
+    default:
+        return "movdqa";
+    }
+}
+
+/**
+ * nasmLoadVectorMemory - Generates code to load a vector from an aligned
+ * memory operand into a new SSE register. (helper function)
+ *
+ * @param address The memory operand (e.g. "[r8+16]" or "[rbp-32]").
+ * @param vectorType The vector type.
+ * @param bytes Estimated encoded length of a plain load of address.
+ *
+ * @return Index of the register containing the vector.
+ */
+static int nasmLoadVectorMemory(const char *address, int vectorType,
+                                int bytes) {
+    int reg = allocateFloatRegister();
+
+    nasmEmit(INSN_LOAD, bytes + 1, "\t%s\t%s, %s\n",
+             nasmVectorMoveInstruction(vectorType), floatRegisterName(reg),
+             address);
+    return reg;
+}
+
+/**
+ * nasmStoreVectorMemory - Generates code to store an SSE register into an
+ * aligned memory operand. (helper function)
+ *
+ * @param reg Index of the register containing the vector.
+ * @param address The memory operand (e.g. "[r8+16]" or "[rbp-32]").
+ * @param vectorType The vector type.
+ * @param bytes Estimated encoded length of a plain store to address.
+ */
+static void nasmStoreVectorMemory(int reg, const char *address,
+                                  int vectorType, int bytes) {
+    nasmEmit(INSN_STORE, bytes + 1, "\t%s\t%s, %s\n",
+             nasmVectorMoveInstruction(vectorType), address,
+             floatRegisterName(reg));
+}
+
+/**
+ * nasmVectorLoad - Generates code to load a vector through a pointer.
+ *
+ * @param pointerReg Index of the register containing the (16-byte
+ *                   aligned) address; it is freed.
+ * @param offset Constant byte displacement added to the pointer.
+ * @param vectorType The vector type.
+ *
+ * @return Index of the SSE register containing the vector.
+ */
+int nasmVectorLoad(int pointerReg, int offset, int vectorType) {
+    int bytes = (offset == 0) ? 3 : (offset >= -128 && offset < 128) ? 4 : 7;
+    int reg = nasmLoadVectorMemory(nasmIndirectOperand(pointerReg, offset),
+                                   vectorType, bytes);
+
+    freeRegister(pointerReg);
+    return reg;
+}
+
+/**
+ * nasmVectorStore - Generates code to store a vector through a pointer.
+ *
+ * @param valueReg Index of the SSE register containing the vector.
+ * @param pointerReg Index of the register containing the (16-byte
+ *                   aligned) address; it is freed.
+ * @param offset Constant byte displacement added to the pointer.
+ * @param vectorType The vector type.
+ *
+ * @return Index of the register that was stored.
+ */
+int nasmVectorStore(int valueReg, int pointerReg, int offset,
+                    int vectorType) {
+    int bytes = (offset == 0) ? 3 : (offset >= -128 && offset < 128) ? 4 : 7;
+
+    nasmStoreVectorMemory(valueReg, nasmIndirectOperand(pointerReg, offset),
+                          vectorType, bytes);
+    freeRegister(pointerReg);
+    return valueReg;
+}
+
+/**
+ * nasmVectorMultiplyInt32 - Generates code to multiply the 32-bit lanes of
+ * two SSE registers. (helper function)
+ *
+ * NOTE:
+ * SSE2 has no pmulld (it came with SSE4.1). pmuludq multiplies lanes 0
+ * and 2 into 64-bit products, so lanes 1 and 3 are shifted down and
+ * multiplied in a second pmuludq; the low halves of the four products are
+ * then gathered back in order. The low 32 bits of a product are the same
+ * for signed and unsigned lanes.
+ *
+ * @param r1 Index of the first register, which receives the product.
+ * @param r2 Index of the second register.
+ */
+static void nasmVectorMultiplyInt32(int r1, int r2) {
+    int odd1 = allocateFloatRegister();
+    int odd2 = allocateFloatRegister();
+    char *a = floatRegisterName(r1);
+    char *b = floatRegisterName(r2);
+    char *c = floatRegisterName(odd1);
+    char *d = floatRegisterName(odd2);
+
+    nasmEmit(INSN_ALU, 5, "\tpshufd\t%s, %s, 0xf5\n", c, a);
+    nasmEmit(INSN_ALU, 5, "\tpshufd\t%s, %s, 0xf5\n", d, b);
+    nasmEmit(INSN_ALU, 4, "\tpmuludq\t%s, %s\n", a, b);
+    nasmEmit(INSN_ALU, 4, "\tpmuludq\t%s, %s\n", c, d);
+    nasmEmit(INSN_ALU, 5, "\tpshufd\t%s, %s, 0x08\n", a, a);
+    nasmEmit(INSN_ALU, 5, "\tpshufd\t%s, %s, 0x08\n", c, c);
+    nasmEmit(INSN_ALU, 4, "\tpunpckldq\t%s, %s\n", a, c);
+    freeRegister(odd1);
+    freeRegister(odd2);
+}
+
+/**
+ * nasmVectorBinary - Generates code for a lane-by-lane operation on two
+ * vectors, or for a shift of every lane of a vector.
+ *
+ * NOTE:
+ * Integer lanes use the packed SSE2 integer instructions (paddd, psubw,
+ * pmullw, pand, ...), floating-point lanes the packed single or double
+ * ones (addps, mulpd, ...). A shift count comes in a general-purpose
+ * register and is moved into an SSE register for psll/psrl/psra.
+ *
+ * @param ASTop The operation (see isVectorOperationSupported()).
+ * @param r1 Index of the SSE register of the left vector.
+ * @param r2 Index of the SSE register of the right vector, or of the
+ *           general-purpose register of a shift count.
+ * @param vectorType The vector type.
+ *
+ * @return Index of the register containing the result (r1).
+ */
+int nasmVectorBinary(int ASTop, int r1, int r2, int vectorType) {
+    static const char *laneSuffixes[] = {
+        [1] = "b", [2] = "w", [4] = "d", [8] = "q"};
+    int lane = TypeTable[vectorType].base;
+    const char *suffix = laneSuffixes[getTypeSize(lane)];
+    const char *insn;
+    int count;
+
+    if (ASTop == A_LSHIFT || ASTop == A_RSHIFT) {
+        count = allocateFloatRegister();
+        nasmEmit(INSN_ALU, 5, "\tmovq\t%s, %s\n", floatRegisterName(count),
+                 qwordRegisterList[r2]);
+        insn = (ASTop == A_LSHIFT) ? "psll"
+               : isUnsignedType(lane) ? "psrl"
+                                      : "psra";
+        nasmEmit(INSN_ALU, 4, "\t%s%s\t%s, %s\n", insn, suffix,
+                 floatRegisterName(r1), floatRegisterName(count));
+        freeRegister(count);
+        freeRegister(r2);
+        return r1;
+    }
+
+    if (ASTop == A_MULTIPLY && isIntegerType(lane) &&
+        getTypeSize(lane) == 4) {
+        nasmVectorMultiplyInt32(r1, r2);
+        freeRegister(r2);
+        return r1;
+    }
+
+    if (isFloatType(lane)) {
+        suffix = (lane == P_FLOAT) ? "s" : "d";
+        switch (ASTop) {
+        case A_ADD:
+            insn = "addp";
+            break;
+        case A_SUBTRACT:
+            insn = "subp";
+            break;
+        case A_MULTIPLY:
+            insn = "mulp";
+            break;
+        default:
+            insn = "divp";
+            break;
+        }
+    } else {
+        switch (ASTop) {
+        case A_ADD:
+            insn = "padd";
+            break;
+        case A_SUBTRACT:
+            insn = "psub";
+            break;
+        case A_MULTIPLY:
+            // 16-bit lanes only (see isVectorOperationSupported())
+            insn = "pmull";
+            break;
+        case A_BITWISEAND:
+            insn = "pand";
+            suffix = "";
+            break;
+        case A_BITWISEOR:
+            insn = "por";
+            suffix = "";
+            break;
+        default:
+            insn = "pxor";
+            suffix = "";
+            break;
+        }
+    }
+
+    nasmEmit(INSN_ALU, 4, "\t%s%s\t%s, %s\n", insn, suffix,
+             floatRegisterName(r1), floatRegisterName(r2));
+    freeRegister(r2);
+    return r1;
+}
+
+/**
+ * nasmVectorSplat - Generates code to copy a scalar into every lane of a
+ * vector.
+ *
+ * NOTE:
+ * An integer is moved into the low lane and then duplicated: bytes and
+ * words are first unpacked into a 32-bit lane, which pshufd copies to the
+ * other three; 64-bit lanes are unpacked with punpcklqdq. A floating-point
+ * scalar is already in an SSE register as a double; it is rounded to
+ * float and spread with shufps, or spread with unpcklpd.
+ *
+ * @param reg Index of the register containing the scalar.
+ * @param vectorType The vector type.
+ *
+ * @return Index of the SSE register containing the vector.
+ */
+int nasmVectorSplat(int reg, int vectorType) {
+    int lane = TypeTable[vectorType].base;
+    char *name;
+    int v;
+
+    if (lane == P_FLOAT) {
+        name = floatRegisterName(reg);
+        nasmEmit(INSN_ALU, 4, "\tcvtsd2ss\t%s, %s\n", name, name);
+        nasmEmit(INSN_ALU, 4, "\tshufps\t%s, %s, 0\n", name, name);
+        return reg;
+    }
+    if (lane == P_DOUBLE) {
+        name = floatRegisterName(reg);
+        nasmEmit(INSN_ALU, 4, "\tunpcklpd\t%s, %s\n", name, name);
+        return reg;
+    }
+
+    v = allocateFloatRegister();
+    name = floatRegisterName(v);
+    if (getTypeSize(lane) == 8) {
+        nasmEmit(INSN_ALU, 5, "\tmovq\t%s, %s\n", name, qwordRegisterList[reg]);
+        nasmEmit(INSN_ALU, 4, "\tpunpcklqdq\t%s, %s\n", name, name);
+        freeRegister(reg);
+        return v;
+    }
+
+    nasmEmit(INSN_ALU, 5, "\tmovd\t%s, %s\n", name, dwordRegisterList[reg]);
+    switch (getTypeSize(lane)) {
+    case 1:
+        nasmEmit(INSN_ALU, 4, "\tpunpcklbw\t%s, %s\n", name, name);
+        // Fall through
+    case 2:
+        nasmEmit(INSN_ALU, 4, "\tpunpcklwd\t%s, %s\n", name, name);
         break;
-    case P_INT:
-        fprintf(Outfile, "\tmov\tDWORD [%s], %s\n",
-                qwordRegisterList[pointerReg], // destination pointer register
-                dwordRegisterList[valueReg]    // source register (lower 32
-                                               // bits)
-        );
+    }
+    nasmEmit(INSN_ALU, 5, "\tpshufd\t%s, %s, 0\n", name, name);
+    freeRegister(reg);
+    return v;
+}
+
+/**
+ * nasmCompoundAssign - Generates code for "memory = memory op value".
+ *
+ * NOTE:
+ * Addition, subtraction, bitwise operations and shifts are a single
+ * read-modify-write instruction on the memory operand, e.g.
+ * "add DWORD [rbp-8], r8" or "or DWORD [r9], 4". imul and (i)div have no
+ * memory destination form, so they load, operate and store back.
+ *
+ * Chars are zero-extended by every load, so they shift right logically
+ * here as well. Floating-point values and vectors are loaded, operated on
+ * with SSE and stored back; their value is always in a register.
+ *
+ * @param ASTop The binary operation (e.g. A_ADD).
+ * @param reg Index of the register holding the value, or NOREG.
+ * @param immediate The value when reg is NOREG.
+ * @param address The memory operand.
+ * @param primitiveType The primitive type of the value in memory.
+ * @param bytes Estimated encoded length of a plain load/store of address.
+ */
+static void nasmCompoundAssign(int ASTop, int reg, int immediate,
+                               const char *address, int primitiveType,
+                               int bytes) {
+    int type = getMemoryAccessType(primitiveType);
+    const char *sizeName = (type == P_CHAR || type == P_UCHAR)     ? "BYTE"
+                           : (type == P_SHORT || type == P_USHORT) ? "WORD"
+                           : (type == P_INT || type == P_UINT)     ? "DWORD"
+                                                                   : "QWORD";
+    const char *insn = NULL;
+    const char *source;
+    char immediateText[16];
+    int tmp;
+
+    if (isVectorType(type)) {
+        tmp = nasmLoadVectorMemory(address, type, bytes);
+        tmp = nasmVectorBinary(ASTop, tmp, reg, type);
+        nasmStoreVectorMemory(tmp, address, type, bytes);
+        freeRegister(tmp);
+        return;
+    }
+    if (isFloatType(type)) {
+        static const char *floatInsns[] = {[A_ADD] = "addsd",
+                                           [A_SUBTRACT] = "subsd",
+                                           [A_MULTIPLY] = "mulsd",
+                                           [A_DIVIDE] = "divsd"};
+        tmp = nasmLoadFloatMemory(address, type, bytes);
+        nasmEmit(INSN_ALU, 4, "\t%s\t%s, %s\n", floatInsns[ASTop],
+                 floatRegisterName(tmp), floatRegisterName(reg));
+        nasmStoreFloatMemory(tmp, address, type, bytes);
+        freeRegister(tmp);
+        freeRegister(reg);
+        return;
+    }
+
+    switch (ASTop) {
+    case A_ADD:
+        insn = "add";
         break;
-    case P_LONG:
-        fprintf(Outfile, "\tmov\tQWORD [%s], %s\n",
-                qwordRegisterList[pointerReg], // destination pointer register
-                qwordRegisterList[valueReg]    // source register
-        );
+    case A_SUBTRACT:
+        insn = "sub";
+        break;
+    case A_BITWISEAND:
+        insn = "and";
+        break;
+    case A_BITWISEOR:
+        insn = "or";
+        break;
+    case A_BITWISEXOR:
+        insn = "xor";
+        break;
+    case A_LSHIFT:
+        insn = "shl";
+        break;
+    case A_RSHIFT:
+        insn = (isUnsignedType(type) || type == P_CHAR) ? "shr" : "sar";
+        break;
+    }
+
+    if (insn != NULL) {
+        if (reg == NOREG) {
+            // A byte operand only takes an 8-bit immediate
+            snprintf(immediateText, sizeof(immediateText), "%d",
+                     (strcmp(sizeName, "BYTE") == 0) ? (immediate & 0xff)
+                                                     : immediate);
+            source = immediateText;
+            bytes += (immediate >= -128 && immediate < 128) ? 1 : 4;
+        } else if (ASTop == A_LSHIFT || ASTop == A_RSHIFT) {
+            // A variable shift count must be in cl
+            nasmEmit(INSN_ALU, 3, "\tmov\tcl, %s\n", byteRegisterList[reg]);
+            source = "cl";
+        } else if (strcmp(sizeName, "BYTE") == 0) {
+            source = byteRegisterList[reg];
+        } else if (strcmp(sizeName, "WORD") == 0) {
+            source = wordRegisterList[reg];
+        } else if (strcmp(sizeName, "DWORD") == 0) {
+            source = dwordRegisterList[reg];
+        } else {
+            source = qwordRegisterList[reg];
+        }
+
+        nasmEmit(INSN_STORE, bytes, "\t%s\t%s %s, %s\n", insn, sizeName,
+                 address, source);
+        if (reg != NOREG) {
+            freeRegister(reg);
+        }
+        return;
+    }
+
+    tmp = allocateRegister();
+    nasmLoadMemory(tmp, address, type, bytes);
+
+    if (ASTop == A_MULTIPLY && reg == NOREG) {
+        // imul has a three-operand immediate form
+        nasmEmit(INSN_ALU, 7, "\timul\t%s, %s, %d\n", qwordRegisterList[tmp],
+                 qwordRegisterList[tmp], immediate);
+        nasmStoreMemory(tmp, address, type, bytes);
+        freeRegister(tmp);
+        return;
+    }
+    if (reg == NOREG) {
+        reg = nasmLoadImmediateInt(immediate, type);
+    }
+
+    switch (ASTop) {
+    case A_MULTIPLY:
+        nasmEmit(INSN_ALU, 4, "\timul\t%s, %s\n", qwordRegisterList[tmp],
+                 qwordRegisterList[reg]);
+        break;
+    case A_DIVIDE:
+        nasmEmit(INSN_ALU, 3, "\tmov\trax, %s\n", qwordRegisterList[tmp]);
+        if (isUnsignedType(type)) {
+            nasmEmit(INSN_ALU, 2, "\txor\tedx, edx\n");
+            nasmEmit(INSN_ALU, 3, "\tdiv\t%s\n", qwordRegisterList[reg]);
+        } else {
+            nasmEmit(INSN_ALU, 2, "\tcqo\n");
+            nasmEmit(INSN_ALU, 3, "\tidiv\t%s\n", qwordRegisterList[reg]);
+        }
+        nasmEmit(INSN_ALU, 3, "\tmov\t%s, rax\n", qwordRegisterList[tmp]);
         break;
     default:
-        fprintf(stderr,
-                "Error: Unsupported primitive type %d in "
-                "nasmStoreDereferencedPointer\n",
-                primitiveType);
-        exit(1);
+        logFatald("Bad operation in nasmCompoundAssign: ", ASTop);
+    }
+
+    nasmStoreMemory(tmp, address, type, bytes);
+    freeRegister(tmp);
+    freeRegister(reg);
+}
+
+/**
+ * nasmCompoundAssignSymbol - Generates code for a compound assignment to a
+ * local or global scalar variable.
+ *
+ * @param ASTop The binary operation (e.g. A_ADD).
+ * @param reg Index of the register holding the value, or NOREG.
+ * @param immediate The value when reg is NOREG.
+ * @param id The ID of the symbol in the symbol table.
+ */
+void nasmCompoundAssignSymbol(int ASTop, int reg, int immediate, int id) {
+    char address[TEXTLEN + 8];
+
+    if (SymbolTable[id].class == C_LOCAL) {
+        snprintf(address, sizeof(address), "[rbp+%d]", SymbolTable[id].offset);
+        nasmCompoundAssign(ASTop, reg, immediate, address,
+                           SymbolTable[id].primitiveType, 4);
+    } else {
+        snprintf(address, sizeof(address), "[%s]", SymbolTable[id].name);
+        nasmCompoundAssign(ASTop, reg, immediate, address,
+                           SymbolTable[id].primitiveType, 8);
     }
+}
 
+/**
+ * nasmCompoundAssignDereferencedPointer - Generates code for a compound
+ * assignment through a pointer. The pointer register is left intact.
+ *
+ * @param ASTop The binary operation (e.g. A_ADD).
+ * @param reg Index of the register holding the value, or NOREG.
+ * @param immediate The value when reg is NOREG.
+ * @param pointerReg Index of the register containing the pointer.
+ * @param offset Constant byte displacement added to the pointer.
+ * @param primitiveType The primitive type of the value in memory.
+ */
+void nasmCompoundAssignDereferencedPointer(int ASTop, int reg, int immediate,
+                                           int pointerReg, int offset,
+                                           int primitiveType) {
+    char address[32];
+    // A displacement makes the encoding longer
+    int bytes = (offset == 0) ? 3 : (offset >= -128 && offset < 128) ? 4 : 7;
+
+    // Copy the operand: nasmIndirectOperand() reuses its buffer
+    snprintf(address, sizeof(address), "%s",
+             nasmIndirectOperand(pointerReg, offset));
+    nasmCompoundAssign(ASTop, reg, immediate, address, primitiveType, bytes);
+}
+
+/**
+ * nasmAtomicRegister - Name of a register at the width of an atomic int or
+ * long object. (helper function)
+ *
+ * @param reg Index of the register.
+ * @param primitiveType The type of the object.
+ *
+ * @return The 32-bit or 64-bit register name.
+ */
+static char *nasmAtomicRegister(int reg, int primitiveType) {
+    return (getTypeSize(primitiveType) == 4) ? dwordRegisterList[reg]
+                                             : qwordRegisterList[reg];
+}
+
+/**
+ * nasmAtomicLoad - Generates code for an atomic load through a pointer.
+ *
+ * NOTE:
+ * An aligned x86-64 load is atomic and already has acquire semantics.
+ * A seq_cst load needs no fence either, since every seq_cst store is
+ * followed by one.
+ *
+ * @param pointerReg Index of the register containing the pointer.
+ * @param primitiveType The type of the object (a 4- or 8-byte integer).
+ * @param order The memory order (MO_*).
+ *
+ * @return Index of the register containing the loaded value.
+ */
+int nasmAtomicLoad(int pointerReg, int primitiveType, int order) {
+    (void)order;
+    return nasmDereferencePointer(pointerReg, 0, primitiveType);
+}
+
+/**
+ * nasmAtomicStore - Generates code for an atomic store through a pointer.
+ *
+ * NOTE:
+ * An aligned x86-64 store is atomic and already has release semantics;
+ * a seq_cst store is followed by mfence, so that no later load can be
+ * satisfied before it is visible.
+ *
+ * @param valueReg Index of the register containing the value; it is freed.
+ * @param pointerReg Index of the register containing the pointer; it is
+ *                   freed.
+ * @param primitiveType The type of the object (a 4- or 8-byte integer).
+ * @param order The memory order (MO_*).
+ */
+void nasmAtomicStore(int valueReg, int pointerReg, int primitiveType,
+                     int order) {
+    nasmStoreMemory(valueReg, nasmIndirectOperand(pointerReg, 0),
+                    primitiveType, 3);
+    if (order == MO_SEQ_CST) {
+        nasmEmit(INSN_ALU, 3, "\tmfence\n");
+    }
+    freeRegister(valueReg);
+    freeRegister(pointerReg);
+}
+
+/**
+ * nasmAtomicReadModifyWrite - Generates code for an atomic fetch-and-add
+ * or exchange through a pointer.
+ *
+ * NOTE:
+ * "lock xadd" and "xchg" (locked implicitly) are full barriers, so every
+ * memory order gets the same instruction. The old value comes back in
+ * the value register; an int is then sign-extended to 64 bits like any
+ * loaded int.
+ *
+ * @param ASTop A_ATOMICFETCHADD or A_ATOMICEXCHANGE.
+ * @param valueReg Index of the register containing the operand.
+ * @param pointerReg Index of the register containing the pointer; it is
+ *                   freed.
+ * @param primitiveType The type of the object (a 4- or 8-byte integer).
+ * @param order The memory order (MO_*).
+ *
+ * @return Index of the register containing the old value (valueReg).
+ */
+int nasmAtomicReadModifyWrite(int ASTop, int valueReg, int pointerReg,
+                              int primitiveType, int order) {
+    (void)order;
+    if (ASTop == A_ATOMICFETCHADD) {
+        nasmEmit(INSN_STORE, 5, "\tlock xadd\t%s, %s\n",
+                 nasmIndirectOperand(pointerReg, 0),
+                 nasmAtomicRegister(valueReg, primitiveType));
+    } else {
+        nasmEmit(INSN_STORE, 3, "\txchg\t%s, %s\n",
+                 nasmIndirectOperand(pointerReg, 0),
+                 nasmAtomicRegister(valueReg, primitiveType));
+    }
+    if (primitiveType == P_INT) {
+        nasmEmit(INSN_ALU, 3, "\tmovsxd\t%s, %s\n", qwordRegisterList[valueReg],
+                 dwordRegisterList[valueReg]);
+    }
+    freeRegister(pointerReg);
     return valueReg;
 }
+
+/**
+ * nasmAtomicCompareExchange - Generates code for an atomic compare and
+ * exchange through a pointer.
+ *
+ * NOTE:
+ * "lock cmpxchg" compares the object with rax (the expected value) and
+ * stores the desired value if they are equal; otherwise it loads the
+ * object into rax, which is then written back to the expected value.
+ * It is a full barrier, so every memory order gets the same code.
+ *
+ * @param pointerReg Index of the register containing the pointer; it is
+ *                   freed.
+ * @param expectedPointerReg Index of the register containing the pointer
+ *                           to the expected value; it is freed.
+ * @param desiredReg Index of the register containing the desired value.
+ * @param primitiveType The type of the object (a 4- or 8-byte integer).
+ * @param order The memory order (MO_*).
+ *
+ * @return Index of the register containing 1 if the desired value was
+ *         stored, 0 otherwise (desiredReg).
+ */
+int nasmAtomicCompareExchange(int pointerReg, int expectedPointerReg,
+                              int desiredReg, int primitiveType, int order) {
+    char *accumulator = (getTypeSize(primitiveType) == 4) ? "eax" : "rax";
+    int label = codegenGetLabelNumber();
+
+    (void)order;
+    nasmEmit(INSN_LOAD, 3, "\tmov\t%s, [%s]\n", accumulator,
+             qwordRegisterList[expectedPointerReg]);
+    nasmEmit(INSN_STORE, 5, "\tlock cmpxchg\t[%s], %s\n",
+             qwordRegisterList[pointerReg],
+             nasmAtomicRegister(desiredReg, primitiveType));
+    nasmEmit(INSN_ALU, 4, "\tsete\t%s\n", byteRegisterList[desiredReg]);
+    nasmEmit(INSN_BRANCH, 2, "\tje\tL%d\n", label);
+    nasmEmit(INSN_STORE, 3, "\tmov\t[%s], %s\n",
+             qwordRegisterList[expectedPointerReg], accumulator);
+    nasmLabel(label);
+    nasmEmit(INSN_ALU, 4, "\tmovzx\t%s, %s\n", qwordRegisterList[desiredReg],
+             byteRegisterList[desiredReg]);
+    freeRegister(pointerReg);
+    freeRegister(expectedPointerReg);
+    return desiredReg;
+}
+
+/**
+ * nasmAtomicFence - Generates code for an atomic thread fence.
+ *
+ * NOTE:
+ * x86-64 only reorders a store with a later load, which only a seq_cst
+ * fence forbids; the weaker fences need no instruction.
+ *
+ * @param order The memory order (MO_*).
+ */
+void nasmAtomicFence(int order) {
+    if (order == MO_SEQ_CST) {
+        nasmEmit(INSN_ALU, 3, "\tmfence\n");
+    }
+}
+
+/**
+ * nasmPrefetch - Generates a software prefetch of the cache line holding
+ * a pointer plus a displacement.
+ *
+ * NOTE:
+ * Locality 3 to 1 map to prefetcht0 to prefetcht2 and 0 to prefetchnta.
+ * A prefetch for writing (prefetchw) is not in the x86-64 baseline, so
+ * writes are prefetched like reads. A prefetch never faults.
+ *
+ * @param pointerReg Index of the register containing the pointer.
+ * @param offset Constant byte displacement added to the pointer.
+ * @param hint The locality (0-3), plus PREFETCH_WRITE.
+ */
+void nasmPrefetch(int pointerReg, int offset, int hint) {
+    static const char *instructions[] = {"prefetchnta", "prefetcht2",
+                                         "prefetcht1", "prefetcht0"};
+    // A displacement makes the encoding longer
+    int bytes = (offset == 0) ? 4 : (offset >= -128 && offset < 128) ? 5 : 8;
+
+    nasmEmit(INSN_LOAD, bytes, "\t%s\t%s\n",
+             instructions[hint & ~PREFETCH_WRITE],
+             nasmIndirectOperand(pointerReg, offset));
+    freeRegister(pointerReg);
+}
@@ -13,24 +13,30 @@ const struct CodegenOps nasmOps = {
     .functionPreamble = nasmFunctionPreamble,
     .returnFromFunction = nasmReturnFromFunction,
     .functionPostamble = nasmFunctionPostamble,
+    .textSection = nasmTextSection,
 
     .declareGlobalSymbol = nasmDeclareGlobalSymbol,
     .declareGlobalString = nasmDeclareGlobalString,
 
     .loadImmediateInt = nasmLoadImmediateInt,
+    .loadImmediateFloat = nasmLoadImmediateFloat,
     .loadGlobalSymbol = nasmLoadGlobalSymbol,
     .loadLocalSymbol = nasmLoadLocalSymbol,
     .storeGlobalSymbol = nasmStoreGlobalSymbol,
     .storeLocalSymbol = nasmStoreLocalSymbol,
+    .compoundAssignSymbol = nasmCompoundAssignSymbol,
+    .compoundAssignDereferencedPointer = nasmCompoundAssignDereferencedPointer,
     .loadGlobalString = nasmLoadGlobalString,
 
     .addRegs = nasmAddRegs,
     .subRegs = nasmSubRegs,
     .mulRegs = nasmMulRegs,
     .divRegsSigned = nasmDivRegsSigned,
+    .divRegsUnsigned = nasmDivRegsUnsigned,
     .shiftLeftConst = nasmShiftLeftConst,
     .shiftLeftRegs = nasmShiftLeftRegs,
-    .shiftRightRegs = nasmShiftRightRegs,
+    .shiftRightRegsSigned = nasmShiftRightRegsSigned,
+    .shiftRightRegsUnsigned = nasmShiftRightRegsUnsigned,
 
     .ArithmeticNegate = nasmArithmeticNegate,
     .logicalInvert = nasmLogicalInvert,
@@ -53,6 +59,21 @@ const struct CodegenOps nasmOps = {
     .dereferencePointer = nasmDereferencePointer,
     .storeDereferencedPointer = nasmStoreDereferencedPointer,
 
+    .vectorLoad = nasmVectorLoad,
+    .vectorStore = nasmVectorStore,
+    .vectorBinary = nasmVectorBinary,
+    .vectorSplat = nasmVectorSplat,
+
+    .atomicLoad = nasmAtomicLoad,
+    .atomicStore = nasmAtomicStore,
+    .atomicReadModifyWrite = nasmAtomicReadModifyWrite,
+    .atomicCompareExchange = nasmAtomicCompareExchange,
+    .atomicFence = nasmAtomicFence,
+    .prefetch = nasmPrefetch,
+
+    .asmReserveClobbers = nasmAsmReserveClobbers,
+    .inlineAsm = nasmInlineAsm,
+
     .resetLocalOffset = nasmResetLocalOffset,
     .getLocalOffset = nasmGetLocalOffset,
 };
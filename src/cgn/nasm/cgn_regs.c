@@ -22,6 +22,15 @@
 #define NUMFREEREGISTERS 4
 static bool freeRegisters[NUMFREEREGISTERS] = {true, true, true, true};
 
+// NOTE:
+// Floating-point values live in the SSE registers, which have a pool of
+// their own. Their indices start at FIRSTFPREG (see defs.h).
+#define NUMFREEFLOATREGISTERS 16
+static bool freeFloatRegisters[NUMFREEFLOATREGISTERS];
+
+// Registers the current function's code writes (bit r for register index r)
+static unsigned long writtenRegisters;
+
 char *qwordRegisterList[] = {
     "r8",  // x64 general-purpose register #1
     "r9",  // x64 general-purpose register #2
@@ -34,6 +43,12 @@ char *dwordRegisterList[] = {
     "r10d", // lower 32 bits of r10
     "r11d"  // lower 32 bits of r11
 };
+char *wordRegisterList[] = {
+    "r8w",  // lower 16 bits of r8
+    "r9w",  // lower 16 bits of r9
+    "r10w", // lower 16 bits of r10
+    "r11w"  // lower 16 bits of r11
+};
 char *byteRegisterList[] = {
     "r8b",  // lower 8 bits of r8
     "r9b",  // lower 8 bits of r9
@@ -41,6 +56,11 @@ char *byteRegisterList[] = {
     "r11b"  // lower 8 bits of r11
 };
 
+char *floatRegisterList[] = {
+    "xmm0", "xmm1", "xmm2",  "xmm3",  "xmm4",  "xmm5",  "xmm6",  "xmm7",
+    "xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15",
+};
+
 /**
  * nasmResetRegisterPool - Marks all registers as free for allocation.
  */
@@ -49,6 +69,9 @@ void nasmResetRegisterPool(void) {
         // Mark all registers as free
         freeRegisters[i] = true;
     }
+    for (int i = 0; i < NUMFREEFLOATREGISTERS; i++) {
+        freeFloatRegisters[i] = true;
+    }
 }
 
 /**
@@ -61,6 +84,7 @@ int allocateRegister(void) {
     for (int i = 0; i < NUMFREEREGISTERS; i++) {
         if (freeRegisters[i]) {
             freeRegisters[i] = false; // Mark as used
+            writtenRegisters |= 1UL << i;
             return i;
         }
     }
@@ -69,6 +93,64 @@ int allocateRegister(void) {
     exit(1);
 }
 
+/**
+ * reserveRegister - Marks the register at the given index as used, for a
+ * register an asm statement clobbers. Dies with an error if the register is
+ * already in use.
+ *
+ * @param r Index of the register to reserve.
+ */
+void reserveRegister(int r) {
+    bool *isFree = isFloatRegister(r) ? &freeFloatRegisters[r - FIRSTFPREG]
+                                      : &freeRegisters[r];
+
+    if (!*isFree) {
+        fprintf(stderr, "Error: Register %s is already in use\n",
+                isFloatRegister(r) ? floatRegisterName(r)
+                                   : qwordRegisterList[r]);
+        exit(1);
+    }
+    *isFree = false;
+    writtenRegisters |= 1UL << r;
+}
+
+/**
+ * allocateFloatRegister - Allocates a free SSE register and returns its
+ * index (FIRSTFPREG and up). Dies with an error if none is available.
+ *
+ * @return Index of the allocated register.
+ */
+int allocateFloatRegister(void) {
+    for (int i = 0; i < NUMFREEFLOATREGISTERS; i++) {
+        if (freeFloatRegisters[i]) {
+            freeFloatRegisters[i] = false; // Mark as used
+            writtenRegisters |= 1UL << (FIRSTFPREG + i);
+            return FIRSTFPREG + i;
+        }
+    }
+
+    fprintf(stderr, "Error: No free SSE registers available\n");
+    exit(1);
+}
+
+/**
+ * isFloatRegister - Checks whether a register index names an SSE register.
+ *
+ * @param r Register index.
+ *
+ * @return true for an SSE register, false for a general-purpose one.
+ */
+bool isFloatRegister(int r) { return r >= FIRSTFPREG; }
+
+/**
+ * floatRegisterName - Returns the name of an SSE register.
+ *
+ * @param r Index of the register (FIRSTFPREG and up).
+ *
+ * @return The register name (e.g. "xmm0").
+ */
+char *floatRegisterName(int r) { return floatRegisterList[r - FIRSTFPREG]; }
+
 /**
  * freeRegister - Frees the register at the given index.
  * Dies with an error if the register is already free.
@@ -76,6 +158,15 @@ int allocateRegister(void) {
  * @param r Index of the register to free.
  */
 void freeRegister(int r) {
+    if (isFloatRegister(r)) {
+        if (freeFloatRegisters[r - FIRSTFPREG]) {
+            fprintf(stderr, "Error: Register %s is already free\n",
+                    floatRegisterName(r));
+            exit(1);
+        }
+        freeFloatRegisters[r - FIRSTFPREG] = true;
+        return;
+    }
     if (freeRegisters[r] == 1) {
         fprintf(stderr, "Error: Register %s is already free\n",
                 qwordRegisterList[r]);
@@ -83,3 +174,48 @@ void freeRegister(int r) {
     }
     freeRegisters[r] = 1; // Mark as free
 }
+
+/**
+ * liveRegisters - Returns the registers currently in use.
+ *
+ * @return The registers (bit r for register index r).
+ */
+unsigned long liveRegisters(void) {
+    unsigned long registers = 0;
+
+    for (int i = 0; i < NUMFREEREGISTERS; i++) {
+        if (!freeRegisters[i]) {
+            registers |= 1UL << i;
+        }
+    }
+    for (int i = 0; i < NUMFREEFLOATREGISTERS; i++) {
+        if (!freeFloatRegisters[i]) {
+            registers |= 1UL << (FIRSTFPREG + i);
+        }
+    }
+    return registers;
+}
+
+/**
+ * resetWrittenRegisters - Starts recording the registers a function's code
+ * writes.
+ */
+void resetWrittenRegisters(void) { writtenRegisters = 0; }
+
+/**
+ * markRegistersWritten - Records registers the current function's code
+ * writes other than by allocating them, e.g. through a call.
+ *
+ * @param registers The registers (bit r for register index r).
+ */
+void markRegistersWritten(unsigned long registers) {
+    writtenRegisters |= registers;
+}
+
+/**
+ * getWrittenRegisters - Returns the registers the current function's code
+ * has written so far.
+ *
+ * @return The registers (bit r for register index r).
+ */
+unsigned long getWrittenRegisters(void) { return writtenRegisters; }
@@ -7,9 +7,21 @@
 // Exposed register name tables for NASM x86-64
 extern char *qwordRegisterList[4];
 extern char *dwordRegisterList[4];
+extern char *wordRegisterList[4];
 extern char *byteRegisterList[4];
+extern char *floatRegisterList[16];
 
 // Register pool management
 void nasmResetRegisterPool(void);
 int allocateRegister(void);
+int allocateFloatRegister(void);
+void reserveRegister(int r);
+bool isFloatRegister(int r);
+char *floatRegisterName(int r);
 void freeRegister(int r);
+
+// Register usage (bit r for register index r), for the callers' summaries
+unsigned long liveRegisters(void);
+void resetWrittenRegisters(void);
+void markRegistersWritten(unsigned long registers);
+unsigned long getWrittenRegisters(void);
@@ -6,6 +6,7 @@
 #include "defs.h"
 
 #include <assert.h>
+#include <stdarg.h>
 
 /**
  * NOTE:
@@ -24,8 +25,12 @@
  */
 enum {
     NO_SEGMENT = -1,
-    TEXT_SEGMENT,
+    TEXT_SEGMENT, // .text, then the other text sections in TS_* order
+    HOT_TEXT_SEGMENT,
+    UNLIKELY_TEXT_SEGMENT,
     DATA_SEGMENT,
+    BSS_SEGMENT,
+    RODATA_SEGMENT,
 } currentSegment = NO_SEGMENT;
 
 // Position of next local variable relative to stack base pointer.
@@ -33,6 +38,22 @@ enum {
 static int localOffset;
 static int stackOffset;
 
+/**
+ * nasmEmit - Outputs one instruction and accounts for it in the size report.
+ *
+ * @param insnClass Instruction class (INSN_*).
+ * @param bytes Estimated encoded length of the instruction in bytes.
+ * @param format printf-style format of the instruction line.
+ */
+void nasmEmit(int insnClass, int bytes, const char *format, ...) {
+    va_list args;
+
+    va_start(args, format);
+    vfprintf(Outfile, format, args);
+    va_end(args);
+    sizeReportCountInstruction(insnClass, bytes);
+}
+
 /**
  * nasmDeclareDataSegment - Outputs the data segment declaration if not
  * already in the data segment.
@@ -44,6 +65,30 @@ void nasmDeclareTextSegment() {
     }
 }
 
+/**
+ * nasmTextSection - Outputs the declaration of a text section if not
+ * already in it.
+ *
+ * NOTE:
+ * NASM only knows the attributes of .text itself, so the others are given
+ * each time (repeating the same attributes is allowed).
+ *
+ * @param section The text section (TS_*).
+ */
+void nasmTextSection(int section) {
+    static char *sectionDeclarations[] = {
+        [TS_HOT] = ".text.hot progbits alloc exec nowrite align=16",
+        [TS_UNLIKELY] = ".text.unlikely progbits alloc exec nowrite align=16",
+    };
+
+    if (section == TS_NORMAL) {
+        nasmDeclareTextSegment();
+    } else if (currentSegment != TEXT_SEGMENT + section) {
+        fprintf(Outfile, "\tsection\t%s\n", sectionDeclarations[section]);
+        currentSegment = TEXT_SEGMENT + section;
+    }
+}
+
 /**
  * nasmDeclareDataSegment - Outputs the data segment declaration if not
  * already in the data segment.
@@ -55,6 +100,28 @@ void nasmDeclareDataSegment() {
     }
 }
 
+/**
+ * nasmDeclareBssSegment - Outputs the BSS segment declaration if not
+ * already in the BSS segment.
+ */
+void nasmDeclareBssSegment() {
+    if (currentSegment != BSS_SEGMENT) {
+        fputs("\tsection\t.bss\n", Outfile);
+        currentSegment = BSS_SEGMENT;
+    }
+}
+
+/**
+ * nasmDeclareRodataSegment - Outputs the read-only data segment declaration
+ * if not already in the read-only data segment.
+ */
+void nasmDeclareRodataSegment() {
+    if (currentSegment != RODATA_SEGMENT) {
+        fputs("\tsection\t.rodata\n", Outfile);
+        currentSegment = RODATA_SEGMENT;
+    }
+}
+
 /**
  * nasmResetLocalOffset - Resets the local variable offset tracker.
  */
@@ -63,15 +130,19 @@ void nasmResetLocalOffset(void) { localOffset = 0; }
 /**
  * nasmGetLocalOffset - Returns the next available local variable offset.
  *
- * @param type The primitive type of the local variable.
+ * @param id The symbol table ID of the local variable.
  * @param isFunctionParameter True if the variable is a function parameter.
  *
  * @return The offset from the base pointer (RBP) for the local variable.
  */
-int nasmGetLocalOffset(int type, bool isFunctionParameter) {
-    localOffset += (nasmGetPrimitiveTypeSize(type) > 4)
-                       ? nasmGetPrimitiveTypeSize(type)
-                       : 4;
+int nasmGetLocalOffset(int id, bool isFunctionParameter) {
+    int size = getSymbolSize(id);
+    int alignment = getSymbolAlignment(id);
+
+    // Each slot takes at least 4 bytes and is aligned for its type
+    // (RBP itself is 16-byte aligned)
+    localOffset += (size > 4) ? size : 4;
+    localOffset = (localOffset + alignment - 1) & ~(alignment - 1);
 
     // NOTE: Stack grows downwards, so local variables are at negative offsets
     assert(localOffset > 0);
@@ -88,29 +159,351 @@ void nasmPreamble() {
     fputs("\textern\tprintint\n", Outfile);
     fputs("\textern\tprintchar\n", Outfile);
     fputs("\textern\tprintstring\n", Outfile);
+    fputs("\textern\tprintdouble\n", Outfile);
+    fputs("\textern\tthread_spawn\n", Outfile);
+    fputs("\textern\tthread_join\n", Outfile);
 
-    fputs("\tsection\t.text\n", Outfile);
+    nasmDeclareTextSegment();
 }
 
 /**
- * nasmFunctionCall - Generates code to call a function with an argument in a
- * register.
+ * nasmMoveSavedRegisters - Saves registers of the pool in a stack area
+ * before a call, or restores them after it. (helper function)
+ *
+ * NOTE:
+ * An SSE register takes 16 bytes, as it may hold a vector, and the area
+ * is a multiple of 16 bytes so that the call keeps rsp aligned.
+ *
+ * @param registers The registers (bit r for register index r).
+ * @param isSave    True to save them, false to restore them.
+ */
+static void nasmMoveSavedRegisters(unsigned long registers, bool isSave) {
+    int size = 0;
+    int slots = 0;
+
+    for (int r = 0; r < FIRSTFPREG + 16; r++) {
+        if (registers & (1UL << r)) {
+            size += isFloatRegister(r) ? 16 : 8;
+            slots++;
+        }
+    }
+    if (size == 0) {
+        return;
+    }
+    size = (size + 15) & ~15;
+
+    if (isSave) {
+        sizeReportCountSpillSlots(slots);
+        nasmEmit(INSN_ALU, 4, "\tsub\trsp, %d\n", size);
+    }
+    // SSE registers first, so that their slots are 16-byte aligned
+    int offset = 0;
+    for (int r = FIRSTFPREG; r < FIRSTFPREG + 16; r++) {
+        if (!(registers & (1UL << r))) {
+            continue;
+        }
+        if (isSave) {
+            nasmEmit(INSN_STORE, 6, "\tmovdqu\t[rsp+%d], %s\n", offset,
+                     floatRegisterName(r));
+        } else {
+            nasmEmit(INSN_LOAD, 6, "\tmovdqu\t%s, [rsp+%d]\n",
+                     floatRegisterName(r), offset);
+        }
+        offset += 16;
+    }
+    for (int r = 0; r < FIRSTFPREG; r++) {
+        if (!(registers & (1UL << r))) {
+            continue;
+        }
+        if (isSave) {
+            nasmEmit(INSN_STORE, 5, "\tmov\t[rsp+%d], %s\n", offset,
+                     qwordRegisterList[r]);
+        } else {
+            nasmEmit(INSN_LOAD, 5, "\tmov\t%s, [rsp+%d]\n",
+                     qwordRegisterList[r], offset);
+        }
+        offset += 8;
+    }
+    if (!isSave) {
+        nasmEmit(INSN_ALU, 4, "\tadd\trsp, %d\n", size);
+    }
+}
+
+/**
+ * nasmFunctionCall - Generates code to call a function with one or two
+ * arguments in registers.
+ *
+ * NOTE:
+ * As in the System V ABI, floating-point arguments are passed in xmm0 and
+ * xmm1 and integer ones in rdi and rsi, each class in order; a float or
+ * double result comes back in xmm0. xmm0 and xmm1 belong to the register
+ * pool as well, so the arguments may already sit in each other's place.
+ * The registers of the pool that hold values across the call are saved
+ * around it, but only those the callee may write: a function defined
+ * earlier in the file has a summary of the registers its code writes,
+ * calls included (see nasmFunctionPostamble()). Any other function may
+ * write them all.
  *
  * @param registerIndex Index of the register containing the argument.
+ * @param secondRegisterIndex Index of the register containing the second
+ *                            argument, or NOREG.
  * @param functionSymbolId The function's symbol table ID.
  *
  * @return Index of the register containing the function's return value.
  */
-int nasmFunctionCall(int registerIndex, int functionSymbolId) {
-    int outRegister = allocateRegister();
-    fprintf(Outfile, "\tmov\trdi, %s\n", qwordRegisterList[registerIndex]);
-    fprintf(Outfile, "\tcall\t%s\n", SymbolTable[functionSymbolId].name);
-    fprintf(Outfile, "\tmov\t%s, rax\n", qwordRegisterList[outRegister]);
+int nasmFunctionCall(int registerIndex, int secondRegisterIndex,
+                     int functionSymbolId) {
+    int returnType =
+        TypeTable[SymbolTable[functionSymbolId].primitiveType].base;
+    bool isFirstFloat = isFloatRegister(registerIndex);
+    unsigned long clobbered = SymbolTable[functionSymbolId].clobberedRegisters;
+    unsigned long saved;
+
+    // Passing floating-point arguments writes xmm0 and xmm1 too
+    if (isFirstFloat) {
+        clobbered |= 1UL << FIRSTFPREG;
+    }
+    if (secondRegisterIndex != NOREG &&
+        isFloatRegister(secondRegisterIndex)) {
+        clobbered |= 1UL << (FIRSTFPREG + (isFirstFloat ? 1 : 0));
+    }
+    markRegistersWritten(clobbered);
+
+    // The arguments are consumed by the call
+    saved = liveRegisters() & clobbered & ~(1UL << registerIndex);
+    if (secondRegisterIndex != NOREG) {
+        saved &= ~(1UL << secondRegisterIndex);
+    }
+    nasmMoveSavedRegisters(saved, true);
+
+    int outRegister =
+        isFloatType(returnType) ? allocateFloatRegister() : allocateRegister();
+
+    if (isFirstFloat && secondRegisterIndex == FIRSTFPREG) {
+        // The second argument is already in xmm0, so it moves to xmm1
+        // before the first one moves in (through rax when the first one is
+        // in xmm1)
+        if (registerIndex == FIRSTFPREG + 1) {
+            nasmEmit(INSN_ALU, 5, "\tmovq\trax, xmm0\n");
+            nasmEmit(INSN_ALU, 4, "\tmovsd\txmm0, xmm1\n");
+            nasmEmit(INSN_ALU, 5, "\tmovq\txmm1, rax\n");
+        } else {
+            nasmEmit(INSN_ALU, 4, "\tmovsd\txmm1, xmm0\n");
+            nasmEmit(INSN_ALU, 4, "\tmovsd\txmm0, %s\n",
+                     floatRegisterName(registerIndex));
+        }
+        freeRegister(secondRegisterIndex);
+        secondRegisterIndex = NOREG;
+    } else if (isFirstFloat) {
+        nasmEmit(INSN_ALU, 4, "\tmovsd\txmm0, %s\n",
+                 floatRegisterName(registerIndex));
+    } else {
+        nasmEmit(INSN_ALU, 3, "\tmov\trdi, %s\n",
+                 qwordRegisterList[registerIndex]);
+    }
+    if (secondRegisterIndex != NOREG) {
+        if (isFloatRegister(secondRegisterIndex)) {
+            nasmEmit(INSN_ALU, 4, "\tmovsd\t%s, %s\n",
+                     isFirstFloat ? "xmm1" : "xmm0",
+                     floatRegisterName(secondRegisterIndex));
+        } else {
+            nasmEmit(INSN_ALU, 3, "\tmov\t%s, %s\n",
+                     isFirstFloat ? "rdi" : "rsi",
+                     qwordRegisterList[secondRegisterIndex]);
+        }
+        freeRegister(secondRegisterIndex);
+    }
+    nasmEmit(INSN_CALL, 5, "\tcall\t%s\n", SymbolTable[functionSymbolId].name);
+    if (returnType == P_FLOAT) {
+        nasmEmit(INSN_ALU, 4, "\tcvtss2sd\t%s, xmm0\n",
+                 floatRegisterName(outRegister));
+    } else if (returnType == P_DOUBLE) {
+        nasmEmit(INSN_ALU, 4, "\tmovsd\t%s, xmm0\n",
+                 floatRegisterName(outRegister));
+    } else {
+        nasmEmit(INSN_ALU, 3, "\tmov\t%s, rax\n",
+                 qwordRegisterList[outRegister]);
+    }
     freeRegister(registerIndex);
+    nasmMoveSavedRegisters(saved, false);
 
     return outRegister;
 }
 
+// Registers an asm statement may clobber that the callee must preserve;
+// they are saved around the statement
+static char *calleeSavedRegisterList[] = {"rbx", "r12", "r13", "r14", "r15"};
+
+// Scratch registers outside the pool, free for asm statements to clobber
+static char *scratchRegisterList[] = {"rax", "rcx", "rdx", "rsi", "rdi"};
+
+/**
+ * isRegisterInList - Checks whether a register name is in a list.
+ * (helper function)
+ *
+ * @param name  The register name.
+ * @param list  The list of register names.
+ * @param count The number of names in the list.
+ *
+ * @return true if the name is in the list.
+ */
+static bool isRegisterInList(char *name, char **list, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!strcmp(name, list[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * nasmAsmReserveClobbers - Reserves the pool registers an asm statement
+ * clobbers, and checks the names of the other clobbers.
+ *
+ * NOTE:
+ * "memory" and "cc" need nothing: every asm statement is emitted in place,
+ * and nothing is kept in the flags or in registers across a statement.
+ *
+ * @param a The asm statement.
+ */
+void nasmAsmReserveClobbers(struct asmStatement *a) {
+    char *name;
+    int n;
+
+    for (int i = 0; i < a->clobberCount; i++) {
+        name = a->clobbers[i];
+        a->clobberRegs[i] = NOREG;
+        if (!strcmp(name, "memory") || !strcmp(name, "cc") ||
+            isRegisterInList(name, calleeSavedRegisterList, 5) ||
+            isRegisterInList(name, scratchRegisterList, 5)) {
+            continue;
+        }
+        for (n = 0; n < 4; n++) {
+            if (!strcmp(name, qwordRegisterList[n])) {
+                a->clobberRegs[i] = n;
+            }
+        }
+        for (n = 0; n < 16; n++) {
+            if (!strcmp(name, floatRegisterList[n])) {
+                a->clobberRegs[i] = FIRSTFPREG + n;
+            }
+        }
+        if (a->clobberRegs[i] == NOREG) {
+            if (!strcmp(name, "rbp") || !strcmp(name, "rsp")) {
+                logFatals("asm statement cannot clobber ", name);
+            }
+            logFatals("Unknown register in asm clobber list: ", name);
+        }
+        reserveRegister(a->clobberRegs[i]);
+    }
+}
+
+/**
+ * nasmAsmOperandText - Formats an operand of an asm statement.
+ * (helper function)
+ *
+ * NOTE:
+ * A register operand is named in full by default, or in its lower 32, 16
+ * or 8 bits with the modifier k, w or b. A memory operand is the address
+ * in brackets.
+ *
+ * @param op       The operand.
+ * @param modifier The modifier letter, or 0.
+ *
+ * @return The text (in a static buffer).
+ */
+static char *nasmAsmOperandText(struct asmOperand *op, int modifier) {
+    static char text[32];
+
+    switch (op->constraint) {
+    case 'i':
+        snprintf(text, sizeof(text), "%ld", op->value);
+        return text;
+    case 'm':
+        if (op->offset == 0) {
+            snprintf(text, sizeof(text), "[%s]", qwordRegisterList[op->reg]);
+        } else {
+            snprintf(text, sizeof(text), "[%s%+d]", qwordRegisterList[op->reg],
+                     op->offset);
+        }
+        return text;
+    }
+
+    switch (modifier) {
+    case 0:
+    case 'q':
+        return qwordRegisterList[op->reg];
+    case 'k':
+        return dwordRegisterList[op->reg];
+    case 'w':
+        return wordRegisterList[op->reg];
+    case 'b':
+        return byteRegisterList[op->reg];
+    default:
+        logFatalc("Unknown asm operand modifier", modifier);
+        return NULL;
+    }
+}
+
+/**
+ * nasmInlineAsm - Outputs the text of an asm statement, with its operands
+ * substituted in.
+ *
+ * NOTE:
+ * The operands' expressions are already in registers. Each register output
+ * gets a register of its own here, which stays allocated until it is
+ * stored; every other operand's register and the reserved clobbers are
+ * freed afterwards. Clobbered callee-saved registers are pushed before the
+ * text and popped after it.
+ *
+ * @param a The asm statement.
+ */
+void nasmInlineAsm(struct asmStatement *a) {
+    struct asmOperand *op;
+    char *text;
+    char *line;
+    int i;
+
+    for (i = 0; i < a->operandCount; i++) {
+        op = &a->operands[i];
+        if (op->constraint == 'r' && op->isOutput && op->reg == NOREG) {
+            op->reg = allocateRegister();
+        }
+    }
+
+    text = codegenExpandAsmText(a, nasmAsmOperandText);
+    for (i = 0; i < a->clobberCount; i++) {
+        if (isRegisterInList(a->clobbers[i], calleeSavedRegisterList, 5)) {
+            nasmEmit(INSN_STORE, 2, "\tpush\t%s\n", a->clobbers[i]);
+        }
+    }
+    for (line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        line += strspn(line, " \t");
+        if (*line != '\0') {
+            // The size of an instruction in the text is not known
+            nasmEmit(INSN_ALU, 4, "\t%s\n", line);
+        }
+    }
+    for (i = a->clobberCount - 1; i >= 0; i--) {
+        if (isRegisterInList(a->clobbers[i], calleeSavedRegisterList, 5)) {
+            nasmEmit(INSN_LOAD, 2, "\tpop\t%s\n", a->clobbers[i]);
+        }
+    }
+    free(text);
+
+    for (i = 0; i < a->operandCount; i++) {
+        op = &a->operands[i];
+        if (op->reg != NOREG && !(op->constraint == 'r' && op->isOutput)) {
+            freeRegister(op->reg);
+        }
+    }
+    for (i = 0; i < a->clobberCount; i++) {
+        if (a->clobberRegs[i] != NOREG) {
+            freeRegister(a->clobberRegs[i]);
+        }
+    }
+}
+
 /**
  * nasmFunctionPreamble - Outputs the assembly code function preamble.
  *
@@ -118,17 +511,29 @@ int nasmFunctionCall(int registerIndex, int functionSymbolId) {
  */
 void nasmFunctionPreamble(int id) {
     char *functionName = SymbolTable[id].name;
-    nasmDeclareTextSegment();
+
+    // A static function's code is emitted later, elsewhere in the output
+    // (see globalDeclaration), so it always names its section
+    if (SymbolTable[id].class == C_STATIC) {
+        currentSegment = NO_SEGMENT;
+    }
+    nasmTextSection(SymbolTable[id].textSection);
 
     stackOffset = (localOffset + 15) & ~15; // Align to 16 bytes
+    // Nothing is live yet: the previous function may end without freeing
+    // its return value
+    nasmResetRegisterPool();
+    resetWrittenRegisters();
+
+    sizeReportBeginFunction(id, stackOffset);
 
-    fprintf(Outfile,
-            "\tglobal\t%s\n"
-            "%s:\n"
-            "\tpush\trbp\n"
-            "\tmov\trbp, rsp\n"
-            "\tadd\trsp, %d\n",
-            functionName, functionName, -stackOffset);
+    if (SymbolTable[id].class == C_GLOBAL) {
+        fprintf(Outfile, "\tglobal\t%s\n", functionName);
+    }
+    fprintf(Outfile, "%s:\n", functionName);
+    nasmEmit(INSN_STORE, 1, "\tpush\trbp\n");
+    nasmEmit(INSN_ALU, 3, "\tmov\trbp, rsp\n");
+    nasmEmit(INSN_ALU, 7, "\tadd\trsp, %d\n", -stackOffset);
 
     // fprintf(Outfile, "\tsection\t.text\n");
     // fprintf(Outfile, "\tglobal\t%s\n", functionName);
@@ -139,28 +544,50 @@ void nasmFunctionPreamble(int id) {
 
 /**
  * nasmReturnFromFunction - Generates code to return a value from a function.
- * (After moving the return value to rax, jumps to function end label)
+ * (After moving the return value to rax, or xmm0 for a float or double,
+ * jumps to function end label)
  *
  * @param reg Index of the register containing the return value.
  * @param id The function's symbol table ID.
  */
 void nasmReturnFromFunction(int reg, int id) {
-    int primitiveType = SymbolTable[id].primitiveType;
+    // The function type's base is its return type
+    int primitiveType =
+        getMemoryAccessType(TypeTable[SymbolTable[id].primitiveType].base);
 
     switch (primitiveType) {
     case P_CHAR:
-        fprintf(Outfile, "\tmovzx\teax, %s\n", byteRegisterList[reg]);
+    case P_UCHAR:
+        nasmEmit(INSN_ALU, 4, "\tmovzx\teax, %s\n", byteRegisterList[reg]);
+        break;
+    case P_SHORT:
+        nasmEmit(INSN_ALU, 4, "\tmovsx\trax, %s\n", wordRegisterList[reg]);
+        break;
+    case P_USHORT:
+        nasmEmit(INSN_ALU, 4, "\tmovzx\teax, %s\n", wordRegisterList[reg]);
         break;
     case P_INT:
-        fprintf(Outfile, "\tmov\teax, %s\n", dwordRegisterList[reg]);
+    case P_UINT:
+        nasmEmit(INSN_ALU, 3, "\tmov\teax, %s\n", dwordRegisterList[reg]);
         break;
     case P_LONG:
-        fprintf(Outfile, "\tmov\trax, %s\n", qwordRegisterList[reg]);
+    case P_ULONG:
+        nasmEmit(INSN_ALU, 3, "\tmov\trax, %s\n", qwordRegisterList[reg]);
+        break;
+    case P_FLOAT:
+        nasmEmit(INSN_ALU, 4, "\tcvtsd2ss\txmm0, %s\n",
+                 floatRegisterName(reg));
+        break;
+    case P_DOUBLE:
+        nasmEmit(INSN_ALU, 4, "\tmovsd\txmm0, %s\n", floatRegisterName(reg));
         break;
     default:
         logFatald("Error: Unsupported primitive type in nasmReturnFromFunction",
                   primitiveType);
     }
+    if (isFloatType(primitiveType)) {
+        markRegistersWritten(1UL << FIRSTFPREG);
+    }
 
     // After moving the return value to rax, jump to function end label
     nasmJump(SymbolTable[id].endLabel);
@@ -173,10 +600,18 @@ void nasmReturnFromFunction(int reg, int id) {
  */
 void nasmFunctionPostamble(int id) {
     nasmLabel(SymbolTable[id].endLabel);
-    fprintf(Outfile, "\tadd\trsp, %d\n", stackOffset);
-    fputs("\tpop	rbp\n"
-          "\tret\n",
-          Outfile);
+    nasmEmit(INSN_ALU, 7, "\tadd\trsp, %d\n", stackOffset);
+    nasmEmit(INSN_LOAD, 1, "\tpop\trbp\n");
+    nasmEmit(INSN_BRANCH, 1, "\tret\n");
+
+    // The callers compiled from now on save only what this function writes
+    SymbolTable[id].clobberedRegisters = getWrittenRegisters();
+
+    // Whatever follows a static function in its buffer is not what follows
+    // it in the output
+    if (SymbolTable[id].class == C_STATIC) {
+        currentSegment = NO_SEGMENT;
+    }
 }
 
 /**
@@ -184,10 +619,11 @@ void nasmFunctionPostamble(int id) {
  *               including function epilogue for main.
  */
 void nasmPostamble() {
-    fputs("\tmov\teax, 0\n"
-          "\tpop\trbp\n"
-          "\tret\n",
-          Outfile);
+    // Static variables may be the last thing declared
+    nasmDeclareTextSegment();
+    nasmEmit(INSN_ALU, 5, "\tmov\teax, 0\n");
+    nasmEmit(INSN_LOAD, 1, "\tpop\trbp\n");
+    nasmEmit(INSN_BRANCH, 1, "\tret\n");
 }
 
 /**
@@ -202,7 +638,50 @@ void nasmLabel(int label) { fprintf(Outfile, "L%d:\n", label); }
  *
  * @param label The label number to jump to.
  */
-void nasmJump(int label) { fprintf(Outfile, "\tjmp\tL%d\n", label); }
+void nasmJump(int label) { nasmEmit(INSN_BRANCH, 5, "\tjmp\tL%d\n", label); }
+
+/**
+ * nasmCompareFloatsAndJump - Generates code to compare two SSE registers and
+ * jump to a label when the comparison is false. (helper function)
+ *
+ * NOTE:
+ * See nasmCompareFloatsAndSet(): "<" and "<=" swap the operands, and a
+ * comparison with a NaN is false (except "!="), so it takes the jump.
+ *
+ * @param ASTop The AST operation code representing the comparison.
+ * @param r1 Index of the first register.
+ * @param r2 Index of the second register.
+ * @param label The label number to jump to if the comparison is false.
+ */
+static void nasmCompareFloatsAndJump(int ASTop, int r1, int r2, int label) {
+    bool isSwapped = (ASTop == A_LT || ASTop == A_LE);
+    int labelTrue;
+
+    nasmEmit(INSN_ALU, 4, "\tucomisd\t%s, %s\n",
+             floatRegisterName(isSwapped ? r2 : r1),
+             floatRegisterName(isSwapped ? r1 : r2));
+
+    switch (ASTop) {
+    case A_EQ:
+        nasmEmit(INSN_BRANCH, 6, "\tjne\tL%d\n", label);
+        nasmEmit(INSN_BRANCH, 6, "\tjp\tL%d\n", label);
+        break;
+    case A_NE:
+        // Unordered is "not equal": skip the jump
+        labelTrue = codegenGetLabelNumber();
+        nasmEmit(INSN_BRANCH, 6, "\tjp\tL%d\n", labelTrue);
+        nasmEmit(INSN_BRANCH, 6, "\tje\tL%d\n", label);
+        nasmLabel(labelTrue);
+        break;
+    case A_LT:
+    case A_GT:
+        nasmEmit(INSN_BRANCH, 6, "\tjbe\tL%d\n", label);
+        break;
+    default: // A_LE, A_GE
+        nasmEmit(INSN_BRANCH, 6, "\tjb\tL%d\n", label);
+        break;
+    }
+}
 
 /**
  * nasmCompareAndJump - Generates code to compare two registers and jump to a
@@ -212,10 +691,14 @@ void nasmJump(int label) { fprintf(Outfile, "\tjmp\tL%d\n", label); }
  * @param r1 Index of the first register.
  * @param r2 Index of the second register.
  * @param label The label number to jump to if the comparison is true.
+ * @param primitiveType The type of the compared values.
  *
  * @return NOREG (indicating no register is returned).
  */
-int nasmCompareAndJump(int ASTop, int r1, int r2, int label) {
+int nasmCompareAndJump(int ASTop, int r1, int r2, int label,
+                       int primitiveType) {
+    bool isUnsigned = isUnsignedType(primitiveType);
+
     if (!((ASTop == A_EQ) || (ASTop == A_NE) || (ASTop == A_LT) ||
           (ASTop == A_LE) || (ASTop == A_GT) || (ASTop == A_GE))) {
         fprintf(stderr,
@@ -224,35 +707,45 @@ int nasmCompareAndJump(int ASTop, int r1, int r2, int label) {
         exit(1);
     }
 
-    fprintf(Outfile, "\tcmp\t%s, %s\n", qwordRegisterList[r1],
-            qwordRegisterList[r2]);
+    if (isFloatType(primitiveType)) {
+        nasmCompareFloatsAndJump(ASTop, r1, r2, label);
+        nasmResetRegisterPool();
+        return NOREG;
+    }
+
+    nasmEmit(INSN_ALU, 3, "\tcmp\t%s, %s\n", qwordRegisterList[r1],
+             qwordRegisterList[r2]);
 
     // WARNING:
     // Jump when the condition is FALSE
     switch (ASTop) {
     case A_EQ:
         // !=
-        fprintf(Outfile, "\tjne\tL%d\n", label);
+        nasmEmit(INSN_BRANCH, 6, "\tjne\tL%d\n", label);
         break;
     case A_NE:
         // ==
-        fprintf(Outfile, "\tje\tL%d\n", label);
+        nasmEmit(INSN_BRANCH, 6, "\tje\tL%d\n", label);
         break;
     case A_LT:
         // >=
-        fprintf(Outfile, "\tjge\tL%d\n", label);
+        nasmEmit(INSN_BRANCH, 6, "\t%s\tL%d\n", isUnsigned ? "jae" : "jge",
+                 label);
         break;
     case A_LE:
         // >
-        fprintf(Outfile, "\tjg\tL%d\n", label);
+        nasmEmit(INSN_BRANCH, 6, "\t%s\tL%d\n", isUnsigned ? "ja" : "jg",
+                 label);
         break;
     case A_GT:
         // <=
-        fprintf(Outfile, "\tjle\tL%d\n", label);
+        nasmEmit(INSN_BRANCH, 6, "\t%s\tL%d\n", isUnsigned ? "jbe" : "jle",
+                 label);
         break;
     case A_GE:
         // <
-        fprintf(Outfile, "\tjl\tL%d\n", label);
+        nasmEmit(INSN_BRANCH, 6, "\t%s\tL%d\n", isUnsigned ? "jb" : "jl",
+                 label);
         break;
     default:
         fprintf(stderr,
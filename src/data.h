@@ -17,6 +17,13 @@ extern_ int CurrentTarget;
 extern_ bool Option_dumpAST;
 // If true, dump a compacted AST (flattens A_GLUE chains)
 extern_ bool Option_dumpASTCompacted;
+// Per-function code size report printed to stdout (SIZE_REPORT_*)
+extern_ int Option_sizeReport;
+// Architecture level the generated code may use (MARCH_*)
+extern_ int Option_march;
+// Bytes ahead of the current iteration that strided loops prefetch
+// (0: no prefetches are inserted)
+extern_ int Option_prefetchDistance;
 
 /**
  * NOTE:
@@ -39,10 +46,25 @@ extern_ FILE *Outfile;
 // Latest token scanned
 extern_ struct token Token;
 
+// Qualifiers (Q_*) of the type parsed last by parsePrimitiveType(), and
+// of the type its outermost pointer points to
+extern_ int TypeQualifiers;
+extern_ int TargetQualifiers;
+
 // Last identifier scanned (e.g. "print")
 extern_ char Text[TEXTLEN + 1];
 // symbol table for both global and local symbols
 extern_ struct symbolTable SymbolTable[NSYMBOLS];
+// struct types declared so far, and the position of the next free slot
+extern_ struct structTable StructTable[NSTRUCTS];
+extern_ int NextStructIndex;
+// names declared by typedef, and the position of the next free slot
+extern_ struct typedefTable TypedefTable[NTYPEDEFS];
+extern_ int NextTypedefIndex;
+// type table of every type used so far, and the position of the next free
+// slot
+extern_ struct typeTable TypeTable[NTYPES];
+extern_ int NextTypeIndex;
 
 /**
  * NOTE:
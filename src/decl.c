@@ -1,17 +1,193 @@
 // src/decl.c
 
+#include <limits.h>
+
 #include "decl.h"
 #include "data.h"
 #include "defs.h"
 
+/**
+ * parseUnsignedType - Parses the type following "unsigned" and returns the
+ * unsigned primitive type. A bare "unsigned" means "unsigned int".
+ * Leaves the last token of the type as the current token.
+ *
+ * @return Unsigned primitive type enum value.
+ */
+static int parseUnsignedType(void) {
+    scan(&Token);
+    switch (Token.token) {
+    case T_CHAR:
+        return P_UCHAR;
+    case T_SHORT:
+        return P_USHORT;
+    case T_INT:
+        return P_UINT;
+    case T_LONG:
+        return P_ULONG;
+    default:
+        // "unsigned x" or "unsigned *p": the current token is not part of
+        // the type, so hand it back to the caller's scan().
+        rejectToken(&Token);
+        return P_UINT;
+    }
+}
+
+/**
+ * structMemberDeclaration - Parses one member declaration of a struct
+ * definition and appends the member to the struct's member list at the
+ * next offset that is suitably aligned for its type.
+ *
+ * NOTE:
+ * member_declaration: type identifier ';' ;
+ *
+ * @param st The struct being defined.
+ * @param size In/out: size of the struct so far, in bytes.
+ * @param structAlignment In/out: largest member alignment so far.
+ */
+static void structMemberDeclaration(struct structTable *st, int *size,
+                                    int *structAlignment) {
+    struct structMember *member;
+    int type;
+    int alignment;
+
+    type = parsePrimitiveType();
+    if (Token.token != T_IDENTIFIER) {
+        logFatals("Expected a member name in struct ", st->name);
+    }
+
+    for (int i = 0; i < st->memberCount; i++) {
+        if (!strcmp(Text, st->members[i].name)) {
+            logFatals("Duplicate struct member: ", Text);
+        }
+    }
+    if (st->memberCount == NMEMBERS) {
+        logFatals("Too many members in struct ", st->name);
+    }
+
+    // getTypeSize() also rejects members of the struct's own type
+    // (it is still incomplete), while pointers to it are fine
+    alignment = getTypeAlignment(type);
+    member = &st->members[st->memberCount++];
+    member->name = strdup(Text);
+    member->primitiveType = type;
+    member->offset = (*size + alignment - 1) & ~(alignment - 1);
+
+    *size = member->offset + getTypeSize(type);
+    if (alignment > *structAlignment) {
+        *structAlignment = alignment;
+    }
+
+    matchIdentifierToken();
+    matchSemicolonToken();
+}
+
+/**
+ * structType - Parses the struct type following "struct": either a
+ * reference to a struct tag, or a struct definition. Returns the struct's
+ * primitive type and leaves the last token of the type (the tag or the
+ * closing '}') as the current token.
+ *
+ * NOTE:
+ * struct_type: identifier
+ *        | identifier '{' member_declaration+ '}'
+ *        ;
+ *
+ * Members are laid out in declaration order at their natural alignment, and
+ * the size is padded to a multiple of the largest member alignment, so
+ * arrays of structs keep every element aligned.
+ *
+ * A tag may be referenced before its definition; such an incomplete struct
+ * can only be used through pointers until it is defined.
+ *
+ * @return Struct primitive type.
+ */
+static int structType(void) {
+    struct structTable *st;
+    int structIndex;
+    int size = 0;
+    int alignment = 1;
+
+    scan(&Token);
+    if (Token.token != T_IDENTIFIER) {
+        logFatal("Expected a struct tag after 'struct'");
+    }
+    if ((structIndex = findStruct(Text)) == -1) {
+        structIndex = addStruct(Text);
+    }
+    st = &StructTable[structIndex];
+
+    scan(&Token);
+    if (Token.token != T_LBRACE) {
+        // Not a definition: hand the token back to the caller's scan()
+        rejectToken(&Token);
+        return structTypeOf(structIndex);
+    }
+
+    if (st->isDefined) {
+        logFatals("Redefinition of struct ", st->name);
+    }
+
+    scan(&Token);
+    while (Token.token != T_RBRACE) {
+        structMemberDeclaration(st, &size, &alignment);
+    }
+    if (st->memberCount == 0) {
+        logFatals("Struct with no members: ", st->name);
+    }
+
+    size = (size + alignment - 1) & ~(alignment - 1);
+    completeStructType(structTypeOf(structIndex), size, alignment);
+    st->isDefined = true;
+    return structTypeOf(structIndex);
+}
+
+/**
+ * parseTypeQualifiers - Parses any "const", "volatile" and "restrict"
+ * starting at the current token, and leaves the first token after them as
+ * the current token.
+ *
+ * @return The Q_* flags of the qualifiers.
+ */
+static int parseTypeQualifiers(void) {
+    int qualifiers = 0;
+
+    while (true) {
+        switch (Token.token) {
+        case T_CONST:
+            qualifiers |= Q_CONST;
+            break;
+        case T_VOLATILE:
+            qualifiers |= Q_VOLATILE;
+            break;
+        case T_RESTRICT:
+            qualifiers |= Q_RESTRICT;
+            break;
+        default:
+            return qualifiers;
+        }
+        scan(&Token);
+    }
+}
+
 /**
  * parsePrimitiveType - Parses the current token and return
  * a primitive type enum value. Also, scan in the next token.
  *
+ * NOTE:
+ * Qualifiers may come before or after the base type and after each '*',
+ * e.g. "const int * restrict p". Those after the last '*' (or of the base
+ * type, if there is no '*') qualify the declared variable and are left in
+ * TypeQualifiers; those of the type the outermost pointer points to are
+ * left in TargetQualifiers.
+ *
  * @return Primitive type enum value.
  */
 int parsePrimitiveType(void) {
+    int qualifiers;
+    int targetQualifiers = 0;
     int type;
+
+    qualifiers = parseTypeQualifiers();
     switch (Token.token) {
     case T_VOID:
         type = P_VOID;
@@ -19,82 +195,246 @@ int parsePrimitiveType(void) {
     case T_CHAR:
         type = P_CHAR;
         break;
+    case T_SHORT:
+        type = P_SHORT;
+        break;
     case T_INT:
         type = P_INT;
         break;
     case T_LONG:
         type = P_LONG;
         break;
+    case T_FLOAT:
+        type = P_FLOAT;
+        break;
+    case T_DOUBLE:
+        type = P_DOUBLE;
+        break;
+    case T_UNSIGNED:
+        type = parseUnsignedType();
+        break;
+    case T_STRUCT:
+        type = structType();
+        break;
+    case T_TYPENAME:
+        type = Token.intvalue;
+        break;
     default:
         logFatald("Error: Invalid primitive type token in parsePrimitiveType",
                   Token.token);
     }
+    scan(&Token);
+    qualifiers |= parseTypeQualifiers();
+    if (qualifiers & Q_RESTRICT) {
+        logFatal("'restrict' must qualify a pointer");
+    }
 
     // Scan in one or more further '*' tokens and
     // determine the correct pointer type
-    while (true) {
-        scan(&Token);
-        if (Token.token != T_STAR) {
-            break;
-        }
+    while (Token.token == T_STAR) {
         type = primitiveTypeToPointerType(type);
+        targetQualifiers = qualifiers;
+        scan(&Token);
+        qualifiers = parseTypeQualifiers();
     }
 
+    TypeQualifiers = qualifiers;
+    TargetQualifiers = targetQualifiers;
     return type;
 }
 
+/**
+ * typedefDeclaration - Parses a typedef, with the current token being
+ * "typedef", and adds the declared name to the typedef table.
+ *
+ * NOTE:
+ * typedef_declaration: "typedef" type identifier vector_attribute? ';' ;
+ * vector_attribute: "__attribute__" '(' '(' "vector_size"
+ *                   '(' constant_expression ')' ')' ')' ;
+ * As with GCC, the vector_size attribute makes the name a SIMD vector
+ * type of that many bytes whose lanes have the declared type, e.g.
+ * "typedef int v4si __attribute__((vector_size(16)));".
+ * Typedefs are only declared at file scope.
+ */
+static void typedefDeclaration(void) {
+    char name[TEXTLEN + 1];
+    long size;
+    int type;
+
+    scan(&Token);
+    type = parsePrimitiveType();
+    if (Token.token != T_IDENTIFIER) {
+        logFatal("Expected a name in typedef");
+    }
+    strcpy(name, Text);
+    scan(&Token);
+
+    if (Token.token == T_ATTRIBUTE) {
+        scan(&Token);
+        matchLeftParenthesisToken();
+        matchLeftParenthesisToken();
+        if (Token.token != T_IDENTIFIER || strcmp(Text, "vector_size")) {
+            logFatals("Unsupported attribute in typedef ", name);
+        }
+        scan(&Token);
+        matchLeftParenthesisToken();
+        size = parseConstantExpression();
+        if (size <= 0 || size > INT_MAX) {
+            logFatal("Vector size must be a positive integer constant");
+        }
+        type = vectorTypeOf(type, size);
+        matchRightParenthesisToken();
+        matchRightParenthesisToken();
+        matchRightParenthesisToken();
+    }
+
+    addTypedef(name, type);
+    matchSemicolonToken();
+}
+
+/**
+ * addVariableSymbol - Adds a variable to the symbol table according to its
+ * storage class. (helper function)
+ *
+ * @param name The name of the variable's storage.
+ * @param type The type of the variable.
+ * @param structuralType S_VARIABLE or S_ARRAY.
+ * @param size The number of elements for arrays, else 0.
+ * @param class C_GLOBAL, C_LOCAL or C_STATIC.
+ *
+ * @return The index of the variable in the symbol table.
+ */
+static int addVariableSymbol(char *name, int type, int structuralType,
+                             int size, int class) {
+    switch (class) {
+    case C_LOCAL:
+        return addLocalSymbol(name, type, structuralType, 0, size);
+    case C_STATIC:
+        return addStaticSymbol(name, type, structuralType, 0, size);
+    default:
+        return addGlobalSymbol(name, type, structuralType, 0, size);
+    }
+}
+
 /**
  * variableDeclaration - Parse the declaration
  * of a scalar variable or an array
  *
  * NOTE:
- * variable_declaration: type identifier ';'    // scalar
- *        | type identifier '[' INTLIT ']' ';'  // array
+ * variable_declaration: type identifier                     // scalar
+ *        | type identifier '=' expression                   // initialized
+ *        | type identifier ('[' constant_expression ']')+   // array
  *        ;
+ * A multi-dimensional array is an array of arrays: "int a[3][4]" has the
+ * type array(3) of array(4) of int, laid out in row-major order.
+ * Array sizes and the initial values of globals are constant expressions
+ * (e.g. "sizeof(long) * 8"), folded before the symbol is declared.
+ * A local's initial value may be any expression; it becomes an assignment.
+ * Statics, local or not, live in static storage and take constant initial
+ * values like globals.
+ * The qualifiers parsed with the type are recorded on the symbol; the
+ * initial value is the only store a const variable accepts.
+ * The terminating ';' is left to the caller.
  *
  * @param type The primitive type of the variable.
  * @bool isLocalVariable True if this is a local variable, false for global.
+ * @bool isStatic True if the declaration has the "static" specifier.
+ *
+ * @return The assignment AST of an initialized local variable, else NULL.
  */
-void variableDeclaration(int type, bool isLocalVariable) {
+struct ASTnode *variableDeclaration(int type, bool isLocalVariable,
+                                    bool isStatic) {
+    struct ASTnode *valueAST;
+    // Text is overwritten by any identifier in a size or initial value
+    char name[TEXTLEN + 1];
+    // Name of the symbol holding the variable's storage
+    char storageName[TEXTLEN + 16];
+    int dimensions[NARRAYDIMS];
+    int dimensionCount = 0;
+    // Like Text, overwritten by a "sizeof(type)" in a size or initial value
+    int qualifiers = TypeQualifiers;
+    int targetQualifiers = TargetQualifiers;
+    long size;
+    int arrayType;
+    int class;
     int id;
 
-    if (Token.token == T_LBRACKET) {
-        // Skip past the '['
-        scan(&Token);
-
-        // Check we have an array size?
-        if (Token.token == T_INTEGERLITERAL) {
-            // Add this as a known array and generate its space in assembly code
+    strcpy(name, Text);
+    strcpy(storageName, name);
+    class = isStatic ? C_STATIC : (isLocalVariable ? C_LOCAL : C_GLOBAL);
+    if (isStatic && isLocalVariable) {
+        // The storage outlives the function, so it is a static symbol,
+        // named apart from other functions' statics (e.g. "count.3")
+        snprintf(storageName, sizeof(storageName), "%s.%d", name,
+                 CurrentFunctionSymbolID);
+    }
 
-            // WARNING:
-            // In C terms, an array is not “a pointer type with a size
-            // attached.” It’s an array type of element type T and length N.
-            // (Just leave for now as I follow the original design of the
-            // lecture...)
+    if (Token.token == T_LBRACKET) {
+        while (Token.token == T_LBRACKET) {
+            // Skip past the '['
+            scan(&Token);
 
-            if (isLocalVariable) {
-                addLocalSymbol(Text, primitiveTypeToPointerType(type), S_ARRAY,
-                               0, Token.intvalue);
-            } else {
-                addGlobalSymbol(Text, primitiveTypeToPointerType(type), S_ARRAY,
-                                0, Token.intvalue);
+            // Get the array size and the following ']'
+            size = parseConstantExpression();
+            if (size <= 0 || size > INT_MAX) {
+                logFatal("Array size must be a positive integer constant");
+            }
+            if (dimensionCount == NARRAYDIMS) {
+                logFatal("Too many array dimensions");
             }
+            dimensions[dimensionCount++] = size;
+            match(T_RBRACKET, "]");
         }
 
-        // Ensure we have a following ']'
+        // Add this as a known array and generate its space in assembly code
+        // NOTE:
+        // The type is built from the innermost dimension outwards.
+        // The symbol gets the array type of element type T and length N;
+        // it decays to a pointer to T when used in an expression.
+        arrayType = type;
+        for (int i = dimensionCount - 1; i >= 0; i--) {
+            arrayType = arrayTypeOf(arrayType, dimensions[i]);
+        }
+        id = addVariableSymbol(storageName, arrayType, S_ARRAY, dimensions[0],
+                               class);
+    } else if (Token.token == T_ASSIGN) {
+        // A local vector is assigned its initial value like a scalar
+        if (!isIntegerType(type) && !isFloatType(type) &&
+            !isPointerType(type) &&
+            !(isVectorType(type) && class == C_LOCAL)) {
+            logFatals("Only scalar variables can be initialized: ", name);
+        }
+        if (class == C_LOCAL) {
+            // "type x = expr" is "type x; x = expr"
+            id = addLocalSymbol(name, type, S_VARIABLE, 0, 0);
+            SymbolTable[id].qualifiers = qualifiers;
+            SymbolTable[id].targetQualifiers = targetQualifiers;
+            scan(&Token);
+            valueAST = binexpr(0);
+            valueAST->isRvalue = true;
+            valueAST = coerceASTTypeForOp(valueAST, type, A_NOTHING);
+            if (valueAST == NULL) {
+                logFatal("Incompatible expression in initialization");
+            }
+            return makeASTNode(A_ASSIGN, type, valueAST, NULL,
+                               makeASTLeaf(A_IDENTIFIER, type, id), 0);
+        }
         scan(&Token);
-        match(T_RBRACKET, "]");
+        id = addInitializedGlobalSymbol(storageName, type, class,
+                                        isFloatType(type)
+                                            ? parseConstantFloatExpression(type)
+                                            : parseConstantExpression());
     } else {
         // Add this as a known scalar variable
-        if (isLocalVariable) {
-            id = addLocalSymbol(Text, type, S_VARIABLE, 0, 0);
-        } else {
-            id = addGlobalSymbol(Text, type, S_VARIABLE, 0, 0);
-        }
+        id = addVariableSymbol(storageName, type, S_VARIABLE, 0, class);
     }
+    SymbolTable[id].qualifiers = qualifiers;
+    SymbolTable[id].targetQualifiers = targetQualifiers;
 
-    // Get the terminating semicolon
-    matchSemicolonToken();
+    if (isStatic && isLocalVariable) {
+        addLocalStaticSymbol(name, id);
+    }
+    return NULL;
 }
 
 /**
@@ -105,10 +445,13 @@ void variableDeclaration(int type, bool isLocalVariable) {
  * function_declaration: type identifier "(" ")" compound_statement ;
  *
  * @param type The primitive type of the function.
+ * @param isStatic True if the function is declared "static".
+ * @param textSection The TS_* section of the function's code.
  *
  * @return AST node representing the function declaration.
  */
-struct ASTnode *functionDeclaration(int type) {
+struct ASTnode *functionDeclaration(int type, bool isStatic,
+                                    int textSection) {
     struct ASTnode *treeNode;
     struct ASTnode *finalStatementNode;
     int functionNameIndex;
@@ -118,13 +461,23 @@ struct ASTnode *functionDeclaration(int type) {
     // Get a label-id for the end label,
     // add the function to the symbol table as declared,
     // and set the CurrentFunctionSymbolID to the function's symbol ID
+    if (isVectorType(type)) {
+        logFatals("Functions cannot return a vector: ", Text);
+    }
     endLabel = codegenGetLabelNumber();
-    functionNameIndex =
-        addGlobalSymbol(Text, type, S_FUNCTION, endLabel,
-                        0); // Function doesn't have a size (number of elements)
+    // Function doesn't have a size (number of elements)
+    if (isStatic) {
+        functionNameIndex = addStaticSymbol(Text, functionTypeOf(type),
+                                            S_FUNCTION, endLabel, 0);
+    } else {
+        functionNameIndex = addGlobalSymbol(Text, functionTypeOf(type),
+                                            S_FUNCTION, endLabel, 0);
+    }
+    SymbolTable[functionNameIndex].textSection = textSection;
     CurrentFunctionSymbolID = functionNameIndex;
 
     // Reset position of new locals
+    freeLocalSymbols();
     codegenResetLocalOffset();
 
     // Scan the parenthesis
@@ -155,39 +508,301 @@ struct ASTnode *functionDeclaration(int type) {
     return makeASTUnary(A_FUNCTION, type, treeNode, functionNameIndex);
 }
 
+// A function whose code is generated once the whole file is parsed, when
+// the stores to the globals are known
+struct deferredFunction {
+    struct ASTnode *tree;       // The A_FUNCTION AST
+    struct symbolTable *locals; // Its local symbols
+    int localCount;
+};
+
+static struct deferredFunction *DeferredFunctions;
+static int DeferredFunctionCount;
+
+/**
+ * deferFunction - Holds back a parsed function, with its local symbols.
+ *
+ * @param n The A_FUNCTION AST of the function.
+ */
+static void deferFunction(struct ASTnode *n) {
+    struct deferredFunction *df;
+
+    DeferredFunctions =
+        realloc(DeferredFunctions,
+                (DeferredFunctionCount + 1) * sizeof(struct deferredFunction));
+    if (DeferredFunctions == NULL) {
+        logFatal("Unable to hold back a function");
+    }
+    df = &DeferredFunctions[DeferredFunctionCount++];
+    df->tree = n;
+    df->locals = saveLocalSymbols(&df->localCount);
+}
+
+// A static function's code, held back until the end of the file, when it
+// is known whether anything uses the function
+struct staticFunction {
+    int id;          // The function's symbol table ID
+    char *text;      // Its generated assembly code
+    size_t length;   // Length of the text
+    int *references; // IDs of the static symbols its code uses
+    int referenceCount;
+    bool isLive;     // Is the function used by emitted code?
+};
+
+static struct staticFunction StaticFunctions[NSTATICFUNCTIONS];
+static int StaticFunctionCount;
+
+/**
+ * collectStaticReferences - Records the static symbols that a function's
+ * code uses. The uses of a non-static function are live straight away;
+ * those of a static function only once the function itself is.
+ *
+ * @param n The AST (sub)tree of the function.
+ * @param sf The static function being generated, or NULL.
+ */
+static void collectStaticReferences(struct ASTnode *n,
+                                    struct staticFunction *sf) {
+    int id;
+
+    if (n == NULL) {
+        return;
+    }
+
+    switch (n->op) {
+    case A_IDENTIFIER:
+    case A_ADDRESSOF:
+    case A_FUNCTIONCALL:
+    case A_POSTINCREMENT:
+    case A_POSTDECREMENT:
+        id = n->v.identifierIndex;
+        if (SymbolTable[id].class != C_STATIC) {
+            break;
+        }
+        if (sf == NULL) {
+            SymbolTable[id].isReferenced = true;
+            break;
+        }
+        sf->references = realloc(sf->references,
+                                 (sf->referenceCount + 1) * sizeof(int));
+        if (sf->references == NULL) {
+            logFatal("Unable to record the references of a static function");
+        }
+        sf->references[sf->referenceCount++] = id;
+        break;
+    }
+
+    collectStaticReferences(n->left, sf);
+    collectStaticReferences(n->middle, sf);
+    collectStaticReferences(n->right, sf);
+}
+
+/**
+ * generateStaticFunction - Generates a static function's code into a
+ * buffer instead of the output file.
+ *
+ * @param n The A_FUNCTION AST of the function.
+ */
+static void generateStaticFunction(struct ASTnode *n) {
+    struct staticFunction *sf;
+    FILE *savedOutfile = Outfile;
+
+    if (StaticFunctionCount == NSTATICFUNCTIONS) {
+        logFatal("Too many static functions");
+    }
+    sf = &StaticFunctions[StaticFunctionCount++];
+    *sf = (struct staticFunction){.id = n->v.identifierIndex};
+    collectStaticReferences(n, sf);
+
+    Outfile = open_memstream(&sf->text, &sf->length);
+    if (Outfile == NULL) {
+        logFatal("Unable to buffer the code of a static function");
+    }
+    codegenAST(n, NOREG, NOREG);
+    fclose(Outfile);
+    Outfile = savedOutfile;
+}
+
+/**
+ * generateDeferredFunctions - Optimizes and generates the held back
+ * functions, in the order of the file.
+ *
+ * NOTE:
+ * By now the globals are classified, so the optimizer can fold the loads
+ * of those that always hold their initial value.
+ */
+static void generateDeferredFunctions(void) {
+    struct deferredFunction *df;
+    struct ASTnode *n;
+
+    for (int i = 0; i < DeferredFunctionCount; i++) {
+        df = &DeferredFunctions[i];
+        n = df->tree;
+        restoreLocalSymbols(df->locals, df->localCount);
+        free(df->locals);
+        CurrentFunctionSymbolID = n->v.identifierIndex;
+
+        // Rewrite the body before any code is generated for it
+        optimizeFunction(n);
+        // NOTE: Optional) AST dump to stdout
+        if (Option_dumpAST) {
+            if (Option_dumpASTCompacted) {
+                dumpASTTreeCompacted(n);
+            } else {
+                dumpASTTree(n);
+            }
+        }
+        if (SymbolTable[n->v.identifierIndex].class == C_STATIC) {
+            generateStaticFunction(n);
+        } else {
+            collectStaticReferences(n, NULL);
+            codegenAST(n, NOREG, NOREG);
+        }
+    }
+    free(DeferredFunctions);
+    DeferredFunctions = NULL;
+    DeferredFunctionCount = 0;
+}
+
+/**
+ * emitDeferredDefinitions - Emits the global variables, and the static
+ * functions and variables that the rest of the output uses, and drops the
+ * other statics.
+ *
+ * NOTE:
+ * Uses spread from the non-static functions: a static function becomes
+ * live when live code calls it, and its own uses become live in turn. A
+ * static that only dead static functions use is dead too, and so is one
+ * whose loads were all folded into immediates.
+ */
+static void emitDeferredDefinitions(void) {
+    struct staticFunction *sf;
+    bool changed;
+
+    do {
+        changed = false;
+        for (int i = 0; i < StaticFunctionCount; i++) {
+            sf = &StaticFunctions[i];
+            if (!sf->isLive && SymbolTable[sf->id].isReferenced) {
+                sf->isLive = true;
+                changed = true;
+                for (int j = 0; j < sf->referenceCount; j++) {
+                    SymbolTable[sf->references[j]].isReferenced = true;
+                }
+            }
+        }
+    } while (changed);
+
+    for (int i = 0; i < NextGlobalSymbolIndex; i++) {
+        if (SymbolTable[i].structuralType != S_FUNCTION &&
+            (SymbolTable[i].class == C_GLOBAL ||
+             SymbolTable[i].isReferenced)) {
+            codegenDeclareGlobalSymbol(i);
+        }
+    }
+
+    // The functions come last: their text names its own section
+    for (int i = 0; i < StaticFunctionCount; i++) {
+        sf = &StaticFunctions[i];
+        if (sf->isLive) {
+            fwrite(sf->text, 1, sf->length, Outfile);
+        } else {
+            sizeReportDropFunction(sf->id);
+        }
+        free(sf->text);
+        free(sf->references);
+    }
+}
+
+/**
+ * functionAttributes - Parses the attributes in front of a function
+ * definition, if any. (helper function)
+ *
+ * NOTE:
+ * function_attributes: ("__attribute__" '(' '(' ("cold" | "hot") ')' ')')* ;
+ * As with GCC, a cold function is unlikely to run and goes to the
+ * .text.unlikely section, where it stays out of the way of the rest, and
+ * a hot one goes to .text.hot, with the other hot functions. An if
+ * statement's arm that calls a cold function is itself unlikely.
+ *
+ * @return The TS_* section of the function's code.
+ */
+static int functionAttributes(void) {
+    int textSection = TS_NORMAL;
+
+    while (Token.token == T_ATTRIBUTE) {
+        scan(&Token);
+        matchLeftParenthesisToken();
+        matchLeftParenthesisToken();
+        if (Token.token != T_IDENTIFIER ||
+            (strcmp(Text, "cold") && strcmp(Text, "hot"))) {
+            logFatal("Unsupported function attribute");
+        }
+        textSection = strcmp(Text, "cold") ? TS_HOT : TS_UNLIKELY;
+        scan(&Token);
+        matchRightParenthesisToken();
+        matchRightParenthesisToken();
+    }
+    return textSection;
+}
+
 /**
  * globalDeclaration - Parses global declarations (functions and variables).
  *
  * NOTE:
- * global_declaration: (function_declaration | variable_declaration)* ;
+ * global_declaration: (typedef_declaration |
+ *                      function_attributes "static"?
+ *                      (function_declaration | variable_declaration))* ;
+ * The code of functions is generated once the whole file is parsed. The
+ * storage of variables and the code of static functions are emitted at
+ * the end, statics only if used.
  */
 void globalDeclaration(void) {
-    struct ASTnode *treeNode;
+    bool isStatic;
+    int textSection;
     int type;
 
     while (true) {
+        if (Token.token == T_TYPEDEF) {
+            typedefDeclaration();
+            if (Token.token == T_EOF) {
+                break;
+            }
+            continue;
+        }
+
+        textSection = functionAttributes();
+        isStatic = (Token.token == T_STATIC);
+        if (isStatic) {
+            scan(&Token);
+        }
+
         // We have to read past the type and identifier to see
         // either a '(' (T_LPARENTHESIS) for function declaration
         // or a ',' or ';' for a variable declaration
         type = parsePrimitiveType();
+
+        // A struct definition on its own, e.g. "struct point { ... };"
+        if (isStructType(type) && Token.token == T_SEMICOLON) {
+            scan(&Token);
+            if (Token.token == T_EOF) {
+                break;
+            }
+            continue;
+        }
+
         matchIdentifierToken();
 
         if (Token.token == T_LPARENTHESIS) {
-            // parse the function declaration and generate the assembly code for
-            // it
-            treeNode = functionDeclaration(type);
-            // NOTE: Optional) AST dump to stdout
-            if (Option_dumpAST) {
-                if (Option_dumpASTCompacted) {
-                    dumpASTTreeCompacted(treeNode);
-                } else {
-                    dumpASTTree(treeNode);
-                }
-            }
-            codegenAST(treeNode, NOREG, NOREG);
+            // parse the function declaration; its assembly code is generated
+            // after the whole file
+            deferFunction(functionDeclaration(type, isStatic, textSection));
         } else {
+            if (textSection != TS_NORMAL) {
+                logFatal("The cold and hot attributes apply to functions");
+            }
             // Assume
-            variableDeclaration(type, false);
+            variableDeclaration(type, false, isStatic);
+            matchSemicolonToken();
         }
 
         // Stop when we reach the end of the file
@@ -195,4 +810,8 @@ void globalDeclaration(void) {
             break;
         }
     }
+
+    classifyGlobalVariables();
+    generateDeferredFunctions();
+    emitDeferredDefinitions();
 }
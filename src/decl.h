@@ -6,6 +6,9 @@
 #include <stdbool.h>
 
 struct token;
+struct structTable;
+struct asmStatement;
+struct asmOperand;
 
 // NOTE: scan.c
 void rejectToken(struct token *t);
@@ -29,6 +32,7 @@ struct ASTnode *makeASTUnary(int op,               // AST operation code
                              struct ASTnode *left, // Left child
                              int intvalue // Integer value (for leaf nodes)
 );
+struct ASTnode *cloneAST(struct ASTnode *n);
 
 // NOTE: treedump.c (AST dump)
 void dumpAST(struct ASTnode *n, int label, int level);
@@ -38,6 +42,9 @@ void dumpASTTreeCompacted(struct ASTnode *n);
 // NOTE: gen.c (target-agnostic code generation)
 int codegenAST(struct ASTnode *n, int reg, int parentASTop);
 int codegenGetLabelNumber(void);
+char *codegenExpandAsmText(struct asmStatement *a,
+                           char *(*operandText)(struct asmOperand *op,
+                                                int modifier));
 void codegenPreamble();
 void codegenPostamble();
 void codegenResetRegisters();
@@ -46,23 +53,28 @@ int codegenDeclareGlobalString(char *stringValue);
 int codegenGetPrimitiveTypeSize(int primitiveType);
 void codegenReturnFromFunction(int reg, int id);
 void codegenResetLocalOffset(void);
-int codegenGetLocalOffset(int type, bool isFunctionParameter);
+int codegenGetLocalOffset(int id, bool isFunctionParameter);
 
 // NOTE: cgn/*/*.c
 // (cgn_expr.c, cgn_stmt.c, cgn_regs.c)
 // Code generation utilities (NASM x86-64)
 
 // NASM x86-64 backend
+void nasmEmit(int insnClass, int bytes, const char *format, ...);
 void nasmDeclareDataSegment(void);
 void nasmDeclareTextSegment(void);
+void nasmTextSection(int section);
+void nasmDeclareBssSegment(void);
+void nasmDeclareRodataSegment(void);
 void nasmResetRegisterPool(void);
 void nasmPreamble();
 void nasmPostamble();
-int nasmFunctionCall(int registerId, int id);
+int nasmFunctionCall(int registerId, int secondRegisterId, int id);
 void nasmFunctionPreamble(int id);
 void nasmReturnFromFunction(int reg, int id);
 void nasmFunctionPostamble(int id);
 int nasmLoadImmediateInt(int value, int primitiveType);
+int nasmLoadImmediateFloat(double value, int primitiveType);
 int nasmLoadGlobalSymbol(int id, int op);
 int nasmLoadLocalSymbol(int id, int op);
 int nasmLoadGlobalString(int id);
@@ -74,19 +86,26 @@ int nasmAddRegs(int dstReg, int srcReg);
 int nasmSubRegs(int dstReg, int srcReg);
 int nasmMulRegs(int dstReg, int srcReg);
 int nasmDivRegsSigned(int dividendReg, int divisorReg);
+int nasmDivRegsUnsigned(int dividendReg, int divisorReg);
 int nasmShiftLeftConst(int reg, int shiftAmount);
 int nasmShiftLeftRegs(int dstReg, int srcReg);
-int nasmShiftRightRegs(int dstReg, int srcReg);
-int nasmCompareAndSet(int ASTop, int r1, int r2);
-int nasmCompareAndJump(int ASTop, int r1, int r2, int label);
+int nasmShiftRightRegsSigned(int dstReg, int srcReg);
+int nasmShiftRightRegsUnsigned(int dstReg, int srcReg);
+int nasmCompareAndSet(int ASTop, int r1, int r2, int primitiveType);
+int nasmCompareAndJump(int ASTop, int r1, int r2, int label,
+                       int primitiveType);
 void nasmLabel(int label);
 void nasmJump(int label);
 int nasmWidenPrimitiveType(int r, int oldPrimitiveType, int newPrimitiveType);
 int nasmGetPrimitiveTypeSize(int primitiveType);
 int nasmAddressOfSymbol(int id);
-int nasmDereferencePointer(int pointerReg, int primitiveType);
-int nasmStoreDereferencedPointer(int valueReg, int pointerReg,
+int nasmDereferencePointer(int pointerReg, int offset, int primitiveType);
+int nasmStoreDereferencedPointer(int valueReg, int pointerReg, int offset,
                                  int primitiveType);
+void nasmCompoundAssignSymbol(int ASTop, int reg, int immediate, int id);
+void nasmCompoundAssignDereferencedPointer(int ASTop, int reg, int immediate,
+                                           int pointerReg, int offset,
+                                           int primitiveType);
 int nasmArithmeticNegate(int reg);
 int nasmLogicalInvert(int reg);
 int nasmLogicalNot(int reg);
@@ -94,20 +113,39 @@ int nasmBitwiseAndRegs(int dstReg, int srcReg);
 int nasmBitwiseOrRegs(int dstReg, int srcReg);
 int nasmBitwiseXorRegs(int dstReg, int srcReg);
 int nasmToBoolean(int reg, int op, int label);
+int nasmVectorLoad(int pointerReg, int offset, int vectorType);
+int nasmVectorStore(int valueReg, int pointerReg, int offset,
+                    int vectorType);
+int nasmVectorBinary(int ASTop, int r1, int r2, int vectorType);
+int nasmVectorSplat(int reg, int vectorType);
+int nasmAtomicLoad(int pointerReg, int primitiveType, int order);
+void nasmAtomicStore(int valueReg, int pointerReg, int primitiveType,
+                     int order);
+int nasmAtomicReadModifyWrite(int ASTop, int valueReg, int pointerReg,
+                              int primitiveType, int order);
+int nasmAtomicCompareExchange(int pointerReg, int expectedPointerReg,
+                              int desiredReg, int primitiveType, int order);
+void nasmAtomicFence(int order);
+void nasmPrefetch(int pointerReg, int offset, int hint);
+void nasmAsmReserveClobbers(struct asmStatement *a);
+void nasmInlineAsm(struct asmStatement *a);
 void nasmResetLocalOffset(void);
-int nasmGetLocalOffset(int type, bool isFunctionParameter);
+int nasmGetLocalOffset(int id, bool isFunctionParameter);
 
 // aarch64 AArch64 backend
+void aarch64Emit(int insnClass, const char *format, ...);
 void aarch64DeclareDataSegment(void);
 void aarch64DeclareTextSegment(void);
+void aarch64TextSection(int section);
 void aarch64ResetRegisterPool(void);
 void aarch64Preamble(void);
 void aarch64Postamble(void);
-int aarch64FunctionCall(int registerId, int id);
+int aarch64FunctionCall(int registerId, int secondRegisterId, int id);
 void aarch64FunctionPreamble(int id);
 void aarch64ReturnFromFunction(int reg, int id);
 void aarch64FunctionPostamble(int id);
 int aarch64LoadImmediateInt(int value, int primitiveType);
+int aarch64LoadImmediateFloat(double value, int primitiveType);
 int aarch64LoadGlobalSymbol(int id, int op);
 int aarch64LoadLocalSymbol(int id, int op);
 int aarch64LoadGlobalString(int id);
@@ -119,20 +157,27 @@ int aarch64AddRegs(int dstReg, int srcReg);
 int aarch64SubRegs(int dstReg, int srcReg);
 int aarch64MulRegs(int dstReg, int srcReg);
 int aarch64DivRegsSigned(int dividendReg, int divisorReg);
+int aarch64DivRegsUnsigned(int dividendReg, int divisorReg);
 int aarch64ShiftLeftConst(int reg, int shiftAmount);
 int aarch64ShiftLeftRegs(int dstReg, int srcReg);
-int aarch64ShiftRightRegs(int dstReg, int srcReg);
-int aarch64CompareAndSet(int ASTop, int r1, int r2);
-int aarch64CompareAndJump(int ASTop, int r1, int r2, int label);
+int aarch64ShiftRightRegsSigned(int dstReg, int srcReg);
+int aarch64ShiftRightRegsUnsigned(int dstReg, int srcReg);
+int aarch64CompareAndSet(int ASTop, int r1, int r2, int primitiveType);
+int aarch64CompareAndJump(int ASTop, int r1, int r2, int label,
+                          int primitiveType);
 void aarch64Label(int label);
 void aarch64Jump(int label);
 int aarch64WidenPrimitiveType(int r, int oldPrimitiveType,
                               int newPrimitiveType);
 int aarch64GetPrimitiveTypeSize(int primitiveType);
 int aarch64AddressOfSymbol(int id);
-int aarch64DereferencePointer(int pointerReg, int primitiveType);
-int aarch64StoreDereferencedPointer(int valueReg, int pointerReg,
+int aarch64DereferencePointer(int pointerReg, int offset, int primitiveType);
+int aarch64StoreDereferencedPointer(int valueReg, int pointerReg, int offset,
                                     int primitiveType);
+void aarch64CompoundAssignSymbol(int ASTop, int reg, int immediate, int id);
+void aarch64CompoundAssignDereferencedPointer(int ASTop, int reg,
+                                              int immediate, int pointerReg,
+                                              int offset, int primitiveType);
 int aarch64ArithmeticNegate(int reg);
 int aarch64LogicalInvert(int reg);
 int aarch64LogicalNot(int reg);
@@ -140,11 +185,35 @@ int aarch64ToBoolean(int reg, int op, int label);
 int aarch64BitwiseAndRegs(int dstReg, int srcReg);
 int aarch64BitwiseOrRegs(int dstReg, int srcReg);
 int aarch64BitwiseXorRegs(int dstReg, int srcReg);
+int aarch64VectorLoad(int pointerReg, int offset, int vectorType);
+int aarch64VectorStore(int valueReg, int pointerReg, int offset,
+                       int vectorType);
+int aarch64VectorBinary(int ASTop, int r1, int r2, int vectorType);
+int aarch64VectorSplat(int reg, int vectorType);
+int aarch64AtomicLoad(int pointerReg, int primitiveType, int order);
+void aarch64AtomicStore(int valueReg, int pointerReg, int primitiveType,
+                        int order);
+int aarch64AtomicReadModifyWrite(int ASTop, int valueReg, int pointerReg,
+                                 int primitiveType, int order);
+int aarch64AtomicCompareExchange(int pointerReg, int expectedPointerReg,
+                                 int desiredReg, int primitiveType,
+                                 int order);
+void aarch64AtomicFence(int order);
+void aarch64Prefetch(int pointerReg, int offset, int hint);
+void aarch64AsmReserveClobbers(struct asmStatement *a);
+void aarch64InlineAsm(struct asmStatement *a);
 void aarch64ResetLocalOffset(void);
-int aarch64GetLocalOffset(int type, bool isFunctionParameter);
+int aarch64GetLocalOffset(int id, bool isFunctionParameter);
 
 // NOTE: expr.c
 struct ASTnode *binexpr(int rbp);
+bool isAssignmentASTop(int ASTop);
+bool isAtomicASTop(int ASTop);
+int compoundAssignToBinaryASTop(int ASTop);
+bool evaluateConstantExpression(struct ASTnode *n, long *value);
+void checkModifiable(struct ASTnode *n);
+long parseConstantExpression(void);
+long parseConstantFloatExpression(int type);
 
 // NOTE: stmt.c
 // void statements(void);
@@ -158,6 +227,7 @@ void matchLeftBraceToken(void);        // {
 void matchRightBraceToken(void);       // }
 void matchLeftParenthesisToken(void);  // (
 void matchRightParenthesisToken(void); // )
+void matchCommaToken(void);            // ,
 void logFatal(char *s);
 void logFatals(char *s1, char *s2);
 void logFatald(char *s, int d);
@@ -167,21 +237,77 @@ void logFatalc(char *s, int c);
 int findGlobalSymbol(char *s);
 int findLocalSymbol(char *s);
 int findSymbol(char *s);
+void freeLocalSymbols(void);
+struct symbolTable *saveLocalSymbols(int *count);
+void restoreLocalSymbols(struct symbolTable *locals, int count);
 int addGlobalSymbol(char *name, int primitiveType, int structuralType,
                     int endLabel, int size);
 int addLocalSymbol(char *name, int primitiveType, int structuralType,
                    int endlabel, int size);
+int addStaticSymbol(char *name, int primitiveType, int structuralType,
+                    int endLabel, int size);
+int addInitializedGlobalSymbol(char *name, int primitiveType, int classType,
+                               long value);
+int addLocalStaticSymbol(char *name, int storageId);
+int findStruct(char *s);
+int addStruct(char *name);
+int findTypedef(char *s);
+void addTypedef(char *name, int primitiveType);
 
 // NOTE: decl.c
 int parsePrimitiveType(void);
-void variableDeclaration(int type, bool isLocalVariable);
-struct ASTnode *functionDeclaration(int type);
+struct ASTnode *variableDeclaration(int type, bool isLocalVariable,
+                                    bool isStatic);
+struct ASTnode *functionDeclaration(int type, bool isStatic,
+                                    int textSection);
 void globalDeclaration(void);
 
+// NOTE: globals.c
+void recordStore(struct ASTnode *n, struct ASTnode *value);
+void recordAsmText(char *text);
+void classifyGlobalVariables(void);
+
+// NOTE: alias.c
+struct memoryAccess;
+bool describeMemoryAccess(struct ASTnode *n, struct memoryAccess *a);
+bool mayAlias(struct memoryAccess *a, struct memoryAccess *b);
+
+// NOTE: opt.c
+void optimizeFunction(struct ASTnode *n);
+
+// NOTE: sizereport.c
+void sizeReportBeginFunction(int id, int frameSize);
+void sizeReportCountInstruction(int insnClass, int bytes);
+void sizeReportCountSpillSlots(int slots);
+void sizeReportEndFunction(void);
+void sizeReportDropFunction(int id);
+void sizeReportPrint(void);
+
 // NOTE: types.c
 bool isIntegerType(int primitiveType);
+bool isUnsignedType(int primitiveType);
+bool isNarrowIntegerType(int primitiveType);
+long convertIntegerValue(long value, int primitiveType);
+bool isFloatType(int primitiveType);
+void initTypeTable(void);
 bool isPointerType(int primitiveType);
+bool isArrayType(int primitiveType);
+bool isStructType(int primitiveType);
+bool isVectorType(int primitiveType);
 int primitiveTypeToPointerType(int primitiveType);
 int pointerToPrimitiveType(int primitiveType);
+int arrayTypeOf(int elementType, int count);
+int functionTypeOf(int returnType);
+int structTypeOf(int structIndex);
+int vectorTypeOf(int elementType, int bytes);
+bool isVectorOperationSupported(int ASTop, int primitiveType);
+void completeStructType(int primitiveType, int size, int alignment);
+struct structTable *structOfType(int primitiveType);
+int getTypeSize(int primitiveType);
+int getTypeAlignment(int primitiveType);
+int getSymbolSize(int id);
+int getSymbolAlignment(int id);
+int getMemoryAccessType(int primitiveType);
+struct ASTnode *promoteInteger(struct ASTnode *node);
 struct ASTnode *coerceASTTypeForOp(struct ASTnode *node, int contextType,
                                    int op);
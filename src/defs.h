@@ -19,6 +19,12 @@ enum {
     TARGET_AARCH64 = 2, // AArch64 (ARM64) GNU as-style assembly
 };
 
+// Architecture levels selected by --march
+enum {
+    MARCH_BASELINE, // x86-64, or armv8-a
+    MARCH_LSE,      // armv8.1-a and later (or "+lse"): LSE atomics
+};
+
 // Length of symbols in input
 #define TEXTLEN 512
 
@@ -26,30 +32,76 @@ enum {
 // = maximum number of unique symbols in input
 #define NSYMBOLS 1024
 
+// Number of slots in the hash index of global symbol names
+// (a power of two, greater than NSYMBOLS)
+#define NGLOBALHASH 2048
+
+// Number of AST nodes allocated at a time
+#define NASTBLOCKNODES 4096
+
+// Number of struct table entries and of members per struct
+#define NSTRUCTS 64
+#define NMEMBERS 64
+
+// Number of type table entries
+// = maximum number of distinct types in input (including derived types)
+#define NTYPES 1024
+
+// Maximum nesting depth of loops (for break/continue targets)
+#define NLOOPS 64
+
+// Maximum number of dimensions of an array
+#define NARRAYDIMS 8
+
+// Maximum number of static functions in input
+#define NSTATICFUNCTIONS 256
+
+// Number of typedef table entries
+#define NTYPEDEFS 64
+
+// Size in bytes of a SIMD vector type (one XMM or NEON Q register)
+#define VECTORSIZE 16
+
+// Maximum number of operands and of clobbers of an asm statement
+#define NASMOPERANDS 10
+#define NASMCLOBBERS 16
+
+// Maximum --prefetch-distance in bytes
+#define MAXPREFETCHDISTANCE 4096
+
 // Token types
 enum {
     // Single-character tokens
     T_EOF, // end of file
 
     // Binary operators
-    T_ASSIGN,     // =
-    T_LOGICALOR,  // ||
-    T_LOGICALAND, // &&
-    T_BITWISEOR,  // |
-    T_BITWISEXOR, // ^
-    T_AMPERSAND,  // & (bitwise AND, address-of operator)
-    T_EQ,         // ==
-    T_NE,         // !=
-    T_LT,         // <
-    T_GT,         // >
-    T_LE,         // <=
-    T_GE,         // >=
-    T_LSHIFT,     // <<
-    T_RSHIFT,     // >>
-    T_PLUS,       // +
-    T_MINUS,      // - (subtraction or (unary) negation)
-    T_STAR,       // *
-    T_SLASH,      // /
+    T_ASSIGN,       // =
+    T_ASSIGNPLUS,   // +=
+    T_ASSIGNMINUS,  // -=
+    T_ASSIGNSTAR,   // *=
+    T_ASSIGNSLASH,  // /=
+    T_ASSIGNOR,     // |=
+    T_ASSIGNAND,    // &=
+    T_ASSIGNXOR,    // ^=
+    T_ASSIGNLSHIFT, // <<=
+    T_ASSIGNRSHIFT, // >>=
+    T_LOGICALOR,    // ||
+    T_LOGICALAND,   // &&
+    T_BITWISEOR,    // |
+    T_BITWISEXOR,   // ^
+    T_AMPERSAND,    // & (bitwise AND, address-of operator)
+    T_EQ,           // ==
+    T_NE,           // !=
+    T_LT,           // <
+    T_GT,           // >
+    T_LE,           // <=
+    T_GE,           // >=
+    T_LSHIFT,       // <<
+    T_RSHIFT,       // >>
+    T_PLUS,         // +
+    T_MINUS,        // - (subtraction or (unary) negation)
+    T_STAR,         // *
+    T_SLASH,        // /
 
     // Unary operators
     T_INCREMENT,     // ++
@@ -58,43 +110,95 @@ enum {
     T_LOGICALNOT,    // !
 
     // Types
-    T_VOID, // "void"
-    T_CHAR, // "char"
-    T_INT,  // "int"
-    T_LONG, // "long"
+    T_VOID,   // "void"
+    T_CHAR,   // "char"
+    T_SHORT,  // "short"
+    T_INT,    // "int"
+    T_LONG,   // "long"
+    T_FLOAT,  // "float"
+    T_DOUBLE, // "double"
+    T_STRUCT, // "struct"
+
+    // Type qualifiers
+    T_UNSIGNED, // "unsigned"
+    T_CONST,    // "const"
+    T_VOLATILE, // "volatile"
+    T_RESTRICT, // "restrict"
+
+    // Storage class specifiers
+    T_STATIC,  // "static"
+    T_TYPEDEF, // "typedef"
 
     // Keywords
-    T_IF,     // "if"
-    T_ELSE,   // "else"
-    T_WHILE,  // "while"
-    T_FOR,    // "for" (will be converted into while statement)
-    T_RETURN, // "return"
+    T_IF,        // "if"
+    T_ELSE,      // "else"
+    T_WHILE,     // "while"
+    T_DO,        // "do"
+    T_FOR,       // "for" (will be converted into while statement)
+    T_BREAK,     // "break"
+    T_CONTINUE,  // "continue"
+    T_RETURN,    // "return"
+    T_SIZEOF,    // "sizeof"
+    T_ATTRIBUTE, // "__attribute__"
+    T_ASM,       // "asm" or "__asm__"
+
+    // Atomic builtins
+    T_ATOMICLOAD,     // "__atomic_load_n"
+    T_ATOMICSTORE,    // "__atomic_store_n"
+    T_ATOMICFETCHADD, // "__atomic_fetch_add"
+    T_ATOMICEXCHANGE, // "__atomic_exchange_n"
+    T_ATOMICCMPXCHG,  // "__atomic_compare_exchange_n"
+    T_ATOMICFENCE,    // "__atomic_thread_fence"
+
+    // Branch hint builtins
+    T_BUILTINEXPECT,      // "__builtin_expect"
+    T_BUILTINUNREACHABLE, // "__builtin_unreachable"
+    T_BUILTINPREFETCH,    // "__builtin_prefetch"
 
     // Structural tokens
     T_INTEGERLITERAL, // integer literal
                       // (decimal whole number which have 1 or more digits of
                       // 0-9)
+    T_FLOATLITERAL,   // floating-point literal
+                      // (e.g. 1.5, .5, 2e-3, 1.5f)
     T_STRINGLITERAL,  // string literal
     T_SEMICOLON,      // ;
     T_IDENTIFIER,     // variable names
+    T_TYPENAME,       // name declared by typedef (its type in intvalue)
     T_LBRACE,         // {
     T_RBRACE,         // }
     T_LPARENTHESIS,   // (
     T_RPARENTHESIS,   // )
     T_LBRACKET,       // [
     T_RBRACKET,       // ]
+    T_DOT,            // .
+    T_ARROW,          // ->
+    T_COMMA,          // , (separates the arguments of builtins)
+    T_COLON,          // : (separates the parts of an asm statement)
 };
 
 // Token structure
 struct token {
-    int token;    // Token type
-    int intvalue; // Integer value if token is T_INTEGERLITERAL
+    int token;         // Token type
+    int intvalue;      // Integer value if token is T_INTEGERLITERAL;
+                       // P_FLOAT or P_DOUBLE if token is T_FLOATLITERAL;
+                       // the named type if token is T_TYPENAME
+    double floatvalue; // Value if token is T_FLOATLITERAL
 };
 
 // AST node types
 enum {
     A_NOTHING = 0,      // No operation
     A_ASSIGN = 1,       // Assignment
+    A_ASSIGNADD,        // Compound assignment (+=)
+    A_ASSIGNSUBTRACT,   // Compound assignment (-=)
+    A_ASSIGNMULTIPLY,   // Compound assignment (*=)
+    A_ASSIGNDIVIDE,     // Compound assignment (/=)
+    A_ASSIGNBITWISEOR,  // Compound assignment (|=)
+    A_ASSIGNBITWISEAND, // Compound assignment (&=)
+    A_ASSIGNBITWISEXOR, // Compound assignment (^=)
+    A_ASSIGNLSHIFT,     // Compound assignment (<<=)
+    A_ASSIGNRSHIFT,     // Compound assignment (>>=)
     A_LOGICALOR,        // Logical OR
     A_LOGICALAND,       // Logical AND
     A_BITWISEOR,        // Bitwise OR
@@ -113,13 +217,14 @@ enum {
     A_MULTIPLY,         // Multiplication
     A_DIVIDE,           // Division
     A_INTEGERLITERAL,   // Integer literal
+    A_FLOATLITERAL,     // Floating-point literal
     A_STRINGLITERAL,    // String literal
     A_IDENTIFIER,       // Identifier (variable)
     A_GLUE,             // Statement glue (for sequencing statements)
     A_IF,               // If statement
     A_WHILE,            // While loop
     A_FUNCTION,         // Function definition
-    A_WIDENTYPE,        // Widen data type (usually integer)
+    A_WIDENTYPE,        // Widen data type (an integer, or to/from float)
     A_RETURN,           // Return statement
     A_FUNCTIONCALL,     // Function call
     A_DEREFERENCE,      // Pointer dereference
@@ -133,10 +238,57 @@ enum {
     A_LOGICALINVERT,    // Bitwise NOT (~expr)
     A_LOGICALNOT,       // Logical NOT (!expr)
     A_TOBOOLEAN,        // Convert to boolean context
+    A_DOWHILE,          // Do-while loop
+    A_BREAK,            // Break out of the innermost loop
+    A_CONTINUE,         // Continue the innermost loop
                         // (e.g., in if statement's conditions)
+    A_SPLAT,            // Copy a scalar into every lane of a vector
+    A_ATOMICLOAD,       // __atomic_load_n (pointer in left)
+    A_ATOMICSTORE,      // __atomic_store_n (pointer in left, value in right)
+    A_ATOMICFETCHADD,   // __atomic_fetch_add (likewise)
+    A_ATOMICEXCHANGE,   // __atomic_exchange_n (likewise)
+    A_ATOMICCMPXCHG,    // __atomic_compare_exchange_n (pointer in left,
+                        // pointer to the expected value in middle,
+                        // desired value in right)
+    A_ATOMICFENCE,      // __atomic_thread_fence
+    A_ASM,              // asm statement (operands in left, output stores
+                        // in right, both chained through A_ASMOPERAND)
+    A_ASMOPERAND,       // One link of an asm operand chain (the operand's
+                        // expression in left, the next link in right)
+    A_ASMRESULT,        // The value an asm statement left in the register
+                        // of output operand v.intvalue
+    A_EXPECT,           // __builtin_expect (the expression in left; whether
+                        // it is expected to be non-zero in v.intvalue)
+    A_UNREACHABLE,      // __builtin_unreachable
+    A_PREFETCH,         // __builtin_prefetch (the address in left; the
+                        // locality, plus PREFETCH_WRITE, in v.intvalue)
+};
+
+// Set in the v.intvalue of an A_PREFETCH for a prefetch for writing
+#define PREFETCH_WRITE 4
+
+// How likely the then arm of an A_IF is to run (its v.intvalue)
+enum {
+    BRANCH_UNKNOWN,
+    BRANCH_LIKELY,   // The else arm, if any, is unlikely
+    BRANCH_UNLIKELY, // The then arm is unlikely
+};
+
+// C11 memory orders, numbered like GCC's __ATOMIC_* constants
+enum {
+    MO_RELAXED, // __ATOMIC_RELAXED
+    MO_CONSUME, // __ATOMIC_CONSUME (parsed as acquire, like GCC does)
+    MO_ACQUIRE, // __ATOMIC_ACQUIRE
+    MO_RELEASE, // __ATOMIC_RELEASE
+    MO_ACQ_REL, // __ATOMIC_ACQ_REL
+    MO_SEQ_CST, // __ATOMIC_SEQ_CST
 };
 
 // Primitive types
+// NOTE:
+// Types are indices into the type table (see types.c). These scalar types
+// are interned first and in this order, so their indices are constants;
+// pointer, array, function and struct types get their indices on demand.
 enum {
     // Value
     P_NONE, // no type
@@ -149,19 +301,45 @@ enum {
             // Here, we assume long is 8 bytes.
             // Later, we may need to modify this to handle different
             // architectures.
+    P_UCHAR, // unsigned char type (1 byte)
+    P_UINT,  // unsigned int type (4 bytes)
+    P_ULONG, // unsigned long type (8 bytes)
+    P_SHORT,  // short type (2 bytes)
+    P_USHORT, // unsigned short type (2 bytes)
+    P_FLOAT,  // single-precision floating-point type (4 bytes)
+    P_DOUBLE, // double-precision floating-point type (8 bytes)
+
+    P_NSCALARS, // number of scalar types
+};
 
-    // Pointer
-    P_VOIDPTR, // pointer to void
-    P_CHARPTR, // pointer to char
-    P_INTPTR,  // pointer to int
-    P_LONGPTR, // pointer to long
+// Type kinds
+enum {
+    TY_SCALAR,   // void, the integer and the floating-point types (P_*)
+    TY_POINTER,  // pointer to the base type
+    TY_ARRAY,    // array of count elements of the base type
+    TY_FUNCTION, // function returning the base type
+    TY_STRUCT,   // struct described by StructTable[structIndex]
+    TY_VECTOR,   // SIMD vector of count lanes of the (scalar) base type
+};
+
+// Type table structure
+// Each distinct type has exactly one entry, so two types are equal
+// if and only if their indices are equal.
+struct typeTable {
+    int kind;        // Type kind (e.g., TY_POINTER)
+    int base;        // Pointee, element, lane or return type
+    int count;       // For arrays and vectors, the number of elements
+    int structIndex; // For structs, the index into StructTable
+    int size;        // Size in bytes (-1 for incomplete structs)
+    int alignment;   // Alignment in bytes
+    int next;        // Next entry in the same hash bucket, or -1
 };
 
 // AST node structure
 struct ASTnode {
     int op;                 // operation to be performed on this tree
                             // (e.g., A_ADD, A_INTEGERLITERAL)
-    int primitiveType;      // primitive type (e.g., P_INT, P_CHAR)
+    int primitiveType;      // type table index (e.g., P_INT, P_CHAR)
     bool isRvalue;          // is this node an r-value?
     struct ASTnode *left;   // left subtree
     struct ASTnode *middle; // middle subtree (for if-else statements)
@@ -170,14 +348,25 @@ struct ASTnode {
     /**
      * NOTE:
      * For A_INTEGERLITERAL,       use v.intvalue to store the integer value.
+     * For A_FLOATLITERAL, use v.floatvalue to store the value (already
+     *                     rounded to float for a P_FLOAT literal)
      * For A_IDENTIFIER,   use v.identifierIndex to store the index
      * For A_FUNCTION,     use v.identifierIndex to store the index
      * For A_FUNCTIONCALL, use v.identifierIndex to store the index
+     * For A_ATOMIC*,      use v.intvalue to store the memory order (MO_*)
+ * For A_PREFETCH,    use v.intvalue to store the locality (and
+ *                     PREFETCH_WRITE)
+     * For A_ASM,          use v.asmStatement to store the text and the
+     *                     operand constraints
      */
     union {
         int intvalue;
         int identifierIndex; // For A_FUNCTION, the symbol slot number
         int size;            // For A_SCALE, the size of scale by
+        int offset;          // For A_DEREFERENCE, constant byte
+                             // displacement added to the address
+        double floatvalue;   // For A_FLOATLITERAL, the value
+        struct asmStatement *asmStatement; // For A_ASM, see below
     } v;
 };
 
@@ -186,11 +375,39 @@ struct ASTnode {
 // functions have no register to return
 #define NOREG -1
 
+// NOTE:
+// Register indices from FIRSTFPREG up name floating-point registers
+// (e.g. xmm0 is FIRSTFPREG + 0), so that the same backend operations can
+// take integer and floating-point registers
+#define FIRSTFPREG 16
+
+// NOTE:
+// Register set of a function whose code is not known (yet): a call to it
+// may write any register of the pool
+#define ALLREGISTERS (~0UL)
+
 // NOTE:
 // Use NOLABEL when we have no label (to jump)
 // to pass to codegenAST() function
 #define NOLABEL 0
 
+// Instruction classes counted by --size-report
+enum {
+    INSN_LOAD,   // Reads memory (including pop / ldp)
+    INSN_STORE,  // Writes memory (including push / stp)
+    INSN_ALU,    // Register-only arithmetic, moves and compares
+    INSN_BRANCH, // Jumps, conditional branches and returns
+    INSN_CALL,   // Calls
+    INSN_NCLASSES,
+};
+
+// Output formats of --size-report
+enum {
+    SIZE_REPORT_NONE,
+    SIZE_REPORT_TABLE,
+    SIZE_REPORT_JSON,
+};
+
 // Structural types
 enum {
     S_VARIABLE,
@@ -202,18 +419,117 @@ enum {
 enum {
     C_GLOBAL = 1, // Globally visible symbol
     C_LOCAL,      // Locally visible symbol
+    C_STATIC,     // Static storage, not visible outside the file
+};
+
+// Type qualifier flags (const, volatile, restrict)
+// NOTE:
+// Qualifiers are kept on the symbol rather than in the type table, because
+// type indices double as the scalar codes the backends switch on.
+enum {
+    Q_CONST = 1,
+    Q_VOLATILE = 2,
+    Q_RESTRICT = 4,
 };
 
 // Symbol table structure
 struct symbolTable {
-    char *name;         // Name of a symbol
-    int primitiveType;  // Primitive type for the symbol (e.g., P_INT)
-    int structuralType; // Structural type (e.g., S_VARIABLE)
-    int class;          // Storage class for the symbol
-    int endLabel;       // For functions, the end label
-    int size;           // Size (number of elements for arrays, etc.)
-    int offset;         // For local variable, the negative offset
-                        // from the stack base pointer (RBP)
+    char *name;           // Name of a symbol
+    int primitiveType;    // Type of the symbol (e.g., P_INT; an array or
+                          // function type for S_ARRAY and S_FUNCTION)
+    int structuralType;   // Structural type (e.g., S_VARIABLE)
+    int class;            // Storage class for the symbol
+    int endLabel;         // For functions, the end label
+    int size;             // Size (number of elements for arrays, etc.)
+    int offset;           // For local variable, the negative offset
+                          // from the stack base pointer (RBP); for a
+                          // function-local static, the ID of its storage
+    bool isInitialized;   // Global variable with a constant initial value
+    long initialValue;    // That value (its IEEE bits for float/double)
+    bool isReferenced;    // Static symbol used by code that is emitted
+    int qualifiers;       // Q_* flags of the variable (of the elements
+                          // for arrays)
+    int targetQualifiers; // For pointers, Q_* flags of the pointed-to type
+    bool isAddressTaken;  // Does the program apply '&' to the variable?
+    bool isStored;        // Does the program store to the variable?
+    bool isChanged;       // Does it store anything but its initial value?
+    bool isConstant;      // Global variable that always holds its initial
+                          // value, so its loads are immediates
+    bool isReadOnly;      // Global variable never stored to, kept in
+                          // .rodata
+    int textSection;      // For functions, the TS_* section of their code
+    unsigned long clobberedRegisters; // For functions, the pool registers
+                                      // a call may write (bit r for
+                                      // register index r)
+};
+
+// Text sections, by how often the code placed in them runs
+enum {
+    TS_NORMAL,   // .text
+    TS_HOT,      // .text.hot (functions declared "hot")
+    TS_UNLIKELY, // .text.unlikely (functions declared "cold", and the
+                 // unlikely arms of if statements)
+};
+
+// Kinds of memory access described by the alias analysis
+enum {
+    ACCESS_OBJECT,  // A named variable or array
+    ACCESS_POINTER, // Through the value of a pointer variable
+    ACCESS_UNKNOWN, // Through a pointer loaded from memory
+};
+
+// A load or store, as seen by the alias analysis (see alias.c)
+struct memoryAccess {
+    int kind;           // ACCESS_*
+    int id;             // The variable, or the pointer variable
+    long offset;        // Byte offset from the variable or pointer value
+    bool isOffsetKnown; // False if a run-time index is added
+    int size;           // Number of bytes accessed
+    int qualifiers;     // Q_* flags of the accessed memory
+};
+
+// Struct member structure
+struct structMember {
+    char *name;        // Name of the member
+    int primitiveType; // Primitive type of the member
+    int offset;        // Byte offset from the start of the struct
+};
+
+// Struct table structure
+// (The struct's size and alignment live in its type table entry)
+struct structTable {
+    char *name;      // Struct tag
+    bool isDefined;  // Has the member list been parsed?
+    int memberCount; // Number of members
+    struct structMember members[NMEMBERS];
+};
+
+// Typedef table structure
+struct typedefTable {
+    char *name;        // Name declared by the typedef
+    int primitiveType; // The type it names
+};
+
+// One operand of an asm statement, referred to as "%N" in its text
+struct asmOperand {
+    char constraint; // 'r' (register), 'm' (memory) or 'i' (immediate)
+    bool isOutput;   // Written by the statement ("=" or "+")
+    int offset;      // For 'm', displacement added to the address
+    long value;      // For 'i', the constant
+    int reg;         // Register holding the value (or for 'm', the
+                     // address) while the text runs; set by codegen
+};
+
+// An asm statement: the text and its operands (outputs first) and
+// clobbers
+struct asmStatement {
+    char *text;
+    struct asmOperand operands[NASMOPERANDS];
+    int operandCount;
+    char *clobbers[NASMCLOBBERS];
+    int clobberCount;
+    int clobberRegs[NASMCLOBBERS]; // Pool register reserved for each
+                                   // clobber, or NOREG; set by codegen
 };
 
 #endif
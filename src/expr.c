@@ -8,10 +8,17 @@
  * functionCall - Parse a function call expression.
  * e.g., foo(42);
  *
+ * NOTE:
+ * A call passes one or two arguments. The second one is kept in the
+ * node's right child; it is what lets a program hand a runtime function
+ * such as thread_spawn() both a function and its argument.
+ * e.g., thread_spawn(worker, 3);
+ *
  * @return ASTnode* The AST node representing the function call.
  */
 static struct ASTnode *functionCall(void) {
     struct ASTnode *treeNode = NULL;
+    struct ASTnode *secondArgument = NULL;
     int id;
 
     // Identifier
@@ -25,12 +32,24 @@ static struct ASTnode *functionCall(void) {
 
     // Parse the following expression
     treeNode = binexpr(0);
+    if (Token.token == T_COMMA) {
+        scan(&Token);
+        secondArgument = binexpr(0);
+        if (Token.token == T_COMMA) {
+            logFatals("Too many arguments to function ", SymbolTable[id].name);
+        }
+    }
+    if (isVectorType(treeNode->primitiveType) ||
+        (secondArgument && isVectorType(secondArgument->primitiveType))) {
+        logFatals("Cannot pass a vector to function ", SymbolTable[id].name);
+    }
 
     // Build the function call AST node.
     // - Store the function's return type as this node's type.
     // - Record the function's symbol ID
-    treeNode = makeASTUnary(A_FUNCTIONCALL, SymbolTable[id].primitiveType,
-                            treeNode, id);
+    treeNode = makeASTNode(A_FUNCTIONCALL,
+                           TypeTable[SymbolTable[id].primitiveType].base,
+                           treeNode, NULL, secondArgument, id);
 
     // Right parenthesis (")")
     matchRightParenthesisToken();
@@ -40,54 +59,237 @@ static struct ASTnode *functionCall(void) {
 
 /**
  * arrayAccess - Parse an array access expression.
- * e.g., arr[5];
+ * e.g., arr[5], grid[i][j];
+ *
+ * NOTE:
+ * Each index is scaled by the (constant) size of the element it selects,
+ * so "grid[i][j]" on "int grid[R][C]" becomes
+ *     &grid + i * (C * 4) + j * 4
+ * with no run-time multiplication of the dimensions. Constant
+ * indices are folded into the displacement of the final access instead of
+ * being added at run time, e.g. "grid[2][j]" loads from
+ * [&grid + j * 4 + 2 * C * 4].
+ * Arrays must be indexed down to a scalar (or struct, or vector) element.
+ * A vector is indexed like an array of its lanes, so "v[2]" (or "vs[i][2]"
+ * for an array of vectors) reads or writes one lane in memory.
  *
  * @return ASTnode* The AST node representing the array access.
  */
 static struct ASTnode *arrayAccess(void) {
     struct ASTnode *leftNode = NULL;
     struct ASTnode *rightNode = NULL;
+    int elementType;
+    int offset = 0;
+    long index;
     int id;
 
     // NOTE:
-    // Check that the identifier has been defined as an array,
-    // then make a leaf node for it that points at the base.
+    // Check that the identifier has been defined as an array (or a
+    // vector), then make a leaf node for it that points at the base.
     if ((id = findSymbol(Text)) == -1 ||
-        SymbolTable[id].structuralType != S_ARRAY) {
+        (SymbolTable[id].structuralType != S_ARRAY &&
+         !isVectorType(SymbolTable[id].primitiveType))) {
         logFatals("Undeclared array: ", Text);
     }
-    leftNode = makeASTLeaf(A_ADDRESSOF, SymbolTable[id].primitiveType, id);
+    elementType = TypeTable[SymbolTable[id].primitiveType].base;
+    leftNode =
+        makeASTLeaf(A_ADDRESSOF, primitiveTypeToPointerType(elementType), id);
 
-    // '['
-    scan(&Token);
+    while (true) {
+        // '['
+        scan(&Token);
 
-    // Parse the following expression
-    rightNode = binexpr(0);
+        // Parse the following expression
+        rightNode = binexpr(0);
+
+        // ']'
+        match(T_RBRACKET, "]");
 
-    // ']'
-    match(T_RBRACKET, "]");
+        // Ensure the array index is an integer type
+        if (!isIntegerType(rightNode->primitiveType)) {
+            logFatal("Array index must be an integer type");
+        }
 
-    // Ensure the array index is an integer type
-    if (!isIntegerType(rightNode->primitiveType)) {
-        logFatal("Array index must be an integer type");
+        if (evaluateConstantExpression(rightNode, &index)) {
+            // Constant index: fold it into the displacement
+            offset += index * getTypeSize(elementType);
+        } else {
+            // Scale the index by the size of the element's type
+            rightNode = coerceASTTypeForOp(
+                rightNode, primitiveTypeToPointerType(elementType), A_ADD);
+
+            // Add the scaled index to the address computed so far
+            leftNode = makeASTNode(A_ADD, leftNode->primitiveType, leftNode,
+                                   NULL, rightNode, 0);
+        }
+
+        // Another dimension to index?
+        if (Token.token != T_LBRACKET) {
+            break;
+        }
+        if (!isArrayType(elementType) && !isVectorType(elementType)) {
+            logFatals("Too many indices for array: ", SymbolTable[id].name);
+        }
+        elementType = TypeTable[elementType].base;
     }
 
-    // Scale the index by the size of the element's type
-    rightNode = coerceASTTypeForOp(rightNode, leftNode->primitiveType, A_ADD);
+    if (isArrayType(elementType)) {
+        logFatals("Array must be indexed down to an element: ",
+                  SymbolTable[id].name);
+    }
 
     // NOTE:
     // Return an AST tree where the array's base has the offset
     // added to it, and dereference the element. Still an lvalue
     // at this point.
-    leftNode = makeASTNode(A_ADD, SymbolTable[id].primitiveType, leftNode, NULL,
-                           rightNode, 0);
-    leftNode = makeASTUnary(A_DEREFERENCE,
-                            pointerToPrimitiveType(leftNode->primitiveType),
-                            leftNode, 0);
+    leftNode = makeASTUnary(A_DEREFERENCE, elementType, leftNode, 0);
+    leftNode->v.offset = offset;
 
     return leftNode;
 }
 
+/**
+ * memberAccess - Parse a struct member access, with the current token being
+ * the '.' or '->' that follows a struct or struct pointer expression.
+ * e.g., p.x, pp->next
+ *
+ * NOTE:
+ * The access becomes an A_DEREFERENCE of the struct's base address with the
+ * member offset as a constant displacement, so "pp->x" is a single load or
+ * store at [pp+offset]. Chained accesses such as "a.b.c" and "arr[i].x" add
+ * their offsets onto the same base address.
+ *
+ * @param n The AST node of the struct or struct pointer expression.
+ *
+ * @return ASTnode* The AST node representing the member (still an lvalue).
+ */
+static struct ASTnode *memberAccess(struct ASTnode *n) {
+    struct ASTnode *base;
+    struct structTable *st;
+    struct structMember *member = NULL;
+    int structType;
+    int offset = 0;
+
+    if (Token.token == T_ARROW) {
+        // The pointer's value is the base address
+        if (!isPointerType(n->primitiveType) ||
+            !isStructType(pointerToPrimitiveType(n->primitiveType))) {
+            logFatal("'->' must be applied to a pointer to a struct");
+        }
+        structType = pointerToPrimitiveType(n->primitiveType);
+        n->isRvalue = true;
+        base = n;
+    } else {
+        // The struct's own address is the base address
+        if (!isStructType(n->primitiveType)) {
+            logFatal("'.' must be applied to a struct");
+        }
+        structType = n->primitiveType;
+        if (n->op == A_IDENTIFIER) {
+            base = makeASTLeaf(A_ADDRESSOF,
+                               primitiveTypeToPointerType(structType),
+                               n->v.identifierIndex);
+        } else {
+            // A struct in memory (an array element or another member)
+            base = n->left;
+            offset = n->v.offset;
+        }
+    }
+
+    // Incomplete structs have no members yet
+    getTypeSize(structType);
+    st = structOfType(structType);
+
+    // Member name
+    scan(&Token);
+    if (Token.token != T_IDENTIFIER) {
+        logFatal("Expected a struct member name after '.' or '->'");
+    }
+    for (int i = 0; i < st->memberCount; i++) {
+        if (!strcmp(Text, st->members[i].name)) {
+            member = &st->members[i];
+            break;
+        }
+    }
+    if (member == NULL) {
+        logFatals("No such struct member: ", Text);
+    }
+    scan(&Token);
+
+    n = makeASTUnary(A_DEREFERENCE, member->primitiveType, base, 0);
+    n->v.offset = offset + member->offset;
+    return n;
+}
+
+/**
+ * checkModifiable - Reject a store to memory that is declared const.
+ * e.g., "x = 1" with "const int x", "*p += 1" with "const int *p"
+ *
+ * @param n The AST node being stored to.
+ */
+void checkModifiable(struct ASTnode *n) {
+    struct memoryAccess access;
+
+    if (describeMemoryAccess(n, &access) &&
+        (access.qualifiers & Q_CONST)) {
+        if (access.kind == ACCESS_OBJECT) {
+            logFatals("Cannot modify a const variable: ",
+                      SymbolTable[access.id].name);
+        }
+        logFatal("Cannot modify memory through a pointer to const");
+    }
+}
+
+/**
+ * checkIncrementable - Reject '++' and '--' on a floating-point or vector
+ * variable, which the backends only step by integer amounts.
+ *
+ * @param n The AST node being incremented or decremented.
+ */
+static void checkIncrementable(struct ASTnode *n) {
+    if (isFloatType(n->primitiveType)) {
+        logFatal("'++' and '--' cannot be applied to a floating-point "
+                 "variable");
+    }
+    if (isVectorType(n->primitiveType)) {
+        logFatal("'++' and '--' cannot be applied to a vector variable");
+    }
+}
+
+/**
+ * checkScalarOperand - Reject a vector operand of a unary operator; only
+ * the binary operators work on vectors, lane by lane.
+ * e.g., "-v", "~v", "!v"
+ *
+ * @param n The operand's AST node.
+ * @param operator The operator, for the error message.
+ */
+static void checkScalarOperand(struct ASTnode *n, char *operator) {
+    if (isVectorType(n->primitiveType)) {
+        logFatals("Operator cannot be applied to a vector: ", operator);
+    }
+}
+
+/**
+ * checkVectorOperator - Reject a binary operator that the backends don't
+ * apply lane by lane to a vector operand's type (see
+ * isVectorOperationSupported()).
+ * e.g., "v / w" with int lanes, "c << 1" with char lanes
+ *
+ * @param left The left operand's AST node.
+ * @param right The right operand's AST node.
+ * @param ASTop The binary operator (e.g. A_DIVIDE).
+ */
+static void checkVectorOperator(struct ASTnode *left, struct ASTnode *right,
+                                int ASTop) {
+    int type = isVectorType(left->primitiveType) ? left->primitiveType
+                                                 : right->primitiveType;
+
+    if (isVectorType(type) && !isVectorOperationSupported(ASTop, type)) {
+        logFatal("Operator not supported on vectors of this lane type");
+    }
+}
+
 /**
  * postfix - Parse a postfix expression.
  * e.g., variable with post-increment/decrement.
@@ -108,11 +310,24 @@ static struct ASTnode *postfix(void) {
 
     // Or is this an array reference?
     if (Token.token == T_LBRACKET) {
-        return arrayAccess();
+        n = arrayAccess();
+        while (Token.token == T_DOT || Token.token == T_ARROW) {
+            n = memberAccess(n);
+        }
+        return n;
     }
 
-    // A variable (can be local or global)
+    // A function name without a call is the function's address, e.g. the
+    // "worker" in "thread_spawn(worker, 3)"
     id = findSymbol(Text);
+    if (id != -1 && SymbolTable[id].structuralType == S_FUNCTION) {
+        return makeASTLeaf(A_ADDRESSOF,
+                           primitiveTypeToPointerType(
+                               SymbolTable[id].primitiveType),
+                           id);
+    }
+
+    // A variable (can be local or global)
     if (id == -1 || SymbolTable[id].structuralType != S_VARIABLE) {
         logFatals("Undeclared variable: ", Text);
     }
@@ -122,23 +337,642 @@ static struct ASTnode *postfix(void) {
         // Post increment: skip over the token
         scan(&Token);
         n = makeASTLeaf(A_POSTINCREMENT, SymbolTable[id].primitiveType, id);
+        checkModifiable(n);
+        recordStore(n, NULL);
+        checkIncrementable(n);
         break;
 
     case T_DECREMENT:
         // Post decrement: skip over the token
         scan(&Token);
         n = makeASTLeaf(A_POSTDECREMENT, SymbolTable[id].primitiveType, id);
+        checkModifiable(n);
+        recordStore(n, NULL);
+        checkIncrementable(n);
         break;
 
     default:
-        // Just a variable inference
+        // Just a variable inference, possibly followed by member accesses
         n = makeASTLeaf(A_IDENTIFIER, SymbolTable[id].primitiveType, id);
+        while (Token.token == T_DOT || Token.token == T_ARROW) {
+            n = memberAccess(n);
+        }
         break;
     }
 
     return n;
 }
 
+/**
+ * makeIntegerLiteral - Make a leaf AST node for an integer constant.
+ *
+ * NOTE:
+ * Make the primitive integer leaf node as P_CHAR if
+ * the value is within char range. because we can optimize
+ * memory usage later. Likewise, values that fit in a short are P_SHORT
+ * so that they can be assigned to shorts.
+ *
+ * @param value The value of the constant.
+ *
+ * @return ASTnode* The A_INTEGERLITERAL leaf node.
+ */
+static struct ASTnode *makeIntegerLiteral(int value) {
+    if (value >= 0 && value <= 255) {
+        return makeASTLeaf(A_INTEGERLITERAL, P_CHAR, value);
+    }
+    if (value >= 0 && value <= 32767) {
+        return makeASTLeaf(A_INTEGERLITERAL, P_SHORT, value);
+    }
+    return makeASTLeaf(A_INTEGERLITERAL, P_INT, value);
+}
+
+/**
+ * sizeofExpression - Parse a sizeof expression, the current token being
+ * 'sizeof'.
+ * e.g., sizeof(long), sizeof(struct point *), sizeof(table), sizeof(a + b)
+ *
+ * NOTE:
+ * The size comes from the type table (and so from the backend's
+ * getPrimitiveTypeSize) and becomes an integer literal at parse time.
+ * The operand is only parsed for its type; no code is generated for it.
+ * An array name on its own gives the size of the whole array.
+ *
+ * @return ASTnode* The A_INTEGERLITERAL node holding the size.
+ */
+static struct ASTnode *sizeofExpression(void) {
+    struct token identifierToken;
+    struct token lookahead;
+    int size;
+    int id;
+
+    // Ensure 'sizeof' and '('
+    match(T_SIZEOF, "sizeof");
+    matchLeftParenthesisToken();
+
+    switch (Token.token) {
+    case T_CONST:
+    case T_VOLATILE:
+    case T_VOID:
+    case T_CHAR:
+    case T_SHORT:
+    case T_INT:
+    case T_LONG:
+    case T_FLOAT:
+    case T_DOUBLE:
+    case T_UNSIGNED:
+    case T_STRUCT:
+    case T_TYPENAME:
+        size = getTypeSize(parsePrimitiveType());
+        break;
+    default:
+        // A whole array does not decay to a pointer here
+        if (Token.token == T_IDENTIFIER && (id = findSymbol(Text)) != -1 &&
+            SymbolTable[id].structuralType == S_ARRAY) {
+            identifierToken = Token;
+            scan(&lookahead);
+            if (lookahead.token == T_RPARENTHESIS) {
+                Token = lookahead;
+                size = getSymbolSize(id);
+                break;
+            }
+            rejectToken(&lookahead);
+            Token = identifierToken;
+        }
+        size = getTypeSize(binexpr(0)->primitiveType);
+        break;
+    }
+
+    if (size <= 0) {
+        logFatal("sizeof applied to an incomplete or void type");
+    }
+
+    // Match the closing ')'; it also scans the following token
+    matchRightParenthesisToken();
+    return makeIntegerLiteral(size);
+}
+
+/**
+ * evaluateConstantExpression - Evaluate an integer constant expression at
+ * compile time.
+ *
+ * NOTE:
+ * Literals (including folded sizeofs) combined with the arithmetic,
+ * bitwise, shift, comparison and logical operators are constant.
+ * Division and right shift are unsigned when the expression's type is.
+ *
+ * @param n     The AST tree of the expression.
+ * @param value Where to store the value.
+ *
+ * @return bool True if the expression is constant, false otherwise.
+ */
+bool evaluateConstantExpression(struct ASTnode *n, long *value) {
+    long left;
+    long right;
+
+    if (n == NULL) {
+        return false;
+    }
+
+    switch (n->op) {
+    case A_INTEGERLITERAL:
+        *value = n->v.intvalue;
+        return true;
+    case A_WIDENTYPE:
+        if (!evaluateConstantExpression(n->left, value)) {
+            return false;
+        }
+        if (isIntegerType(n->primitiveType)) {
+            *value = convertIntegerValue(*value, n->primitiveType);
+        }
+        return true;
+    case A_ARITHMETICNEGATE:
+    case A_LOGICALINVERT:
+    case A_LOGICALNOT:
+        if (!evaluateConstantExpression(n->left, &left)) {
+            return false;
+        }
+        *value = (n->op == A_ARITHMETICNEGATE) ? -left
+                 : (n->op == A_LOGICALINVERT) ? ~left
+                                              : !left;
+        return true;
+    case A_ADD:
+    case A_SUBTRACT:
+    case A_MULTIPLY:
+    case A_DIVIDE:
+    case A_BITWISEAND:
+    case A_BITWISEOR:
+    case A_BITWISEXOR:
+    case A_LSHIFT:
+    case A_RSHIFT:
+    case A_EQ:
+    case A_NE:
+    case A_LT:
+    case A_GT:
+    case A_LE:
+    case A_GE:
+    case A_LOGICALAND:
+    case A_LOGICALOR:
+        break;
+    default:
+        return false;
+    }
+
+    if (!evaluateConstantExpression(n->left, &left) ||
+        !evaluateConstantExpression(n->right, &right)) {
+        return false;
+    }
+
+    switch (n->op) {
+    case A_ADD:
+        *value = left + right;
+        break;
+    case A_SUBTRACT:
+        *value = left - right;
+        break;
+    case A_MULTIPLY:
+        *value = left * right;
+        break;
+    case A_DIVIDE:
+        if (right == 0) {
+            logFatal("Division by zero in constant expression");
+        }
+        *value = isUnsignedType(n->primitiveType)
+                     ? (long)((unsigned long)left / (unsigned long)right)
+                     : left / right;
+        break;
+    case A_BITWISEAND:
+        *value = left & right;
+        break;
+    case A_BITWISEOR:
+        *value = left | right;
+        break;
+    case A_BITWISEXOR:
+        *value = left ^ right;
+        break;
+    case A_LSHIFT:
+        *value = (long)((unsigned long)left << right);
+        break;
+    case A_RSHIFT:
+        *value = isUnsignedType(n->primitiveType)
+                     ? (long)((unsigned long)left >> right)
+                     : left >> right;
+        break;
+    case A_EQ:
+        *value = left == right;
+        break;
+    case A_NE:
+        *value = left != right;
+        break;
+    case A_LT:
+        *value = left < right;
+        break;
+    case A_GT:
+        *value = left > right;
+        break;
+    case A_LE:
+        *value = left <= right;
+        break;
+    case A_GE:
+        *value = left >= right;
+        break;
+    case A_LOGICALAND:
+        *value = left && right;
+        break;
+    default: // A_LOGICALOR
+        *value = left || right;
+        break;
+    }
+    return true;
+}
+
+/**
+ * parseConstantExpression - Parse an expression that must be a
+ * compile-time constant, e.g. an array dimension or the initial value of
+ * a global variable.
+ *
+ * @return long The value of the expression.
+ */
+long parseConstantExpression(void) {
+    long value;
+
+    if (!evaluateConstantExpression(binexpr(0), &value)) {
+        logFatal("Expression is not a compile-time constant");
+    }
+    return value;
+}
+
+/**
+ * evaluateConstantFloatExpression - Evaluate a floating-point constant
+ * expression at compile time. (helper function)
+ *
+ * NOTE:
+ * Integer-typed subtrees are evaluated by evaluateConstantExpression(), so
+ * that e.g. "7 / 2" stays an integer division. Results of float type are
+ * rounded to float, as the generated code would do.
+ *
+ * @param n     The AST tree of the expression.
+ * @param value Where to store the value.
+ *
+ * @return bool True if the expression is constant, false otherwise.
+ */
+static bool evaluateConstantFloatExpression(struct ASTnode *n,
+                                            double *value) {
+    double left;
+    double right;
+    long intValue;
+
+    if (n == NULL) {
+        return false;
+    }
+    if (isIntegerType(n->primitiveType)) {
+        if (!evaluateConstantExpression(n, &intValue)) {
+            return false;
+        }
+        *value = intValue;
+        return true;
+    }
+
+    switch (n->op) {
+    case A_FLOATLITERAL:
+        *value = n->v.floatvalue;
+        return true;
+    case A_WIDENTYPE:
+    case A_ARITHMETICNEGATE:
+        if (!evaluateConstantFloatExpression(n->left, value)) {
+            return false;
+        }
+        if (n->op == A_ARITHMETICNEGATE) {
+            *value = -*value;
+        }
+        break;
+    case A_ADD:
+    case A_SUBTRACT:
+    case A_MULTIPLY:
+    case A_DIVIDE:
+        if (!evaluateConstantFloatExpression(n->left, &left) ||
+            !evaluateConstantFloatExpression(n->right, &right)) {
+            return false;
+        }
+        *value = (n->op == A_ADD)        ? left + right
+                 : (n->op == A_SUBTRACT) ? left - right
+                 : (n->op == A_MULTIPLY) ? left * right
+                                         : left / right;
+        break;
+    default:
+        return false;
+    }
+
+    if (n->primitiveType == P_FLOAT) {
+        *value = (float)*value;
+    }
+    return true;
+}
+
+/**
+ * parseConstantFloatExpression - Parse the initial value of a float or
+ * double global variable, which must be a compile-time constant.
+ *
+ * NOTE:
+ * The value is returned as the bits of its IEEE 754 representation in the
+ * given type, so that the backends can emit it like an integer of the
+ * same size.
+ *
+ * @param type The variable's type (P_FLOAT or P_DOUBLE).
+ *
+ * @return long The bits of the value.
+ */
+long parseConstantFloatExpression(int type) {
+    struct ASTnode *n;
+    double value;
+    float single;
+    long bits = 0;
+
+    n = coerceASTTypeForOp(binexpr(0), type, A_NOTHING);
+    if (n == NULL) {
+        logFatal("Incompatible expression in initialization");
+    }
+    if (!evaluateConstantFloatExpression(n, &value)) {
+        logFatal("Expression is not a compile-time constant");
+    }
+
+    if (type == P_FLOAT) {
+        single = value;
+        memcpy(&bits, &single, sizeof(single));
+    } else {
+        memcpy(&bits, &value, sizeof(value));
+    }
+    return bits;
+}
+
+/**
+ * atomicPointerOperand - Parse the pointer operand of an atomic builtin.
+ * (helper function)
+ *
+ * NOTE:
+ * The pointed-to object is a 4- or 8-byte integer (int, long or their
+ * unsigned kinds), which both backends access atomically in one
+ * instruction or one exclusive load/store pair.
+ *
+ * @return ASTnode* The pointer expression.
+ */
+static struct ASTnode *atomicPointerOperand(void) {
+    struct ASTnode *n = binexpr(0);
+    int base;
+
+    if (!isPointerType(n->primitiveType)) {
+        logFatal("The first operand of an atomic builtin must be a pointer");
+    }
+    base = TypeTable[n->primitiveType].base;
+    if (!isIntegerType(base) ||
+        (getTypeSize(base) != 4 && getTypeSize(base) != 8)) {
+        logFatal("Atomic builtins only support int and long objects");
+    }
+    return n;
+}
+
+/**
+ * memoryOrderOperand - Parse the memory order operand of an atomic builtin.
+ * (helper function)
+ *
+ * NOTE:
+ * The order must be a constant (one of the __ATOMIC_* names). Consume is
+ * promoted to acquire, as GCC does. A load cannot release and a store
+ * cannot acquire.
+ *
+ * @param ASTop The builtin's operation (e.g. A_ATOMICLOAD).
+ *
+ * @return int The memory order (MO_*).
+ */
+static int memoryOrderOperand(int ASTop) {
+    long order;
+
+    if (!evaluateConstantExpression(binexpr(0), &order) ||
+        order < MO_RELAXED || order > MO_SEQ_CST) {
+        logFatal("A memory order must be a constant __ATOMIC_* value");
+    }
+    if (order == MO_CONSUME) {
+        order = MO_ACQUIRE;
+    }
+    if ((ASTop == A_ATOMICLOAD &&
+         (order == MO_RELEASE || order == MO_ACQ_REL)) ||
+        (ASTop == A_ATOMICSTORE &&
+         (order == MO_ACQUIRE || order == MO_ACQ_REL))) {
+        logFatal("Invalid memory order for an atomic load or store");
+    }
+    return order;
+}
+
+/**
+ * atomicBuiltin - Parse a call of an atomic builtin, the current token
+ * being its name.
+ * e.g., __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED)
+ *
+ * NOTE:
+ * atomic_builtin := "__atomic_load_n" '(' ptr ',' order ')'
+ *      | "__atomic_store_n" '(' ptr ',' value ',' order ')'
+ *      | "__atomic_fetch_add" '(' ptr ',' value ',' order ')'
+ *      | "__atomic_exchange_n" '(' ptr ',' value ',' order ')'
+ *      | "__atomic_compare_exchange_n" '(' ptr ',' ptr ',' value ','
+ *                                          weak ',' order ',' order ')'
+ *      | "__atomic_thread_fence" '(' order ')'
+ *      ;
+ * These are GCC's builtins. fetch_add and exchange give the old value,
+ * compare_exchange gives 1 if it stored the desired value, and 0 after
+ * storing the current value into the expected one. The weak flag must be
+ * constant; the exchange never fails spuriously, which is allowed for a
+ * weak one. The failure order may not release nor be stronger than the
+ * success order, which the backends use for both outcomes.
+ *
+ * @return ASTnode* The AST node of the builtin.
+ */
+static struct ASTnode *atomicBuiltin(void) {
+    struct ASTnode *pointer = NULL;
+    struct ASTnode *expected = NULL;
+    struct ASTnode *value = NULL;
+    struct ASTnode *n;
+    int ASTop;
+    int type = P_VOID;
+    int order;
+    long failureOrder;
+    long weak;
+
+    switch (Token.token) {
+    case T_ATOMICLOAD:
+        ASTop = A_ATOMICLOAD;
+        break;
+    case T_ATOMICSTORE:
+        ASTop = A_ATOMICSTORE;
+        break;
+    case T_ATOMICFETCHADD:
+        ASTop = A_ATOMICFETCHADD;
+        break;
+    case T_ATOMICEXCHANGE:
+        ASTop = A_ATOMICEXCHANGE;
+        break;
+    case T_ATOMICCMPXCHG:
+        ASTop = A_ATOMICCMPXCHG;
+        break;
+    default:
+        ASTop = A_ATOMICFENCE;
+        break;
+    }
+    scan(&Token);
+    matchLeftParenthesisToken();
+
+    if (ASTop != A_ATOMICFENCE) {
+        pointer = atomicPointerOperand();
+        matchCommaToken();
+        type = TypeTable[pointer->primitiveType].base;
+    }
+    if (ASTop == A_ATOMICCMPXCHG) {
+        expected = binexpr(0);
+        if (expected->primitiveType != pointer->primitiveType) {
+            logFatal("The expected value of an atomic compare-exchange "
+                     "must be of the same type");
+        }
+        matchCommaToken();
+    }
+    if (ASTop != A_ATOMICLOAD && ASTop != A_ATOMICFENCE) {
+        value = coerceASTTypeForOp(binexpr(0), type, A_NOTHING);
+        if (value == NULL) {
+            logFatal("Incompatible value in atomic builtin");
+        }
+        matchCommaToken();
+
+        // The object is written to
+        checkModifiable(makeASTUnary(A_DEREFERENCE, type, pointer, 0));
+    }
+    if (ASTop == A_ATOMICCMPXCHG) {
+        if (!evaluateConstantExpression(binexpr(0), &weak)) {
+            logFatal("The weak flag of an atomic compare-exchange must be "
+                     "constant");
+        }
+        matchCommaToken();
+    }
+
+    order = memoryOrderOperand(ASTop);
+    if (ASTop == A_ATOMICCMPXCHG) {
+        matchCommaToken();
+        failureOrder = memoryOrderOperand(A_ATOMICLOAD);
+        if (failureOrder > order) {
+            logFatal("The failure memory order of an atomic compare-exchange "
+                     "cannot be stronger than the success order");
+        }
+    }
+
+    // Match the closing ')'; it also scans the following token
+    matchRightParenthesisToken();
+
+    switch (ASTop) {
+    case A_ATOMICLOAD:
+    case A_ATOMICFETCHADD:
+    case A_ATOMICEXCHANGE:
+        break;
+    case A_ATOMICCMPXCHG:
+        type = P_INT;
+        break;
+    default:
+        type = P_VOID;
+        break;
+    }
+    n = makeASTNode(ASTop, type, pointer, expected, value, order);
+    n->isRvalue = true;
+    return n;
+}
+
+/**
+ * branchHintBuiltin - Parse a call of __builtin_expect or
+ * __builtin_unreachable, the current token being its name.
+ * e.g., __builtin_expect(error != 0, 0)
+ *
+ * NOTE:
+ * hint_builtin := "__builtin_expect" '(' expression ',' constant ')'
+ *      | "__builtin_unreachable" '(' ')'
+ *      ;
+ * As with GCC, __builtin_expect gives the expression's value, and the
+ * constant is the value the expression is expected to have. Only whether
+ * that is zero matters here: an if statement with such a condition keeps
+ * the expected arm in line (see ifStatement). __builtin_unreachable marks
+ * code that never runs, and the arm holding it as unlikely.
+ *
+ * @return ASTnode* The AST node of the builtin.
+ */
+static struct ASTnode *branchHintBuiltin(void) {
+    struct ASTnode *n;
+    long expected;
+
+    if (Token.token == T_BUILTINUNREACHABLE) {
+        scan(&Token);
+        matchLeftParenthesisToken();
+        matchRightParenthesisToken();
+        return makeASTLeaf(A_UNREACHABLE, P_VOID, 0);
+    }
+
+    scan(&Token);
+    matchLeftParenthesisToken();
+    n = binexpr(0);
+    if (!isIntegerType(n->primitiveType) && !isPointerType(n->primitiveType)) {
+        logFatal("__builtin_expect needs an integer or pointer expression");
+    }
+    matchCommaToken();
+    if (!evaluateConstantExpression(binexpr(0), &expected)) {
+        logFatal("The expected value of __builtin_expect must be constant");
+    }
+    matchRightParenthesisToken();
+
+    n = makeASTUnary(A_EXPECT, n->primitiveType, n, expected != 0);
+    n->isRvalue = true;
+    return n;
+}
+
+/**
+ * prefetchBuiltin - Parse a call of __builtin_prefetch, the current token
+ * being its name.
+ * e.g., __builtin_prefetch(p + 64, 0, 3)
+ *
+ * NOTE:
+ * prefetch_builtin := "__builtin_prefetch" '(' ptr [',' rw [',' locality]]
+ *                     ')'
+ *      ;
+ * As with GCC, rw is 0 (the default) for a read and 1 for a write, and
+ * locality goes from 0 (no temporal locality) to 3 (the default: keep in
+ * every cache level). Both must be constant. The hint never faults, so
+ * any address may be given; it has no value.
+ *
+ * @return ASTnode* The AST node of the builtin.
+ */
+static struct ASTnode *prefetchBuiltin(void) {
+    struct ASTnode *address;
+    long isWrite = 0;
+    long locality = 3;
+
+    scan(&Token);
+    matchLeftParenthesisToken();
+    address = binexpr(0);
+    if (!isPointerType(address->primitiveType)) {
+        logFatal("__builtin_prefetch needs a pointer");
+    }
+    if (Token.token == T_COMMA) {
+        scan(&Token);
+        if (!evaluateConstantExpression(binexpr(0), &isWrite) ||
+            (isWrite != 0 && isWrite != 1)) {
+            logFatal("The rw argument of __builtin_prefetch must be 0 or 1");
+        }
+        if (Token.token == T_COMMA) {
+            scan(&Token);
+            if (!evaluateConstantExpression(binexpr(0), &locality) ||
+                locality < 0 || locality > 3) {
+                logFatal("The locality argument of __builtin_prefetch "
+                         "must be a constant from 0 to 3");
+            }
+        }
+    }
+    matchRightParenthesisToken();
+
+    return makeASTUnary(A_PREFETCH, P_VOID, address,
+                        locality + (isWrite ? PREFETCH_WRITE : 0));
+}
+
 /**
  * primary - Parse a primary expression.
  * e.g., integer literals.
@@ -156,24 +990,43 @@ static struct ASTnode *primary(void) {
     case T_INTEGERLITERAL:
         // If it's an integer literal, create a leaf node.
         // Then scan the next token. It will be used by the caller.
+        n = makeIntegerLiteral(Token.intvalue);
+        break;
 
-        // NOTE:
-        // Make the primitive integer leaf node as P_CHAR if
-        // the value is within char range. because we can optimize
-        // memory usage later.
-        if (Token.intvalue >= 0 && Token.intvalue <= 255) {
-            n = makeASTLeaf(A_INTEGERLITERAL, P_CHAR, Token.intvalue);
-        } else {
-            n = makeASTLeaf(A_INTEGERLITERAL, P_INT, Token.intvalue);
-        }
-
+    case T_FLOATLITERAL:
+        // The scanner gives the literal's type (float or double)
+        n = makeASTLeaf(A_FLOATLITERAL, Token.intvalue, 0);
+        n->v.floatvalue = Token.floatvalue;
         break;
 
+    case T_SIZEOF:
+        // Already folded to a literal; the token after ')' is scanned
+        return sizeofExpression();
+
+    case T_ATOMICLOAD:
+    case T_ATOMICSTORE:
+    case T_ATOMICFETCHADD:
+    case T_ATOMICEXCHANGE:
+    case T_ATOMICCMPXCHG:
+    case T_ATOMICFENCE:
+        // The token after ')' is scanned already
+        return atomicBuiltin();
+
+    case T_BUILTINEXPECT:
+    case T_BUILTINUNREACHABLE:
+        // The token after ')' is scanned already
+        return branchHintBuiltin();
+
+    case T_BUILTINPREFETCH:
+        // The token after ')' is scanned already
+        return prefetchBuiltin();
+
     case T_STRINGLITERAL:
         // For a string literal token, generate the assembly for this,
         // and then make a leaf AST node for it. "id" is the string's label
         id = codegenDeclareGlobalString(Text);
-        n = makeASTLeaf(A_STRINGLITERAL, P_CHARPTR, id);
+        n = makeASTLeaf(A_STRINGLITERAL, primitiveTypeToPointerType(P_CHAR),
+                        id);
         break;
 
     case T_IDENTIFIER:
@@ -212,42 +1065,60 @@ static struct ASTnode *primary(void) {
  */
 int tokenToASTOperator(int token) {
     switch (token) {
-    case T_ASSIGN:           // =
-        return A_ASSIGN;     //
-    case T_LOGICALOR:        // ||
-        return A_LOGICALOR;  //
-    case T_LOGICALAND:       // &&
-        return A_LOGICALAND; //
-    case T_BITWISEOR:        // |
-        return A_BITWISEOR;  //
-    case T_BITWISEXOR:       // ^
-        return A_BITWISEXOR; //
-    case T_AMPERSAND:        // & (bitwise AND, address-of operator)
-        return A_BITWISEAND; //
-    case T_EQ:               // ==
-        return A_EQ;         //
-    case T_NE:               // !=
-        return A_NE;         //
-    case T_LT:               // <
-        return A_LT;         //
-    case T_GT:               // >
-        return A_GT;         //
-    case T_LE:               // <=
-        return A_LE;         //
-    case T_GE:               // >=
-        return A_GE;         //
-    case T_LSHIFT:           // <<
-        return A_LSHIFT;     //
-    case T_RSHIFT:           // >>
-        return A_RSHIFT;     //
-    case T_PLUS:             // +
-        return A_ADD;        //
-    case T_MINUS:            // - (subtraction or (unary) negation)
-        return A_SUBTRACT;   //
-    case T_STAR:             // *
-        return A_MULTIPLY;   //
-    case T_SLASH:            // /
-        return A_DIVIDE;     //
+    case T_ASSIGN:                 // =
+        return A_ASSIGN;           //
+    case T_ASSIGNPLUS:             // +=
+        return A_ASSIGNADD;        //
+    case T_ASSIGNMINUS:            // -=
+        return A_ASSIGNSUBTRACT;   //
+    case T_ASSIGNSTAR:             // *=
+        return A_ASSIGNMULTIPLY;   //
+    case T_ASSIGNSLASH:            // /=
+        return A_ASSIGNDIVIDE;     //
+    case T_ASSIGNOR:               // |=
+        return A_ASSIGNBITWISEOR;  //
+    case T_ASSIGNAND:              // &=
+        return A_ASSIGNBITWISEAND; //
+    case T_ASSIGNXOR:              // ^=
+        return A_ASSIGNBITWISEXOR; //
+    case T_ASSIGNLSHIFT:           // <<=
+        return A_ASSIGNLSHIFT;     //
+    case T_ASSIGNRSHIFT:           // >>=
+        return A_ASSIGNRSHIFT;     //
+    case T_LOGICALOR:              // ||
+        return A_LOGICALOR;        //
+    case T_LOGICALAND:             // &&
+        return A_LOGICALAND;       //
+    case T_BITWISEOR:              // |
+        return A_BITWISEOR;        //
+    case T_BITWISEXOR:             // ^
+        return A_BITWISEXOR;       //
+    case T_AMPERSAND:              // & (bitwise AND, address-of operator)
+        return A_BITWISEAND;       //
+    case T_EQ:                     // ==
+        return A_EQ;               //
+    case T_NE:                     // !=
+        return A_NE;               //
+    case T_LT:                     // <
+        return A_LT;               //
+    case T_GT:                     // >
+        return A_GT;               //
+    case T_LE:                     // <=
+        return A_LE;               //
+    case T_GE:                     // >=
+        return A_GE;               //
+    case T_LSHIFT:                 // <<
+        return A_LSHIFT;           //
+    case T_RSHIFT:                 // >>
+        return A_RSHIFT;           //
+    case T_PLUS:                   // +
+        return A_ADD;              //
+    case T_MINUS:                  // - (subtraction or (unary) negation)
+        return A_SUBTRACT;         //
+    case T_STAR:                   // *
+        return A_MULTIPLY;         //
+    case T_SLASH:                  // /
+        return A_DIVIDE;           //
 
     default:
         fprintf(stderr, "Unknown arithmetic operator: %d, line: %d\n", token,
@@ -256,6 +1127,64 @@ int tokenToASTOperator(int token) {
     }
 }
 
+/**
+ * isAssignmentASTop - Check if an AST operation is an assignment, either
+ * plain ("=") or compound ("+=", "<<=", ...).
+ *
+ * @param ASTop The AST operation to check.
+ *
+ * @return bool True if the operation is an assignment, false otherwise.
+ */
+bool isAssignmentASTop(int ASTop) {
+    return ASTop == A_ASSIGN || compoundAssignToBinaryASTop(ASTop) != A_NOTHING;
+}
+
+/**
+ * isAtomicASTop - Check if an AST operation is an atomic builtin.
+ *
+ * @param ASTop The AST operation to check.
+ *
+ * @return bool True if the operation is an atomic builtin, false otherwise.
+ */
+bool isAtomicASTop(int ASTop) {
+    return ASTop >= A_ATOMICLOAD && ASTop <= A_ATOMICFENCE;
+}
+
+/**
+ * compoundAssignToBinaryASTop - Get the binary operation a compound
+ * assignment applies.
+ * e.g. A_ASSIGNADD ("+=") applies A_ADD
+ *
+ * @param ASTop The AST operation to map.
+ *
+ * @return int The binary AST operation, or A_NOTHING if ASTop is not a
+ * compound assignment.
+ */
+int compoundAssignToBinaryASTop(int ASTop) {
+    switch (ASTop) {
+    case A_ASSIGNADD:
+        return A_ADD;
+    case A_ASSIGNSUBTRACT:
+        return A_SUBTRACT;
+    case A_ASSIGNMULTIPLY:
+        return A_MULTIPLY;
+    case A_ASSIGNDIVIDE:
+        return A_DIVIDE;
+    case A_ASSIGNBITWISEOR:
+        return A_BITWISEOR;
+    case A_ASSIGNBITWISEAND:
+        return A_BITWISEAND;
+    case A_ASSIGNBITWISEXOR:
+        return A_BITWISEXOR;
+    case A_ASSIGNLSHIFT:
+        return A_LSHIFT;
+    case A_ASSIGNRSHIFT:
+        return A_RSHIFT;
+    default:
+        return A_NOTHING;
+    }
+}
+
 /**
  * isTokenRightAssociative - Check if a token is right associative.
  *
@@ -266,6 +1195,15 @@ int tokenToASTOperator(int token) {
 static bool isTokenRightAssociative(int tokentype) {
     switch (tokentype) {
     case T_ASSIGN:
+    case T_ASSIGNPLUS:
+    case T_ASSIGNMINUS:
+    case T_ASSIGNSTAR:
+    case T_ASSIGNSLASH:
+    case T_ASSIGNOR:
+    case T_ASSIGNAND:
+    case T_ASSIGNXOR:
+    case T_ASSIGNLSHIFT:
+    case T_ASSIGNRSHIFT:
         return true;
     default:
         return false;
@@ -276,7 +1214,9 @@ static bool isTokenRightAssociative(int tokentype) {
  * operatorPrecedence - Get the precedence of a given operator token.
  *
  * WARNING:
- * Doesn't accept unexpected token types: T_VOID, T_CHAR, T_INT, T_LONG.
+ * Doesn't accept unexpected token types: T_VOID, T_CHAR, T_SHORT, T_INT,
+ * T_LONG, T_FLOAT, T_DOUBLE, T_STRUCT, T_UNSIGNED, T_CONST, T_VOLATILE,
+ * T_RESTRICT, T_TYPENAME.
  *
  *  NOTE:
  *  Based on the C language operator precedence:
@@ -291,6 +1231,15 @@ static int operatorPrecedence(int tokentype) {
     case T_EOF:
         return 0;
     case T_ASSIGN:
+    case T_ASSIGNPLUS:
+    case T_ASSIGNMINUS:
+    case T_ASSIGNSTAR:
+    case T_ASSIGNSLASH:
+    case T_ASSIGNOR:
+    case T_ASSIGNAND:
+    case T_ASSIGNXOR:
+    case T_ASSIGNLSHIFT:
+    case T_ASSIGNRSHIFT:
         return 10;
     case T_LOGICALOR:
         return 20;
@@ -321,7 +1270,12 @@ static int operatorPrecedence(int tokentype) {
         return 110;
     default: //
         if ((tokentype == T_VOID) || (tokentype == T_CHAR) ||
-            (tokentype == T_INT) || (tokentype == T_LONG)) {
+            (tokentype == T_SHORT) || (tokentype == T_INT) ||
+            (tokentype == T_LONG) || (tokentype == T_FLOAT) ||
+            (tokentype == T_DOUBLE) || (tokentype == T_STRUCT) ||
+            (tokentype == T_UNSIGNED) || (tokentype == T_CONST) ||
+            (tokentype == T_VOLATILE) || (tokentype == T_RESTRICT) ||
+            (tokentype == T_TYPENAME)) {
             // Unexpected token types
             logFatald("Unexpected token in expression: ", tokentype);
             logFatal("operatorPrecedence doesn't handle this token");
@@ -330,6 +1284,51 @@ static int operatorPrecedence(int tokentype) {
     }
 }
 
+/**
+ * markAddressesTaken - Record that pointers may reach every variable whose
+ * address a tree computes. (helper function)
+ *
+ * @param n The AST tree.
+ */
+static void markAddressesTaken(struct ASTnode *n) {
+    if (n == NULL) {
+        return;
+    }
+    if (n->op == A_ADDRESSOF) {
+        SymbolTable[n->v.identifierIndex].isAddressTaken = true;
+    }
+    markAddressesTaken(n->left);
+    markAddressesTaken(n->middle);
+    markAddressesTaken(n->right);
+}
+
+/**
+ * addressOfElement - Turn an array element or struct member access into
+ * its address, e.g. "&a[i]" or "&s.x". (helper function)
+ *
+ * NOTE:
+ * The access already computes the address, plus the constant member
+ * offset the load or store would add.
+ *
+ * @param n The A_DEREFERENCE node of the access.
+ *
+ * @return ASTnode* The address.
+ */
+static struct ASTnode *addressOfElement(struct ASTnode *n) {
+    int type = primitiveTypeToPointerType(n->primitiveType);
+    struct ASTnode *address = n->left;
+
+    markAddressesTaken(address);
+    if (n->v.offset != 0) {
+        address = makeASTNode(A_ADD, type, address, NULL,
+                              makeASTLeaf(A_INTEGERLITERAL, P_INT,
+                                          n->v.offset),
+                              0);
+    }
+    address->primitiveType = type;
+    return address;
+}
+
 /**
  * prefix - Parse a prefix expression and return a sub-tree representing it
  *
@@ -350,8 +1349,9 @@ struct ASTnode *prefix(void) {
     case T_AMPERSAND:
         /**
          * NOTE: & operator (address-of)
-         * It must be applied to an identifier only.
-         * This operator returns the address of the variable.
+         * It must be applied to an identifier, an array element or a
+         * struct member only.
+         * This operator returns the address of the object.
          */
 
         // Get the next token and parse it,
@@ -359,13 +1359,25 @@ struct ASTnode *prefix(void) {
         scan(&Token);
         tree = prefix();
 
+        // "&function" is the same address as "function"
+        if (tree->op == A_ADDRESSOF &&
+            SymbolTable[tree->v.identifierIndex].structuralType ==
+                S_FUNCTION) {
+            break;
+        }
+        if (tree->op == A_DEREFERENCE) {
+            tree = addressOfElement(tree);
+            break;
+        }
         if (tree->op != A_IDENTIFIER) {
-            logFatal(
-                "Address-of operator '&' must be applied to an identifier");
+            logFatal("Address-of operator '&' must be applied to an "
+                     "identifier, an array element or a struct member");
         }
 
         // Change the operator to A_ADDRESSOF and the type to
-        // a pointer to the original type
+        // a pointer to the original type. Pointers may now reach the
+        // variable, which the alias analysis has to know.
+        SymbolTable[tree->v.identifierIndex].isAddressTaken = true;
         tree->op = A_ADDRESSOF;
         tree->primitiveType = primitiveTypeToPointerType(tree->primitiveType);
         break;
@@ -387,6 +1399,10 @@ struct ASTnode *prefix(void) {
                      "pointer (*)");
         }
 
+        // The operand's value is the address, so a nested dereference
+        // ("**pp") must load the intermediate pointer
+        tree->isRvalue = true;
+
         // Prepend an A_DEREF operation to the tree
         tree =
             makeASTUnary(A_DEREFERENCE,
@@ -399,11 +1415,19 @@ struct ASTnode *prefix(void) {
         tree = prefix();
 
         // Prepend an A_ARITHMETICNEGATE operation to the tree and make the
-        // child an rvalue. Because character type (T_CHAR) is unsigned, also
-        // widen this to int so that it's signed
+        // child an rvalue. A floating-point value keeps its type
         tree->isRvalue = true;
-        tree = coerceASTTypeForOp(tree, P_INT, 0);
-        tree = makeASTUnary(A_ARITHMETICNEGATE, P_INT, tree, 0);
+        checkScalarOperand(tree, "-");
+        if (isFloatType(tree->primitiveType)) {
+            tree = makeASTUnary(A_ARITHMETICNEGATE, tree->primitiveType, tree,
+                                0);
+            break;
+        }
+
+        // Because character type (T_CHAR) is unsigned, also widen this to
+        // int so that it's signed
+        tree = promoteInteger(tree);
+        tree = makeASTUnary(A_ARITHMETICNEGATE, tree->primitiveType, tree, 0);
         break;
 
     case T_LOGICALINVERT:
@@ -414,6 +1438,11 @@ struct ASTnode *prefix(void) {
         // Prepend an A_INVERT operation to the tree and make the child an
         // rvalue.
         tree->isRvalue = true;
+        if (isFloatType(tree->primitiveType)) {
+            logFatal("'~' cannot be applied to a floating-point value");
+        }
+        checkScalarOperand(tree, "~");
+        tree = promoteInteger(tree);
         tree = makeASTUnary(A_LOGICALINVERT, tree->primitiveType, tree, 0);
         break;
 
@@ -423,9 +1452,14 @@ struct ASTnode *prefix(void) {
         tree = prefix();
 
         // Prepend an A_LOGNOT operation to the tree and make the child an
-        // rvalue
+        // rvalue. "!x" of a floating-point x is an int
         tree->isRvalue = 1;
-        tree = makeASTUnary(A_LOGICALNOT, tree->primitiveType, tree, 0);
+        checkScalarOperand(tree, "!");
+        tree = makeASTUnary(A_LOGICALNOT,
+                            isFloatType(tree->primitiveType)
+                                ? P_INT
+                                : tree->primitiveType,
+                            tree, 0);
         break;
 
     case T_INCREMENT:
@@ -438,6 +1472,9 @@ struct ASTnode *prefix(void) {
             logFatal(
                 "Pre-increment operator '++' must be applied to an identifier");
         }
+        checkModifiable(tree);
+        recordStore(tree, NULL);
+        checkIncrementable(tree);
 
         // Prepend an A_PREINCREMENT operation to the tree
         tree = makeASTUnary(A_PREINCREMENT, tree->primitiveType, tree, 0);
@@ -453,6 +1490,9 @@ struct ASTnode *prefix(void) {
             logFatal(
                 "Pre-decrement operator '--' must be applied to an identifier");
         }
+        checkModifiable(tree);
+        recordStore(tree, NULL);
+        checkIncrementable(tree);
 
         // Prepend an A_PREDECREMENT operation to the tree
         tree = makeASTUnary(A_PREDECREMENT, tree->primitiveType, tree, 0);
@@ -466,6 +1506,69 @@ struct ASTnode *prefix(void) {
     return tree;
 }
 
+/**
+ * coerceCompoundAssignment - Coerce the right-hand side of a compound
+ * assignment ("a op= b") to the type of its left-hand side.
+ *
+ * NOTE:
+ * The left-hand side is read and written in place, so its address is
+ * evaluated only once, and the operation is done in the left-hand side's
+ * type. A wider integer right-hand side is accepted as is: the result is
+ * truncated to the left-hand side's type by the store anyway. On a pointer
+ * only "+=" and "-=" are allowed, with the integer scaled by the pointee
+ * size like "p + n". A floating-point left-hand side takes "+=", "-=",
+ * "*=" and "/=", with the right-hand side converted to its type. A vector
+ * takes the operators of isVectorOperationSupported() with a vector or a
+ * splatted scalar, or with a scalar integer count for "<<=" and ">>=".
+ *
+ * @param right The right-hand side expression (an rvalue).
+ * @param left The left-hand side expression (an lvalue).
+ * @param ASTop The compound assignment operation (e.g. A_ASSIGNADD).
+ *
+ * @return ASTnode* The coerced right-hand side, or NULL if the types are
+ * incompatible.
+ */
+static struct ASTnode *coerceCompoundAssignment(struct ASTnode *right,
+                                                struct ASTnode *left,
+                                                int ASTop) {
+    int binaryOp = compoundAssignToBinaryASTop(ASTop);
+    struct ASTnode *coerced;
+
+    if (left->op != A_IDENTIFIER && left->op != A_DEREFERENCE) {
+        logFatal("Compound assignment to something that is not an lvalue");
+    }
+    if (isFloatType(left->primitiveType)) {
+        if (binaryOp != A_ADD && binaryOp != A_SUBTRACT &&
+            binaryOp != A_MULTIPLY && binaryOp != A_DIVIDE) {
+            return NULL;
+        }
+        return coerceASTTypeForOp(right, left->primitiveType, A_NOTHING);
+    }
+    if (isVectorType(left->primitiveType)) {
+        checkVectorOperator(left, right, binaryOp);
+        if (binaryOp == A_LSHIFT || binaryOp == A_RSHIFT) {
+            return isIntegerType(right->primitiveType) ? right : NULL;
+        }
+        return coerceASTTypeForOp(right, left->primitiveType, binaryOp);
+    }
+    if (!isIntegerType(right->primitiveType)) {
+        return NULL;
+    }
+
+    if (isPointerType(left->primitiveType)) {
+        if (binaryOp != A_ADD && binaryOp != A_SUBTRACT) {
+            return NULL;
+        }
+        return coerceASTTypeForOp(right, left->primitiveType, binaryOp);
+    }
+
+    if (!isIntegerType(left->primitiveType)) {
+        return NULL;
+    }
+    coerced = coerceASTTypeForOp(right, left->primitiveType, binaryOp);
+    return (coerced != NULL) ? coerced : right;
+}
+
 /**
  * binexpr - Parse a binary expression based on operator precedence.
  *
@@ -480,6 +1583,7 @@ struct ASTnode *binexpr(int ptp) {
     struct ASTnode *rightTemp;
     int tokentype;
     int ASToperation;
+    int resultType;
 
     // Parse the left-hand side expression
     // And, fetch the next token at the same time
@@ -512,18 +1616,27 @@ struct ASTnode *binexpr(int ptp) {
 
         // Determine the operation to be performed on the sub-trees
         ASToperation = tokenToASTOperator(tokentype);
-        if (ASToperation == A_ASSIGN) {
+        if (isAssignmentASTop(ASToperation)) {
             // assignment, the current node is a r-value
             // because "b = (something)" needs the value of "something"
             right->isRvalue = true;
 
             // Ensure the right's type matches the left.
-            right = coerceASTTypeForOp(right, left->primitiveType, A_NOTHING);
+            if (ASToperation == A_ASSIGN) {
+                right =
+                    coerceASTTypeForOp(right, left->primitiveType, A_NOTHING);
+            } else {
+                right = coerceCompoundAssignment(right, left, ASToperation);
+            }
 
-            // NOTE: Sure about this?
-            if (left == NULL) {
+            if (right == NULL) {
                 logFatal("Incompatible expression in assignment");
             }
+            checkModifiable(left);
+            recordStore(left, (ASToperation == A_ASSIGN) ? right : NULL);
+
+            // The assignment's value has the type of its left-hand side
+            resultType = left->primitiveType;
 
             // Make an assignment AST tree.
             // However, switch left and right around,
@@ -545,6 +1658,16 @@ struct ASTnode *binexpr(int ptp) {
             // trees
             left->isRvalue = true;
             right->isRvalue = true;
+            checkVectorOperator(left, right, ASToperation);
+
+            // Two operands narrower than int are both computed as int. One
+            // narrow operand is widened straight to the other's type below,
+            // which gives the same value
+            if (isNarrowIntegerType(left->primitiveType) &&
+                isNarrowIntegerType(right->primitiveType)) {
+                left = promoteInteger(left);
+                right = promoteInteger(right);
+            }
 
             // Ensure the two types are compatible by trying to modify each
             // tree to match the other's type
@@ -565,12 +1688,24 @@ struct ASTnode *binexpr(int ptp) {
             if (rightTemp != NULL) {
                 right = rightTemp;
             }
+
+            // Only a vector is shifted by a scalar count, e.g. "v << 2",
+            // while "2 << v" is not a vector operation
+            if (isVectorType(right->primitiveType) &&
+                !isVectorType(left->primitiveType)) {
+                logFatal("Incompatible types in binary expression");
+            }
+
+            // Result type is the widened type, but comparing floating-point
+            // values gives an int
+            resultType = left->primitiveType;
+            if (isFloatType(resultType) && ASToperation >= A_EQ &&
+                ASToperation <= A_GE) {
+                resultType = P_INT;
+            }
         }
 
-        left =
-            makeASTNode(tokenToASTOperator(tokentype),
-                        left->primitiveType, // Result type is the widened type
-                        left, NULL, right, 0);
+        left = makeASTNode(ASToperation, resultType, left, NULL, right, 0);
 
         // Update the details of the current token.
         // If we hit a semicolon(";"), right parenthesis(")"), or right
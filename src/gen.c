@@ -21,6 +21,47 @@ int codegenGetLabelNumber(void) {
     return (id++);
 }
 
+// Jump targets of the enclosing loops, innermost last
+static int BreakLabels[NLOOPS];
+static int ContinueLabels[NLOOPS];
+static int LoopDepth = 0;
+
+/**
+ * codegenPushLoop - Records the jump targets of a loop whose body is about
+ * to be generated, for the break and continue statements inside it.
+ *
+ * @param labelBreak    Label that 'break' jumps to (after the loop).
+ * @param labelContinue Label that 'continue' jumps to (the next iteration).
+ */
+static void codegenPushLoop(int labelBreak, int labelContinue) {
+    if (LoopDepth == NLOOPS) {
+        logFatal("Loops nested too deeply");
+    }
+    BreakLabels[LoopDepth] = labelBreak;
+    ContinueLabels[LoopDepth] = labelContinue;
+    LoopDepth++;
+}
+
+/**
+ * codegenPopLoop - Forgets the jump targets of the innermost loop.
+ */
+static void codegenPopLoop(void) { LoopDepth--; }
+
+// Text section (TS_*) the code being generated goes to
+static int CurrentTextSection;
+
+/**
+ * codegenTextSection - Places the code that follows in a text section.
+ *
+ * @param section The text section (TS_*).
+ */
+static void codegenTextSection(int section) {
+    if (section != CurrentTextSection) {
+        CG->textSection(section);
+        CurrentTextSection = section;
+    }
+}
+
 /**
  * codegenLabel - Outputs a label in the assembly code
  * for the current target backend.
@@ -46,11 +87,127 @@ static void codegenJump(int label) { CG->jump(label); }
  * @param r1 Index of the first register.
  * @param r2 Index of the second register.
  * @param label The label number to jump to if the comparison is true.
+ * @param primitiveType The type of the compared values (selects a signed or
+ *                      unsigned comparison).
  *
  * @return The register index where the result is stored (NOREG).
  */
-static int codegenCompareAndJump(int ASTop, int r1, int r2, int label) {
-    return CG->compareAndJump(ASTop, r1, r2, label);
+static int codegenCompareAndJump(int ASTop, int r1, int r2, int label,
+                                 int primitiveType) {
+    return CG->compareAndJump(ASTop, r1, r2, label, primitiveType);
+}
+
+/**
+ * codegenZeroExtendUnsignedInt - Clears bits 32-63 of an unsigned int value
+ * before an operation that observes them (division, right shift,
+ * comparisons, call arguments and array indices).
+ *
+ * NOTE:
+ * Registers are 64 bits wide, so an unsigned int computed by add, subtract,
+ * multiply, left shift, negate or invert may carry bits above bit 31 (e.g.
+ * 0u - 1 leaves all 64 bits set). Loads, literals and the other operators
+ * already leave those bits clear, so they are left alone.
+ *
+ * @param n The AST node that produced the value.
+ * @param reg The register holding the value.
+ *
+ * @return The register holding the zero-extended value.
+ */
+static int codegenZeroExtendUnsignedInt(struct ASTnode *n, int reg) {
+    if (n->primitiveType != P_UINT) {
+        return reg;
+    }
+
+    switch (n->op) {
+    case A_ADD:
+    case A_SUBTRACT:
+    case A_MULTIPLY:
+    case A_LSHIFT:
+    case A_ARITHMETICNEGATE:
+    case A_LOGICALINVERT:
+        return CG->widenPrimitiveType(reg, P_UINT, P_ULONG);
+    default:
+        return reg;
+    }
+}
+
+/**
+ * isTruncatedByParent - Check whether an A_WIDENTYPE node narrows an
+ * integer that its parent truncates anyway: a statement storing it, or a
+ * return (which converts to the return type). (helper function)
+ *
+ * NOTE:
+ * The parser only wraps an A_ASSIGN in these statement nodes when its
+ * value is not used; a condition is a comparison or an A_TOBOOLEAN.
+ *
+ * @param n            The child AST node.
+ * @param parentASTop  The operator of n's parent.
+ * @param grandparentASTop The operator of the parent's parent.
+ *
+ * @return bool True if the conversion can be left out.
+ */
+static bool isTruncatedByParent(struct ASTnode *n, int parentASTop,
+                                int grandparentASTop) {
+    if (n->op != A_WIDENTYPE || !isIntegerType(n->primitiveType) ||
+        !isIntegerType(n->left->primitiveType) ||
+        getTypeSize(n->primitiveType) >= getTypeSize(n->left->primitiveType)) {
+        return false;
+    }
+    if (parentASTop == A_RETURN) {
+        return true;
+    }
+    return parentASTop == A_ASSIGN &&
+           (grandparentASTop == A_GLUE || grandparentASTop == A_FUNCTION ||
+            grandparentASTop == A_IF || grandparentASTop == A_WHILE ||
+            grandparentASTop == A_DOWHILE);
+}
+
+/**
+ * codegenUnlikelyArmAST - Generates code for an IF statement AST node one
+ * arm of which is unlikely to run. (helper function)
+ *
+ * NOTE:
+ * The likely arm falls through from the condition, and the unlikely one is
+ * moved to the .text.unlikely section, out of the hot path's way:
+ * ----------------------------------------
+ *        perform the comparison
+ *        jump to L1 if the unlikely arm runs
+ *        perform the likely arm (if any)
+ * L2:
+ *        ...
+ *        section .text.unlikely
+ * L1:    perform the unlikely arm
+ *        jump to L2
+ * ----------------------------------------
+ * For an unlikely then arm, the jump is taken when the condition holds,
+ * as at the bottom of a do-while loop.
+ *
+ * @param n The AST node representing the IF statement (BRANCH_UNLIKELY, or
+ *          BRANCH_LIKELY with an else arm).
+ *
+ * @return The register index where the result is stored (NOREG).
+ */
+static int codegenUnlikelyArmAST(struct ASTnode *n) {
+    bool isThenUnlikely = (n->v.intvalue == BRANCH_UNLIKELY);
+    int labelUnlikely = codegenGetLabelNumber();
+    int labelEndStatement = codegenGetLabelNumber();
+    int section = CurrentTextSection;
+
+    codegenAST(n->left, labelUnlikely, isThenUnlikely ? A_DOWHILE : A_IF);
+    codegenResetRegisters();
+
+    codegenAST(isThenUnlikely ? n->right : n->middle, NOLABEL, n->op);
+    codegenResetRegisters();
+    codegenLabel(labelEndStatement);
+
+    codegenTextSection(TS_UNLIKELY);
+    codegenLabel(labelUnlikely);
+    codegenAST(isThenUnlikely ? n->middle : n->right, NOLABEL, n->op);
+    codegenResetRegisters();
+    codegenJump(labelEndStatement);
+    codegenTextSection(section);
+
+    return NOREG;
 }
 
 /**
@@ -84,6 +241,11 @@ static int codegenIfStatementAST(struct ASTnode *n) {
     int labelFalseStatement;
     int labelEndStatement;
 
+    if (n->v.intvalue == BRANCH_UNLIKELY ||
+        (n->v.intvalue == BRANCH_LIKELY && n->right != NULL)) {
+        return codegenUnlikelyArmAST(n);
+    }
+
     // Generate two labels:
     // - one for the false branch
     // - one for the end of the if statement
@@ -126,10 +288,11 @@ static int codegenIfStatementAST(struct ASTnode *n) {
  * The While statement is represented in the AST as follows:
  * ----------------------------------------
  *       [  A_WHILE  ]
- *          /      \
- *        cond     body
- *       (left)  (middle)
+ *       /     |     \
+ *     cond   post    body
+ *    (left) (middle) (right)
  * ----------------------------------------
+ * The middle child is the post-operation of a for loop (NULL for while).
  * Conventional while statement will be
  * converted into the following assembly
  * structure
@@ -137,9 +300,12 @@ static int codegenIfStatementAST(struct ASTnode *n) {
  * L1:    perform the comparison
  *        jump to L2 if false
  *        perform the loop body
+ * L3:    perform the post-operation
  *        jump to L1
  * L2:
  * ----------------------------------------
+ * 'break' jumps to L2 and 'continue' to L3 (L1 when there is no
+ * post-operation).
  *
  * @param n The AST node representing the WHILE statement.
  *
@@ -148,12 +314,17 @@ static int codegenIfStatementAST(struct ASTnode *n) {
 static int codegenWhileStatementAST(struct ASTnode *n) {
     int labelStartLoop;
     int labelEndLoop;
+    int labelContinue;
 
     // Generate two labels:
     // - one for the start of the loop
     // - one for the end of the loop
     labelStartLoop = codegenGetLabelNumber();
     labelEndLoop = codegenGetLabelNumber();
+    labelContinue = labelStartLoop;
+    if (n->middle != NULL) {
+        labelContinue = codegenGetLabelNumber();
+    }
     codegenLabel(labelStartLoop);
 
     // Generate the loop condition
@@ -161,9 +332,18 @@ static int codegenWhileStatementAST(struct ASTnode *n) {
     codegenResetRegisters();
 
     // Generate the loop body (stored in right child for WHILE)
+    codegenPushLoop(labelEndLoop, labelContinue);
     codegenAST(n->right, NOLABEL, n->op);
+    codegenPopLoop();
     codegenResetRegisters();
 
+    // Generate the post-operation of a for loop
+    if (n->middle != NULL) {
+        codegenLabel(labelContinue);
+        codegenAST(n->middle, NOLABEL, n->op);
+        codegenResetRegisters();
+    }
+
     // Jump back to the start of the loop
     codegenJump(labelStartLoop);
     codegenLabel(labelEndLoop);
@@ -171,6 +351,396 @@ static int codegenWhileStatementAST(struct ASTnode *n) {
     return NOREG;
 }
 
+/**
+ * codegenDoWhileStatementAST - Generates code for a DO-WHILE statement AST
+ * node.
+ *
+ * NOTE:
+ * A_DOWHILE has the condition in the left child and the body in the right.
+ * The loop is only tested at the bottom, with a branch that is taken
+ * while the condition holds, so each iteration executes a single branch:
+ * ----------------------------------------
+ * L1:    perform the loop body
+ * L2:    perform the comparison
+ *        jump to L1 if true
+ * L3:
+ * ----------------------------------------
+ * 'break' jumps to L3 and 'continue' to L2.
+ *
+ * @param n The AST node representing the DO-WHILE statement.
+ *
+ * @return The register index where the result is stored (NOREG).
+ */
+static int codegenDoWhileStatementAST(struct ASTnode *n) {
+    int labelStartLoop = codegenGetLabelNumber();
+    int labelContinue = codegenGetLabelNumber();
+    int labelEndLoop = codegenGetLabelNumber();
+
+    codegenLabel(labelStartLoop);
+
+    // Generate the loop body
+    codegenPushLoop(labelEndLoop, labelContinue);
+    codegenAST(n->right, NOLABEL, n->op);
+    codegenPopLoop();
+    codegenResetRegisters();
+
+    // Generate the loop condition, jumping back to the start when true
+    codegenLabel(labelContinue);
+    codegenAST(n->left, labelStartLoop, n->op);
+    codegenResetRegisters();
+    codegenLabel(labelEndLoop);
+
+    return NOREG;
+}
+
+/**
+ * invertComparisonASTop - Returns the comparison that is true exactly when
+ * the given one is false (e.g. A_LT -> A_GE).
+ *
+ * @param ASTop A comparison operator (A_EQ .. A_GE).
+ *
+ * @return The inverted comparison operator.
+ */
+static int invertComparisonASTop(int ASTop) {
+    switch (ASTop) {
+    case A_EQ:
+        return A_NE;
+    case A_NE:
+        return A_EQ;
+    case A_LT:
+        return A_GE;
+    case A_GE:
+        return A_LT;
+    case A_GT:
+        return A_LE;
+    default: // A_LE
+        return A_GT;
+    }
+}
+
+/**
+ * codegenVectorAST - Generates code for an AST node of a vector type, once
+ * its subtrees have been generated.
+ *
+ * NOTE:
+ * Vectors live in the floating-point registers. A vector variable is
+ * loaded and stored through its address, with the aligned vector loads
+ * and stores of the backend; A_DEREFERENCE (e.g. "vs[i]" in an array of
+ * vectors) does the same through the computed address. The binary
+ * operators work lane by lane, and A_SPLAT copies a scalar into every
+ * lane.
+ *
+ * @param n             The AST node.
+ * @param leftRegister  The register of the left subtree, if any.
+ * @param rightRegister The register of the right subtree, if any.
+ *
+ * @return The register holding the vector, or the address of an lvalue.
+ */
+static int codegenVectorAST(struct ASTnode *n, int leftRegister,
+                            int rightRegister) {
+    struct ASTnode *lhs;
+
+    switch (n->op) {
+    case A_IDENTIFIER:
+        if (!n->isRvalue) {
+            return NOREG; // Lvalue: the store takes the address
+        }
+        return CG->vectorLoad(CG->addressOfSymbol(n->v.identifierIndex), 0,
+                              n->primitiveType);
+    case A_DEREFERENCE:
+        if (!n->isRvalue) {
+            return leftRegister; // Lvalue: the store applies v.offset
+        }
+        return CG->vectorLoad(leftRegister, n->v.offset, n->primitiveType);
+    case A_ASSIGN:
+        lhs = n->right;
+        if (lhs->op == A_IDENTIFIER) {
+            rightRegister = CG->addressOfSymbol(lhs->v.identifierIndex);
+        }
+        return CG->vectorStore(leftRegister, rightRegister,
+                               (lhs->op == A_IDENTIFIER) ? 0 : lhs->v.offset,
+                               n->primitiveType);
+    case A_SPLAT:
+        return CG->vectorSplat(leftRegister, n->primitiveType);
+    case A_ADD:
+    case A_SUBTRACT:
+    case A_MULTIPLY:
+    case A_DIVIDE:
+    case A_BITWISEAND:
+    case A_BITWISEOR:
+    case A_BITWISEXOR:
+    case A_LSHIFT:
+    case A_RSHIFT:
+        return CG->vectorBinary(n->op, leftRegister, rightRegister,
+                                n->primitiveType);
+    default:
+        logFatald("Unsupported AST operator on a vector: ", n->op);
+    }
+    return NOREG; // Unreachable
+}
+
+/**
+ * codegenCompoundAssignAST - Generates code for a compound assignment
+ * ("a op= b") AST node.
+ *
+ * NOTE:
+ * Like A_ASSIGN, n->left is the RHS expression and n->right the LHS lvalue.
+ * The LHS address is evaluated once and the backend updates the memory in
+ * place (e.g. "add DWORD [rbp-8], r8" on x86-64). An integer literal RHS
+ * is passed as an immediate instead of being loaded into a register, unless
+ * the LHS is floating-point or a vector.
+ * The updated value is only loaded back when the expression is used, e.g.
+ * "a = (b += 2)", and not when it is a statement on its own.
+ *
+ * @param n           The compound assignment AST node.
+ * @param parentASTop The operator of the parent AST node.
+ *
+ * @return The register holding the assigned value, or NOREG when the
+ *         value is unused.
+ */
+static int codegenCompoundAssignAST(struct ASTnode *n, int parentASTop) {
+    struct ASTnode *lhs = n->right;
+    struct ASTnode *rhs = n->left;
+    int binaryOp = compoundAssignToBinaryASTop(n->op);
+    int valueRegister = NOREG;
+    int immediate = 0;
+    int pointerRegister;
+    int id;
+    bool isValueUsed = parentASTop != A_GLUE && parentASTop != A_FUNCTION &&
+                       parentASTop != A_IF && parentASTop != A_WHILE &&
+                       parentASTop != A_DOWHILE;
+
+    // Small literals are chars widened to the LHS type; the value is the same
+    if (rhs->op == A_WIDENTYPE && rhs->left->op == A_INTEGERLITERAL) {
+        rhs = rhs->left;
+    }
+
+    if (rhs->op == A_INTEGERLITERAL && !isFloatType(lhs->primitiveType) &&
+        !isVectorType(lhs->primitiveType)) {
+        immediate = rhs->v.intvalue;
+    } else {
+        valueRegister = codegenAST(n->left, NOLABEL, n->op);
+        if (binaryOp == A_DIVIDE) {
+            valueRegister =
+                codegenZeroExtendUnsignedInt(n->left, valueRegister);
+        }
+    }
+
+    switch (lhs->op) {
+    case A_IDENTIFIER:
+        id = lhs->v.identifierIndex;
+        CG->compoundAssignSymbol(binaryOp, valueRegister, immediate, id);
+        if (!isValueUsed) {
+            return NOREG;
+        }
+        if (isVectorType(lhs->primitiveType)) {
+            return CG->vectorLoad(CG->addressOfSymbol(id), 0,
+                                  lhs->primitiveType);
+        }
+        if (SymbolTable[id].class == C_LOCAL) {
+            return CG->loadLocalSymbol(id, A_IDENTIFIER);
+        }
+        return CG->loadGlobalSymbol(id, A_IDENTIFIER);
+    case A_DEREFERENCE:
+        // An lvalue A_DEREFERENCE evaluates to the address
+        pointerRegister = codegenAST(lhs, NOLABEL, n->op);
+        CG->compoundAssignDereferencedPointer(binaryOp, valueRegister,
+                                              immediate, pointerRegister,
+                                              lhs->v.offset,
+                                              lhs->primitiveType);
+        if (!isValueUsed) {
+            return NOREG;
+        }
+        if (isVectorType(lhs->primitiveType)) {
+            return CG->vectorLoad(pointerRegister, lhs->v.offset,
+                                  lhs->primitiveType);
+        }
+        return CG->dereferencePointer(pointerRegister, lhs->v.offset,
+                                      lhs->primitiveType);
+    default:
+        logFatald("can't assign (compound assignment) to this AST node type: ",
+                  lhs->op);
+    }
+    return NOREG; // Unreachable
+}
+
+/**
+ * codegenAtomicAST - Generate the assembly code for an atomic builtin.
+ * (helper function)
+ *
+ * NOTE:
+ * The operands are evaluated in order (pointer, expected value pointer,
+ * value) before the single atomic access; no other load or store of the
+ * object is generated.
+ *
+ * @param n The A_ATOMIC* AST node.
+ *
+ * @return Index of the register holding the result, or NOREG.
+ */
+static int codegenAtomicAST(struct ASTnode *n) {
+    int pointerRegister;
+    int expectedRegister;
+    int valueRegister;
+    int type;
+
+    if (n->op == A_ATOMICFENCE) {
+        CG->atomicFence(n->v.intvalue);
+        return NOREG;
+    }
+
+    // The type of the object, not of the result
+    type = TypeTable[n->left->primitiveType].base;
+    pointerRegister = codegenAST(n->left, NOLABEL, n->op);
+    expectedRegister = codegenAST(n->middle, NOLABEL, n->op);
+    valueRegister = codegenAST(n->right, NOLABEL, n->op);
+
+    switch (n->op) {
+    case A_ATOMICLOAD:
+        return CG->atomicLoad(pointerRegister, type, n->v.intvalue);
+    case A_ATOMICSTORE:
+        CG->atomicStore(valueRegister, pointerRegister, type, n->v.intvalue);
+        return NOREG;
+    case A_ATOMICCMPXCHG:
+        return CG->atomicCompareExchange(pointerRegister, expectedRegister,
+                                         valueRegister, type, n->v.intvalue);
+    default:
+        return CG->atomicReadModifyWrite(n->op, valueRegister,
+                                         pointerRegister, type,
+                                         n->v.intvalue);
+    }
+}
+
+/**
+ * codegenPrefetchAST - Generate the assembly code for a software prefetch.
+ * (helper function)
+ *
+ * NOTE:
+ * A constant byte offset added to the address, as in the prefetches the
+ * optimizer inserts, is folded into the instruction's displacement.
+ *
+ * @param n The A_PREFETCH AST node.
+ */
+static void codegenPrefetchAST(struct ASTnode *n) {
+    struct ASTnode *address = n->left;
+    int offset = 0;
+
+    if (address->op == A_ADD && address->right->op == A_INTEGERLITERAL) {
+        offset = address->right->v.intvalue;
+        address = address->left;
+    }
+    CG->prefetch(codegenAST(address, NOLABEL, n->op), offset, n->v.intvalue);
+}
+
+/**
+ * codegenExpandAsmText - Substitute the operands into the text of an asm
+ * statement.
+ *
+ * NOTE:
+ * "%N" is operand N and "%cN" the same operand with the backend-specific
+ * modifier letter c (e.g. "%k0" for the 32-bit name of a register on
+ * x86-64, "%w0" on AArch64). "%%" is a '%', and "%=" a number unique to
+ * the statement, for local labels.
+ *
+ * @param a           The asm statement.
+ * @param operandText Backend function that formats an operand.
+ *
+ * @return The text (malloc'ed).
+ */
+char *codegenExpandAsmText(struct asmStatement *a,
+                           char *(*operandText)(struct asmOperand *op,
+                                                int modifier)) {
+    size_t capacity = strlen(a->text) + 1;
+    size_t length = 0;
+    int uniqueNumber = 0;
+    char number[32];
+    char *text;
+    char *piece;
+    char *c;
+    int modifier;
+    int index;
+
+    if ((text = malloc(capacity)) == NULL) {
+        logFatal("Unable to malloc in codegenExpandAsmText()");
+    }
+    *text = '\0';
+
+    for (c = a->text; *c != '\0'; c++) {
+        piece = number;
+        if (*c != '%') {
+            number[0] = *c;
+            number[1] = '\0';
+        } else if (c[1] == '%') {
+            c++;
+            strcpy(number, "%");
+        } else if (c[1] == '=') {
+            c++;
+            if (uniqueNumber == 0) {
+                uniqueNumber = codegenGetLabelNumber();
+            }
+            snprintf(number, sizeof(number), "%d", uniqueNumber);
+        } else {
+            modifier = 0;
+            if (isalpha((unsigned char)c[1]) &&
+                isdigit((unsigned char)c[2])) {
+                modifier = *++c;
+            }
+            if (!isdigit((unsigned char)c[1])) {
+                logFatal("Invalid '%' sequence in asm text");
+            }
+            for (index = 0; isdigit((unsigned char)c[1]); c++) {
+                index = index * 10 + (c[1] - '0');
+            }
+            if (index >= a->operandCount) {
+                logFatald("asm text refers to a missing operand: ", index);
+            }
+            piece = operandText(&a->operands[index], modifier);
+        }
+
+        if (length + strlen(piece) + 1 > capacity) {
+            capacity = 2 * (length + strlen(piece) + 1);
+            if ((text = realloc(text, capacity)) == NULL) {
+                logFatal("Unable to malloc in codegenExpandAsmText()");
+            }
+        }
+        strcpy(text + length, piece);
+        length += strlen(piece);
+    }
+    return text;
+}
+
+// The asm statement whose outputs are being stored; the A_ASMRESULT nodes
+// name its operands
+static struct asmStatement *CurrentAsmStatement;
+
+/**
+ * codegenAsmAST - Generate the assembly code for an asm statement.
+ * (helper function)
+ *
+ * NOTE:
+ * The pool registers named by the clobbers are reserved first, so that no
+ * operand lands in one. Each operand's expression (for "m", its address)
+ * is then generated into a register, in operand order, and the backend
+ * emits the text. Last, each register output is assigned to its lvalue.
+ *
+ * @param n The A_ASM AST node.
+ */
+static void codegenAsmAST(struct ASTnode *n) {
+    struct asmStatement *a = n->v.asmStatement;
+    struct ASTnode *link;
+
+    CG->asmReserveClobbers(a);
+    for (link = n->left; link != NULL; link = link->right) {
+        a->operands[link->v.intvalue].reg =
+            codegenAST(link->left, NOLABEL, n->op);
+    }
+    CG->inlineAsm(a);
+
+    CurrentAsmStatement = a;
+    for (link = n->right; link != NULL; link = link->right) {
+        codegenAST(link->left, NOLABEL, n->op);
+    }
+}
+
 /**
  * codegenAST - Generates code for the given AST node and its subtrees.
  *
@@ -188,7 +758,7 @@ static int codegenWhileStatementAST(struct ASTnode *n) {
  * @return The register index where the result is stored.
  */
 int codegenAST(struct ASTnode *n, int label, int parentASTop) {
-    int leftRegister, rightRegister;
+    int leftRegister = NOREG, rightRegister = NOREG;
 
     if (n == NULL) {
         return NOREG;
@@ -201,6 +771,48 @@ int codegenAST(struct ASTnode *n, int label, int parentASTop) {
     case A_WHILE:
         // While statement
         return codegenWhileStatementAST(n);
+    case A_DOWHILE:
+        // Do-while statement
+        return codegenDoWhileStatementAST(n);
+    case A_BREAK:
+        codegenJump(BreakLabels[LoopDepth - 1]);
+        return NOREG;
+    case A_CONTINUE:
+        codegenJump(ContinueLabels[LoopDepth - 1]);
+        return NOREG;
+    case A_ASSIGNADD:
+    case A_ASSIGNSUBTRACT:
+    case A_ASSIGNMULTIPLY:
+    case A_ASSIGNDIVIDE:
+    case A_ASSIGNBITWISEOR:
+    case A_ASSIGNBITWISEAND:
+    case A_ASSIGNBITWISEXOR:
+    case A_ASSIGNLSHIFT:
+    case A_ASSIGNRSHIFT:
+        // The LHS must not be evaluated as a plain lvalue/rvalue below
+        return codegenCompoundAssignAST(n, parentASTop);
+    case A_ATOMICLOAD:
+    case A_ATOMICSTORE:
+    case A_ATOMICFETCHADD:
+    case A_ATOMICEXCHANGE:
+    case A_ATOMICCMPXCHG:
+    case A_ATOMICFENCE:
+        // Three operands, generated in order
+        return codegenAtomicAST(n);
+    case A_ASM:
+        codegenAsmAST(n);
+        return NOREG;
+    case A_ASMRESULT:
+        return CurrentAsmStatement->operands[n->v.intvalue].reg;
+    case A_EXPECT:
+        // Only a hint: the value is the expression's
+        return codegenAST(n->left, label, parentASTop);
+    case A_UNREACHABLE:
+        // Never runs; the arm holding it was moved out of line
+        return NOREG;
+    case A_PREFETCH:
+        codegenPrefetchAST(n);
+        return NOREG;
     case A_GLUE:
         // Do each sub-tree separately,
         // and return NOREG since GLUE does not produce a value
@@ -211,9 +823,12 @@ int codegenAST(struct ASTnode *n, int label, int parentASTop) {
         CG->resetRegisters();
         return NOREG;
     case A_FUNCTION:
+        // The preamble places the function in its section
+        CurrentTextSection = SymbolTable[n->v.identifierIndex].textSection;
         CG->functionPreamble(n->v.identifierIndex);
         codegenAST(n->left, NOLABEL, n->op);
         CG->functionPostamble(n->v.identifierIndex);
+        sizeReportEndFunction();
         return NOREG;
     }
 
@@ -223,12 +838,20 @@ int codegenAST(struct ASTnode *n, int label, int parentASTop) {
     // Get the left and right sub-tree value
     if (n->left) {
         // Use NOREG because left subtree can use any register
-        leftRegister = codegenAST(n->left, NOLABEL, n->op);
+        leftRegister =
+            codegenAST(isTruncatedByParent(n->left, n->op, parentASTop)
+                           ? n->left->left
+                           : n->left,
+                       NOLABEL, n->op);
     }
     if (n->right) {
         rightRegister = codegenAST(n->right, NOLABEL, n->op);
     }
 
+    if (isVectorType(n->primitiveType)) {
+        return codegenVectorAST(n, leftRegister, rightRegister);
+    }
+
     switch (n->op) {
     // Arithmetic operations
     case A_ADD:
@@ -238,6 +861,12 @@ int codegenAST(struct ASTnode *n, int label, int parentASTop) {
     case A_MULTIPLY:
         return CG->mulRegs(leftRegister, rightRegister);
     case A_DIVIDE:
+        if (isUnsignedType(n->primitiveType)) {
+            leftRegister = codegenZeroExtendUnsignedInt(n->left, leftRegister);
+            rightRegister =
+                codegenZeroExtendUnsignedInt(n->right, rightRegister);
+            return CG->divRegsUnsigned(leftRegister, rightRegister);
+        }
         return CG->divRegsSigned(leftRegister, rightRegister);
 
     case A_BITWISEAND:
@@ -249,7 +878,12 @@ int codegenAST(struct ASTnode *n, int label, int parentASTop) {
     case A_LSHIFT:
         return CG->shiftLeftRegs(leftRegister, rightRegister);
     case A_RSHIFT:
-        return CG->shiftRightRegs(leftRegister, rightRegister);
+        // Logical shift for unsigned values, arithmetic shift otherwise
+        if (isUnsignedType(n->primitiveType)) {
+            leftRegister = codegenZeroExtendUnsignedInt(n->left, leftRegister);
+            return CG->shiftRightRegsUnsigned(leftRegister, rightRegister);
+        }
+        return CG->shiftRightRegsSigned(leftRegister, rightRegister);
 
     // Comparison operations
     case A_EQ:
@@ -262,16 +896,37 @@ int codegenAST(struct ASTnode *n, int label, int parentASTop) {
         // generate a compare followed by a jjump.
         // Otherwise, compare registers and set one to 1 or 0 based on the
         // comparison.
+        // Both operands have the same type after coercion; unsigned types
+        // use unsigned condition codes.
+        leftRegister = codegenZeroExtendUnsignedInt(n->left, leftRegister);
+        rightRegister = codegenZeroExtendUnsignedInt(n->right, rightRegister);
         if (parentASTop == A_IF || parentASTop == A_WHILE) {
             return codegenCompareAndJump(n->op, leftRegister, rightRegister,
-                                         label);
+                                         label, n->left->primitiveType);
+        } else if (parentASTop == A_DOWHILE) {
+            // compareAndJump() jumps when the comparison is false, but
+            // do-while loops back when it is true. The inverse of a
+            // floating-point comparison is not a comparison (a NaN makes
+            // both false), so test its value instead
+            if (isFloatType(n->left->primitiveType)) {
+                leftRegister = CG->compareAndSet(n->op, leftRegister,
+                                                 rightRegister,
+                                                 n->left->primitiveType);
+                return CG->toBoolean(leftRegister, parentASTop, label);
+            }
+            return codegenCompareAndJump(invertComparisonASTop(n->op),
+                                         leftRegister, rightRegister, label,
+                                         n->left->primitiveType);
         } else {
-            return CG->compareAndSet(n->op, leftRegister, rightRegister);
+            return CG->compareAndSet(n->op, leftRegister, rightRegister,
+                                     n->left->primitiveType);
         }
 
     // Leaf nodes
     case A_INTEGERLITERAL:
         return CG->loadImmediateInt(n->v.intvalue, n->primitiveType);
+    case A_FLOATLITERAL:
+        return CG->loadImmediateFloat(n->v.floatvalue, n->primitiveType);
     case A_STRINGLITERAL:
         return CG->loadGlobalString(n->v.identifierIndex);
     case A_IDENTIFIER:
@@ -314,44 +969,65 @@ int codegenAST(struct ASTnode *n, int label, int parentASTop) {
             // rightRegister is the computed address
             // of the dereferenced pointer
             return CG->storeDereferencedPointer(leftRegister, rightRegister,
+                                                n->right->v.offset,
                                                 n->right->primitiveType);
         default:
             logFatald("can't assign (A_ASSIGN) to this AST node type: ",
                       n->right->op);
         }
     case A_WIDENTYPE:
-        // Widen the child node's primitive type to the parent node's type
+        // Widen the child node's primitive type to the parent node's type.
+        // An unsigned int converted to floating-point must not carry bits
+        // above bit 31
+        if (isFloatType(n->primitiveType)) {
+            leftRegister = codegenZeroExtendUnsignedInt(n->left, leftRegister);
+        }
         return CG->widenPrimitiveType(leftRegister, n->left->primitiveType,
                                       n->primitiveType);
     case A_RETURN:
         CG->returnFromFunction(leftRegister, CurrentFunctionSymbolID);
         return NOREG;
     case A_FUNCTIONCALL:
-        return CG->functionCall(leftRegister, n->v.identifierIndex);
+        // The callee may read an unsigned int argument as a long
+        if (n->left) {
+            leftRegister = codegenZeroExtendUnsignedInt(n->left, leftRegister);
+        }
+        if (n->right) {
+            rightRegister =
+                codegenZeroExtendUnsignedInt(n->right, rightRegister);
+        }
+        return CG->functionCall(leftRegister, rightRegister,
+                                n->v.identifierIndex);
     case A_ADDRESSOF:
         return CG->addressOfSymbol(n->v.identifierIndex);
     case A_DEREFERENCE:
+        // NOTE:
+        // Struct member accesses fold the member offset into v.offset,
+        // so the address is the pointer plus a constant displacement.
         if (n->isRvalue) {
-            return CG->dereferencePointer(leftRegister, n->left->primitiveType);
+            return CG->dereferencePointer(leftRegister, n->v.offset,
+                                          n->primitiveType);
         } else {
-            return leftRegister; // Lvalue: return address in leftRegister;
+            return leftRegister; // Lvalue: the store applies v.offset
         }
     case A_SCALETYPE:
+        // An unsigned int index is added to a 64-bit address
+        leftRegister = codegenZeroExtendUnsignedInt(n->left, leftRegister);
+
         // Small optimization:
         // use shift if the scale value is a known power of 2
-        switch (n->v.size) {
-        case 2:
-            return CG->shiftLeftConst(leftRegister, 1);
-        case 4:
-            return CG->shiftLeftConst(leftRegister, 2);
-        case 8:
-            return CG->shiftLeftConst(leftRegister, 3);
-        default:
-            // Load a register with the size and multiply
-            // the left register by this size...
-            rightRegister = CG->loadImmediateInt(n->v.size, P_INT);
-            return CG->mulRegs(leftRegister, rightRegister);
+        // (element sizes and most row strides of multi-dimensional arrays)
+        if ((n->v.size & (n->v.size - 1)) == 0) {
+            int shift = 0;
+            while ((1 << shift) < n->v.size) {
+                shift++;
+            }
+            return CG->shiftLeftConst(leftRegister, shift);
         }
+        // Load a register with the size and multiply
+        // the left register by this size...
+        rightRegister = CG->loadImmediateInt(n->v.size, P_INT);
+        return CG->mulRegs(leftRegister, rightRegister);
 
     case A_POSTINCREMENT:
         // Load the variable's value into a register then increment it
@@ -387,6 +1063,9 @@ int codegenAST(struct ASTnode *n, int label, int parentASTop) {
         // Logical NOT
         return CG->logicalNot(leftRegister);
     case A_TOBOOLEAN:
+        if (isVectorType(n->left->primitiveType)) {
+            logFatal("A vector cannot be used as a condition");
+        }
         // If the present AST node is an A_IF or A_WHILE,
         // generate a compare followed by a jump.
         // Otherwise, set the register to 0(false) or 1(true) based on it's
@@ -453,13 +1132,13 @@ int codegenGetPrimitiveTypeSize(int primitiveType) {
 void codegenResetLocalOffset(void) { CG->resetLocalOffset(); }
 
 /**
- * codegenGetLocalOffset - Gets the local variable offset for a given type.
+ * codegenGetLocalOffset - Allocates stack space for a local variable.
  *
- * @param type                 The primitive type of the local variable.
+ * @param id                   The symbol table ID of the local variable.
  * @param isFunctionParameter  True if the variable is a function parameter.
  *
  * @return int The local offset for the variable.
  */
-int codegenGetLocalOffset(int type, bool isFunctionParameter) {
-    return CG->getLocalOffset(type, isFunctionParameter);
+int codegenGetLocalOffset(int id, bool isFunctionParameter) {
+    return CG->getLocalOffset(id, isFunctionParameter);
 }
@@ -0,0 +1,192 @@
+// src/globals.c
+//
+// Whole-file analysis of the stores to global variables. While parsing,
+// each assignment, compound assignment, '++', '--' and asm output records
+// a store on the symbol it writes; '&' and asm memory operands mark the
+// symbol as address-taken. Once the file is parsed, a global scalar that
+// is only ever assigned its initial value is known to always hold it: its
+// loads become immediates, and if nothing stores to it at all, its
+// storage goes in .rodata.
+
+#include "data.h"
+#include "decl.h"
+#include "defs.h"
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The texts of the asm statements, which may name globals in their
+// instructions
+static char **AsmTexts;
+static int AsmTextCount;
+
+/**
+ * recordStore - Record a store to a variable.
+ *
+ * NOTE:
+ * "x = 5" stores the constant 5; it leaves x unchanged if that is its
+ * initial value. Any other store changes x. Stores through pointers and
+ * to array elements are not recorded on a scalar.
+ *
+ * @param n     The AST node being stored to.
+ * @param value The value of a plain assignment, or NULL.
+ */
+void recordStore(struct ASTnode *n, struct ASTnode *value) {
+    struct memoryAccess access;
+    struct symbolTable *sym;
+    long constant;
+
+    if (!describeMemoryAccess(n, &access) || access.kind != ACCESS_OBJECT) {
+        return;
+    }
+
+    sym = &SymbolTable[access.id];
+    sym->isStored = true;
+    if (value == NULL || !evaluateConstantExpression(value, &constant) ||
+        constant != sym->initialValue) {
+        sym->isChanged = true;
+    }
+}
+
+/**
+ * recordAsmText - Keep the text of an asm statement, so that the globals
+ * it names are known to be stored to.
+ *
+ * @param text The text of the asm statement.
+ */
+void recordAsmText(char *text) {
+    AsmTexts = realloc(AsmTexts, (AsmTextCount + 1) * sizeof(char *));
+    if (AsmTexts == NULL) {
+        logFatal("Unable to record the text of an asm statement");
+    }
+    AsmTexts[AsmTextCount++] = text;
+}
+
+/**
+ * recordAsmWords - Record every global named in an asm statement's text as
+ * stored to, since the instructions may write to it by its name.
+ * (helper function)
+ *
+ * @param text The text of the asm statement.
+ */
+static void recordAsmWords(char *text) {
+    char word[TEXTLEN + 1];
+    int length;
+    int id;
+
+    while (*text != '\0') {
+        if (!isalpha((unsigned char)*text) && *text != '_') {
+            text++;
+            continue;
+        }
+        length = 0;
+        while (isalnum((unsigned char)*text) || *text == '_') {
+            if (length < TEXTLEN) {
+                word[length++] = *text;
+            }
+            text++;
+        }
+        word[length] = '\0';
+        if ((id = findGlobalSymbol(word)) != -1) {
+            SymbolTable[id].isStored = true;
+            SymbolTable[id].isChanged = true;
+        }
+    }
+}
+
+/**
+ * fitsType - Check whether a variable of a type reads back a value as it
+ * is. (helper function)
+ *
+ * NOTE:
+ * A char is loaded zero-extended, so below int only values that read back
+ * the same either way are accepted.
+ *
+ * @param value The value.
+ * @param type  The integer type.
+ *
+ * @return bool True if storing and loading the value keeps it.
+ */
+static bool fitsType(long value, int type) {
+    int bits = getTypeSize(type) * 8;
+
+    if (bits >= 64) {
+        return true;
+    }
+    if (bits < 32 || isUnsignedType(type)) {
+        return value >= 0 && value < (1L << (bits - 1));
+    }
+    return value >= -(1L << (bits - 1)) && value < (1L << (bits - 1));
+}
+
+/**
+ * classifyGlobalVariable - Decide whether the loads of a global or static
+ * variable can use its initial value, and whether its storage can be
+ * read-only. (helper function)
+ *
+ * NOTE:
+ * A const scalar only ever holds its initial value. Another scalar does
+ * too if the file never stores to it, or only stores that same constant,
+ * and never takes its address. A global that is not static could still be
+ * changed by another file, unless this file is a whole program: a program
+ * is linked from the file that defines main() and the runtime, which
+ * touches none of its variables.
+ *
+ * @param id      The symbol table ID of the variable's storage.
+ * @param hasMain True if the file defines main().
+ */
+static void classifyGlobalVariable(int id, bool hasMain) {
+    struct symbolTable *sym = &SymbolTable[id];
+    bool isUnchanged;
+
+    if (sym->structuralType != S_VARIABLE ||
+        (sym->qualifiers & Q_VOLATILE) ||
+        (!isIntegerType(sym->primitiveType) &&
+         !isFloatType(sym->primitiveType) &&
+         !isPointerType(sym->primitiveType))) {
+        return;
+    }
+
+    if (sym->qualifiers & Q_CONST) {
+        isUnchanged = true;
+        sym->isReadOnly = true;
+    } else {
+        if (sym->class == C_GLOBAL && !hasMain) {
+            return;
+        }
+        isUnchanged = !sym->isChanged && !sym->isAddressTaken;
+        sym->isReadOnly = !sym->isStored && !sym->isAddressTaken;
+    }
+
+    // Folded loads are int literals
+    sym->isConstant = isUnchanged && isIntegerType(sym->primitiveType) &&
+                      sym->initialValue >= INT_MIN &&
+                      sym->initialValue <= INT_MAX &&
+                      fitsType(sym->initialValue, sym->primitiveType);
+}
+
+/**
+ * classifyGlobalVariables - Classify every global and static variable by
+ * the stores that the parsed file makes to it.
+ *
+ * NOTE:
+ * This runs once the whole file is parsed, before any function is
+ * optimized, so every store is known.
+ */
+void classifyGlobalVariables(void) {
+    int mainId = findGlobalSymbol("main");
+    bool hasMain =
+        mainId != -1 && SymbolTable[mainId].structuralType == S_FUNCTION;
+
+    for (int i = 0; i < AsmTextCount; i++) {
+        recordAsmWords(AsmTexts[i]);
+    }
+    for (int i = 0; i < NextGlobalSymbolIndex; i++) {
+        classifyGlobalVariable(i, hasMain);
+    }
+    free(AsmTexts);
+    AsmTexts = NULL;
+    AsmTextCount = 0;
+}
@@ -22,6 +22,8 @@ static void initCompilerState(void) {
     Putback = '\n';
     NextGlobalSymbolIndex = 0;           // Grow upward
     NextLocalSymbolIndex = NSYMBOLS - 1; // Grow downward
+    NextStructIndex = 0;
+    initTypeTable(); // Needs the backend's type sizes
 }
 
 /**
@@ -37,6 +39,9 @@ static void dieUsage(const char *program) {
             "[--target [nasm|aarch64]|-t [nasm|aarch64]] "
             "[--dump-ast|-a] "
             "[--dump-ast-compacted|-A] "
+            "[--size-report[=table|json]] "
+            "[--march=arch] "
+            "[--prefetch-distance=bytes] "
             "infile\n",
             program);
     exit(1);
@@ -66,6 +71,103 @@ static int parseTargetOrDie(const char *targetName, const char *program) {
     return TARGET_NASM; // unreachable, but keeps compilers quiet
 }
 
+/**
+ * parseSizeReportOrDie - Parse the --size-report format. Exit if the format
+ * is unsupported.
+ *
+ * @param formatName The format name, or NULL when omitted (table).
+ * @param program Name of the program (typically argv[0]).
+ *
+ * @return The report format constant (SIZE_REPORT_*).
+ */
+static int parseSizeReportOrDie(const char *formatName, const char *program) {
+    if (formatName == NULL || strcmp(formatName, "table") == 0) {
+        return SIZE_REPORT_TABLE;
+    }
+    if (strcmp(formatName, "json") == 0) {
+        return SIZE_REPORT_JSON;
+    }
+
+    fprintf(stderr,
+            "Unsupported size report format: %s (only 'table' or 'json' is "
+            "supported)\n",
+            formatName);
+    dieUsage(program);
+    return SIZE_REPORT_NONE; // unreachable, but keeps compilers quiet
+}
+
+/**
+ * parseMarchOrDie - Parse the --march architecture level for the target.
+ * Exit if the target does not have it.
+ *
+ * NOTE:
+ * Only the levels that change the generated code are told apart: LSE
+ * atomics are part of Armv8.1-A and later, or can be added with "+lse".
+ *
+ * @param marchName The architecture name, or NULL when omitted.
+ * @param target The code generation target (TARGET_*).
+ * @param program Name of the program (typically argv[0]).
+ *
+ * @return The architecture level constant (MARCH_*).
+ */
+static int parseMarchOrDie(const char *marchName, int target,
+                           const char *program) {
+    static const char *lseNames[] = {
+        "armv8-a+lse", "armv8.1-a", "armv8.2-a", "armv8.3-a", "armv8.4-a",
+        "armv8.5-a",   "armv8.6-a", "armv8.7-a", "armv8.8-a", "armv8.9-a",
+        "armv9-a",     "armv9.1-a", "armv9.2-a", "armv9.3-a", "armv9.4-a",
+    };
+
+    if (marchName == NULL) {
+        return MARCH_BASELINE;
+    }
+    if (target == TARGET_NASM && strcmp(marchName, "x86-64") == 0) {
+        return MARCH_BASELINE;
+    }
+    if (target == TARGET_AARCH64) {
+        if (strcmp(marchName, "armv8-a") == 0) {
+            return MARCH_BASELINE;
+        }
+        for (size_t i = 0; i < sizeof(lseNames) / sizeof(lseNames[0]); i++) {
+            if (strcmp(marchName, lseNames[i]) == 0) {
+                return MARCH_LSE;
+            }
+        }
+    }
+
+    fprintf(stderr,
+            "Unsupported architecture for this target: %s (x86-64 for "
+            "'nasm'; armv8-a, armv8-a+lse, armv8.N-a or armv9.N-a for "
+            "'aarch64')\n",
+            marchName);
+    dieUsage(program);
+    return MARCH_BASELINE; // unreachable, but keeps compilers quiet
+}
+
+/**
+ * parsePrefetchDistanceOrDie - Parse the --prefetch-distance byte count.
+ * Exit if it is not a number from 0 to MAXPREFETCHDISTANCE.
+ *
+ * @param distance The distance as given on the command line.
+ * @param program Name of the program (typically argv[0]).
+ *
+ * @return The distance in bytes.
+ */
+static int parsePrefetchDistanceOrDie(const char *distance,
+                                      const char *program) {
+    char *end;
+    long bytes = strtol(distance, &end, 10);
+
+    if (*distance == '\0' || *end != '\0' || bytes < 0 ||
+        bytes > MAXPREFETCHDISTANCE) {
+        fprintf(stderr,
+                "Invalid prefetch distance: %s (expected 0 to %d bytes)\n",
+                distance, MAXPREFETCHDISTANCE);
+        dieUsage(program);
+    }
+    return bytes;
+}
+
 /**
  * parseArgsOrDie - Parse command-line arguments and set output parameters.
  *
@@ -74,20 +176,26 @@ static int parseTargetOrDie(const char *targetName, const char *program) {
  * @param outTargetName Output parameter for the target name.
  * @param outInfilePath Output parameter for the input file path.
  * @param outOutfilePath Output parameter for the output file path.
+ * @param outMarchName Output parameter for the --march name (or NULL).
  */
 static void parseArgsOrDie(int argc, char **argv, const char **outTargetName,
                            const char **outInfilePath,
-                           const char **outOutfilePath) {
+                           const char **outOutfilePath,
+                           const char **outMarchName) {
     // Defaults
     const char *targetName = "nasm"; // TARGET_NASM
     const char *infilePath = NULL;
     const char *outfilePath = "out.asm"; // default
+    const char *marchName = NULL;        // the target's baseline
 
     static struct option longopts[] = {
         {"target", required_argument, 0, 't'},
         {"output", required_argument, 0, 'o'},
         {"dump-ast", no_argument, 0, 'a'},
         {"dump-ast-compacted", no_argument, 0, 'A'},
+        {"size-report", optional_argument, 0, 'S'},
+        {"march", required_argument, 0, 'M'},
+        {"prefetch-distance", required_argument, 0, 'P'},
         {0, 0, 0, 0},
     };
 
@@ -108,6 +216,16 @@ static void parseArgsOrDie(int argc, char **argv, const char **outTargetName,
             Option_dumpAST = true;
             Option_dumpASTCompacted = true;
             break;
+        case 'S':
+            Option_sizeReport = parseSizeReportOrDie(optarg, argv[0]);
+            break;
+        case 'M':
+            marchName = optarg;
+            break;
+        case 'P':
+            Option_prefetchDistance =
+                parsePrefetchDistanceOrDie(optarg, argv[0]);
+            break;
         default:
             dieUsage(argv[0]);
         }
@@ -122,6 +240,7 @@ static void parseArgsOrDie(int argc, char **argv, const char **outTargetName,
     *outTargetName = targetName;
     *outInfilePath = infilePath;
     *outOutfilePath = outfilePath;
+    *outMarchName = marchName;
 }
 
 /**
@@ -160,14 +279,19 @@ int main(int argc, char **argv) {
     const char *targetName = NULL;
     const char *infilePath = NULL;
     const char *outfilePath = NULL;
+    const char *marchName = NULL;
 
     // Defaults (may be overridden by CLI flags)
     Option_dumpAST = false;
     Option_dumpASTCompacted = false;
+    Option_sizeReport = SIZE_REPORT_NONE;
+    Option_prefetchDistance = 0;
 
-    parseArgsOrDie(argc, argv, &targetName, &infilePath, &outfilePath);
+    parseArgsOrDie(argc, argv, &targetName, &infilePath, &outfilePath,
+                   &marchName);
 
     CurrentTarget = parseTargetOrDie(targetName, argv[0]);
+    Option_march = parseMarchOrDie(marchName, CurrentTarget, argv[0]);
     codegenSelectTargetBackend(CurrentTarget);
 
     initCompilerState();
@@ -177,15 +301,22 @@ int main(int argc, char **argv) {
     // Ensure runtime-provided function is known to the compiler.
     // Prefer the correct type for future typechecking.
     // If your language only has int right now: use P_INT.
-    addGlobalSymbol("printint", P_CHAR, S_FUNCTION, 0, 0);
-    addGlobalSymbol("printchar", P_CHAR, S_FUNCTION, 0, 0);
-    addGlobalSymbol("printstring", P_LONG, S_FUNCTION, 0, 0);
+    addGlobalSymbol("printint", functionTypeOf(P_CHAR), S_FUNCTION, 0, 0);
+    addGlobalSymbol("printchar", functionTypeOf(P_CHAR), S_FUNCTION, 0, 0);
+    addGlobalSymbol("printstring", functionTypeOf(P_LONG), S_FUNCTION, 0, 0);
+    addGlobalSymbol("printdouble", functionTypeOf(P_CHAR), S_FUNCTION, 0, 0);
+    addGlobalSymbol("thread_spawn", functionTypeOf(P_LONG), S_FUNCTION, 0, 0);
+    addGlobalSymbol("thread_join", functionTypeOf(P_LONG), S_FUNCTION, 0, 0);
 
     scan(&Token);      // Prime first token
     codegenPreamble(); // Emit target preamble
     globalDeclaration();
     codegenPostamble();
 
+    if (Option_sizeReport != SIZE_REPORT_NONE) {
+        sizeReportPrint();
+    }
+
     closeFiles();
     return 0;
 }
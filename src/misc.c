@@ -52,6 +52,11 @@ void matchLeftParenthesisToken(void) { match(T_LPARENTHESIS, "("); }
  */
 void matchRightParenthesisToken(void) { match(T_RPARENTHESIS, ")"); }
 
+/**
+ * matchCommaToken - Matches a comma token.
+ */
+void matchCommaToken(void) { match(T_COMMA, ","); }
+
 /**
  * logFatal - Logs a fatal error message and exits.
  *
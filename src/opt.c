@@ -0,0 +1,1759 @@
+// src/opt.c
+//
+// Target-independent rewrites of a function's AST, done after the whole
+// function has been parsed and before any code is generated for it.
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "data.h"
+#include "decl.h"
+#include "defs.h"
+
+// Maximum number of distinct products reduced in one loop
+#define NREDUCEDPRODUCTS 16
+// Maximum number of stores in a loop whose loads are hoisted
+#define NLOOPSTORES 32
+// Maximum number of distinct loads hoisted out of one loop
+#define NHOISTEDLOADS 16
+// Maximum number of prefetches inserted into one loop
+#define NPREFETCHES 8
+// Maximum depth of a loop nest that is interchanged or fused
+#define NNESTLOOPS 8
+// Maximum number of loads and stores in loops that are interchanged or
+// fused
+#define NNESTACCESSES 64
+// Size in bytes of a cache line, for the cost of a strided access
+#define CACHELINESIZE 64
+
+/**
+ * stripWiden - Look through the A_WIDENTYPE nodes wrapping an expression.
+ *
+ * @param n The AST node.
+ *
+ * @return The first node below n that is not an A_WIDENTYPE.
+ */
+static struct ASTnode *stripWiden(struct ASTnode *n) {
+    while (n != NULL && n->op == A_WIDENTYPE) {
+        n = n->left;
+    }
+    return n;
+}
+
+/**
+ * isIdentifierOf - Check whether an expression is just the value of a
+ * given variable (possibly widened).
+ *
+ * @param n  The AST node.
+ * @param id Symbol table ID of the variable.
+ *
+ * @return bool True if n reads the variable id.
+ */
+static bool isIdentifierOf(struct ASTnode *n, int id) {
+    n = stripWiden(n);
+    return n != NULL && n->op == A_IDENTIFIER && n->v.identifierIndex == id;
+}
+
+/**
+ * getLiteral - Get the value of an integer literal expression (possibly
+ * widened).
+ *
+ * @param n     The AST node.
+ * @param value Where to store the literal's value.
+ *
+ * @return bool True if n is an integer literal.
+ */
+static bool getLiteral(struct ASTnode *n, long *value) {
+    n = stripWiden(n);
+    if (n == NULL || n->op != A_INTEGERLITERAL) {
+        return false;
+    }
+    *value = n->v.intvalue;
+    return true;
+}
+
+/**
+ * isWritten - Check whether a tree assigns to a variable.
+ *
+ * @param n  The AST tree.
+ * @param id Symbol table ID of the variable.
+ *
+ * @return bool True if the tree contains an assignment, compound
+ *         assignment, increment or decrement of the variable.
+ */
+static bool isWritten(struct ASTnode *n, int id) {
+    if (n == NULL) {
+        return false;
+    }
+
+    // NOTE: Assignments have the LHS in the right child
+    if (isAssignmentASTop(n->op) && n->right->op == A_IDENTIFIER &&
+        n->right->v.identifierIndex == id) {
+        return true;
+    }
+    switch (n->op) {
+    case A_POSTINCREMENT:
+    case A_POSTDECREMENT:
+        if (n->v.identifierIndex == id) {
+            return true;
+        }
+        break;
+    case A_PREINCREMENT:
+    case A_PREDECREMENT:
+        if (isIdentifierOf(n->left, id)) {
+            return true;
+        }
+        break;
+    }
+
+    return isWritten(n->left, id) || isWritten(n->middle, id) ||
+           isWritten(n->right, id);
+}
+
+/**
+ * getInductionStep - Recognise the post-operation of a for loop that
+ * steps a variable by a constant.
+ *
+ * NOTE:
+ * Accepted forms are "i++", "++i", "i--", "--i", "i += c", "i -= c",
+ * "i = i + c", "i = c + i" and "i = i - c".
+ *
+ * @param n    The post-operation AST.
+ * @param id   Where to store the symbol ID of the stepped variable.
+ * @param step Where to store the (signed) step.
+ *
+ * @return bool True if n is one of the forms above.
+ */
+static bool getInductionStep(struct ASTnode *n, int *id, long *step) {
+    struct ASTnode *value;
+    long c;
+
+    switch (n->op) {
+    case A_POSTINCREMENT:
+    case A_POSTDECREMENT:
+        *id = n->v.identifierIndex;
+        *step = (n->op == A_POSTINCREMENT) ? 1 : -1;
+        return true;
+    case A_PREINCREMENT:
+    case A_PREDECREMENT:
+        if (stripWiden(n->left)->op != A_IDENTIFIER) {
+            return false;
+        }
+        *id = stripWiden(n->left)->v.identifierIndex;
+        *step = (n->op == A_PREINCREMENT) ? 1 : -1;
+        return true;
+    case A_ASSIGNADD:
+    case A_ASSIGNSUBTRACT:
+        if (n->right->op != A_IDENTIFIER || !getLiteral(n->left, &c)) {
+            return false;
+        }
+        *id = n->right->v.identifierIndex;
+        *step = (n->op == A_ASSIGNADD) ? c : -c;
+        return true;
+    case A_ASSIGN:
+        if (n->right->op != A_IDENTIFIER) {
+            return false;
+        }
+        *id = n->right->v.identifierIndex;
+        value = stripWiden(n->left);
+        if (value->op == A_ADD && isIdentifierOf(value->left, *id) &&
+            getLiteral(value->right, &c)) {
+            *step = c;
+            return true;
+        }
+        if (value->op == A_ADD && isIdentifierOf(value->right, *id) &&
+            getLiteral(value->left, &c)) {
+            *step = c;
+            return true;
+        }
+        if (value->op == A_SUBTRACT && isIdentifierOf(value->left, *id) &&
+            getLiteral(value->right, &c)) {
+            *step = -c;
+            return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+/**
+ * getProductFactor - Check whether an expression is a variable multiplied
+ * by a constant, i.e. "i * c", "c * i" or an index scaled by a stride that
+ * is not a power of two (powers of two are already a single shift).
+ *
+ * @param n      The AST node.
+ * @param id     Symbol table ID of the variable.
+ * @param factor Where to store the constant factor.
+ *
+ * @return bool True if n is such a product.
+ */
+static bool getProductFactor(struct ASTnode *n, int id, long *factor) {
+    switch (n->op) {
+    case A_MULTIPLY:
+        if (isIdentifierOf(n->left, id) && getLiteral(n->right, factor)) {
+            return true;
+        }
+        return isIdentifierOf(n->right, id) && getLiteral(n->left, factor);
+    case A_SCALETYPE:
+        *factor = n->v.size;
+        return isIdentifierOf(n->left, id) &&
+               (n->v.size & (n->v.size - 1)) != 0;
+    default:
+        return false;
+    }
+}
+
+// A reduced product of the loop being rewritten
+struct reducedProduct {
+    long factor;        // Constant the induction variable is multiplied by
+    int primitiveType;  // Type of the product
+    int id;             // Symbol ID of the variable holding the product
+};
+
+// The for loop whose induction variable is being reduced
+struct inductionLoop {
+    struct ASTnode **slot;  // Where the A_WHILE node hangs in the tree
+    struct ASTnode *loop;   // The A_WHILE node
+    int id;                 // Symbol ID of the induction variable
+    long step;              // Amount added by the post-operation
+    struct reducedProduct products[NREDUCEDPRODUCTS];
+    int productCount;
+};
+
+/**
+ * getReducedProduct - Find, or create, the variable that holds
+ * "induction variable * factor" for a loop.
+ *
+ * NOTE:
+ * A new variable is a hidden local initialised from the original product
+ * just before the loop, and stepped by "step * factor" after the loop's
+ * post-operation.
+ *
+ * @param il      The loop.
+ * @param product The product expression (copied for the initialisation).
+ * @param factor  The constant factor of the product.
+ *
+ * @return The symbol ID of the variable, or -1 if none can be made.
+ */
+static int getReducedProduct(struct inductionLoop *il,
+                             struct ASTnode *product, long factor) {
+    static int tempNumber = 0;
+    struct ASTnode *init;
+    struct ASTnode *update;
+    char name[TEXTLEN];
+    long increment = il->step * factor;
+    // A scaled index is added to a pointer: keep it 64 bits wide
+    int type = isPointerType(product->primitiveType) ? P_LONG
+                                                     : product->primitiveType;
+    int id;
+
+    for (int i = 0; i < il->productCount; i++) {
+        if (il->products[i].factor == factor &&
+            il->products[i].primitiveType == type) {
+            return il->products[i].id;
+        }
+    }
+    if (il->productCount == NREDUCEDPRODUCTS || increment < INT_MIN ||
+        increment > INT_MAX) {
+        return -1;
+    }
+
+    // The name cannot clash with an identifier in the program
+    snprintf(name, sizeof(name), ".iv%d", ++tempNumber);
+    id = addLocalSymbol(name, type, S_VARIABLE, 0, 0);
+
+    // variable = product, just before the loop
+    init = makeASTNode(A_ASSIGN, type, cloneAST(product), NULL,
+                       makeASTLeaf(A_IDENTIFIER, type, id), 0);
+    *il->slot = makeASTNode(A_GLUE, P_NONE, init, NULL, *il->slot, 0);
+
+    // variable += step * factor, after the post-operation
+    update = makeASTNode(A_ASSIGNADD, type,
+                         makeASTLeaf(A_INTEGERLITERAL, P_INT, increment),
+                         NULL, makeASTLeaf(A_IDENTIFIER, type, id), 0);
+    il->loop->middle =
+        makeASTNode(A_GLUE, P_NONE, il->loop->middle, NULL, update, 0);
+
+    il->products[il->productCount++] =
+        (struct reducedProduct){factor, type, id};
+    return id;
+}
+
+/**
+ * reduceProducts - Replace the products of a loop's induction variable and
+ * a constant within a tree by the variables that track them.
+ *
+ * @param np Where the AST tree hangs.
+ * @param il The loop.
+ */
+static void reduceProducts(struct ASTnode **np, struct inductionLoop *il) {
+    struct ASTnode *n = *np;
+    long factor;
+    int id;
+
+    if (n == NULL) {
+        return;
+    }
+
+    if (getProductFactor(n, il->id, &factor) &&
+        (id = getReducedProduct(il, n, factor)) != -1) {
+        *np = makeASTLeaf(A_IDENTIFIER, SymbolTable[id].primitiveType, id);
+        (*np)->isRvalue = true;
+        return;
+    }
+
+    reduceProducts(&n->left, il);
+    reduceProducts(&n->middle, il);
+    reduceProducts(&n->right, il);
+}
+
+/**
+ * reduceInductionVariable - Strength-reduce the multiplications of a for
+ * loop's induction variable by constants.
+ *
+ * NOTE:
+ * In
+ *     for (i = 0; i < n; i++) { ... a[i * 10 + j] ... grid[i][j] ... }
+ * "i * 10" (and "i * 40", the byte offset of row i of "int grid[][10]")
+ * are replaced by hidden variables that start at their value on loop
+ * entry and grow by 10 (and 40) on every iteration. The loop body, and
+ * any loop nested in it, then no longer multiplies.
+ * The induction variable must be a signed integer local whose address is
+ * never taken, and the post-operation must be the only place the loop
+ * changes it, so that the products stay in step with it.
+ *
+ * @param slot Where the A_WHILE node of the loop hangs in the tree.
+ */
+static void reduceInductionVariable(struct ASTnode **slot) {
+    struct inductionLoop il = {0};
+    int type;
+
+    il.slot = slot;
+    il.loop = *slot;
+    if (!getInductionStep(il.loop->middle, &il.id, &il.step)) {
+        return;
+    }
+
+    type = SymbolTable[il.id].primitiveType;
+    if (SymbolTable[il.id].class != C_LOCAL ||
+        SymbolTable[il.id].structuralType != S_VARIABLE ||
+        (SymbolTable[il.id].qualifiers & Q_VOLATILE) ||
+        !isIntegerType(type) || isUnsignedType(type) ||
+        SymbolTable[il.id].isAddressTaken || isWritten(il.loop->left, il.id) ||
+        isWritten(il.loop->right, il.id)) {
+        return;
+    }
+
+    reduceProducts(&il.loop->left, &il);
+    reduceProducts(&il.loop->right, &il);
+}
+
+/**
+ * isSameAST - Check whether two AST trees are structurally identical.
+ *
+ * @param a The first tree.
+ * @param b The second tree.
+ *
+ * @return bool True if both compute the same expression.
+ */
+static bool isSameAST(struct ASTnode *a, struct ASTnode *b) {
+    if (a == NULL || b == NULL) {
+        return a == b;
+    }
+    return a->op == b->op && a->primitiveType == b->primitiveType &&
+           a->isRvalue == b->isRvalue && a->v.intvalue == b->v.intvalue &&
+           (a->op != A_FLOATLITERAL || a->v.floatvalue == b->v.floatvalue) &&
+           isSameAST(a->left, b->left) && isSameAST(a->middle, b->middle) &&
+           isSameAST(a->right, b->right);
+}
+
+/**
+ * hasLoopExit - Check whether a tree contains a break, continue or return.
+ *
+ * @param n The AST tree.
+ *
+ * @return bool True if control may leave the tree early.
+ */
+static bool hasLoopExit(struct ASTnode *n) {
+    if (n == NULL) {
+        return false;
+    }
+    if (n->op == A_BREAK || n->op == A_CONTINUE || n->op == A_RETURN) {
+        return true;
+    }
+    return hasLoopExit(n->left) || hasLoopExit(n->middle) ||
+           hasLoopExit(n->right);
+}
+
+// The loop whose invariant loads are being hoisted
+struct invariantLoop {
+    struct ASTnode **slot; // Where the loop hangs; hoisted loads go here
+    struct memoryAccess stores[NLOOPSTORES];
+    int storeCount;
+    struct ASTnode *loads[NHOISTEDLOADS]; // Loads hoisted so far
+    int ids[NHOISTEDLOADS];               // Variables now holding them
+    int loadCount;
+};
+
+/**
+ * collectStores - Record every store a loop makes.
+ *
+ * @param n  The AST tree of (a part of) the loop.
+ * @param il The loop.
+ *
+ * @return bool False if the loop cannot be analysed: it calls a function
+ *         (which may store anywhere), makes an atomic access (which may
+ *         order it after other threads' stores), holds an asm statement
+ *         (which may do either) or makes too many stores.
+ */
+static bool collectStores(struct ASTnode *n, struct invariantLoop *il) {
+    struct ASTnode *target = NULL;
+
+    if (n == NULL) {
+        return true;
+    }
+
+    // NOTE: Assignments have the LHS in the right child
+    if (isAssignmentASTop(n->op)) {
+        target = n->right;
+    }
+    if (isAtomicASTop(n->op)) {
+        return false;
+    }
+    switch (n->op) {
+    case A_FUNCTIONCALL:
+    case A_ASM:
+        return false;
+    case A_POSTINCREMENT:
+    case A_POSTDECREMENT:
+        target = n;
+        break;
+    case A_PREINCREMENT:
+    case A_PREDECREMENT:
+        target = stripWiden(n->left);
+        break;
+    }
+
+    if (target != NULL) {
+        if (il->storeCount == NLOOPSTORES ||
+            !describeMemoryAccess(target, &il->stores[il->storeCount])) {
+            return false;
+        }
+        il->storeCount++;
+    }
+
+    return collectStores(n->left, il) && collectStores(n->middle, il) &&
+           collectStores(n->right, il);
+}
+
+/**
+ * isLoopInvariant - Check whether an expression has the same value on
+ * every iteration of a loop.
+ *
+ * NOTE:
+ * Only loads, constants, addresses of variables and arithmetic that cannot
+ * trap are accepted. A load is invariant if its address is, it is not
+ * volatile, and no store of the loop may alias it.
+ *
+ * @param n  The AST node.
+ * @param il The loop.
+ *
+ * @return bool True if n is loop invariant.
+ */
+static bool isLoopInvariant(struct ASTnode *n, struct invariantLoop *il) {
+    struct memoryAccess access;
+
+    switch (n->op) {
+    case A_INTEGERLITERAL:
+    case A_FLOATLITERAL:
+    case A_ADDRESSOF:
+        return true;
+    case A_IDENTIFIER:
+    case A_DEREFERENCE:
+        if (!n->isRvalue || !describeMemoryAccess(n, &access) ||
+            (access.qualifiers & Q_VOLATILE)) {
+            return false;
+        }
+        for (int i = 0; i < il->storeCount; i++) {
+            if (mayAlias(&access, &il->stores[i])) {
+                return false;
+            }
+        }
+        return n->op == A_IDENTIFIER || isLoopInvariant(n->left, il);
+    case A_ADD:
+    case A_SUBTRACT:
+    case A_MULTIPLY:
+    case A_LSHIFT:
+        return isLoopInvariant(n->left, il) && isLoopInvariant(n->right, il);
+    case A_WIDENTYPE:
+    case A_SCALETYPE:
+        return isLoopInvariant(n->left, il);
+    default:
+        return false;
+    }
+}
+
+/**
+ * isSafeToLoad - Check whether a load can be done even where the program
+ * would not do it, i.e. it cannot fault.
+ *
+ * @param n The load (A_IDENTIFIER or A_DEREFERENCE).
+ *
+ * @return bool True for variables and in-bounds constant array elements.
+ */
+static bool isSafeToLoad(struct ASTnode *n) {
+    struct memoryAccess access;
+
+    if (n->op == A_IDENTIFIER) {
+        return true;
+    }
+    describeMemoryAccess(n, &access);
+    return access.kind == ACCESS_OBJECT && access.isOffsetKnown &&
+           access.offset >= 0 &&
+           access.offset + access.size <= getSymbolSize(access.id);
+}
+
+/**
+ * hoistLoad - Replace a loop-invariant load by a hidden local that is
+ * loaded once, just before the loop.
+ *
+ * @param np Where the load hangs in the tree.
+ * @param il The loop.
+ */
+static void hoistLoad(struct ASTnode **np, struct invariantLoop *il) {
+    static int tempNumber = 0;
+    struct ASTnode *n = *np;
+    struct ASTnode *init;
+    char name[TEXTLEN];
+    int type = n->primitiveType;
+    int id = -1;
+
+    for (int i = 0; i < il->loadCount; i++) {
+        if (isSameAST(il->loads[i], n)) {
+            id = il->ids[i];
+        }
+    }
+
+    if (id == -1) {
+        if (il->loadCount == NHOISTEDLOADS) {
+            return;
+        }
+
+        // The name cannot clash with an identifier in the program
+        snprintf(name, sizeof(name), ".licm%d", ++tempNumber);
+        id = addLocalSymbol(name, type, S_VARIABLE, 0, 0);
+        if (n->op == A_IDENTIFIER) {
+            // A copy of a restrict pointer is as good as the original
+            SymbolTable[id].qualifiers =
+                SymbolTable[n->v.identifierIndex].qualifiers & Q_RESTRICT;
+            SymbolTable[id].targetQualifiers =
+                SymbolTable[n->v.identifierIndex].targetQualifiers;
+        }
+
+        // variable = load, just before the loop (after earlier hoists)
+        init = makeASTNode(A_ASSIGN, type, n, NULL,
+                           makeASTLeaf(A_IDENTIFIER, type, id), 0);
+        *il->slot = makeASTNode(A_GLUE, P_NONE, init, NULL, *il->slot, 0);
+        il->slot = &(*il->slot)->right;
+
+        il->loads[il->loadCount] = n;
+        il->ids[il->loadCount++] = id;
+    }
+
+    *np = makeASTLeaf(A_IDENTIFIER, type, id);
+    (*np)->isRvalue = true;
+}
+
+/**
+ * hoistLoads - Hoist the loop-invariant loads of a tree out of a loop.
+ *
+ * NOTE:
+ * Global and static variables are loaded from memory on every use, so
+ * they are hoisted too; locals are not, as a copy would be no cheaper.
+ * A load that could fault is only hoisted if the loop is sure to do it,
+ * so that hoisting adds no fault the program would not have had.
+ *
+ * @param np         Where the AST tree hangs.
+ * @param il         The loop.
+ * @param isExecuted True if the tree is executed whenever the loop is.
+ */
+static void hoistLoads(struct ASTnode **np, struct invariantLoop *il,
+                       bool isExecuted) {
+    struct ASTnode *n = *np;
+
+    if (n == NULL) {
+        return;
+    }
+
+    switch (n->op) {
+    case A_GLUE:
+        hoistLoads(&n->left, il, isExecuted);
+        hoistLoads(&n->right, il, isExecuted && !hasLoopExit(n->left));
+        return;
+    case A_IF:
+    case A_WHILE:
+        hoistLoads(&n->left, il, isExecuted);
+        hoistLoads(&n->middle, il, false);
+        hoistLoads(&n->right, il, false);
+        return;
+    case A_DOWHILE:
+        hoistLoads(&n->right, il, isExecuted);
+        hoistLoads(&n->left, il, false);
+        return;
+    case A_LOGICALAND:
+    case A_LOGICALOR:
+        hoistLoads(&n->left, il, isExecuted);
+        hoistLoads(&n->right, il, false);
+        return;
+    case A_IDENTIFIER:
+        if (SymbolTable[n->v.identifierIndex].class == C_LOCAL ||
+            isStructType(n->primitiveType)) {
+            return;
+        }
+        // Fall through
+    case A_DEREFERENCE:
+        if (n->isRvalue && isLoopInvariant(n, il) &&
+            (isExecuted || isSafeToLoad(n))) {
+            hoistLoad(np, il);
+            return;
+        }
+        break;
+    }
+
+    hoistLoads(&n->left, il, isExecuted);
+    hoistLoads(&n->middle, il, isExecuted);
+    hoistLoads(&n->right, il, isExecuted);
+}
+
+/**
+ * runsAtLeastOnce - Check whether the condition of a while or for loop is
+ * true on entry, e.g. "for (i = 0; i < 8; i++)".
+ *
+ * @param loop     The A_WHILE node.
+ * @param previous The statement before the loop, or NULL.
+ *
+ * @return bool True if the body is executed at least once.
+ */
+static bool runsAtLeastOnce(struct ASTnode *loop, struct ASTnode *previous) {
+    struct ASTnode *cond = loop->left;
+    long start;
+    long limit;
+    int id;
+
+    if (getLiteral(cond, &limit)) {
+        return limit != 0;
+    }
+
+    while (previous != NULL && previous->op == A_GLUE) {
+        previous = previous->right;
+    }
+    if (previous == NULL || previous->op != A_ASSIGN ||
+        previous->right->op != A_IDENTIFIER ||
+        !getLiteral(previous->left, &start)) {
+        return false;
+    }
+    id = previous->right->v.identifierIndex;
+    if (!isIdentifierOf(cond->left, id) || !getLiteral(cond->right, &limit)) {
+        return false;
+    }
+
+    switch (cond->op) {
+    case A_EQ:
+        return start == limit;
+    case A_NE:
+        return start != limit;
+    case A_LT:
+        return start < limit;
+    case A_GT:
+        return start > limit;
+    case A_LE:
+        return start <= limit;
+    case A_GE:
+        return start >= limit;
+    default:
+        return false;
+    }
+}
+
+/**
+ * hoistInvariantLoads - Move the loads of a loop whose value cannot change
+ * while it runs to just before the loop (loop-invariant code motion).
+ *
+ * NOTE:
+ * In
+ *     for (i = 0; i < n; i++) { out[i] = in[0] * scale; }
+ * "in[0]" and "scale" are loaded once into hidden locals, as the alias
+ * analysis shows that no store to "out" can change them. With
+ * "int *restrict src, *restrict dst", "*src" is hoisted out of a loop
+ * storing through "dst" in the same way.
+ *
+ * @param slot     Where the A_WHILE or A_DOWHILE node hangs in the tree.
+ * @param previous The statement before the loop, or NULL.
+ */
+static void hoistInvariantLoads(struct ASTnode **slot,
+                                struct ASTnode *previous) {
+    struct invariantLoop il = {0};
+    struct ASTnode *loop = *slot;
+
+    il.slot = slot;
+    if (!collectStores(loop, &il)) {
+        return;
+    }
+
+    if (loop->op == A_WHILE) {
+        hoistLoads(&loop->left, &il, true);
+        hoistLoads(&loop->right, &il, runsAtLeastOnce(loop, previous));
+        hoistLoads(&loop->middle, &il, false);
+    } else {
+        hoistLoads(&loop->right, &il, true);
+        hoistLoads(&loop->left, &il, !hasLoopExit(loop->right));
+    }
+}
+
+// What the variables of an affine address may do
+struct affineContext {
+    struct ASTnode *region; // Any other variable must be unchanged in it
+    int ids[NNESTLOOPS];    // Induction variables of the enclosing loops
+    int idCount;
+};
+
+/**
+ * getAffineStride - Get how much an address changes when one induction
+ * variable grows by one.
+ *
+ * NOTE:
+ * The address must be affine in the induction variables of the enclosing
+ * loops: a sum of variables, constants and addresses of variables,
+ * scaled by constants. Any other variable it reads must not be changed
+ * in the region. It must not load through a pointer, call or divide, so
+ * that computing it ahead of time cannot fault.
+ *
+ * @param n      The address expression.
+ * @param ac     The induction variables and the region.
+ * @param id     Symbol table ID of the induction variable.
+ * @param stride Where to store the change in bytes.
+ *
+ * @return bool True if n is such an address.
+ */
+static bool getAffineStride(struct ASTnode *n, struct affineContext *ac,
+                            int id, long *stride) {
+    long left;
+    long right;
+    long c;
+
+    switch (n->op) {
+    case A_INTEGERLITERAL:
+    case A_ADDRESSOF:
+        *stride = 0;
+        return true;
+    case A_IDENTIFIER:
+        *stride = (n->v.identifierIndex == id) ? 1 : 0;
+        for (int i = 0; i < ac->idCount; i++) {
+            if (ac->ids[i] == n->v.identifierIndex) {
+                return true;
+            }
+        }
+        return !(SymbolTable[n->v.identifierIndex].qualifiers & Q_VOLATILE) &&
+               !isWritten(ac->region, n->v.identifierIndex);
+    case A_ADD:
+    case A_SUBTRACT:
+        if (!getAffineStride(n->left, ac, id, &left) ||
+            !getAffineStride(n->right, ac, id, &right)) {
+            return false;
+        }
+        *stride = (n->op == A_ADD) ? left + right : left - right;
+        return true;
+    case A_MULTIPLY:
+        // One side is a constant
+        if (getLiteral(n->right, &c)) {
+            if (!getAffineStride(n->left, ac, id, &left)) {
+                return false;
+            }
+        } else if (!getLiteral(n->left, &c) ||
+                   !getAffineStride(n->right, ac, id, &left)) {
+            return false;
+        }
+        *stride = left * c;
+        return true;
+    case A_LSHIFT:
+        if (!getLiteral(n->right, &c) || c < 0 || c > 31 ||
+            !getAffineStride(n->left, ac, id, &left)) {
+            return false;
+        }
+        *stride = left << c;
+        return true;
+    case A_SCALETYPE:
+        if (!getAffineStride(n->left, ac, id, &left)) {
+            return false;
+        }
+        *stride = left * n->v.size;
+        return true;
+    case A_WIDENTYPE:
+        return getAffineStride(n->left, ac, id, stride);
+    default:
+        return false;
+    }
+}
+
+// The for loop whose strided accesses are being prefetched
+struct prefetchLoop {
+    struct affineContext context; // The loop and its induction variable
+    long step;                    // Amount added by the post-operation
+    struct ASTnode *prefetches[NPREFETCHES]; // A_PREFETCH nodes so far
+    int prefetchCount;
+};
+
+/**
+ * addPrefetch - Make a prefetch of the memory a loop accesses some
+ * iterations ahead, unless the loop already prefetches that address.
+ *
+ * NOTE:
+ * The prefetch runs Option_prefetchDistance bytes ahead, rounded to a
+ * whole number of iterations (at least one).
+ *
+ * @param n       The A_DEREFERENCE node of the access.
+ * @param pl      The loop.
+ * @param isWrite True if the access is a store.
+ */
+static void addPrefetch(struct ASTnode *n, struct prefetchLoop *pl,
+                        bool isWrite) {
+    struct ASTnode *address;
+    long stride;
+    long iterations;
+    long offset;
+
+    if (!getAffineStride(n->left, &pl->context, pl->context.ids[0],
+                         &stride) ||
+        (stride *= pl->step) == 0) {
+        return;
+    }
+
+    for (int i = 0; i < pl->prefetchCount; i++) {
+        if (isSameAST(pl->prefetches[i]->left->left, n->left)) {
+            if (isWrite) {
+                pl->prefetches[i]->v.intvalue |= PREFETCH_WRITE;
+            }
+            return;
+        }
+    }
+    if (pl->prefetchCount == NPREFETCHES) {
+        return;
+    }
+
+    iterations = Option_prefetchDistance / labs(stride);
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    offset = stride * iterations + n->v.offset;
+    if (offset < INT_MIN || offset > INT_MAX) {
+        return;
+    }
+
+    // address + offset (in bytes)
+    address = makeASTNode(A_ADD, n->left->primitiveType, cloneAST(n->left),
+                          NULL, makeASTLeaf(A_INTEGERLITERAL, P_LONG, offset),
+                          0);
+    pl->prefetches[pl->prefetchCount++] = makeASTUnary(
+        A_PREFETCH, P_VOID, address, 3 + (isWrite ? PREFETCH_WRITE : 0));
+}
+
+/**
+ * collectPrefetches - Make the prefetches for the strided accesses of a
+ * tree.
+ *
+ * NOTE:
+ * Loops nested in the tree are left alone: their own accesses advance
+ * with their own induction variables.
+ *
+ * @param n  The AST tree.
+ * @param pl The loop.
+ */
+static void collectPrefetches(struct ASTnode *n, struct prefetchLoop *pl) {
+    if (n == NULL || n->op == A_WHILE || n->op == A_DOWHILE) {
+        return;
+    }
+
+    // NOTE: Assignments have the LHS in the right child
+    if (isAssignmentASTop(n->op) && n->right->op == A_DEREFERENCE) {
+        addPrefetch(n->right, pl, true);
+    } else if (n->op == A_DEREFERENCE && !isVectorType(n->primitiveType)) {
+        addPrefetch(n, pl, false);
+    }
+
+    collectPrefetches(n->left, pl);
+    collectPrefetches(n->middle, pl);
+    collectPrefetches(n->right, pl);
+}
+
+/**
+ * insertPrefetches - Prefetch the array elements a counted for loop will
+ * access a few iterations later (software prefetching).
+ *
+ * NOTE:
+ * In
+ *     for (i = 0; i < n; i++) { sum = sum + a[i]; }
+ * with --prefetch-distance=256, the body first prefetches the address of
+ * a[i] plus 256 bytes, so that the cache line 64 elements ahead is on its
+ * way while this one is used. Only accesses whose address
+ * moves by a constant stride on each iteration are prefetched. The loop
+ * condition must test the induction variable, which the loop may change
+ * only in its post-operation, as for reduceInductionVariable.
+ * The prefetches go before reduceInductionVariable, which then also
+ * reduces the products in their addresses.
+ *
+ * @param loop The A_WHILE node of the loop.
+ */
+static void insertPrefetches(struct ASTnode *loop) {
+    struct prefetchLoop pl = {0};
+    struct ASTnode *cond = loop->left;
+    struct ASTnode *prefetches = NULL;
+    int id;
+
+    pl.context.region = loop;
+    pl.context.idCount = 1;
+    if (!getInductionStep(loop->middle, &id, &pl.step) ||
+        cond->op < A_EQ || cond->op > A_GE ||
+        (!isIdentifierOf(cond->left, id) && !isIdentifierOf(cond->right, id))) {
+        return;
+    }
+    if (SymbolTable[id].class != C_LOCAL ||
+        SymbolTable[id].structuralType != S_VARIABLE ||
+        (SymbolTable[id].qualifiers & Q_VOLATILE) ||
+        !isIntegerType(SymbolTable[id].primitiveType) ||
+        SymbolTable[id].isAddressTaken || isWritten(loop->left, id) ||
+        isWritten(loop->right, id)) {
+        return;
+    }
+    pl.context.ids[0] = id;
+
+    collectPrefetches(loop->right, &pl);
+    for (int i = pl.prefetchCount - 1; i >= 0; i--) {
+        prefetches = (prefetches == NULL)
+                         ? pl.prefetches[i]
+                         : makeASTNode(A_GLUE, P_NONE, pl.prefetches[i], NULL,
+                                       prefetches, 0);
+    }
+    if (prefetches != NULL) {
+        loop->right =
+            makeASTNode(A_GLUE, P_NONE, prefetches, NULL, loop->right, 0);
+    }
+}
+
+// A counted for loop, "for (id = start; id <op> bound; post)" where op is
+// <, <=, > or >= and post steps id by a constant
+struct countedLoop {
+    struct ASTnode *loop; // The A_WHILE node
+    int id;               // Symbol ID of the induction variable
+    long step;            // Amount added by the post-operation
+    long tripCount;       // Number of iterations, or -1 if not constant
+    long low;             // Smallest and largest values of the variable
+    long high;            // in the body (if tripCount > 0)
+};
+
+// Where in a loop nest a tree is
+struct nestPosition {
+    int loops[NNESTLOOPS]; // The loops around it (indices in the nest),
+    int depth;             // outermost first
+    int part;              // For fusion, which of the two loops it is in
+};
+
+// A load or store made in a loop nest
+struct nestAccess {
+    struct ASTnode *n; // The A_IDENTIFIER, ++/-- or A_DEREFERENCE node
+    struct memoryAccess access;
+    bool isStore;
+    struct nestPosition position;
+};
+
+// A loop nest being interchanged or fused
+struct loopNest {
+    struct ASTnode *region; // The loops of the nest
+    struct countedLoop loops[NNESTLOOPS];
+    int loopCount;
+    struct nestAccess accesses[NNESTACCESSES];
+    int accessCount;
+};
+
+/**
+ * isForLoop - Check whether a tree is a for loop, i.e. the A_GLUE of its
+ * pre-operation and its A_WHILE (which has a post-operation).
+ *
+ * @param n The AST tree.
+ *
+ * @return bool True if n is a for loop.
+ */
+static bool isForLoop(struct ASTnode *n) {
+    return n != NULL && n->op == A_GLUE && n->right != NULL &&
+           n->right->op == A_WHILE && n->right->middle != NULL;
+}
+
+/**
+ * getCountedLoop - Recognise a for loop that runs its induction variable
+ * from a start value to a bound by a constant step.
+ *
+ * NOTE:
+ * The induction variable must be a signed integer local whose address is
+ * never taken, changed only by the post-operation. With a constant start
+ * and bound, the trip count and the range of the variable are known.
+ *
+ * @param n  The for loop (see isForLoop).
+ * @param cl Where to store the description.
+ *
+ * @return bool True if n is a counted loop.
+ */
+static bool getCountedLoop(struct ASTnode *n, struct countedLoop *cl) {
+    struct ASTnode *init = n->left;
+    struct ASTnode *cond = n->right->left;
+    long start;
+    long bound;
+    int id;
+    int type;
+
+    cl->loop = n->right;
+    if (init == NULL || init->op != A_ASSIGN ||
+        init->right->op != A_IDENTIFIER ||
+        !getInductionStep(cl->loop->middle, &cl->id, &cl->step) ||
+        cl->id != init->right->v.identifierIndex || cl->step == 0 ||
+        cond->op < A_LT || cond->op > A_GE ||
+        !isIdentifierOf(cond->left, cl->id)) {
+        return false;
+    }
+
+    id = cl->id;
+    type = SymbolTable[id].primitiveType;
+    if (SymbolTable[id].class != C_LOCAL ||
+        SymbolTable[id].structuralType != S_VARIABLE ||
+        (SymbolTable[id].qualifiers & Q_VOLATILE) || !isIntegerType(type) ||
+        isUnsignedType(type) || SymbolTable[id].isAddressTaken ||
+        isWritten(cond, id) || isWritten(cl->loop->right, id)) {
+        return false;
+    }
+
+    cl->tripCount = -1;
+    if (!getLiteral(init->left, &start) || !getLiteral(cond->right, &bound)) {
+        return true;
+    }
+    switch (cond->op) {
+    case A_LT:
+        bound--;
+        // Fall through
+    case A_LE:
+        if (cl->step < 0) {
+            return true; // Runs until the variable wraps around
+        }
+        cl->tripCount = (start > bound) ? 0 : (bound - start) / cl->step + 1;
+        break;
+    case A_GT:
+        bound++;
+        // Fall through
+    default:
+        if (cl->step > 0) {
+            return true;
+        }
+        cl->tripCount = (start < bound) ? 0 : (start - bound) / -cl->step + 1;
+        break;
+    }
+
+    // The last value is not necessarily the bound
+    cl->low = start;
+    cl->high = start + (cl->tripCount - 1) * cl->step;
+    if (cl->step < 0) {
+        cl->low = cl->high;
+        cl->high = start;
+    }
+    return true;
+}
+
+/**
+ * addNestAccess - Record a load or store made in a loop nest.
+ *
+ * @param n        The AST node of the access.
+ * @param nest     The loop nest.
+ * @param position Where the access is.
+ * @param isStore  True for a store (or a read-modify-write).
+ *
+ * @return bool False if the access cannot be analysed: it is volatile,
+ *         or the nest makes too many accesses.
+ */
+static bool addNestAccess(struct ASTnode *n, struct loopNest *nest,
+                          struct nestPosition *position, bool isStore) {
+    struct nestAccess *a = &nest->accesses[nest->accessCount];
+
+    if (nest->accessCount == NNESTACCESSES ||
+        !describeMemoryAccess(n, &a->access) ||
+        (a->access.qualifiers & Q_VOLATILE)) {
+        return false;
+    }
+    a->n = n;
+    a->isStore = isStore;
+    a->position = *position;
+    nest->accessCount++;
+    return true;
+}
+
+/**
+ * collectNestAccesses - Record the loops of a loop nest and the loads and
+ * stores they make.
+ *
+ * NOTE:
+ * Every loop of the nest must be a counted loop without break, continue
+ * or return, and it may not call a function, make an atomic access or
+ * hold an asm statement, whose effects cannot be reordered. An induction
+ * variable may only be read in its loop, where it is not recorded.
+ *
+ * @param n        The AST tree.
+ * @param nest     The loop nest.
+ * @param position Where the tree is.
+ *
+ * @return bool False if the nest cannot be analysed.
+ */
+static bool collectNestAccesses(struct ASTnode *n, struct loopNest *nest,
+                                struct nestPosition position) {
+    struct ASTnode *target;
+    int loop;
+
+    if (n == NULL) {
+        return true;
+    }
+    if (isAtomicASTop(n->op)) {
+        return false;
+    }
+
+    // NOTE: Assignments have the LHS in the right child
+    if (isAssignmentASTop(n->op)) {
+        target = n->right;
+        return addNestAccess(target, nest, &position, true) &&
+               (target->op != A_DEREFERENCE ||
+                collectNestAccesses(target->left, nest, position)) &&
+               collectNestAccesses(n->left, nest, position);
+    }
+
+    switch (n->op) {
+    case A_FUNCTIONCALL:
+    case A_ASM:
+    case A_BREAK:
+    case A_CONTINUE:
+    case A_RETURN:
+    case A_WHILE:
+    case A_DOWHILE:
+        return false;
+    case A_GLUE:
+        if (!isForLoop(n)) {
+            break;
+        }
+        if (position.depth == NNESTLOOPS || nest->loopCount == NNESTLOOPS ||
+            !getCountedLoop(n, &nest->loops[nest->loopCount])) {
+            return false;
+        }
+        loop = nest->loopCount++;
+
+        // The start and the bound are read outside the loop
+        if (!collectNestAccesses(n->left->left, nest, position) ||
+            !collectNestAccesses(n->right->left->right, nest, position)) {
+            return false;
+        }
+        position.loops[position.depth++] = loop;
+        return collectNestAccesses(n->right->right, nest, position);
+    case A_IDENTIFIER:
+        for (int i = 0; i < position.depth; i++) {
+            if (nest->loops[position.loops[i]].id == n->v.identifierIndex) {
+                return true;
+            }
+        }
+        return addNestAccess(n, nest, &position, false);
+    case A_DEREFERENCE:
+        return addNestAccess(n, nest, &position, false) &&
+               collectNestAccesses(n->left, nest, position);
+    case A_POSTINCREMENT:
+    case A_POSTDECREMENT:
+        return addNestAccess(n, nest, &position, true);
+    case A_PREINCREMENT:
+    case A_PREDECREMENT:
+        target = stripWiden(n->left);
+        return addNestAccess(target, nest, &position, true) &&
+               (target->op != A_DEREFERENCE ||
+                collectNestAccesses(target->left, nest, position));
+    }
+
+    return collectNestAccesses(n->left, nest, position) &&
+           collectNestAccesses(n->middle, nest, position) &&
+           collectNestAccesses(n->right, nest, position);
+}
+
+/**
+ * hasStrayInductionAccess - Check whether a loop nest accesses an
+ * induction variable outside its loop (e.g. reads it after the loop).
+ *
+ * @param nest The loop nest.
+ *
+ * @return bool True if such an access was recorded.
+ */
+static bool hasStrayInductionAccess(struct loopNest *nest) {
+    struct ASTnode *n;
+
+    for (int i = 0; i < nest->accessCount; i++) {
+        n = nest->accesses[i].n;
+        if (n->op == A_DEREFERENCE) {
+            continue;
+        }
+        for (int j = 0; j < nest->loopCount; j++) {
+            if (nest->loops[j].id == n->v.identifierIndex) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * getAccessCoefficient - Get how much the address of an access in a loop
+ * nest changes when the induction variable of one of the loops around it
+ * grows by one.
+ *
+ * @param nest        The loop nest.
+ * @param a           The access.
+ * @param level       The loop (0 for the outermost loop around a).
+ * @param coefficient Where to store the change in bytes.
+ *
+ * @return bool True if the address is affine (see getAffineStride).
+ */
+static bool getAccessCoefficient(struct loopNest *nest, struct nestAccess *a,
+                                 int level, long *coefficient) {
+    struct affineContext ac;
+
+    // A variable is always at the same address
+    if (a->n->op != A_DEREFERENCE) {
+        *coefficient = 0;
+        return true;
+    }
+    ac.region = nest->region;
+    ac.idCount = a->position.depth;
+    for (int i = 0; i < a->position.depth; i++) {
+        ac.ids[i] = nest->loops[a->position.loops[i]].id;
+    }
+    return getAffineStride(a->n->left, &ac,
+                           nest->loops[a->position.loops[level]].id,
+                           coefficient);
+}
+
+/**
+ * isSameAccess - Check whether two accesses have the same address
+ * expression and size.
+ *
+ * @param a The first A_DEREFERENCE node.
+ * @param b The second A_DEREFERENCE node.
+ *
+ * @return bool True if they access the same memory in the same iteration.
+ */
+static bool isSameAccess(struct ASTnode *a, struct ASTnode *b) {
+    return a->op == A_DEREFERENCE && b->op == A_DEREFERENCE &&
+           a->primitiveType == b->primitiveType && a->v.offset == b->v.offset &&
+           isSameAST(a->left, b->left);
+}
+
+/**
+ * usesVariable - Check whether a tree reads, writes or takes the address
+ * of a variable.
+ *
+ * @param n  The AST tree.
+ * @param id Symbol table ID of the variable.
+ *
+ * @return bool True if the variable appears in the tree.
+ */
+static bool usesVariable(struct ASTnode *n, int id) {
+    if (n == NULL) {
+        return false;
+    }
+    switch (n->op) {
+    case A_IDENTIFIER:
+    case A_ADDRESSOF:
+    case A_POSTINCREMENT:
+    case A_POSTDECREMENT:
+        if (n->v.identifierIndex == id) {
+            return true;
+        }
+        break;
+    }
+    return usesVariable(n->left, id) || usesVariable(n->middle, id) ||
+           usesVariable(n->right, id);
+}
+
+/**
+ * isSumOf - Check whether a variable is only used in a tree to add values
+ * up, e.g. "sum += a[i];" or "sum = sum - a[i];".
+ *
+ * NOTE:
+ * Each update must be a statement of its own, and the added value may not
+ * read the variable. The order of the additions then does not change the
+ * final value of an integer variable.
+ *
+ * @param n           The AST tree.
+ * @param id          Symbol table ID of the variable.
+ * @param isStatement True if n is a statement.
+ *
+ * @return bool True if every use of the variable is such an update.
+ */
+static bool isSumOf(struct ASTnode *n, int id, bool isStatement) {
+    struct ASTnode *value;
+
+    if (n == NULL) {
+        return true;
+    }
+
+    // NOTE: Assignments have the LHS in the right child
+    if (isAssignmentASTop(n->op) && isIdentifierOf(n->right, id)) {
+        value = stripWiden(n->left);
+        switch (isStatement ? n->op : A_NOTHING) {
+        case A_ASSIGNADD:
+        case A_ASSIGNSUBTRACT:
+            return !usesVariable(value, id);
+        case A_ASSIGN:
+            if ((value->op == A_ADD || value->op == A_SUBTRACT) &&
+                isIdentifierOf(value->left, id)) {
+                return !usesVariable(value->right, id);
+            }
+            return value->op == A_ADD && isIdentifierOf(value->right, id) &&
+                   !usesVariable(value->left, id);
+        default:
+            return false;
+        }
+    }
+
+    switch (n->op) {
+    case A_GLUE:
+        return isSumOf(n->left, id, true) && isSumOf(n->right, id, true);
+    case A_IF:
+        return !usesVariable(n->left, id) && isSumOf(n->middle, id, true) &&
+               isSumOf(n->right, id, true);
+    default:
+        return !usesVariable(n, id);
+    }
+}
+
+/**
+ * isInterchangeableStore - Check whether a store of a two-loop nest still
+ * gives the same result with the loops interchanged.
+ *
+ * NOTE:
+ * A variable must be an integer local whose address is never taken,
+ * only summed into (see isSumOf). Array elements and other memory may only
+ * alias accesses with the same address, and no two iterations (i, j) and
+ * (i', j') with i < i' and j > j', whose order interchange reverses, may
+ * reach that address: the address is then either the same all along one
+ * loop, or moves in opposite directions along the two loops, or one loop
+ * moves it by less than a single step of the other.
+ *
+ * @param nest The loop nest (loop 0 around loop 1).
+ * @param s    The store.
+ *
+ * @return bool True if the store allows the interchange.
+ */
+static bool isInterchangeableStore(struct loopNest *nest,
+                                   struct nestAccess *s) {
+    struct countedLoop *outer = &nest->loops[0];
+    struct countedLoop *inner = &nest->loops[1];
+    struct nestAccess *a;
+    long outerStride;
+    long innerStride;
+    int id;
+
+    if (s->n->op != A_DEREFERENCE) {
+        id = s->n->v.identifierIndex;
+        return s->n->op == A_IDENTIFIER &&
+               SymbolTable[id].class == C_LOCAL &&
+               isIntegerType(SymbolTable[id].primitiveType) &&
+               !SymbolTable[id].isAddressTaken &&
+               isSumOf(inner->loop->right, id, true);
+    }
+
+    for (int i = 0; i < nest->accessCount; i++) {
+        a = &nest->accesses[i];
+        if ((a == s || mayAlias(&s->access, &a->access)) &&
+            !isSameAccess(s->n, a->n)) {
+            return false;
+        }
+    }
+
+    // Per iteration
+    if (!getAccessCoefficient(nest, s, 0, &outerStride) ||
+        !getAccessCoefficient(nest, s, 1, &innerStride)) {
+        return false;
+    }
+    outerStride *= outer->step;
+    innerStride *= inner->step;
+
+    if (outerStride == 0 || innerStride == 0) {
+        return outerStride != innerStride;
+    }
+    return (outerStride > 0) != (innerStride > 0) ||
+           labs(innerStride) * (inner->tripCount - 1) < labs(outerStride) ||
+           labs(outerStride) * (outer->tripCount - 1) < labs(innerStride);
+}
+
+/**
+ * getStrideCost - Estimate the memory traffic of an access that moves by
+ * a stride on every iteration.
+ *
+ * @param stride The stride in bytes.
+ *
+ * @return long The bytes fetched per iteration: a whole cache line once
+ *         the stride reaches one.
+ */
+static long getStrideCost(long stride) {
+    return (labs(stride) < CACHELINESIZE) ? labs(stride) : CACHELINESIZE;
+}
+
+/**
+ * interchangeLoops - Swap a loop and the loop nested in it, so that the
+ * inner loop walks memory with the smaller stride (loop interchange).
+ *
+ * NOTE:
+ * In
+ *     for (j = 0; j < 100; j++) {
+ *         for (i = 0; i < 100; i++) { sum += grid[i][j]; }
+ *     }
+ * the inner loop goes down a column of a row-major array, touching a new
+ * cache line on every iteration. With the loops swapped it goes along a
+ * row. Only a perfect nest of two counted loops with constant bounds is
+ * interchanged, and the inner loop must not hold another loop. Both
+ * loops run at least once, so the induction variables end with the same
+ * values. The stores must allow the new order (see
+ * isInterchangeableStore).
+ *
+ * @param n The outer for loop.
+ */
+static void interchangeLoops(struct ASTnode *n) {
+    static struct loopNest nest;
+    struct nestPosition position = {0};
+    struct ASTnode *inner = n->right->right;
+    struct ASTnode *swap;
+    long outerCost = 0;
+    long innerCost = 0;
+    long outerStride;
+    long innerStride;
+
+    if (!isForLoop(inner)) {
+        return;
+    }
+    nest.region = n;
+    nest.loopCount = 0;
+    nest.accessCount = 0;
+    if (!collectNestAccesses(n, &nest, position) || nest.loopCount != 2 ||
+        nest.loops[0].tripCount < 1 || nest.loops[1].tripCount < 1 ||
+        hasStrayInductionAccess(&nest)) {
+        return;
+    }
+
+    for (int i = 0; i < nest.accessCount; i++) {
+        if (nest.accesses[i].isStore &&
+            !isInterchangeableStore(&nest, &nest.accesses[i])) {
+            return;
+        }
+        if (getAccessCoefficient(&nest, &nest.accesses[i], 0,
+                                 &outerStride) &&
+            getAccessCoefficient(&nest, &nest.accesses[i], 1,
+                                 &innerStride)) {
+            outerCost += getStrideCost(outerStride * nest.loops[0].step);
+            innerCost += getStrideCost(innerStride * nest.loops[1].step);
+        }
+    }
+    if (outerCost >= innerCost) {
+        return;
+    }
+
+    // Swap the pre-operations, conditions and post-operations
+    swap = n->left;
+    n->left = inner->left;
+    inner->left = swap;
+    swap = n->right->left;
+    n->right->left = inner->right->left;
+    inner->right->left = swap;
+    swap = n->right->middle;
+    n->right->middle = inner->right->middle;
+    inner->right->middle = swap;
+}
+
+/**
+ * getInductionRange - Find the values an induction variable takes around
+ * an access in a loop nest.
+ *
+ * @param nest The loop nest.
+ * @param a    The access.
+ * @param id   Symbol table ID of the induction variable.
+ * @param low  Where to store the smallest value.
+ * @param high Where to store the largest value.
+ *
+ * @return bool True if a loop around the access has that variable and a
+ *         constant, non-zero trip count.
+ */
+static bool getInductionRange(struct loopNest *nest, struct nestAccess *a,
+                              int id, long *low, long *high) {
+    struct countedLoop *loop;
+
+    for (int i = 0; i < a->position.depth; i++) {
+        loop = &nest->loops[a->position.loops[i]];
+        if (loop->id == id && loop->tripCount > 0) {
+            *low = loop->low;
+            *high = loop->high;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * isSeparated - Check whether two accesses with the same address, in the
+ * two loops being fused, reach different memory in different iterations.
+ *
+ * NOTE:
+ * The address must move by more from one iteration of the fused loop to
+ * the next than the loops nested in the bodies can move it.
+ *
+ * @param nest The loop nest (loop 0 is the fused loop).
+ * @param x    The access in the first loop.
+ * @param y    The access in the second loop.
+ *
+ * @return bool True if the accesses only meet in the same iteration.
+ */
+static bool isSeparated(struct loopNest *nest, struct nestAccess *x,
+                        struct nestAccess *y) {
+    struct countedLoop *loop;
+    long coefficient;
+    long spread = 0;
+    long low;
+    long high;
+
+    for (int i = 1; i < x->position.depth; i++) {
+        loop = &nest->loops[x->position.loops[i]];
+        if (!getAccessCoefficient(nest, x, i, &coefficient)) {
+            return false;
+        }
+        if (coefficient == 0) {
+            continue;
+        }
+        if (loop->tripCount < 1 ||
+            !getInductionRange(nest, y, loop->id, &low, &high)) {
+            return false;
+        }
+        low = (loop->low < low) ? loop->low : low;
+        high = (loop->high > high) ? loop->high : high;
+        spread += labs(coefficient) * (high - low);
+    }
+
+    return getAccessCoefficient(nest, x, 0, &coefficient) &&
+           labs(coefficient * nest->loops[0].step) > spread;
+}
+
+/**
+ * isInvariantIn - Check whether an expression has the same value
+ * throughout a tree.
+ *
+ * @param n      The expression.
+ * @param region The AST tree.
+ *
+ * @return bool True for constants, and arithmetic on variables the tree
+ *         does not change.
+ */
+static bool isInvariantIn(struct ASTnode *n, struct ASTnode *region) {
+    switch (n->op) {
+    case A_INTEGERLITERAL:
+        return true;
+    case A_IDENTIFIER:
+        return !(SymbolTable[n->v.identifierIndex].qualifiers & Q_VOLATILE) &&
+               !isWritten(region, n->v.identifierIndex);
+    case A_ADD:
+    case A_SUBTRACT:
+    case A_MULTIPLY:
+        return isInvariantIn(n->left, region) &&
+               isInvariantIn(n->right, region);
+    case A_WIDENTYPE:
+        return isInvariantIn(n->left, region);
+    default:
+        return false;
+    }
+}
+
+/**
+ * fuseLoops - Merge a for loop into the identical for loop just before it,
+ * so that the data both use streams through the cache once (loop fusion).
+ *
+ * NOTE:
+ * In
+ *     for (i = 0; i < n; i++) { a[i] = b[i] * 2; }
+ *     for (i = 0; i < n; i++) { c[i] = a[i] + 1; }
+ * the second body joins the first one, and a[i] is read back while still
+ * in the cache. The loops must have the same pre-operation, condition and
+ * post-operation, and neither may change the start or the bound. The
+ * second body of an iteration now runs before the first body of the later
+ * ones: a store of either body may only alias accesses of the other with
+ * the same address, and that address must be different in every
+ * iteration (see isSeparated).
+ *
+ * @param first  The first for loop.
+ * @param second The second for loop.
+ *
+ * @return bool True if the second loop was merged into the first.
+ */
+static bool fuseLoops(struct ASTnode *first, struct ASTnode *second) {
+    static struct loopNest nest;
+    struct nestPosition position = {0};
+    struct countedLoop secondLoop;
+    struct nestAccess *x;
+    struct nestAccess *y;
+
+    if (!isSameAST(first->left, second->left) ||
+        !isSameAST(first->right->left, second->right->left) ||
+        !isSameAST(first->right->middle, second->right->middle)) {
+        return false;
+    }
+
+    nest.region = makeASTNode(A_GLUE, P_NONE, first, NULL, second, 0);
+    nest.loopCount = 0;
+    nest.accessCount = 0;
+    if (!collectNestAccesses(first, &nest, position) ||
+        !getCountedLoop(second, &secondLoop) ||
+        !isInvariantIn(first->left->left, nest.region) ||
+        !isInvariantIn(first->right->left->right, nest.region)) {
+        return false;
+    }
+    // The second body, as if already in the first loop
+    position.loops[position.depth++] = 0;
+    position.part = 1;
+    if (!collectNestAccesses(second->right->right, &nest, position) ||
+        hasStrayInductionAccess(&nest)) {
+        return false;
+    }
+
+    for (int i = 0; i < nest.accessCount; i++) {
+        x = &nest.accesses[i];
+        for (int j = 0; j < nest.accessCount; j++) {
+            y = &nest.accesses[j];
+            if (x->position.part != 0 || y->position.part != 1 ||
+                (!x->isStore && !y->isStore) ||
+                !mayAlias(&x->access, &y->access)) {
+                continue;
+            }
+            if (!isSameAccess(x->n, y->n) || !isSeparated(&nest, x, y)) {
+                return false;
+            }
+        }
+    }
+
+    first->right->right = makeASTNode(A_GLUE, P_NONE, first->right->right,
+                                      NULL, second->right->right, 0);
+    return true;
+}
+
+/**
+ * restructureLoops - Interchange and fuse the loops of a tree, innermost
+ * loops first.
+ *
+ * @param np Where the AST tree hangs.
+ */
+static void restructureLoops(struct ASTnode **np) {
+    struct ASTnode *n = *np;
+    struct ASTnode *previous;
+
+    if (n == NULL) {
+        return;
+    }
+
+    restructureLoops(&n->left);
+    restructureLoops(&n->middle);
+    restructureLoops(&n->right);
+
+    if (isForLoop(n)) {
+        interchangeLoops(n);
+        return;
+    }
+    if (n->op != A_GLUE || !isForLoop(n->right)) {
+        return;
+    }
+
+    // In a statement list, the statement before a loop ends the left tree
+    previous = n->left;
+    if (!isForLoop(previous) && previous != NULL && previous->op == A_GLUE) {
+        previous = previous->right;
+    }
+    if (isForLoop(previous) && fuseLoops(previous, n->right)) {
+        *np = n->left;
+        // Loops of the two bodies may now be adjacent
+        restructureLoops(&previous->right->right);
+    }
+}
+
+/**
+ * optimizeLoops - Apply the loop optimizations to every loop of a tree,
+ * innermost loops first.
+ *
+ * @param np       Where the AST tree hangs.
+ * @param previous The statement before the tree, or NULL.
+ */
+static void optimizeLoops(struct ASTnode **np, struct ASTnode *previous) {
+    struct ASTnode *n = *np;
+
+    if (n == NULL) {
+        return;
+    }
+
+    optimizeLoops(&n->left, NULL);
+    optimizeLoops(&n->middle, NULL);
+    optimizeLoops(&n->right, (n->op == A_GLUE) ? n->left : NULL);
+
+    if (n->op != A_WHILE && n->op != A_DOWHILE) {
+        return;
+    }
+    hoistInvariantLoads(np, previous);
+
+    // The loop now hangs below the hoisted loads
+    while ((*np)->op == A_GLUE) {
+        np = &(*np)->right;
+    }
+    // Only for loops have a post-operation
+    if (n->op == A_WHILE && n->middle != NULL) {
+        if (Option_prefetchDistance > 0) {
+            insertPrefetches(n);
+        }
+        reduceInductionVariable(np);
+    }
+}
+
+/**
+ * foldConstantGlobals - Replace the loads of global variables that always
+ * hold their initial value with that value (see classifyGlobalVariables()).
+ *
+ * NOTE:
+ * This runs first, so that e.g. a loop bound read from such a variable is
+ * a constant for the loop optimizations.
+ *
+ * @param n The AST tree.
+ */
+static void foldConstantGlobals(struct ASTnode *n) {
+    if (n == NULL) {
+        return;
+    }
+
+    if (n->op == A_IDENTIFIER && n->isRvalue &&
+        SymbolTable[n->v.identifierIndex].isConstant) {
+        n->op = A_INTEGERLITERAL;
+        n->v.intvalue = SymbolTable[n->v.identifierIndex].initialValue;
+        return;
+    }
+
+    foldConstantGlobals(n->left);
+    foldConstantGlobals(n->middle);
+    foldConstantGlobals(n->right);
+}
+
+/**
+ * optimizeFunction - Rewrite a function's AST into a cheaper equivalent.
+ *
+ * @param n The A_FUNCTION AST node.
+ */
+void optimizeFunction(struct ASTnode *n) {
+    foldConstantGlobals(n->left);
+    restructureLoops(&n->left);
+    optimizeLoops(&n->left, NULL);
+}
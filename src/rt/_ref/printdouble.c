@@ -0,0 +1,64 @@
+// src/rt/_ref/printdouble.c
+
+/**
+ * NOTE:
+ * AARCH64 implementation: src/rt/aarch64/printdouble.s
+ * x86_64 implementation: src/rt/x86_64/printdouble.asm
+ *
+ * NOTE:
+ * The following code is a conceptual reference implementation in C.
+ * It is not used in the actual runtime.
+ *
+ * Prints like printf("%f\n", x): the sign, the integer part and six
+ * rounded decimals. NaN prints as "nan", and infinities as well as any
+ * value too large for a 64-bit integer part (|x| >= 2^63) print as "inf".
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+void printdouble(double x) {
+    char buf[64];
+    char *end = buf + 32;
+    char *p = end;
+    unsigned long bits;
+    unsigned long whole;
+    unsigned long fraction;
+    int negative;
+
+    memcpy(&bits, &x, sizeof(bits));
+    negative = bits >> 63;
+    bits &= ~(1UL << 63);
+    memcpy(&x, &bits, sizeof(x));
+
+    *--p = '\n';
+    if (x != x) {
+        p -= 3;
+        memcpy(p, "nan", 3);
+    } else if (bits >= 0x43e0000000000000UL) { // 2^63
+        p -= 3;
+        memcpy(p, "inf", 3);
+    } else {
+        whole = (unsigned long)x;
+        // Rounds to nearest, like the cvtsd2si/fcvtns in the assembly
+        fraction = (unsigned long)((x - (double)whole) * 1000000.0 + 0.5);
+        if (fraction >= 1000000) {
+            fraction -= 1000000;
+            whole++;
+        }
+        for (int i = 0; i < 6; i++) {
+            *--p = (char)('0' + fraction % 10);
+            fraction /= 10;
+        }
+        *--p = '.';
+        do {
+            *--p = (char)('0' + whole % 10);
+            whole /= 10;
+        } while (whole != 0);
+    }
+    if (negative) {
+        *--p = '-';
+    }
+
+    write(1, p, (size_t)(end - p));
+}
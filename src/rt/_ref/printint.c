@@ -30,6 +30,10 @@ void printint(long x) {
     char *end = buf + 32; // conceptually matches "rbp-1 ... rbp-32" region
     char *p = end;
 
+    // One write() for the digits and the newline, so lines printed by
+    // concurrent threads never interleave
+    *--p = '\n';
+
     long n = x;
     int negative = 0;
 
@@ -55,5 +59,4 @@ void printint(long x) {
     }
 
     write(1, p, (size_t)(end - p));
-    write(1, "\n", 1);
 }
@@ -0,0 +1,80 @@
+// src/rt/_ref/thread.c
+
+/**
+ * NOTE:
+ * AARCH64 implementation: src/rt/aarch64/thread.s
+ * x86_64 implementation: src/rt/x86_64/thread.asm
+ *
+ * NOTE:
+ * The following code is a conceptual reference implementation in C.
+ * It is not used in the actual runtime: the child half of clone() runs on
+ * a fresh stack, which only the assembly versions can set up safely.
+ */
+
+#define _GNU_SOURCE
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define STACK_SIZE 0x100000 // 1 MiB per thread
+
+/*
+ * NOTE:
+ * The control block sits at the top of the thread's stack, and its address
+ * is the thread id.
+ */
+struct threadControlBlock {
+    volatile int tid; // Set at clone, cleared and futex-woken at exit
+    long (*fn)(long);
+    long arg;
+    long result;
+};
+
+static void threadStart(struct threadControlBlock *t) {
+    t->result = t->fn(t->arg);
+    syscall(SYS_exit, 0); // Ends this thread only
+}
+
+long thread_spawn(long (*fn)(long), long arg) {
+    char *stack = mmap(NULL, STACK_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) {
+        return 0;
+    }
+
+    struct threadControlBlock *t =
+        (struct threadControlBlock *)(stack + STACK_SIZE) - 1;
+    t->fn = fn;
+    t->arg = arg;
+
+    long tid = syscall(SYS_clone,
+                       CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND |
+                           CLONE_THREAD | CLONE_SYSVSEM | CLONE_PARENT_SETTID |
+                           CLONE_CHILD_CLEARTID,
+                       t, &t->tid, &t->tid, 0);
+    if (tid == 0) {
+        threadStart(t); // New thread, now running on the new stack
+    }
+    if (tid < 0) {
+        munmap(stack, STACK_SIZE);
+        return 0;
+    }
+    return (long)t;
+}
+
+long thread_join(long id) {
+    struct threadControlBlock *t = (struct threadControlBlock *)id;
+    int tid;
+
+    // FUTEX_WAIT (not FUTEX_WAIT_PRIVATE): the kernel's wake-up at thread
+    // exit is a shared one
+    while ((tid = t->tid) != 0) {
+        syscall(SYS_futex, &t->tid, FUTEX_WAIT, tid, NULL);
+    }
+
+    long result = t->result;
+    munmap((char *)(t + 1) - STACK_SIZE, STACK_SIZE);
+    return result;
+}
@@ -0,0 +1,106 @@
+// src/rt/aarch64/printdouble.s
+
+// Linux aarch64
+// long printdouble(double x)
+// arg:  d0 = x
+// clobbers: x0-x17, x8, d0, d1
+// preserves: x19-x28 (we don't touch), and uses standard frame save/restore
+//
+// Prints like printf("%f\n", x): sign, integer part and six rounded
+// decimals. NaN prints as "nan"; infinities and |x| >= 2^63 (no 64-bit
+// integer part) print as "inf".
+
+    .text
+    .global printdouble
+
+printdouble:
+    // 64 bytes stack frame (multiple of 16); the text is built
+    // backwards from the top of the frame
+    stp x29, x30, [sp, -64]!
+    mov x29, sp
+
+    add x10, sp, #64          // end of frame (sp + 64)
+    mov x11, x10              // current write pointer, starts at end
+    mov w14, #10              // trailing newline
+    strb w14, [x11, #-1]!
+
+    // Split off the sign bit (so -0.0 prints as "-0.000000")
+    fmov x9, d0
+    lsr x15, x9, #63          // x15: sign flag, 0 = positive, 1 = negative
+    and x9, x9, #0x7fffffffffffffff
+    fmov d0, x9               // |x|
+
+    fcmp d0, d0               // only a NaN is unordered with itself
+    b.vs 7f
+    movz x12, #0x43e0, lsl #48 // 2^63: bits of positive doubles
+    cmp x9, x12               // compare like unsigned integers
+    b.hs 8f
+
+    fcvtzu x9, d0             // x9: integer part (truncated)
+    ucvtf d1, x9
+    fsub d0, d0, d1           // fraction in [0, 1)
+    movz x12, #0x4240         // x12 = 1000000
+    movk x12, #0x000f, lsl #16
+    ucvtf d1, x12
+    fmul d0, d0, d1
+    fcvtns x13, d0            // six decimals, rounded to nearest
+    cmp x13, x12              // 0.9999996 rounds up into the integer part
+    b.lo 1f
+    sub x13, x13, x12
+    add x9, x9, #1
+
+1:
+    mov x12, #10              // divisor (10)
+    mov w16, #6               // always six digits, with leading zeroes
+2:  // decimals
+    udiv x14, x13, x12        // x14 (quotient) = x13 / 10
+    msub x17, x14, x12, x13   // x17 (remainder) = x13 - x14 * 10
+    add x17, x17, #48         // convert to ASCII ('0' = 48)
+    strb w17, [x11, #-1]!
+    mov x13, x14
+    subs w16, w16, #1
+    b.ne 2b
+
+    mov w17, #46              // '.'
+    strb w17, [x11, #-1]!
+
+3:  // integer part
+    udiv x14, x9, x12
+    msub x17, x14, x12, x9
+    add x17, x17, #48
+    strb w17, [x11, #-1]!
+    mov x9, x14
+    cbnz x9, 3b
+    b 5f
+
+7:  // "nan"
+    mov w17, #110             // 'n'
+    strb w17, [x11, #-1]!
+    mov w17, #97              // 'a'
+    strb w17, [x11, #-1]!
+    mov w17, #110             // 'n'
+    strb w17, [x11, #-1]!
+    b 5f
+
+8:  // "inf"
+    mov w17, #102             // 'f'
+    strb w17, [x11, #-1]!
+    mov w17, #110             // 'n'
+    strb w17, [x11, #-1]!
+    mov w17, #105             // 'i'
+    strb w17, [x11, #-1]!
+
+5:  // maybe sign
+    cbz x15, 6f
+    mov w17, #45              // '-'
+    strb w17, [x11, #-1]!
+
+6:  // write(1, start, end - start)
+    mov x0, #1                // x0 (1st argument): fd = stdout
+    mov x1, x11               // x1 (2nd argument): buf
+    sub x2, x10, x11          // x2 (3rd argument): len
+    mov x8, #64               // x8 (syscall number): SYS_WRITE
+    svc #0
+
+    ldp x29, x30, [sp], 64
+    ret
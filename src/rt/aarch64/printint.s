@@ -5,6 +5,9 @@
 // arg:  x0 = x
 // clobbers: x0-x15, x8
 // preserves: x19-x28 (we don't touch), and uses standard frame save/restore
+//
+// The digits and the newline go out in a single write(), so lines printed
+// by concurrent threads never interleave.
 
     .text
     .global printint
@@ -14,8 +17,6 @@
 minstr:
     .ascii "-9223372036854775808\n"
 minlen = . - minstr
-newline:
-    .ascii "\n"
 
     .text
 
@@ -62,6 +63,8 @@ printint:
     // buffer: use the top of our frame (end = sp+96)
     add x10, sp, #96          // end of frame (sp + 96)
     mov x11, x10              // current write pointer, starts at end
+    mov w14, #10              // '\n'
+    strb w14, [x11, #-1]!     // trailing newline (pre-decrement, then store)
     mov x12, #10              // divisor (10)
 
     // handle 0
@@ -93,14 +96,6 @@ printint:
     mov x8, #64               // x8 (syscall number): SYS_WRITE
     svc #0                    // execute the system call! >_<
 
-    // write newline
-    mov x0, #1
-    adrp x1, newline
-    add  x1, x1, :lo12:newline
-    mov x2, #1
-    mov x8, #64
-    svc #0
-
     ldp x29, x30, [sp], 96
     ret
 
@@ -3,7 +3,7 @@
 // Linux aarch64
 // Exports: _start
 // Calls: main
-// Exits with main's return value
+// Exits with main's return value, ending every thread of the process
 
     .text
     .global _start
@@ -11,6 +11,6 @@
 
 _start:
     bl    main            // w0 = return value
-    mov   x8, #93         // __NR_exit
+    mov   x8, #94         // __NR_exit_group (exit ends one thread only)
     svc   #0
 
@@ -0,0 +1,125 @@
+// src/rt/aarch64/thread.s
+
+// Linux aarch64
+// long thread_spawn(long (*fn)(long), long arg)
+// arg:  x0 = fn, x1 = arg
+// ret:  x0 = thread id (0 if no thread could be created)
+//
+// long thread_join(long id)
+// arg:  x0 = id returned by thread_spawn
+// ret:  x0 = the value fn returned
+//
+// Every thread runs fn(arg) on its own mmap'd stack. A small control block
+// sits at the top of that stack, and its address is the thread id:
+//   [id+0]   tid word: written by the kernel at clone (CLONE_PARENT_SETTID),
+//            cleared and futex-woken when the thread exits
+//            (CLONE_CHILD_CLEARTID)
+//   [id+8]   fn
+//   [id+16]  arg
+//   [id+24]  fn's return value
+// thread_join sleeps on the tid word until it is 0, then unmaps the stack.
+
+    .text
+    .global thread_spawn
+    .global thread_join
+
+    .equ STACK_SIZE, 0x100000 // 1 MiB per thread
+    .equ TCB_SIZE, 32         // control block (keeps the stack 16-aligned)
+    .equ PROT_RW, 0x3         // PROT_READ | PROT_WRITE
+    .equ FUTEX_WAIT, 0        // shared, to match the kernel's wake-up
+
+thread_spawn:
+    stp x29, x30, [sp, -32]!
+    mov x29, sp
+    stp x19, x20, [sp, 16]
+    mov x19, x0               // fn
+    mov x20, x1               // arg
+
+    // mmap(NULL, STACK_SIZE, PROT_RW, MAP_FLAGS, -1, 0)
+    mov x0, #0
+    mov x1, #STACK_SIZE
+    mov x2, #PROT_RW
+    movz x3, #0x0022          // MAP_PRIVATE | MAP_ANONYMOUS
+    movk x3, #0x2, lsl #16    // | MAP_STACK
+    mov x4, #-1
+    mov x5, #0
+    mov x8, #222              // SYS_mmap
+    svc #0
+    cmn x0, #4095             // -4095..-1 is -errno
+    b.hs 2f
+
+    // Fill in the control block (the tid word is already 0)
+    add x9, x0, #STACK_SIZE
+    sub x9, x9, #TCB_SIZE
+    stp x19, x20, [x9, 8]
+    mov x19, x9               // x19 = id, kept by both threads
+
+    // clone(CLONE_FLAGS, stack=id, parent_tid=id, tls=0, child_tid=id)
+    movz x0, #0x0f00          // CLONE_VM | CLONE_FS | CLONE_FILES |
+                              // CLONE_SIGHAND
+    movk x0, #0x3d, lsl #16   // | CLONE_THREAD | CLONE_SYSVSEM |
+                              // CLONE_PARENT_SETTID | CLONE_CHILD_CLEARTID
+    mov x1, x9                // the child's stack grows down from the block
+    mov x2, x9
+    mov x3, #0
+    mov x4, x9
+    mov x8, #220              // SYS_clone
+    svc #0
+    cbz x0, 4f                // 0 in the new thread
+    tbnz x0, #63, 1f          // -errno
+
+    mov x0, x19               // return the id
+    b 3f
+
+1:  // munmap(stack, STACK_SIZE)
+    sub x0, x19, #STACK_SIZE
+    add x0, x0, #TCB_SIZE
+    mov x1, #STACK_SIZE
+    mov x8, #215              // SYS_munmap
+    svc #0
+
+2:  mov x0, #0                // no thread
+
+3:  ldp x19, x20, [sp, 16]
+    ldp x29, x30, [sp], 32
+    ret
+
+4:  // sp = id, 16-byte aligned
+    mov x29, #0               // outermost frame of this thread
+    ldp x9, x0, [x19, 8]      // fn, arg
+    blr x9                    // fn(arg)
+    str x0, [x19, 24]
+
+    // exit(0) ends this thread only; the kernel then clears the tid word
+    // and wakes the joiner
+    mov x0, #0
+    mov x8, #93               // SYS_exit
+    svc #0
+
+thread_join:
+    mov x9, x0                // id (svc keeps x1-x30)
+1:
+    ldar w2, [x9]             // tid word
+    cbz w2, 2f
+
+    // futex(&tid, FUTEX_WAIT, tid, NULL): returns at once (EAGAIN) if the
+    // thread exited in between
+    mov x0, x9
+    mov x1, #FUTEX_WAIT
+    mov x3, #0                // no timeout
+    mov x8, #98               // SYS_futex
+    svc #0
+    b 1b
+
+2:
+    ldr x10, [x9, 24]         // fn's return value
+
+    // munmap(stack, STACK_SIZE)
+    sub x0, x9, #STACK_SIZE
+    add x0, x0, #TCB_SIZE
+    mov x1, #STACK_SIZE
+    mov x8, #215              // SYS_munmap
+    svc #0
+
+    mov x0, x10
+    ret
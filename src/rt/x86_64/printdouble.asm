@@ -0,0 +1,110 @@
+; src/rt/x86_64/printdouble.asm
+
+; Linux x86_64
+; long printdouble(double x)
+; arg:  xmm0 = x
+; clobbers: rax, rcx, rdx, rsi, rdi, r8-r11, xmm0, xmm1
+; preserves: rbx, rbp, r12-r15 (we don't touch callee-saved regs except rbp)
+;
+; Prints like printf("%f\n", x): sign, integer part and six rounded
+; decimals. NaN prints as "nan"; infinities and |x| >= 2^63 (no 64-bit
+; integer part) print as "inf".
+
+global printdouble
+
+section .rodata
+million: dq 1000000.0
+
+section .text
+printdouble:
+    push    rbp
+    mov     rbp, rsp
+    sub     rsp, 64             ; scratch buffer (keeps alignment)
+
+    ; Build the text backwards into [rbp-1 .. rbp-32]
+    lea     r10, [rbp-1]        ; end ptr (one past last byte we use)
+    mov     r11, r10            ; current ptr
+    dec     r11
+    mov     byte [r11], 10      ; trailing newline
+
+    ; Split off the sign bit (so -0.0 prints as "-0.000000")
+    xor     r8d, r8d            ; negative = 0
+    movq    rax, xmm0
+    btr     rax, 63             ; clear the sign bit, CF = old sign
+    jnc     .positive
+    mov     r8d, 1              ; negative = 1
+.positive:
+    movq    xmm0, rax           ; |x|
+
+    ucomisd xmm0, xmm0          ; only a NaN is unordered with itself
+    jp      .nan
+    mov     rcx, 0x43e0000000000000 ; 2^63: bits of positive doubles
+    cmp     rax, rcx                ; compare like unsigned integers
+    jae     .inf
+
+    cvttsd2si rsi, xmm0         ; integer part (truncated)
+    cvtsi2sd xmm1, rsi
+    subsd   xmm0, xmm1          ; fraction in [0, 1)
+    mulsd   xmm0, [rel million]
+    cvtsd2si rax, xmm0          ; six decimals, rounded to nearest
+    cmp     rax, 1000000        ; 0.9999996 rounds up into the integer part
+    jb      .decimals
+    sub     rax, 1000000
+    inc     rsi
+
+.decimals:
+    mov     r9, 10              ; divisor
+    mov     ecx, 6              ; always six digits, with leading zeroes
+.decimal_loop:
+    xor     rdx, rdx
+    div     r9                  ; rax = quotient, rdx = remainder
+    add     dl, '0'
+    dec     r11
+    mov     [r11], dl
+    dec     ecx
+    jnz     .decimal_loop
+
+    dec     r11
+    mov     byte [r11], '.'
+
+    mov     rax, rsi            ; integer part
+.integer_loop:
+    xor     rdx, rdx
+    div     r9
+    add     dl, '0'
+    dec     r11
+    mov     [r11], dl
+    test    rax, rax            ; while quotient != 0
+    jne     .integer_loop
+    jmp     .maybe_sign
+
+.nan:
+    sub     r11, 3
+    mov     byte [r11], 'n'
+    mov     byte [r11+1], 'a'
+    mov     byte [r11+2], 'n'
+    jmp     .maybe_sign
+
+.inf:
+    sub     r11, 3
+    mov     byte [r11], 'i'
+    mov     byte [r11+1], 'n'
+    mov     byte [r11+2], 'f'
+
+.maybe_sign:
+    test    r8d, r8d            ; if the value is negative
+    jz      .write_num
+    dec     r11
+    mov     byte [r11], '-'
+
+.write_num:
+    ; write(stdout, start=r11, len=end-r11)
+    mov     eax, 1              ; __NR_write
+    mov     rdi, 1              ; stdout
+    mov     rsi, r11            ; start ptr
+    mov     rdx, r10
+    sub     rdx, r11            ; length (=end - start)
+    syscall
+
+    leave
+    ret
@@ -5,13 +5,15 @@
 ; arg:  rdi = x
 ; clobbers: rax, rcx, rdx, rsi, r8-r11
 ; preserves: rbx, rbp, r12-r15 (we don't touch callee-saved regs except rbp)
+;
+; The digits and the newline go out in a single write(), so lines printed
+; by concurrent threads never interleave.
 
 global printint
 
 section .rodata
 minstr: db "-9223372036854775808", 10
 minlen: equ $-minstr
-nl:     db 10
 
 section .text
 printint:
@@ -49,6 +51,8 @@ printint:
     ; Build digits backwards into [rbp-1 .. rbp-32]
     lea     r10, [rbp-1]        ; end ptr (one past last byte we use)
     mov     r11, r10            ; current ptr
+    dec     r11
+    mov     byte [r11], 10      ; trailing newline
 
     ; Handle 0
     test    rax, rax
@@ -84,13 +88,6 @@ printint:
     sub     rdx, r11            ; length (=end - start)
     syscall
 
-    ; write newline
-    mov     eax, 1
-    mov     rdi, 1
-    lea     rsi, [rel nl]
-    mov     edx, 1
-    syscall
-
     leave
     ret
 
@@ -3,18 +3,19 @@
 ; Linux x86_64
 ; Exports: _start
 ; Calls: main
-; Exits with main's return value
+; Exits with main's return value, ending every thread of the process
 
 global _start
 extern main
 
 section .text
 _start:
-    sub   rsp, 8          ; Align stack to 16 bytes
+    ; The ABI wants rsp 16-byte aligned at a call, so that every function's
+    ; rbp is too: 16-byte locals (vectors) are moved with movdqa
+    and   rsp, -16
     call  main           ; Call main function
-    add   rsp, 8          ; Restore stack
 
-    ; exit (status = eax)
+    ; exit_group (status = eax)
     mov   rdi, rax        ; Move return value of main to rdi (first argument to exit)
-    mov   rax, 60         ; syscall: exit
+    mov   rax, 231        ; syscall: exit_group (exit ends one thread only)
     syscall             ; Invoke kernel
@@ -0,0 +1,125 @@
+; src/rt/x86_64/thread.asm
+
+; Linux x86_64
+; long thread_spawn(long (*fn)(long), long arg)
+; arg:  rdi = fn, rsi = arg
+; ret:  rax = thread id (0 if no thread could be created)
+;
+; long thread_join(long id)
+; arg:  rdi = id returned by thread_spawn
+; ret:  rax = the value fn returned
+;
+; Every thread runs fn(arg) on its own mmap'd stack. A small control block
+; sits at the top of that stack, and its address is the thread id:
+;   [id+0]   tid word: written by the kernel at clone (CLONE_PARENT_SETTID),
+;            cleared and futex-woken when the thread exits
+;            (CLONE_CHILD_CLEARTID)
+;   [id+8]   fn
+;   [id+16]  arg
+;   [id+24]  fn's return value
+; thread_join sleeps on the tid word until it is 0, then unmaps the stack.
+
+global thread_spawn
+global thread_join
+
+%define STACK_SIZE  0x100000    ; 1 MiB per thread
+%define TCB_SIZE    32          ; control block (keeps the stack 16-aligned)
+%define PROT_RW     0x3         ; PROT_READ | PROT_WRITE
+%define MAP_FLAGS   0x20022     ; MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK
+%define CLONE_FLAGS 0x3d0f00    ; CLONE_VM | CLONE_FS | CLONE_FILES |
+                                ; CLONE_SIGHAND | CLONE_THREAD |
+                                ; CLONE_SYSVSEM | CLONE_PARENT_SETTID |
+                                ; CLONE_CHILD_CLEARTID
+%define FUTEX_WAIT  0           ; shared, to match the kernel's wake-up
+
+section .text
+thread_spawn:
+    push    rbx
+    push    r12
+    mov     rbx, rdi            ; fn
+    mov     r12, rsi            ; arg
+
+    ; mmap(NULL, STACK_SIZE, PROT_RW, MAP_FLAGS, -1, 0)
+    mov     eax, 9              ; __NR_mmap
+    xor     edi, edi
+    mov     esi, STACK_SIZE
+    mov     edx, PROT_RW
+    mov     r10d, MAP_FLAGS
+    mov     r8, -1
+    xor     r9d, r9d
+    syscall
+    cmp     rax, -4095          ; -4095..-1 is -errno
+    jae     .fail
+
+    ; Fill in the control block (the tid word is already 0)
+    lea     rdx, [rax+STACK_SIZE-TCB_SIZE]
+    mov     [rdx+8], rbx
+    mov     [rdx+16], r12
+    mov     rbx, rdx            ; rbx = id, kept by both threads
+
+    ; clone(CLONE_FLAGS, stack=id, parent_tid=id, child_tid=id, tls=0)
+    mov     eax, 56             ; __NR_clone
+    mov     edi, CLONE_FLAGS
+    mov     rsi, rdx            ; the child's stack grows down from the block
+    mov     r10, rdx
+    xor     r8d, r8d
+    syscall
+    test    rax, rax
+    jz      .child              ; 0 in the new thread
+    js      .unmap              ; -errno
+
+    mov     rax, rbx            ; return the id
+    pop     r12
+    pop     rbx
+    ret
+
+.unmap:
+    ; munmap(stack, STACK_SIZE)
+    mov     eax, 11             ; __NR_munmap
+    lea     rdi, [rbx-(STACK_SIZE-TCB_SIZE)]
+    mov     esi, STACK_SIZE
+    syscall
+
+.fail:
+    xor     eax, eax            ; no thread
+    pop     r12
+    pop     rbx
+    ret
+
+.child:
+    ; rsp = id, 16-byte aligned as a call site expects
+    mov     rdi, [rbx+16]
+    call    [rbx+8]             ; fn(arg)
+    mov     [rbx+24], rax
+
+    ; exit(0) ends this thread only; the kernel then clears the tid word
+    ; and wakes the joiner
+    mov     eax, 60             ; __NR_exit
+    xor     edi, edi
+    syscall
+
+thread_join:
+.wait:
+    mov     edx, [rdi]          ; tid word
+    test    edx, edx
+    jz      .done
+
+    ; futex(&tid, FUTEX_WAIT, tid, NULL): returns at once (EAGAIN) if the
+    ; thread exited in between
+    mov     eax, 202            ; __NR_futex
+    xor     esi, esi            ; FUTEX_WAIT
+    xor     r10d, r10d          ; no timeout
+    syscall
+    jmp     .wait
+
+.done:
+    mov     rdx, [rdi+24]       ; fn's return value (syscalls keep rdx)
+
+    ; munmap(stack, STACK_SIZE)
+    mov     eax, 11             ; __NR_munmap
+    sub     rdi, STACK_SIZE-TCB_SIZE
+    mov     esi, STACK_SIZE
+    syscall
+
+    mov     rax, rdx
+    ret
@@ -103,24 +103,82 @@ static int scanCharacter(void) {
 }
 
 /**
- * scanInteger - scan an integer literal from input
+ * scanFloat - scan the rest of a floating-point literal from input
  *
- * @param c The first character of the integer literal
+ * NOTE: The integer part (if any) has already been scanned into the
+ * buffer; c is the first character after it, i.e. a '.' or an exponent.
+ * An 'f' or 'F' suffix makes the literal a float, otherwise it is a
+ * double.
  *
- * @return The integer value of the scanned integer literal
+ * @param c The first character after the integer part
+ * @param buffer The buffer holding the integer part
+ * @param length The length of the integer part
+ * @param t The token to fill in
  */
-static int scanInteger(int c) {
-    int k = 0;
-    int value = 0;
+static void scanFloat(int c, char *buffer, int length, struct token *t) {
+    if (c == '.') {
+        do {
+            buffer[length++] = c;
+            c = next();
+        } while (isdigit(c) && length < TEXTLEN - 1);
+    }
 
-    while ((k = chrpos("0123456789", c)) >= 0) {
-        value = value * 10 + k;
+    if (c == 'e' || c == 'E') {
+        buffer[length++] = c;
         c = next();
+        if (c == '+' || c == '-') {
+            buffer[length++] = c;
+            c = next();
+        }
+        if (!isdigit(c)) {
+            logFatal("Malformed exponent in floating-point literal");
+        }
+        while (isdigit(c) && length < TEXTLEN - 1) {
+            buffer[length++] = c;
+            c = next();
+        }
+    }
+    buffer[length] = '\0';
+
+    t->token = T_FLOATLITERAL;
+    t->floatvalue = strtod(buffer, NULL);
+    t->intvalue = P_DOUBLE;
+    if (c == 'f' || c == 'F') {
+        t->floatvalue = (float)t->floatvalue;
+        t->intvalue = P_FLOAT;
+    } else {
+        putback(c);
     }
+}
+
+/**
+ * scanNumber - scan an integer or floating-point literal from input
+ *
+ * @param c The first character of the literal
+ * @param t The token to fill in
+ */
+static void scanNumber(int c, struct token *t) {
+    char buffer[TEXTLEN];
+    int length = 0;
 
-    // Hit a non-integer character, put it back for future processing
+    while (isdigit(c) && length < TEXTLEN - 1) {
+        buffer[length++] = c;
+        c = next();
+    }
+
+    if (c == '.' || c == 'e' || c == 'E') {
+        scanFloat(c, buffer, length, t);
+        return;
+    }
+
+    // Not a floating-point literal, rescan the digits as an integer
+    buffer[length] = '\0';
     putback(c);
-    return value;
+    t->intvalue = 0;
+    for (int i = 0; i < length; i++) {
+        t->intvalue = t->intvalue * 10 + chrpos("0123456789", buffer[i]);
+    }
+    t->token = T_INTEGERLITERAL;
 }
 
 /**
@@ -198,10 +256,72 @@ static int scanIdentifier(int c, char *buf, int lengthLimit) {
  */
 static int keyword(char *s) {
     switch (*s) {
+    case '_':
+        if (!strcmp(s, "__asm__")) {
+            return T_ASM;
+        }
+        if (!strcmp(s, "__attribute__")) {
+            return T_ATTRIBUTE;
+        }
+        if (!strcmp(s, "__atomic_compare_exchange_n")) {
+            return T_ATOMICCMPXCHG;
+        }
+        if (!strcmp(s, "__atomic_exchange_n")) {
+            return T_ATOMICEXCHANGE;
+        }
+        if (!strcmp(s, "__atomic_fetch_add")) {
+            return T_ATOMICFETCHADD;
+        }
+        if (!strcmp(s, "__atomic_load_n")) {
+            return T_ATOMICLOAD;
+        }
+        if (!strcmp(s, "__atomic_store_n")) {
+            return T_ATOMICSTORE;
+        }
+        if (!strcmp(s, "__atomic_thread_fence")) {
+            return T_ATOMICFENCE;
+        }
+        if (!strcmp(s, "__builtin_expect")) {
+            return T_BUILTINEXPECT;
+        }
+        if (!strcmp(s, "__builtin_unreachable")) {
+            return T_BUILTINUNREACHABLE;
+        }
+        if (!strcmp(s, "__builtin_prefetch")) {
+            return T_BUILTINPREFETCH;
+        }
+        if (!strcmp(s, "__volatile__")) {
+            return T_VOLATILE;
+        }
+        break;
+    case 'a':
+        if (!strcmp(s, "asm")) {
+            return T_ASM;
+        }
+        break;
+    case 'b':
+        if (!strcmp(s, "break")) {
+            return T_BREAK;
+        }
+        break;
     case 'c':
         if (!strcmp(s, "char")) {
             return T_CHAR;
         }
+        if (!strcmp(s, "const")) {
+            return T_CONST;
+        }
+        if (!strcmp(s, "continue")) {
+            return T_CONTINUE;
+        }
+        break;
+    case 'd':
+        if (!strcmp(s, "do")) {
+            return T_DO;
+        }
+        if (!strcmp(s, "double")) {
+            return T_DOUBLE;
+        }
         break;
     case 'e':
         if (!strcmp(s, "else")) {
@@ -209,6 +329,9 @@ static int keyword(char *s) {
         }
         break;
     case 'f':
+        if (!strcmp(s, "float")) {
+            return T_FLOAT;
+        }
         if (!strcmp(s, "for")) {
             return T_FOR;
         }
@@ -227,10 +350,37 @@ static int keyword(char *s) {
         }
         break;
     case 'r':
+        if (!strcmp(s, "restrict")) {
+            return T_RESTRICT;
+        }
         if (!strcmp(s, "return")) {
             return T_RETURN;
         }
         break;
+    case 's':
+        if (!strcmp(s, "short")) {
+            return T_SHORT;
+        }
+        if (!strcmp(s, "sizeof")) {
+            return T_SIZEOF;
+        }
+        if (!strcmp(s, "static")) {
+            return T_STATIC;
+        }
+        if (!strcmp(s, "struct")) {
+            return T_STRUCT;
+        }
+        break;
+    case 't':
+        if (!strcmp(s, "typedef")) {
+            return T_TYPEDEF;
+        }
+        break;
+    case 'u':
+        if (!strcmp(s, "unsigned")) {
+            return T_UNSIGNED;
+        }
+        break;
     case 'w':
         if (!strcmp(s, "while")) {
             return T_WHILE;
@@ -240,11 +390,44 @@ static int keyword(char *s) {
         if (!strcmp(s, "void")) {
             return T_VOID;
         }
+        if (!strcmp(s, "volatile")) {
+            return T_VOLATILE;
+        }
         break;
     }
     return 0;
 }
 
+/**
+ * memoryOrder - check if a string names a memory order.
+ *
+ * NOTE:
+ * GCC predefines the __ATOMIC_* names as macros for the memory order
+ * arguments of the atomic builtins; without a preprocessor they are
+ * scanned as the integer literals they expand to.
+ *
+ * @param s The string to check
+ *
+ * @return The memory order (MO_*), or -1 if s does not name one
+ */
+static int memoryOrder(char *s) {
+    static char *names[] = {
+        [MO_RELAXED] = "__ATOMIC_RELAXED", [MO_CONSUME] = "__ATOMIC_CONSUME",
+        [MO_ACQUIRE] = "__ATOMIC_ACQUIRE", [MO_RELEASE] = "__ATOMIC_RELEASE",
+        [MO_ACQ_REL] = "__ATOMIC_ACQ_REL", [MO_SEQ_CST] = "__ATOMIC_SEQ_CST",
+    };
+
+    if (strncmp(s, "__ATOMIC_", 9) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (!strcmp(s, names[i])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 // A pointer to a rejected token
 static struct token *RejectToken = NULL;
 
@@ -294,6 +477,9 @@ bool scan(struct token *t) {
         if ((c = next()) == '+') {
             // "++"
             t->token = T_INCREMENT;
+        } else if (c == '=') {
+            // "+="
+            t->token = T_ASSIGNPLUS;
         } else {
             // "+"
             putback(c);
@@ -304,6 +490,12 @@ bool scan(struct token *t) {
         if ((c = next()) == '-') {
             // "--"
             t->token = T_DECREMENT;
+        } else if (c == '>') {
+            // "->"
+            t->token = T_ARROW;
+        } else if (c == '=') {
+            // "-="
+            t->token = T_ASSIGNMINUS;
         } else {
             // "-"
             putback(c);
@@ -311,10 +503,24 @@ bool scan(struct token *t) {
         }
         break;
     case '*':
-        t->token = T_STAR;
+        if ((c = next()) == '=') {
+            // "*="
+            t->token = T_ASSIGNSTAR;
+        } else {
+            // "*"
+            putback(c);
+            t->token = T_STAR;
+        }
         break;
     case '/':
-        t->token = T_SLASH;
+        if ((c = next()) == '=') {
+            // "/="
+            t->token = T_ASSIGNSLASH;
+        } else {
+            // "/"
+            putback(c);
+            t->token = T_SLASH;
+        }
         break;
     case ';':
         t->token = T_SEMICOLON;
@@ -337,11 +543,34 @@ bool scan(struct token *t) {
     case ']':
         t->token = T_RBRACKET;
         break;
+    case '.':
+        // A '.' followed by a digit starts a floating-point literal
+        c = next();
+        putback(c);
+        if (isdigit(c)) {
+            scanNumber('.', t);
+            break;
+        }
+        t->token = T_DOT;
+        break;
+    case ',':
+        t->token = T_COMMA;
+        break;
+    case ':':
+        t->token = T_COLON;
+        break;
     case '~':
         t->token = T_LOGICALINVERT;
         break;
     case '^':
-        t->token = T_BITWISEXOR;
+        if ((c = next()) == '=') {
+            // "^="
+            t->token = T_ASSIGNXOR;
+        } else {
+            // "^"
+            putback(c);
+            t->token = T_BITWISEXOR;
+        }
         break;
     case '=':
         if ((c = next()) == '=') {
@@ -367,8 +596,14 @@ bool scan(struct token *t) {
             // "<="
             t->token = T_LE;
         } else if (c == '<') {
-            // "<<"
-            t->token = T_LSHIFT;
+            if ((c = next()) == '=') {
+                // "<<="
+                t->token = T_ASSIGNLSHIFT;
+            } else {
+                // "<<"
+                putback(c);
+                t->token = T_LSHIFT;
+            }
         } else {
             // "<"
             putback(c);
@@ -380,8 +615,14 @@ bool scan(struct token *t) {
             // ">="
             t->token = T_GE;
         } else if (c == '>') {
-            // ">>"
-            t->token = T_RSHIFT;
+            if ((c = next()) == '=') {
+                // ">>="
+                t->token = T_ASSIGNRSHIFT;
+            } else {
+                // ">>"
+                putback(c);
+                t->token = T_RSHIFT;
+            }
         } else {
             // ">"
             putback(c);
@@ -392,6 +633,9 @@ bool scan(struct token *t) {
         if ((c = next()) == '&') {
             // "&&"
             t->token = T_LOGICALAND;
+        } else if (c == '=') {
+            // "&="
+            t->token = T_ASSIGNAND;
         } else {
             // "&"
             putback(c);
@@ -402,6 +646,9 @@ bool scan(struct token *t) {
         if ((c = next()) == '|') {
             // "||"
             t->token = T_LOGICALOR;
+        } else if (c == '=') {
+            // "|="
+            t->token = T_ASSIGNOR;
         } else {
             // "|"
             putback(c);
@@ -424,9 +671,8 @@ bool scan(struct token *t) {
         break;
     default:
         if (isdigit(c)) {
-            // If it's a digit, scan the literal integer value in
-            t->intvalue = scanInteger(c);
-            t->token = T_INTEGERLITERAL;
+            // If it's a digit, scan the literal number in
+            scanNumber(c, t);
             break;
         } else if (isalpha(c) || c == '_') {
             // If it's supposed to be a keyword, return that token instead!
@@ -437,6 +683,18 @@ bool scan(struct token *t) {
                 break;
             }
 
+            // A memory order name stands for its value
+            if ((t->intvalue = memoryOrder(Text)) != -1) {
+                t->token = T_INTEGERLITERAL;
+                break;
+            }
+
+            // A name declared by typedef stands for its type
+            if ((t->intvalue = findTypedef(Text)) != -1) {
+                t->token = T_TYPENAME;
+                break;
+            }
+
             // Not a recognized keyword, thus it's an identifier
             // (e.g. variable name)
             t->token = T_IDENTIFIER;
@@ -0,0 +1,165 @@
+// src/sizereport.c
+//
+// Static per-function code size and instruction mix (--size-report).
+// The backends account for every instruction they emit through
+// nasmEmit() / aarch64Emit(); nothing here looks at the generated text.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "data.h"
+#include "decl.h"
+#include "defs.h"
+
+// Counters collected for one function
+struct sizeRecord {
+    char *name;                     // Function name
+    int instructions;               // Instructions emitted
+    int bytes;                      // Estimated encoded size
+    int classCount[INSN_NCLASSES];  // Instructions per INSN_* class
+    int frameSize;                  // Stack frame size (stackOffset)
+    int spillSlots;                 // Stack slots for registers saved
+                                    // around calls (the most at one call)
+};
+
+static const char *insnClassNames[INSN_NCLASSES] = {
+    "loads", "stores", "alu", "branches", "calls",
+};
+
+static struct sizeRecord *Records;
+static int RecordCount;
+static int RecordCapacity;
+// Record of the function being generated, or NULL outside functions
+static struct sizeRecord *Current;
+
+/**
+ * sizeReportBeginFunction - Starts accounting for a function's code.
+ *
+ * @param id The function's symbol table ID.
+ * @param frameSize Size of the function's stack frame in bytes.
+ */
+void sizeReportBeginFunction(int id, int frameSize) {
+    if (Option_sizeReport == SIZE_REPORT_NONE) {
+        return;
+    }
+
+    if (RecordCount == RecordCapacity) {
+        RecordCapacity = RecordCapacity ? RecordCapacity * 2 : 16;
+        Records = realloc(Records, RecordCapacity * sizeof(struct sizeRecord));
+        if (Records == NULL) {
+            logFatal("Unable to allocate the size report");
+        }
+    }
+
+    Current = &Records[RecordCount++];
+    *Current = (struct sizeRecord){0};
+    Current->name = SymbolTable[id].name;
+    Current->frameSize = frameSize;
+}
+
+/**
+ * sizeReportCountInstruction - Accounts for one emitted instruction.
+ * Instructions emitted outside a function are ignored.
+ *
+ * @param insnClass Instruction class (INSN_*).
+ * @param bytes Estimated encoded length of the instruction in bytes.
+ */
+void sizeReportCountInstruction(int insnClass, int bytes) {
+    if (Current == NULL) {
+        return;
+    }
+
+    Current->instructions++;
+    Current->bytes += bytes;
+    Current->classCount[insnClass]++;
+}
+
+/**
+ * sizeReportCountSpillSlots - Accounts for the registers saved around one
+ * call. Every call reuses the same stack area, so the function needs as
+ * many slots as its largest save.
+ *
+ * @param slots Number of registers saved.
+ */
+void sizeReportCountSpillSlots(int slots) {
+    if (Current != NULL && slots > Current->spillSlots) {
+        Current->spillSlots = slots;
+    }
+}
+
+/**
+ * sizeReportEndFunction - Stops accounting for the current function.
+ */
+void sizeReportEndFunction(void) { Current = NULL; }
+
+/**
+ * sizeReportDropFunction - Forgets a function whose code was generated but
+ * left out of the output (an unused static function).
+ *
+ * @param id The function's symbol table ID.
+ */
+void sizeReportDropFunction(int id) {
+    for (int i = 0; i < RecordCount; i++) {
+        if (Records[i].name == SymbolTable[id].name) {
+            RecordCount--;
+            memmove(&Records[i], &Records[i + 1],
+                    (RecordCount - i) * sizeof(struct sizeRecord));
+            return;
+        }
+    }
+}
+
+/**
+ * sizeReportPrintTable - Prints the report as an aligned table.
+ */
+static void sizeReportPrintTable(void) {
+    printf("%-24s %8s %8s", "function", "insns", "bytes");
+    for (int c = 0; c < INSN_NCLASSES; c++) {
+        printf(" %8s", insnClassNames[c]);
+    }
+    printf(" %8s %8s\n", "frame", "spills");
+
+    for (int i = 0; i < RecordCount; i++) {
+        struct sizeRecord *r = &Records[i];
+        printf("%-24s %8d %8d", r->name, r->instructions, r->bytes);
+        for (int c = 0; c < INSN_NCLASSES; c++) {
+            printf(" %8d", r->classCount[c]);
+        }
+        printf(" %8d %8d\n", r->frameSize, r->spillSlots);
+    }
+}
+
+/**
+ * sizeReportPrintJSON - Prints the report as a JSON array of objects.
+ */
+static void sizeReportPrintJSON(void) {
+    printf("[");
+    for (int i = 0; i < RecordCount; i++) {
+        struct sizeRecord *r = &Records[i];
+        printf("%s\n  {\"function\": \"%s\", \"instructions\": %d, "
+               "\"bytes\": %d",
+               i ? "," : "", r->name, r->instructions, r->bytes);
+        for (int c = 0; c < INSN_NCLASSES; c++) {
+            printf(", \"%s\": %d", insnClassNames[c], r->classCount[c]);
+        }
+        printf(", \"frame\": %d, \"spills\": %d}", r->frameSize,
+               r->spillSlots);
+    }
+    printf("%s]\n", RecordCount ? "\n" : "");
+}
+
+/**
+ * sizeReportPrint - Prints the collected report to stdout in the format
+ * selected by --size-report.
+ */
+void sizeReportPrint(void) {
+    switch (Option_sizeReport) {
+    case SIZE_REPORT_TABLE:
+        sizeReportPrintTable();
+        break;
+    case SIZE_REPORT_JSON:
+        sizeReportPrintJSON();
+        break;
+    }
+}
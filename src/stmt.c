@@ -9,6 +9,60 @@
 // Forward declarations
 static struct ASTnode *singleStatement(void);
 
+// Number of loops enclosing the statement being parsed
+// (break and continue are only valid inside one)
+static int LoopDepth = 0;
+
+/**
+ * loopBody - Parse the compound statement that is the body of a loop.
+ *
+ * @return AST node representing the loop body.
+ */
+static struct ASTnode *loopBody(void) {
+    struct ASTnode *bodyAST;
+
+    LoopDepth++;
+    bodyAST = compoundStatement();
+    LoopDepth--;
+
+    return bodyAST;
+}
+
+/**
+ * isColdStatement - Check whether a statement is unlikely to run: it
+ * reaches __builtin_unreachable() or calls a function declared "cold".
+ * (helper function)
+ *
+ * NOTE:
+ * Nested if statements and loops are not looked into, as their code may
+ * not run whenever the statement does.
+ *
+ * @param n The AST of the statement.
+ *
+ * @return true if the statement is unlikely to run.
+ */
+static bool isColdStatement(struct ASTnode *n) {
+    if (n == NULL) {
+        return false;
+    }
+
+    switch (n->op) {
+    case A_UNREACHABLE:
+        return true;
+    case A_FUNCTIONCALL:
+        if (SymbolTable[n->v.identifierIndex].textSection == TS_UNLIKELY) {
+            return true;
+        }
+        break;
+    case A_IF:
+    case A_WHILE:
+    case A_DOWHILE:
+        return false;
+    }
+    return isColdStatement(n->left) || isColdStatement(n->middle) ||
+           isColdStatement(n->right);
+}
+
 /**
  * ifStatement - Parse and handle an if statement.
  *
@@ -21,6 +75,10 @@ static struct ASTnode *singleStatement(void);
  *    else-statements (else AST)
  * }
  * -----------------------------------
+ * A condition that is a call of __builtin_expect is replaced by its
+ * expression, and says which arm is likely to run; otherwise an arm that
+ * is cold (see isColdStatement) is unlikely. The A_IF node records that
+ * as a BRANCH_* value.
  *
  * @return AST node representing the if statement.
  */
@@ -28,6 +86,7 @@ static struct ASTnode *ifStatement(void) {
     struct ASTnode *conditionAST;   // condition
     struct ASTnode *thenAST;        // true branch
     struct ASTnode *elseAST = NULL; // false branch
+    int hint = BRANCH_UNKNOWN;
 
     // Ensure we have 'if' then '('
     match(T_IF, "if");
@@ -36,6 +95,10 @@ static struct ASTnode *ifStatement(void) {
     // Parse the following expression and the following ')'
     // Ensure the tree's operation is a comparison.
     conditionAST = binexpr(0);
+    if (conditionAST->op == A_EXPECT) {
+        hint = conditionAST->v.intvalue ? BRANCH_LIKELY : BRANCH_UNLIKELY;
+        conditionAST = conditionAST->left;
+    }
 
     // For a non-comparison to be boolean
     if (!(conditionAST->op == A_EQ) && !(conditionAST->op == A_NE) &&
@@ -53,7 +116,15 @@ static struct ASTnode *ifStatement(void) {
         elseAST = compoundStatement();
     }
 
-    return makeASTNode(A_IF, P_NONE, conditionAST, thenAST, elseAST, 0);
+    if (hint == BRANCH_UNKNOWN) {
+        if (isColdStatement(thenAST)) {
+            hint = BRANCH_UNLIKELY;
+        } else if (isColdStatement(elseAST)) {
+            hint = BRANCH_LIKELY;
+        }
+    }
+
+    return makeASTNode(A_IF, P_NONE, conditionAST, thenAST, elseAST, hint);
 }
 
 /**
@@ -90,12 +161,56 @@ static struct ASTnode *whileStatement(void) {
     matchRightParenthesisToken();
 
     // Get the AST for the compount statement; this is the body of the loop
-    bodyAST = compoundStatement();
+    bodyAST = loopBody();
 
     // Store body in the right child for structural consistency
     return makeASTNode(A_WHILE, P_NONE, conditionAST, NULL, bodyAST, 0);
 }
 
+/**
+ * doWhileStatement - Parse and handle a do-while statement.
+ *
+ * NOTE:
+ * Do-while statement is composed of:
+ * -----------------------------------
+ * do {
+ *     body-statements
+ *     ...
+ * } while (condition);
+ * -----------------------------------
+ * The body runs once before the condition is first tested, so the loop
+ * is bottom-tested only (see codegenDoWhileStatementAST()).
+ * The trailing ';' is matched by compoundStatement().
+ *
+ * @return AST node representing the do-while statement.
+ */
+static struct ASTnode *doWhileStatement(void) {
+    struct ASTnode *conditionAST;
+    struct ASTnode *bodyAST;
+
+    // Ensure we have 'do', then the body
+    match(T_DO, "do");
+    bodyAST = loopBody();
+
+    // Ensure we have 'while' then '('
+    match(T_WHILE, "while");
+    matchLeftParenthesisToken();
+
+    // Parse the following expression and the following ')'
+    conditionAST = binexpr(0);
+
+    // Force non-comparisons to be boolean
+    if (!(conditionAST->op == A_EQ) && !(conditionAST->op == A_NE) &&
+        !(conditionAST->op == A_LT) && !(conditionAST->op == A_LE) &&
+        !(conditionAST->op == A_GT) && !(conditionAST->op == A_GE)) {
+        conditionAST = makeASTUnary(A_TOBOOLEAN, P_INT, conditionAST, 0);
+    }
+    matchRightParenthesisToken();
+
+    // Same layout as A_WHILE: condition on the left, body on the right
+    return makeASTNode(A_DOWHILE, P_NONE, conditionAST, NULL, bodyAST, 0);
+}
+
 /**
  * forStatement - Parse and handle a for statement.
  *
@@ -111,11 +226,10 @@ static struct ASTnode *whileStatement(void) {
  * ----------------------------------------------
  *               A_GLUE
  *             /       \
- *       preOperation  A_WHILE
- *                     /      \
- *               condition   A_GLUE
- *                          /      \
- *                     bodyAST   postOperation
+ *       preOperation     A_WHILE
+ *                     /     |     \
+ *               condition  post   bodyAST
+ *                        Operation
  *                   (compound)
  * ----------------------------------------------
  * It means that the for loop is
@@ -154,17 +268,16 @@ static struct ASTnode *forStatement(void) {
     matchRightParenthesisToken();
 
     // Get the compound statement in the body part
-    bodyAST = compoundStatement();
+    bodyAST = loopBody();
 
     // TODO:
     // For now, all four sub-trees have to be non-NULL.
     // Later on, we'll change the semantics for when some are missing
 
-    // Glue the compount statement and the postOperationAST
-    treeNode = makeASTNode(A_GLUE, P_NONE, bodyAST, NULL, postOperationAST, 0);
-
-    // Glue the conditionAST and the WHILE node
-    treeNode = makeASTNode(A_WHILE, P_NONE, conditionAST, NULL, treeNode, 0);
+    // The postOperationAST is kept apart from the body (in the middle
+    // child) so that 'continue' can jump straight to it
+    treeNode = makeASTNode(A_WHILE, P_NONE, conditionAST, postOperationAST,
+                           bodyAST, 0);
 
     // Finally, glue the preOperationAST and the WHILE node
     treeNode = makeASTNode(A_GLUE, P_NONE, preOperationAST, NULL, treeNode, 0);
@@ -185,9 +298,12 @@ static struct ASTnode *forStatement(void) {
  */
 static struct ASTnode *returnStatement(void) {
     struct ASTnode *treeNode;
+    // The function type's base is its return type
+    int returnType =
+        TypeTable[SymbolTable[CurrentFunctionSymbolID].primitiveType].base;
 
     // Can't return a value if function returns P_VOID
-    if (SymbolTable[CurrentFunctionSymbolID].primitiveType == P_VOID) {
+    if (returnType == P_VOID) {
         logFatal("Cannot return a value from a void function");
     }
 
@@ -199,9 +315,7 @@ static struct ASTnode *returnStatement(void) {
     treeNode = binexpr(0);
 
     // Ensure the two types are compatible
-    treeNode = coerceASTTypeForOp(
-        treeNode, SymbolTable[CurrentFunctionSymbolID].primitiveType,
-        A_NOTHING);
+    treeNode = coerceASTTypeForOp(treeNode, returnType, A_NOTHING);
     if (treeNode == NULL) {
         logFatal("Type error: incompatible type in return statement");
     }
@@ -216,34 +330,294 @@ static struct ASTnode *returnStatement(void) {
     return treeNode;
 }
 
+/**
+ * loopJumpStatement - Parse and handle a break or continue statement.
+ *
+ * NOTE:
+ * Both are a single keyword and only valid inside a loop body.
+ *
+ * @param token The keyword token, T_BREAK or T_CONTINUE.
+ * @return AST leaf A_BREAK or A_CONTINUE.
+ */
+static struct ASTnode *loopJumpStatement(int token) {
+    char *what = (token == T_BREAK) ? "break" : "continue";
+
+    if (LoopDepth == 0) {
+        logFatals("Statement not within a loop: ", what);
+    }
+    match(token, what);
+
+    return makeASTLeaf(token == T_BREAK ? A_BREAK : A_CONTINUE, P_NONE, 0);
+}
+
+/**
+ * asmString - Parse a string literal of an asm statement; adjacent string
+ * literals are concatenated, as in C. (helper function)
+ *
+ * @return A copy of the string.
+ */
+static char *asmString(void) {
+    char *s;
+
+    if (Token.token != T_STRINGLITERAL) {
+        logFatal("Expected a string literal in asm statement");
+    }
+    s = strdup(Text);
+    scan(&Token);
+    while (Token.token == T_STRINGLITERAL) {
+        if ((s = realloc(s, strlen(s) + strlen(Text) + 1)) == NULL) {
+            logFatal("Unable to malloc in asmString()");
+        }
+        strcat(s, Text);
+        scan(&Token);
+    }
+    return s;
+}
+
+/**
+ * asmOperand - Parse an operand of an asm statement.
+ * (helper function)
+ *
+ * NOTE:
+ * - "r"(expression): an integer or pointer value in a register
+ * - "m"(lvalue): the object itself, addressed through a register
+ * - "i"(constant expression): an integer constant
+ * An output ("=r", "+r", "=m", "+m") must be a modifiable lvalue; "=&"
+ * is accepted, as no two operands ever share a register. A register
+ * output becomes an assignment from its register once the text has run,
+ * and "+r" first loads the lvalue's value into that register.
+ *
+ * @param a        The asm statement.
+ * @param isOutput True for an operand of the output list.
+ * @param store    Where to store the assignment of a register output.
+ *
+ * @return The expression to generate into the operand's register before
+ *         the text runs (the address for "m"), or NULL if none.
+ */
+static struct ASTnode *asmOperand(struct asmStatement *a, bool isOutput,
+                                  struct ASTnode **store) {
+    struct asmOperand *op;
+    struct ASTnode *n;
+    struct ASTnode *initialValue = NULL;
+    char *constraint;
+    char *c;
+    int index;
+
+    index = a->operandCount++;
+    op = &a->operands[index];
+    op->isOutput = isOutput;
+
+    // The constraint, e.g. "=r", and the expression in parentheses
+    c = constraint = asmString();
+    if (isOutput != (*c == '=' || *c == '+')) {
+        logFatals(isOutput ? "asm output constraint must start with '=' or "
+                             "'+': "
+                           : "asm input constraint cannot start with '=' "
+                             "or '+': ",
+                  constraint);
+    }
+    if (isOutput) {
+        c++;
+        if (*c == '&') {
+            c++;
+        }
+    }
+    if ((*c != 'r' && *c != 'm' && *c != 'i') || c[1] != '\0') {
+        logFatals("Unsupported asm constraint: ", constraint);
+    }
+    op->constraint = *c;
+    matchLeftParenthesisToken();
+    n = binexpr(0);
+    matchRightParenthesisToken();
+
+    if (op->constraint == 'i') {
+        if (isOutput) {
+            logFatal("asm output operand cannot be an immediate ('i')");
+        }
+        if (!evaluateConstantExpression(n, &op->value)) {
+            logFatal("asm operand with constraint 'i' is not a constant");
+        }
+        return NULL;
+    }
+    if (op->constraint == 'r' && !isIntegerType(n->primitiveType) &&
+        !isPointerType(n->primitiveType)) {
+        logFatal("asm operand with constraint 'r' must be an integer or a "
+                 "pointer");
+    }
+    if (op->constraint == 'r' && !isOutput) {
+        return n;
+    }
+
+    if (n->op != A_IDENTIFIER && n->op != A_DEREFERENCE) {
+        logFatal("asm output or memory operand must be an lvalue");
+    }
+    if (isOutput) {
+        checkModifiable(n);
+        recordStore(n, NULL);
+    }
+
+    if (op->constraint == 'm') {
+        // The asm text reaches the object through its address
+        if (n->op == A_DEREFERENCE) {
+            op->offset = n->v.offset;
+            n->left->isRvalue = true;
+            return n->left;
+        }
+        SymbolTable[n->v.identifierIndex].isAddressTaken = true;
+        return makeASTLeaf(A_ADDRESSOF,
+                           primitiveTypeToPointerType(n->primitiveType),
+                           n->v.identifierIndex);
+    }
+
+    if (*constraint == '+') {
+        initialValue = cloneAST(n);
+    }
+    n->isRvalue = false;
+    *store = makeASTNode(A_ASSIGN, n->primitiveType,
+                         makeASTLeaf(A_ASMRESULT, n->primitiveType, index),
+                         NULL, n, 0);
+    return initialValue;
+}
+
+/**
+ * asmStatement - Parse a GNU-style asm statement.
+ *
+ * NOTE:
+ * asm_statement := ('asm' | '__asm__') ['volatile']
+ *                  '(' string [':' outputs [':' inputs [':' clobbers]]] ')'
+ * outputs, inputs := [string '(' expression ')' (',' ...)*]
+ * clobbers := [string (',' string)*]
+ * Operands are numbered outputs first, "%0" onwards. The text is handed
+ * to the backend as is, with the operands substituted. No asm statement
+ * is ever removed or moved, so "volatile" is accepted and implied.
+ * The terminating ';' is left to the caller.
+ *
+ * @return AST node A_ASM.
+ */
+static struct ASTnode *asmStatement(void) {
+    struct asmStatement *a;
+    struct ASTnode *expressions[NASMOPERANDS];
+    struct ASTnode *stores[NASMOPERANDS];
+    struct ASTnode *operands = NULL;
+    struct ASTnode *outputStores = NULL;
+    struct ASTnode *n;
+    int part;
+
+    match(T_ASM, "asm");
+    if (Token.token == T_VOLATILE) {
+        scan(&Token);
+    }
+    matchLeftParenthesisToken();
+
+    if ((a = calloc(1, sizeof(struct asmStatement))) == NULL) {
+        logFatal("Unable to malloc in asmStatement()");
+    }
+    a->text = asmString();
+    // The instructions may store to any global they name
+    recordAsmText(a->text);
+
+    // Up to three lists, each after a ':' and possibly empty:
+    // outputs, inputs and clobbers
+    for (part = 0; part < 3 && Token.token == T_COLON; part++) {
+        scan(&Token);
+        while (Token.token == T_STRINGLITERAL) {
+            if (part == 2) {
+                if (a->clobberCount == NASMCLOBBERS) {
+                    logFatal("Too many clobbers in asm statement");
+                }
+                a->clobbers[a->clobberCount++] = asmString();
+            } else {
+                if (a->operandCount == NASMOPERANDS) {
+                    logFatal("Too many operands in asm statement");
+                }
+                stores[a->operandCount] = NULL;
+                expressions[a->operandCount] =
+                    asmOperand(a, part == 0, &stores[a->operandCount]);
+            }
+            if (Token.token != T_COMMA) {
+                break;
+            }
+            matchCommaToken();
+        }
+    }
+    matchRightParenthesisToken();
+
+    // Chain the operands, and the output stores, in operand order
+    for (int i = a->operandCount - 1; i >= 0; i--) {
+        operands = makeASTNode(A_ASMOPERAND, P_NONE, expressions[i], NULL,
+                               operands, i);
+        if (stores[i] != NULL) {
+            outputStores = makeASTNode(A_ASMOPERAND, P_NONE, stores[i], NULL,
+                                       outputStores, i);
+        }
+    }
+    n = makeASTNode(A_ASM, P_NONE, operands, NULL, outputStores, 0);
+    n->v.asmStatement = a;
+    return n;
+}
+
 /**
  * singleStatement - Parse and handle a single statement.
  *
  * @return AST node representing the single statement.
  */
 static struct ASTnode *singleStatement(void) {
+    struct ASTnode *treeNode;
+    bool isStatic;
     int type;
 
     switch (Token.token) {
-    case T_CHAR: // primitive data type (char, 1 byte)
-    case T_INT:  // primitive data type (int, 4 bytes)
-    case T_LONG: // primitive data type (long, 8 bytes)
+    case T_STATIC:   // local variable with static storage
+    case T_CONST:    // qualified type (const, volatile)
+    case T_VOLATILE:
+    case T_CHAR:     // primitive data type (char, 1 byte)
+    case T_SHORT:    // primitive data type (short, 2 bytes)
+    case T_INT:      // primitive data type (int, 4 bytes)
+    case T_LONG:     // primitive data type (long, 8 bytes)
+    case T_FLOAT:    // primitive data type (float, 4 bytes)
+    case T_DOUBLE:   // primitive data type (double, 8 bytes)
+    case T_UNSIGNED: // unsigned char/short/int/long
+    case T_STRUCT:   // struct definition or struct-typed variable
+    case T_TYPENAME: // type named by a typedef
 
         // Parse the type and get the identifier.
         // Then parse the rest of the declaration.
+        isStatic = (Token.token == T_STATIC);
+        if (isStatic) {
+            scan(&Token);
+        }
         type = parsePrimitiveType();
+
+        // A struct definition on its own, e.g. "struct point { ... };"
+        if (isStructType(type) && Token.token == T_SEMICOLON) {
+            matchSemicolonToken();
+            return NULL;
+        }
+
         matchIdentifierToken();
-        variableDeclaration(type, true);
 
-        return NULL; // No AST node for declarations
+        // No AST node for declarations, except an initial value assignment
+        // (whose ';' is matched like any other assignment's)
+        treeNode = variableDeclaration(type, true, isStatic);
+        if (treeNode == NULL) {
+            matchSemicolonToken();
+        }
+        return treeNode;
     case T_IF:
         return ifStatement();
     case T_WHILE:
         return whileStatement();
+    case T_DO:
+        return doWhileStatement();
     case T_FOR:
         return forStatement();
+    case T_BREAK:
+    case T_CONTINUE:
+        return loopJumpStatement(Token.token);
     case T_RETURN:
         return returnStatement();
+    case T_ASM:
+        return asmStatement();
     default:
         // TODO:
         // For now, see if this is an expression.
@@ -276,9 +650,16 @@ struct ASTnode *compoundStatement(void) {
 
         // Some statement must be followed by a semicolon
         if (treeNode != NULL &&
-            (treeNode->op == A_ASSIGN ||     // e.g. "identifier = expr;"
-             treeNode->op == A_RETURN ||     // e.g. "return expr;"
-             treeNode->op == A_FUNCTIONCALL) // e.g. "functionCall(
+            (isAssignmentASTop(treeNode->op) || // e.g. "identifier = expr;"
+             treeNode->op == A_RETURN ||        // e.g. "return expr;"
+             treeNode->op == A_BREAK ||         // e.g. "break;"
+             treeNode->op == A_CONTINUE ||      // e.g. "continue;"
+             treeNode->op == A_DOWHILE ||       // e.g. "do {} while (c);"
+             isAtomicASTop(treeNode->op) ||     // e.g. "__atomic_store_n(
+             treeNode->op == A_ASM ||           // e.g. "asm("pause");"
+             treeNode->op == A_UNREACHABLE ||   // e.g. "__builtin_unreachable(
+             treeNode->op == A_PREFETCH ||      // e.g. "__builtin_prefetch(
+             treeNode->op == A_FUNCTIONCALL)    // e.g. "functionCall(
         ) {
             matchSemicolonToken();
         }
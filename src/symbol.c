@@ -4,38 +4,62 @@
 #include "decl.h"
 #include "defs.h"
 
+// Open-addressing hash index of the global symbol names. A slot holds
+// the symbol table index plus one, or 0 when empty.
+static int GlobalSymbolHash[NGLOBALHASH];
+
 /**
- * findGlobalSymbol - Find a global symbol in the symbol table.
+ * findGlobalHashSlot - Find a name in the hash index of global symbols.
+ * (helper function)
  *
- * @param s The name of the symbol to add
+ * @param s The name.
  *
- * @return The index of the symbol in the symbol table. -1 if not present
+ * @return The slot of the name, or else the empty slot where it belongs.
  */
-int findGlobalSymbol(char *s) {
-    for (int i = 0; i < NextGlobalSymbolIndex; i++) {
-        if (*s == *SymbolTable[i].name && !strcmp(s, SymbolTable[i].name)) {
-            return i;
+static int *findGlobalHashSlot(char *s) {
+    unsigned long hash = 5381;
+    int *slot;
+
+    for (char *p = s; *p != '\0'; p++) {
+        hash = hash * 33 + (unsigned char)*p;
+    }
+    // The index has more slots than the symbol table, so one is always free
+    for (int i = 0;; i++) {
+        slot = &GlobalSymbolHash[(hash + i) & (NGLOBALHASH - 1)];
+        if (*slot == 0 || !strcmp(s, SymbolTable[*slot - 1].name)) {
+            return slot;
         }
     }
-    return -1;
 }
 
+/**
+ * findGlobalSymbol - Find a global symbol in the symbol table.
+ *
+ * @param s The name of the symbol to add
+ *
+ * @return The index of the symbol in the symbol table. -1 if not present
+ */
+int findGlobalSymbol(char *s) { return *findGlobalHashSlot(s) - 1; }
+
 /**
  * getNewGlobalSymbolIndex - Get a new index for a global symbol.
  *
  * NOTE:
  * Global symbol index grows in an ascending manner.
  *
+ * @param name The name of the symbol, added to the hash index.
+ *
  * @return The new index for the global symbol
  *
  * @note Logs a fatal error if the symbol table is full
  */
-static int getNewGlobalSymbolIndex(void) {
+static int getNewGlobalSymbolIndex(char *name) {
     int p;
 
     if ((p = NextGlobalSymbolIndex++) >= NSYMBOLS) {
         logFatal("Too many global symbols");
     }
+    *findGlobalHashSlot(name) = p + 1;
 
     return p;
 }
@@ -77,6 +101,66 @@ static int getNewLocalSymbolIndex(void) {
     return p;
 }
 
+/**
+ * freeLocalSymbols - Forget the local symbols of the previous function.
+ *
+ * NOTE:
+ * Without this, a local declared in an earlier function would be found by
+ * findLocalSymbol() and reuse that function's stack offset.
+ */
+void freeLocalSymbols(void) { NextLocalSymbolIndex = NSYMBOLS - 1; }
+
+/**
+ * saveLocalSymbols - Copy the local symbols of the current function, so
+ * that its code can be generated once the rest of the file is parsed.
+ *
+ * @param count Set to the number of symbols copied.
+ *
+ * @return The copy, to be freed by the caller.
+ */
+struct symbolTable *saveLocalSymbols(int *count) {
+    struct symbolTable *locals;
+
+    *count = NSYMBOLS - 1 - NextLocalSymbolIndex;
+    // One more, so that a function without locals gets a buffer too
+    locals = malloc((*count + 1) * sizeof(struct symbolTable));
+    if (locals == NULL) {
+        logFatal("Unable to save the local symbols of a function");
+    }
+    memcpy(locals, &SymbolTable[NextLocalSymbolIndex + 1],
+           *count * sizeof(struct symbolTable));
+    return locals;
+}
+
+/**
+ * restoreLocalSymbols - Make the saved local symbols of a function the
+ * current ones again.
+ *
+ * NOTE:
+ * The backend hands out the stack slots again, in the order the locals
+ * were added, so that it knows the size of the function's frame.
+ *
+ * @param locals The symbols saved by saveLocalSymbols().
+ * @param count  The number of symbols.
+ *
+ * @note Logs a fatal error if the globals declared since then left no room
+ */
+void restoreLocalSymbols(struct symbolTable *locals, int count) {
+    if (NSYMBOLS - 1 - count < NextGlobalSymbolIndex) {
+        logFatal("Too many local symbols");
+    }
+    NextLocalSymbolIndex = NSYMBOLS - 1 - count;
+    memcpy(&SymbolTable[NextLocalSymbolIndex + 1], locals,
+           count * sizeof(struct symbolTable));
+
+    codegenResetLocalOffset();
+    for (int i = NSYMBOLS - 1; i > NextLocalSymbolIndex; i--) {
+        if (SymbolTable[i].class == C_LOCAL) {
+            codegenGetLocalOffset(i, false /* not a function param */);
+        }
+    }
+}
+
 /**
  * addGlobalSymbol - Add a global symbol to the symbol table.
  *
@@ -107,11 +191,27 @@ static void updateSymbolTable(int slotIndex, char *name, int primitiveType,
     SymbolTable[slotIndex].endLabel = endLabel;
     SymbolTable[slotIndex].size = size;
     SymbolTable[slotIndex].offset = offsetPosition;
+    SymbolTable[slotIndex].isInitialized = false;
+    SymbolTable[slotIndex].initialValue = 0;
+    SymbolTable[slotIndex].isReferenced = false;
+    SymbolTable[slotIndex].qualifiers = 0;
+    SymbolTable[slotIndex].targetQualifiers = 0;
+    SymbolTable[slotIndex].isAddressTaken = false;
+    SymbolTable[slotIndex].isStored = false;
+    SymbolTable[slotIndex].isChanged = false;
+    SymbolTable[slotIndex].isConstant = false;
+    SymbolTable[slotIndex].isReadOnly = false;
+    SymbolTable[slotIndex].textSection = TS_NORMAL;
+    SymbolTable[slotIndex].clobberedRegisters = ALLREGISTERS;
 }
 
 /**
  * addGlobalSymbol - Add a global symbol to the symbol table.
  *
+ * NOTE:
+ * The storage of a global variable is declared at the end of the file,
+ * once the stores to it are known (see classifyGlobalVariables()).
+ *
  * @param name           The name of the symbol to add.
  * @param primitiveType  The primitive data type of the symbol.
  * @param structuralType The structural data type of the symbol.
@@ -129,10 +229,70 @@ int addGlobalSymbol(char *name, int primitiveType, int structuralType,
         return slotIndex;
     }
 
-    slotIndex = getNewGlobalSymbolIndex();
+    slotIndex = getNewGlobalSymbolIndex(name);
     updateSymbolTable(slotIndex, name, primitiveType, structuralType, C_GLOBAL,
                       endLabel, size, 0);
-    codegenDeclareGlobalSymbol(slotIndex);
+    return slotIndex;
+}
+
+/**
+ * addStaticSymbol - Add a static symbol (file-scope static, or the storage
+ * of a function-local static) to the symbol table.
+ *
+ * NOTE:
+ * Like globals, statics are declared at the end of the file, but only if
+ * used.
+ *
+ * @param name           The name of the symbol to add.
+ * @param primitiveType  The primitive data type of the symbol.
+ * @param structuralType The structural data type of the symbol.
+ * @param endLabel       The end label for the symbol (if applicable).
+ * @param size           The number of elements (for arrays, etc.).
+ *
+ * @return The index of the added symbol in the symbol table.
+ */
+int addStaticSymbol(char *name, int primitiveType, int structuralType,
+                    int endLabel, int size) {
+    int slotIndex;
+
+    if ((slotIndex = findGlobalSymbol(name)) != -1) {
+        // Symbol already exists, return its index
+        return slotIndex;
+    }
+
+    slotIndex = getNewGlobalSymbolIndex(name);
+    updateSymbolTable(slotIndex, name, primitiveType, structuralType, C_STATIC,
+                      endLabel, size, 0);
+    return slotIndex;
+}
+
+/**
+ * addInitializedGlobalSymbol - Add a global scalar variable with a constant
+ * initial value to the symbol table.
+ *
+ * NOTE:
+ * The storage, with the value, is declared at the end of the file.
+ *
+ * @param name          The name of the symbol to add.
+ * @param primitiveType The primitive data type of the symbol.
+ * @param classType     C_GLOBAL, or C_STATIC for a static variable.
+ * @param value         The initial value.
+ *
+ * @return The index of the added symbol in the symbol table.
+ */
+int addInitializedGlobalSymbol(char *name, int primitiveType, int classType,
+                               long value) {
+    int slotIndex;
+
+    if (findGlobalSymbol(name) != -1) {
+        logFatals("Redefinition of global variable: ", name);
+    }
+
+    slotIndex = getNewGlobalSymbolIndex(name);
+    updateSymbolTable(slotIndex, name, primitiveType, S_VARIABLE, classType, 0,
+                      0, 0);
+    SymbolTable[slotIndex].isInitialized = true;
+    SymbolTable[slotIndex].initialValue = value;
     return slotIndex;
 }
 
@@ -157,11 +317,39 @@ int addLocalSymbol(char *name, int primitiveType, int structuralType,
     }
 
     slotIndex = getNewLocalSymbolIndex();
-    int offsetPosition =
-        // TODO: "isFunctionParameter=false" for now
-        codegenGetLocalOffset(primitiveType, false /* not a function param */);
     updateSymbolTable(slotIndex, name, primitiveType, structuralType, C_LOCAL,
-                      endLabel, size, offsetPosition);
+                      endLabel, size, 0);
+    // The backend sizes the stack slot from the symbol's type and size
+    SymbolTable[slotIndex].offset =
+        // TODO: "isFunctionParameter=false" for now
+        codegenGetLocalOffset(slotIndex, false /* not a function param */);
+    return slotIndex;
+}
+
+/**
+ * addLocalStaticSymbol - Make a function-local static visible by its name
+ * in the current function.
+ *
+ * NOTE:
+ * The storage is a static symbol with a name unique to the function (see
+ * variableDeclaration()); this local entry only maps the source name to it.
+ *
+ * @param name      The name of the variable in the source.
+ * @param storageId The symbol table ID of its storage.
+ *
+ * @return The index of the added symbol in the symbol table.
+ */
+int addLocalStaticSymbol(char *name, int storageId) {
+    int slotIndex;
+
+    if (findLocalSymbol(name) != -1) {
+        logFatals("Redefinition of local variable: ", name);
+    }
+
+    slotIndex = getNewLocalSymbolIndex();
+    updateSymbolTable(slotIndex, name, SymbolTable[storageId].primitiveType,
+                      SymbolTable[storageId].structuralType, C_STATIC, 0,
+                      SymbolTable[storageId].size, storageId);
     return slotIndex;
 }
 
@@ -172,6 +360,7 @@ int addLocalSymbol(char *name, int primitiveType, int structuralType,
  * It first tries to find the symbol in the local scope,
  * and then looks for it in the global scope.
  * It's in concord with typical scoping rules in programming languages.
+ * A function-local static resolves to its storage symbol.
  *
  * @param s The name of the symbol to add
  *
@@ -184,7 +373,84 @@ int findSymbol(char *s) {
     if (slotIndex == -1) {
         // There was no locally defined variable
         slotIndex = findGlobalSymbol(s);
+    } else if (SymbolTable[slotIndex].class == C_STATIC) {
+        slotIndex = SymbolTable[slotIndex].offset;
     }
 
     return slotIndex;
 }
+
+/**
+ * findStruct - Find a struct in the struct table.
+ *
+ * @param s The tag of the struct
+ *
+ * @return The index of the struct in the struct table. -1 if not present
+ */
+int findStruct(char *s) {
+    for (int i = 0; i < NextStructIndex; i++) {
+        if (*s == *StructTable[i].name && !strcmp(s, StructTable[i].name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * addStruct - Add a struct without members to the struct table.
+ *
+ * @param name The tag of the struct
+ *
+ * @return The index of the added struct in the struct table.
+ *
+ * @note Logs a fatal error if the struct table is full
+ */
+int addStruct(char *name) {
+    int structIndex;
+
+    if ((structIndex = NextStructIndex++) >= NSTRUCTS) {
+        logFatal("Too many struct types");
+    }
+
+    StructTable[structIndex] = (struct structTable){0};
+    StructTable[structIndex].name = strdup(name);
+    return structIndex;
+}
+
+/**
+ * findTypedef - Find a name declared by typedef.
+ *
+ * @param s The name
+ *
+ * @return The type the name stands for. -1 if not present
+ */
+int findTypedef(char *s) {
+    for (int i = 0; i < NextTypedefIndex; i++) {
+        if (*s == *TypedefTable[i].name && !strcmp(s, TypedefTable[i].name)) {
+            return TypedefTable[i].primitiveType;
+        }
+    }
+    return -1;
+}
+
+/**
+ * addTypedef - Add a typedef name to the typedef table.
+ *
+ * @param name The name being declared
+ * @param primitiveType The type it stands for
+ *
+ * @note Logs a fatal error if the name is taken or the table is full
+ */
+void addTypedef(char *name, int primitiveType) {
+    int typedefIndex;
+
+    if (findTypedef(name) != -1 || findGlobalSymbol(name) != -1) {
+        logFatals("Redeclaration of typedef name: ", name);
+    }
+    if ((typedefIndex = NextTypedefIndex++) >= NTYPEDEFS) {
+        logFatal("Too many typedefs");
+    }
+
+    TypedefTable[typedefIndex].name = strdup(name);
+    TypedefTable[typedefIndex].primitiveType = primitiveType;
+}
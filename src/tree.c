@@ -4,6 +4,31 @@
 #include "decl.h"
 #include "defs.h"
 
+/**
+ * allocateASTNode - Allocate the memory of an AST node. (helper function)
+ *
+ * NOTE:
+ * Nodes are never freed, and the trees of all the functions are kept until
+ * the end of the file, so nodes are carved out of large blocks: they take
+ * less memory, and a tree walk finds them close together.
+ *
+ * @return pointer to the uninitialized node
+ */
+static struct ASTnode *allocateASTNode(void) {
+    static struct ASTnode *block;
+    static int usedNodes = NASTBLOCKNODES;
+
+    if (usedNodes == NASTBLOCKNODES) {
+        block = malloc(NASTBLOCKNODES * sizeof(struct ASTnode));
+        if (block == NULL) {
+            fprintf(stderr, "out of memory in makeASTNode()\n");
+            exit(1);
+        }
+        usedNodes = 0;
+    }
+    return &block[usedNodes++];
+}
+
 /**
  * makeASTNode - Build and return a generic ASt node
  *
@@ -21,12 +46,7 @@ struct ASTnode *makeASTNode(int op, int primitiveType, struct ASTnode *left,
                             int intvalue) {
     struct ASTnode *n;
 
-    n = (struct ASTnode *)malloc(sizeof(struct ASTnode));
-    if (n == NULL) {
-        fprintf(stderr, "out of memory in makeASTNode()\n");
-        exit(1);
-    }
-
+    n = allocateASTNode();
     n->op = op;
     n->primitiveType = primitiveType;
     n->isRvalue = false; // default to lvalue until context sets rvalue
@@ -65,3 +85,24 @@ struct ASTnode *makeASTUnary(int op, int primitiveType, struct ASTnode *left,
                              int intvalue) {
     return makeASTNode(op, primitiveType, left, NULL, NULL, intvalue);
 }
+
+/**
+ * cloneAST - Make a deep copy of an AST tree.
+ *
+ * @param n The AST tree.
+ *
+ * @return The copy.
+ */
+struct ASTnode *cloneAST(struct ASTnode *n) {
+    struct ASTnode *copy;
+
+    if (n == NULL) {
+        return NULL;
+    }
+    copy = allocateASTNode();
+    *copy = *n;
+    copy->left = cloneAST(n->left);
+    copy->middle = cloneAST(n->middle);
+    copy->right = cloneAST(n->right);
+    return copy;
+}
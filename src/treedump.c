@@ -7,6 +7,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "data.h"
 #include "decl.h"
@@ -58,6 +59,24 @@ static const char *astOpToString(int op) {
         return "A_NOTHING";
     case A_ASSIGN:
         return "A_ASSIGN";
+    case A_ASSIGNADD:
+        return "A_ASSIGNADD";
+    case A_ASSIGNSUBTRACT:
+        return "A_ASSIGNSUBTRACT";
+    case A_ASSIGNMULTIPLY:
+        return "A_ASSIGNMULTIPLY";
+    case A_ASSIGNDIVIDE:
+        return "A_ASSIGNDIVIDE";
+    case A_ASSIGNBITWISEOR:
+        return "A_ASSIGNBITWISEOR";
+    case A_ASSIGNBITWISEAND:
+        return "A_ASSIGNBITWISEAND";
+    case A_ASSIGNBITWISEXOR:
+        return "A_ASSIGNBITWISEXOR";
+    case A_ASSIGNLSHIFT:
+        return "A_ASSIGNLSHIFT";
+    case A_ASSIGNRSHIFT:
+        return "A_ASSIGNRSHIFT";
     case A_LOGICALOR:
         return "A_LOGICALOR";
     case A_LOGICALAND:
@@ -94,6 +113,8 @@ static const char *astOpToString(int op) {
         return "A_RSHIFT";
     case A_INTEGERLITERAL:
         return "A_INTEGERLITERAL";
+    case A_FLOATLITERAL:
+        return "A_FLOATLITERAL";
     case A_STRINGLITERAL:
         return "A_STRINGLITERAL";
     case A_IDENTIFIER:
@@ -134,41 +155,112 @@ static const char *astOpToString(int op) {
         return "A_LOGICALNOT";
     case A_TOBOOLEAN:
         return "A_TOBOOLEAN";
+    case A_DOWHILE:
+        return "A_DOWHILE";
+    case A_BREAK:
+        return "A_BREAK";
+    case A_CONTINUE:
+        return "A_CONTINUE";
+    case A_SPLAT:
+        return "A_SPLAT";
+    case A_ATOMICLOAD:
+        return "A_ATOMICLOAD";
+    case A_ATOMICSTORE:
+        return "A_ATOMICSTORE";
+    case A_ATOMICFETCHADD:
+        return "A_ATOMICFETCHADD";
+    case A_ATOMICEXCHANGE:
+        return "A_ATOMICEXCHANGE";
+    case A_ATOMICCMPXCHG:
+        return "A_ATOMICCMPXCHG";
+    case A_ATOMICFENCE:
+        return "A_ATOMICFENCE";
+    case A_ASM:
+        return "A_ASM";
+    case A_ASMOPERAND:
+        return "A_ASMOPERAND";
+    case A_ASMRESULT:
+        return "A_ASMRESULT";
+    case A_EXPECT:
+        return "A_EXPECT";
+    case A_UNREACHABLE:
+        return "A_UNREACHABLE";
+    case A_PREFETCH:
+        return "A_PREFETCH";
     default:
         return "A_?";
     }
 }
 
+/**
+ * appendTypeName - Append the name of a type to a buffer.
+ *
+ * NOTE:
+ * Scalars keep their enum names; each pointer level appends "PTR" (so
+ * "int **" is P_INTPTRPTR), structs are P_STRUCT(tag) and arrays
+ * element[count].
+ *
+ * @param buf Buffer to append to.
+ * @param size Size of the buffer in bytes.
+ * @param primitiveType Type table index.
+ */
+static void appendTypeName(char *buf, size_t size, int primitiveType) {
+    static const char *scalarNames[P_NSCALARS] = {
+        "P_NONE", "P_VOID", "P_CHAR",  "P_INT",
+        "P_LONG", "P_UCHAR", "P_UINT", "P_ULONG",
+        "P_SHORT", "P_USHORT", "P_FLOAT", "P_DOUBLE",
+    };
+    struct typeTable *t = &TypeTable[primitiveType];
+    size_t len = strlen(buf);
+
+    switch (t->kind) {
+    case TY_SCALAR:
+        snprintf(buf + len, size - len, "%s", scalarNames[primitiveType]);
+        break;
+    case TY_POINTER:
+        appendTypeName(buf, size, t->base);
+        len = strlen(buf);
+        snprintf(buf + len, size - len, "PTR");
+        break;
+    case TY_ARRAY:
+        appendTypeName(buf, size, t->base);
+        len = strlen(buf);
+        snprintf(buf + len, size - len, "[%d]", t->count);
+        break;
+    case TY_FUNCTION:
+        appendTypeName(buf, size, t->base);
+        len = strlen(buf);
+        snprintf(buf + len, size - len, "()");
+        break;
+    case TY_STRUCT:
+        snprintf(buf + len, size - len, "P_STRUCT(%s)",
+                 StructTable[t->structIndex].name);
+        break;
+    case TY_VECTOR:
+        appendTypeName(buf, size, t->base);
+        len = strlen(buf);
+        snprintf(buf + len, size - len, "x%d", t->count);
+        break;
+    default:
+        snprintf(buf + len, size - len, "P_?");
+        break;
+    }
+}
+
 /**
  * primitiveTypeToString - Convert primitive type code to string.
  *
  * @param primitiveType Primitive type code.
  *
- * @return String representation of the primitive type.
+ * @return String representation of the primitive type, valid until the
+ * next call.
  */
 static const char *primitiveTypeToString(int primitiveType) {
-    switch (primitiveType) {
-    case P_NONE:
-        return "P_NONE";
-    case P_VOID:
-        return "P_VOID";
-    case P_CHAR:
-        return "P_CHAR";
-    case P_INT:
-        return "P_INT";
-    case P_LONG:
-        return "P_LONG";
-    case P_VOIDPTR:
-        return "P_VOIDPTR";
-    case P_CHARPTR:
-        return "P_CHARPTR";
-    case P_INTPTR:
-        return "P_INTPTR";
-    case P_LONGPTR:
-        return "P_LONGPTR";
-    default:
-        return "P_?";
-    }
+    static char buf[128];
+
+    buf[0] = '\0';
+    appendTypeName(buf, sizeof(buf), primitiveType);
+    return buf;
 }
 
 /**
@@ -191,6 +283,9 @@ static void dumpASTNodeHeader(struct ASTnode *n, int label, int level) {
     case A_INTEGERLITERAL:
         printf(" value=%d", n->v.intvalue);
         break;
+    case A_FLOATLITERAL:
+        printf(" value=%g", n->v.floatvalue);
+        break;
     case A_STRINGLITERAL:
         printf(" label=%d", n->v.identifierIndex);
         break;
@@ -207,6 +302,36 @@ static void dumpASTNodeHeader(struct ASTnode *n, int label, int level) {
     case A_SCALETYPE:
         printf(" size=%d", n->v.size);
         break;
+    case A_ATOMICLOAD:
+    case A_ATOMICSTORE:
+    case A_ATOMICFETCHADD:
+    case A_ATOMICEXCHANGE:
+    case A_ATOMICCMPXCHG:
+    case A_ATOMICFENCE:
+        printf(" order=%d", n->v.intvalue);
+        break;
+    case A_ASMOPERAND:
+    case A_ASMRESULT:
+        printf(" operand=%d", n->v.intvalue);
+        break;
+    case A_EXPECT:
+        printf(" expected=%d", n->v.intvalue);
+        break;
+    case A_PREFETCH:
+        printf(" locality=%d%s", n->v.intvalue & ~PREFETCH_WRITE,
+               (n->v.intvalue & PREFETCH_WRITE) ? " write" : "");
+        break;
+    case A_IF:
+        if (n->v.intvalue != BRANCH_UNKNOWN) {
+            printf(" then=%s",
+                   n->v.intvalue == BRANCH_LIKELY ? "likely" : "unlikely");
+        }
+        break;
+    case A_DEREFERENCE:
+        if (n->v.offset != 0) {
+            printf(" offset=%d", n->v.offset);
+        }
+        break;
     case A_WIDENTYPE:
     case A_TOBOOLEAN:
         if (n->left) {
@@ -349,12 +474,19 @@ static void dumpASTInternal(struct ASTnode *n, int label, int level,
         return;
 
     case A_WHILE:
+    case A_DOWHILE:
         if (n->left) {
             leftLabel = gendumpLabel();
             dumpIndent(level + 1);
             printf("cond -> L%03d\n", leftLabel);
             dumpASTInternal(n->left, leftLabel, level + 2, compacted);
         }
+        if (n->middle) {
+            middleLabel = gendumpLabel();
+            dumpIndent(level + 1);
+            printf("post -> L%03d\n", middleLabel);
+            dumpASTInternal(n->middle, middleLabel, level + 2, compacted);
+        }
         if (n->right) {
             rightLabel = gendumpLabel();
             dumpIndent(level + 1);
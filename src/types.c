@@ -6,7 +6,129 @@
 
 /**
  * Type system implemenetaion
+ *
+ * NOTE:
+ * Every type is an index into TypeTable. Derived types are hash-consed:
+ * asking for "pointer to int" twice returns the same index, so type
+ * equality is an integer comparison. Each entry caches its size and
+ * alignment so that neither the parser nor the backends recompute them.
+ */
+
+// Number of hash buckets of the type table
+#define NTYPEBUCKETS 256
+
+// First type table index of each hash bucket, or -1
+static int TypeBuckets[NTYPEBUCKETS];
+
+/**
+ * hashType - Hash the identifying fields of a type.
+ *
+ * @return Hash bucket index
+ */
+static int hashType(int kind, int base, int count, int structIndex) {
+    unsigned int h = kind;
+
+    h = h * 31 + base;
+    h = h * 31 + count;
+    h = h * 31 + structIndex;
+    return h % NTYPEBUCKETS;
+}
+
+/**
+ * internType - Find the type with the given identifying fields, adding it to
+ * the type table if it does not exist yet.
+ *
+ * NOTE:
+ * A new type's size and alignment are computed here from its base type, so
+ * the base type must be complete unless the new type is a pointer.
+ *
+ * @param kind Type kind (TY_*)
+ * @param base Pointee, element or return type (P_NONE if none)
+ * @param count Number of elements for arrays and vectors, 0 otherwise
+ * @param structIndex Index into StructTable for structs, -1 otherwise
+ *
+ * @return Index of the type in the type table
+ *
+ * @note Logs a fatal error if the type table is full
  */
+static int internType(int kind, int base, int count, int structIndex) {
+    struct typeTable *t;
+    int bucket = hashType(kind, base, count, structIndex);
+    int id;
+
+    for (id = TypeBuckets[bucket]; id != -1; id = TypeTable[id].next) {
+        t = &TypeTable[id];
+        if (t->kind == kind && t->base == base && t->count == count &&
+            t->structIndex == structIndex) {
+            return id;
+        }
+    }
+
+    if ((id = NextTypeIndex++) >= NTYPES) {
+        logFatal("Too many types");
+    }
+
+    t = &TypeTable[id];
+    t->kind = kind;
+    t->base = base;
+    t->count = count;
+    t->structIndex = structIndex;
+    t->next = TypeBuckets[bucket];
+    TypeBuckets[bucket] = id;
+
+    switch (kind) {
+    case TY_SCALAR:
+        // Scalars are their own index, see initTypeTable()
+        t->size = codegenGetPrimitiveTypeSize(id);
+        t->alignment = t->size > 0 ? t->size : 1;
+        break;
+    case TY_POINTER:
+        t->size = codegenGetPrimitiveTypeSize(P_ULONG);
+        t->alignment = t->size;
+        break;
+    case TY_ARRAY:
+        t->size = getTypeSize(base) * count;
+        t->alignment = getTypeAlignment(base);
+        break;
+    case TY_FUNCTION:
+        // Functions are not objects, they have no storage
+        t->size = 0;
+        t->alignment = 1;
+        break;
+    case TY_STRUCT:
+        // Incomplete until completeStructType()
+        t->size = -1;
+        t->alignment = 1;
+        break;
+    case TY_VECTOR:
+        // Aligned loads and stores need the vector's own alignment
+        t->size = getTypeSize(base) * count;
+        t->alignment = t->size;
+        break;
+    }
+
+    return id;
+}
+
+/**
+ * initTypeTable - Empty the type table and intern the scalar types, so that
+ * P_NONE ... P_ULONG are their own type table indices.
+ *
+ * NOTE:
+ * Sizes come from the target backend, which must be selected first.
+ */
+void initTypeTable(void) {
+    NextTypeIndex = 0;
+    for (int i = 0; i < NTYPEBUCKETS; i++) {
+        TypeBuckets[i] = -1;
+    }
+
+    for (int type = P_NONE; type < P_NSCALARS; type++) {
+        if (internType(TY_SCALAR, type, 0, -1) != type) {
+            logFatald("Internal compiler error: bad scalar type index ", type);
+        }
+    }
+}
 
 /**
  * isIntegerType - Check if a primitive type is an integer type
@@ -20,6 +142,11 @@ bool isIntegerType(int primitiveType) {
     case P_CHAR:
     case P_INT:
     case P_LONG:
+    case P_UCHAR:
+    case P_UINT:
+    case P_ULONG:
+    case P_SHORT:
+    case P_USHORT:
         return true;
     default:
         return false;
@@ -27,18 +154,18 @@ bool isIntegerType(int primitiveType) {
 }
 
 /**
- * isPointerType - Check if a primitive type is a pointer type
+ * isUnsignedType - Check if a primitive type is an unsigned integer type
  *
  * @param primitiveType Primitive type to check
  *
- * @return true if the type is a pointer type, false otherwise
+ * @return true if the type is an unsigned integer type, false otherwise
  */
-bool isPointerType(int primitiveType) {
+bool isUnsignedType(int primitiveType) {
     switch (primitiveType) {
-    case P_VOIDPTR:
-    case P_CHARPTR:
-    case P_INTPTR:
-    case P_LONGPTR:
+    case P_UCHAR:
+    case P_UINT:
+    case P_ULONG:
+    case P_USHORT:
         return true;
     default:
         return false;
@@ -46,51 +173,494 @@ bool isPointerType(int primitiveType) {
 }
 
 /**
- * primitiveTypeToPointerType - Convert a primitive type to its pointer type
+ * isNarrowIntegerType - Check if a primitive type is an integer type
+ * narrower than int, which C promotes to int in an expression
  *
- * @param primitiveType Primitive type to convert
+ * @param primitiveType Primitive type to check
  *
- * @return Corresponding pointer type
+ * @return true if the type is char, short or their unsigned types
  */
-int primitiveTypeToPointerType(int primitiveType) {
+bool isNarrowIntegerType(int primitiveType) {
+    return isIntegerType(primitiveType) && getTypeSize(primitiveType) < 4;
+}
+
+/**
+ * convertIntegerValue - Convert an integer value to an integer type, as
+ * the generated code does: truncate it to the type's size, then sign- or
+ * zero-extend it (char is unsigned)
+ *
+ * @param value The value
+ * @param primitiveType The integer type to convert to
+ *
+ * @return The converted value
+ */
+long convertIntegerValue(long value, int primitiveType) {
     switch (primitiveType) {
-    case P_VOID:
-        return P_VOIDPTR;
     case P_CHAR:
-        return P_CHARPTR;
+    case P_UCHAR:
+        return (unsigned char)value;
+    case P_SHORT:
+        return (short)value;
+    case P_USHORT:
+        return (unsigned short)value;
     case P_INT:
-        return P_INTPTR;
-    case P_LONG:
-        return P_LONGPTR;
+        return (int)value;
+    case P_UINT:
+        return (unsigned int)value;
     default:
-        logFatald("Internal compiler error: unknown primitive type ",
-                  primitiveType);
-        return -1; // Unreachable
+        return value;
     }
 }
 
 /**
- * pointerToPrimitiveType - Convert a pointer type to its primitive type
+ * isFloatType - Check if a primitive type is a floating-point type
+ *
+ * @param primitiveType Primitive type to check
+ *
+ * @return true if the type is float or double, false otherwise
+ */
+bool isFloatType(int primitiveType) {
+    return primitiveType == P_FLOAT || primitiveType == P_DOUBLE;
+}
+
+/**
+ * isPointerType - Check if a primitive type is a pointer type
  *
- * @param primitiveType Pointer type to convert
+ * @param primitiveType Primitive type to check
  *
- * @return Corresponding primitive type
+ * @return true if the type is a pointer type, false otherwise
+ */
+bool isPointerType(int primitiveType) {
+    return TypeTable[primitiveType].kind == TY_POINTER;
+}
+
+/**
+ * isArrayType - Check if a primitive type is an array type
+ *
+ * @param primitiveType Primitive type to check
+ *
+ * @return true if the type is an array type, false otherwise
+ */
+bool isArrayType(int primitiveType) {
+    return TypeTable[primitiveType].kind == TY_ARRAY;
+}
+
+/**
+ * isStructType - Check if a primitive type is a struct type
+ *
+ * @param primitiveType Primitive type to check
+ *
+ * @return true if the type is a struct type, false otherwise
+ */
+bool isStructType(int primitiveType) {
+    return TypeTable[primitiveType].kind == TY_STRUCT;
+}
+
+/**
+ * isVectorType - Check if a primitive type is a SIMD vector type
+ *
+ * @param primitiveType Primitive type to check
+ *
+ * @return true if the type is a vector type, false otherwise
+ */
+bool isVectorType(int primitiveType) {
+    return TypeTable[primitiveType].kind == TY_VECTOR;
+}
+
+/**
+ * primitiveTypeToPointerType - Get the type of a pointer to a type
+ *
+ * @param primitiveType Pointee type
+ *
+ * @return Corresponding pointer type
+ */
+int primitiveTypeToPointerType(int primitiveType) {
+    return internType(TY_POINTER, primitiveType, 0, -1);
+}
+
+/**
+ * pointerToPrimitiveType - Get the type a pointer type points to
+ *
+ * @param primitiveType Pointer type
+ *
+ * @return Corresponding pointee type
  */
 int pointerToPrimitiveType(int primitiveType) {
-    switch (primitiveType) {
-    case P_VOIDPTR:
-        return P_VOID;
-    case P_CHARPTR:
-        return P_CHAR;
-    case P_INTPTR:
-        return P_INT;
-    case P_LONGPTR:
-        return P_LONG;
-    default:
-        logFatald("Internal compiler error: unknown pointer type ",
+    if (!isPointerType(primitiveType)) {
+        logFatald("Internal compiler error: not a pointer type ",
                   primitiveType);
-        return -1; // Unreachable
     }
+    return TypeTable[primitiveType].base;
+}
+
+/**
+ * arrayTypeOf - Get the type of an array of count elements
+ *
+ * @param elementType Type of the elements (must be complete)
+ * @param count Number of elements
+ *
+ * @return The array type
+ */
+int arrayTypeOf(int elementType, int count) {
+    return internType(TY_ARRAY, elementType, count, -1);
+}
+
+/**
+ * functionTypeOf - Get the type of a function returning a type
+ *
+ * @param returnType Return type of the function
+ *
+ * @return The function type
+ */
+int functionTypeOf(int returnType) {
+    return internType(TY_FUNCTION, returnType, 0, -1);
+}
+
+/**
+ * structTypeOf - Get the type of a struct in the struct table
+ *
+ * @param structIndex Index of the struct in StructTable
+ *
+ * @return The struct's type
+ */
+int structTypeOf(int structIndex) {
+    return internType(TY_STRUCT, P_NONE, 0, structIndex);
+}
+
+/**
+ * vectorTypeOf - Get the type of a SIMD vector of a scalar type, as
+ * declared by "__attribute__((vector_size(bytes)))"
+ *
+ * NOTE:
+ * Only VECTORSIZE-byte vectors of integer or floating-point lanes exist:
+ * each one fills exactly one XMM (x86-64) or Q (AArch64) register.
+ *
+ * @param elementType Type of the lanes
+ * @param bytes Size of the vector in bytes
+ *
+ * @return The vector type
+ */
+int vectorTypeOf(int elementType, int bytes) {
+    if (!isIntegerType(elementType) && !isFloatType(elementType)) {
+        logFatal("Vector lanes must have an integer or floating-point type");
+    }
+    if (bytes != VECTORSIZE) {
+        logFatald("Unsupported vector size (only 16 bytes): ", bytes);
+    }
+    return internType(TY_VECTOR, elementType,
+                      bytes / getTypeSize(elementType), -1);
+}
+
+/**
+ * completeStructType - Record the size and alignment of a struct type once
+ * its members have been laid out.
+ *
+ * @param primitiveType Struct type
+ * @param size Size in bytes, padded to a multiple of the alignment
+ * @param alignment Alignment in bytes
+ */
+void completeStructType(int primitiveType, int size, int alignment) {
+    TypeTable[primitiveType].size = size;
+    TypeTable[primitiveType].alignment = alignment;
+}
+
+/**
+ * structOfType - Get the struct table entry of a struct type
+ *
+ * @param primitiveType Struct type
+ *
+ * @return The struct's entry in StructTable
+ */
+struct structTable *structOfType(int primitiveType) {
+    if (!isStructType(primitiveType)) {
+        logFatald("Internal compiler error: not a struct type ",
+                  primitiveType);
+    }
+    return &StructTable[TypeTable[primitiveType].structIndex];
+}
+
+/**
+ * getTypeSize - Get the size of a value of the given type in bytes
+ *
+ * NOTE:
+ * Using an incomplete struct (declared, but not yet defined) by value is an
+ * error.
+ *
+ * @param primitiveType Type to query
+ *
+ * @return Size in bytes
+ */
+int getTypeSize(int primitiveType) {
+    if (TypeTable[primitiveType].size < 0) {
+        logFatals("Incomplete struct type: ",
+                  structOfType(primitiveType)->name);
+    }
+    return TypeTable[primitiveType].size;
+}
+
+/**
+ * getTypeAlignment - Get the alignment of a value of the given type in bytes
+ *
+ * NOTE:
+ * Scalars are naturally aligned, structs take the largest alignment of
+ * their members and arrays the alignment of their elements.
+ *
+ * @param primitiveType Type to query
+ *
+ * @return Alignment in bytes (at least 1)
+ */
+int getTypeAlignment(int primitiveType) {
+    getTypeSize(primitiveType); // Rejects incomplete structs
+    return TypeTable[primitiveType].alignment;
+}
+
+/**
+ * getSymbolSize - Get the number of bytes of storage a variable or array
+ * symbol occupies
+ *
+ * @param id Symbol table index
+ *
+ * @return Size in bytes
+ */
+int getSymbolSize(int id) { return getTypeSize(SymbolTable[id].primitiveType); }
+
+/**
+ * getSymbolAlignment - Get the alignment of a variable or array symbol's
+ * storage in bytes
+ *
+ * @param id Symbol table index
+ *
+ * @return Alignment in bytes
+ */
+int getSymbolAlignment(int id) {
+    return getTypeAlignment(SymbolTable[id].primitiveType);
+}
+
+/**
+ * getMemoryAccessType - Get the scalar type whose load/store width and
+ * extension the backends use to access a value of the given type in memory
+ *
+ * NOTE:
+ * Every pointer is a 64-bit value and is accessed like an unsigned long.
+ *
+ * @param primitiveType Type of the value
+ *
+ * @return The scalar type to access it as
+ */
+int getMemoryAccessType(int primitiveType) {
+    if (isPointerType(primitiveType)) {
+        return P_ULONG;
+    }
+    return primitiveType;
+}
+
+/**
+ * convertFloatOperand - Convert an integer or floating-point AST node to
+ * another arithmetic type, where one of the two types is floating-point.
+ * (helper function)
+ *
+ * NOTE:
+ * Literals are converted at compile time (a float literal is rounded to
+ * float, an integer literal made from a floating-point one truncates);
+ * anything else gets an A_WIDENTYPE node that converts at run time.
+ *
+ * @param node AST node to convert
+ * @param type Type to convert to
+ *
+ * @return The converted AST node
+ */
+static struct ASTnode *convertFloatOperand(struct ASTnode *node, int type) {
+    double value;
+
+    switch (node->op) {
+    case A_INTEGERLITERAL:
+        value = node->v.intvalue;
+        break;
+    case A_FLOATLITERAL:
+        value = node->v.floatvalue;
+        break;
+    default:
+        return makeASTUnary(A_WIDENTYPE, type, node, 0);
+    }
+
+    if (isIntegerType(type)) {
+        return makeASTLeaf(A_INTEGERLITERAL, type, (int)value);
+    }
+    node = makeASTLeaf(A_FLOATLITERAL, type, 0);
+    node->v.floatvalue = (type == P_FLOAT) ? (float)value : value;
+    return node;
+}
+
+/**
+ * coerceFloatForOp - Coerce an AST node where the node's type or the
+ * context type is floating-point. (helper function)
+ *
+ * NOTE:
+ * Only the four arithmetic operators, the comparisons and assignments
+ * take floating-point operands. In an expression, an integer operand
+ * converts to the floating-point type and a float to a double. Only an
+ * assignment or a return converts the other way (double to float, or a
+ * floating-point value to an integer).
+ *
+ * @param node AST node to coerce
+ * @param contextType Peer/expected primitive type
+ * @param op AST operator context
+ *
+ * @return Coerced AST node if types are compatible, NULL otherwise
+ */
+static struct ASTnode *coerceFloatForOp(struct ASTnode *node, int contextType,
+                                        int op) {
+    int nodeType = node->primitiveType;
+
+    if ((!isIntegerType(nodeType) && !isFloatType(nodeType)) ||
+        (!isIntegerType(contextType) && !isFloatType(contextType))) {
+        return NULL;
+    }
+
+    switch (op) {
+    case A_NOTHING:
+    case A_ADD:
+    case A_SUBTRACT:
+    case A_MULTIPLY:
+    case A_DIVIDE:
+    case A_EQ:
+    case A_NE:
+    case A_LT:
+    case A_GT:
+    case A_LE:
+    case A_GE:
+        break;
+    default:
+        return NULL;
+    }
+
+    if (nodeType == contextType) {
+        return node;
+    }
+    if (op == A_NOTHING || isIntegerType(nodeType) ||
+        contextType == P_DOUBLE) {
+        return convertFloatOperand(node, contextType);
+    }
+    // A float or double operand in an expression with a narrower peer: the
+    // peer's coercion converts the peer instead
+    return NULL;
+}
+
+/**
+ * isVectorOperationSupported - Check if a binary operator applies to a
+ * vector type, lane by lane
+ *
+ * NOTE:
+ * This is the subset that SSE2 and NEON both do in a few instructions:
+ * - '+' and '-' on every lane type
+ * - '*' on 16-bit, 32-bit and floating-point lanes (SSE2 multiplies no
+ *   8-bit or 64-bit lanes)
+ * - '/' on floating-point lanes only
+ * - '&', '|' and '^' on integer lanes
+ * - '<<' and '>>' on 16-bit, 32-bit and 64-bit integer lanes, except an
+ *   arithmetic '>>' of 64-bit lanes (no such SSE2 instruction)
+ *
+ * @param ASTop The binary operator (e.g. A_ADD)
+ * @param primitiveType The vector type
+ *
+ * @return true if the operator is supported on the vector type
+ */
+bool isVectorOperationSupported(int ASTop, int primitiveType) {
+    int lane = TypeTable[primitiveType].base;
+    int laneSize = getTypeSize(lane);
+
+    switch (ASTop) {
+    case A_ADD:
+    case A_SUBTRACT:
+        return true;
+    case A_MULTIPLY:
+        return isFloatType(lane) || laneSize == 2 || laneSize == 4;
+    case A_DIVIDE:
+        return isFloatType(lane);
+    case A_BITWISEAND:
+    case A_BITWISEOR:
+    case A_BITWISEXOR:
+        return isIntegerType(lane);
+    case A_LSHIFT:
+        return isIntegerType(lane) && laneSize > 1;
+    case A_RSHIFT:
+        return isIntegerType(lane) && laneSize > 1 &&
+               (laneSize < 8 || isUnsignedType(lane));
+    default:
+        return false;
+    }
+}
+
+/**
+ * coerceVectorForOp - Coerce an AST node where the node's type or the
+ * context type is a vector. (helper function)
+ *
+ * NOTE:
+ * Both operands of a vector operation have the same vector type, except
+ * that a scalar may stand for a vector with the scalar in every lane: it
+ * is converted to the lane type and wrapped in an A_SPLAT node. A shift
+ * count is always a scalar integer instead: "v << 2" shifts every lane
+ * by 2. Assignments take the same vector type only.
+ *
+ * @param node AST node to coerce
+ * @param contextType Peer/expected primitive type
+ * @param op AST operator context
+ *
+ * @return Coerced AST node if types are compatible, NULL otherwise
+ */
+static struct ASTnode *coerceVectorForOp(struct ASTnode *node,
+                                         int contextType, int op) {
+    int nodeType = node->primitiveType;
+    int lane;
+
+    if (op == A_NOTHING) {
+        return (nodeType == contextType) ? node : NULL;
+    }
+
+    if (isVectorType(nodeType)) {
+        if (!isVectorOperationSupported(op, nodeType)) {
+            return NULL;
+        }
+        if (op == A_LSHIFT || op == A_RSHIFT) {
+            return isIntegerType(contextType) ? node : NULL;
+        }
+        // A scalar peer is splatted by its own coercion
+        return (nodeType == contextType) ? node : NULL;
+    }
+
+    if (!isVectorOperationSupported(op, contextType) ||
+        op == A_LSHIFT || op == A_RSHIFT) {
+        return NULL;
+    }
+    lane = TypeTable[contextType].base;
+    if (isIntegerType(nodeType) && isFloatType(lane) &&
+        node->op != A_INTEGERLITERAL) {
+        // Like GCC, only a constant integer splats into floating-point lanes
+        return NULL;
+    }
+    if ((node = coerceASTTypeForOp(node, lane, A_NOTHING)) == NULL) {
+        return NULL;
+    }
+    return makeASTUnary(A_SPLAT, contextType, node, 0);
+}
+
+/**
+ * promoteInteger - Apply C's integer promotion to an operand: a value of
+ * a type narrower than int is converted to int.
+ * e.g., "uc - 10" is computed as an int, and is negative for uc < 10
+ *
+ * @param node AST node of the operand
+ *
+ * @return The promoted AST node (the node itself if it is not narrower)
+ */
+struct ASTnode *promoteInteger(struct ASTnode *node) {
+    if (!isNarrowIntegerType(node->primitiveType)) {
+        return node;
+    }
+    if (node->op == A_INTEGERLITERAL) {
+        return makeASTLeaf(A_INTEGERLITERAL, P_INT, node->v.intvalue);
+    }
+    return makeASTUnary(A_WIDENTYPE, P_INT, node, 0);
 }
 
 /**
@@ -99,8 +669,14 @@ int pointerToPrimitiveType(int primitiveType) {
  *
  * Depending on the operator context, this may:
  * - widen integer scalar types (e.g. char -> int/long)
+ * - narrow an integer in a no-op context (e.g. "c = i" with a char c), as
+ *   C converts a value to the type it is stored as
+ * - convert a signed integer to the unsigned type of the same size
+ *   (e.g. int -> unsigned int), as in C's usual arithmetic conversions
  * - scale an integer index for pointer arithmetic (e.g. int* + 1 -> +4 bytes)
  * - accept identical pointer types in a no-op context (assign/return checking)
+ * - convert between integer and floating-point types (see coerceFloatForOp)
+ * - splat a scalar operand of a vector operation (see coerceVectorForOp)
  *
  * @param node AST node to coerce
  * @param contextType Peer/expected primitive type (depends on op)
@@ -116,6 +692,13 @@ struct ASTnode *coerceASTTypeForOp(struct ASTnode *node, int contextType,
 
     nodeType = node->primitiveType;
 
+    if (isVectorType(nodeType) || isVectorType(contextType)) {
+        return coerceVectorForOp(node, contextType, op);
+    }
+    if (isFloatType(nodeType) || isFloatType(contextType)) {
+        return coerceFloatForOp(node, contextType, op);
+    }
+
     // Compare scalar integer types
     if (isIntegerType(nodeType) && isIntegerType(contextType)) {
         // Both types are the same, it's ok
@@ -126,15 +709,37 @@ struct ASTnode *coerceASTTypeForOp(struct ASTnode *node, int contextType,
         nodeSizeBytes = codegenGetPrimitiveTypeSize(nodeType);
         contextSizeBytes = codegenGetPrimitiveTypeSize(contextType);
 
-        // Tree's size is too big
+        // Tree's size is too big: only a store or a return narrows it.
+        // A literal is converted right away, e.g. "us = 65535" stores the
+        // unsigned short 65535
         if (nodeSizeBytes > contextSizeBytes) {
-            return NULL;
+            if (op != A_NOTHING) {
+                return NULL;
+            }
+            if (node->op == A_INTEGERLITERAL) {
+                return makeASTLeaf(
+                    A_INTEGERLITERAL, contextType,
+                    convertIntegerValue(node->v.intvalue, contextType));
+            }
+            return makeASTUnary(A_WIDENTYPE, contextType, node, 0);
         }
 
         // Widen the right size
         if (contextSizeBytes > nodeSizeBytes) {
             return makeASTUnary(A_WIDENTYPE, contextType, node, 0);
         }
+
+        // Same size, different signedness.
+        // Assignments and returns simply store/return the bits.
+        if (op == A_NOTHING) {
+            return node;
+        }
+        // In an expression the signed side becomes unsigned, never the
+        // other way around (the peer's coercion handles that case).
+        if (isUnsignedType(contextType)) {
+            return makeASTUnary(A_WIDENTYPE, contextType, node, 0);
+        }
+        return NULL;
     }
 
     // Pointer type is on the left
@@ -155,8 +760,8 @@ struct ASTnode *coerceASTTypeForOp(struct ASTnode *node, int contextType,
         if (isIntegerType(nodeType) && isPointerType(contextType)) {
             // Scale by the size of the pointed-to type, not by the pointer
             // size. E.g. int* + 1 => +4 bytes on LP64.
-            contextSizeBytes = codegenGetPrimitiveTypeSize(
-                pointerToPrimitiveType(contextType));
+            contextSizeBytes =
+                getTypeSize(pointerToPrimitiveType(contextType));
             if (contextSizeBytes > 1) {
                 return makeASTUnary(A_SCALETYPE, contextType, node,
                                     contextSizeBytes);
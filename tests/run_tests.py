@@ -2,10 +2,14 @@
 from __future__ import annotations
 
 import argparse
+import contextlib
 import difflib
+import io
+import os
 import shutil
 import subprocess
 import sys
+from concurrent.futures import ProcessPoolExecutor
 from dataclasses import dataclass
 from pathlib import Path
 from typing import Sequence, Tuple
@@ -94,13 +98,16 @@ def print_output_diff(expected_text: str, actual_text: str, test_name: str) -> N
 def discover_tests(tests_dir: Path) -> list[TestCase]:
     """
     Discovers all test cases in the given tests directory.
-    A test case consists of a .kc source file and a corresponding .expected file.
+    A test case consists of a .kc source file and a corresponding .expected file,
+    or a .error file for a source that keccc must reject.
     Returns a list of TestCase objects.
     """
     test_cases: list[TestCase] = []
     for source_path in sorted(tests_dir.glob("*.c")):
         name = source_path.stem
         expected_path = source_path.with_suffix(".expected")
+        if not expected_path.exists() and source_path.with_suffix(".error").exists():
+            expected_path = source_path.with_suffix(".error")
         test_cases.append(TestCase(name=name, source=source_path, expected=expected_path))
     return test_cases
 
@@ -114,11 +121,21 @@ def ensure_empty_dir(path: Path) -> None:
     path.mkdir(parents=True, exist_ok=True)
 
 
+# Exit status meson reports as a skipped test
+EXIT_SKIPPED = 77
+
+# Runtime archive built by meson for each target (src/rt/<arch>/meson.build)
+RUNTIME_LIBRARY = {
+    "nasm": Path("src") / "rt" / "x86_64" / "libkecrt.a",
+    "aarch64": Path("src") / "rt" / "aarch64" / "libkecrt.a",
+}
+
+
 def run_single_test_nasm(
     test_case: TestCase,
     workdir: Path,
     keccc_path: Path,
-    source_root: Path,
+    runtime_lib: Path,
     nasm: str,
     ld: str,
 ) -> Tuple[bool, str]:
@@ -129,19 +146,9 @@ def run_single_test_nasm(
     # Build artifacts in workdir
     out_asm = workdir / "out.asm"
     out_o = workdir / "out.o"
-    start_o = workdir / "start.o"
-    printint_o = workdir / "printint.o"
-    printchar_o = workdir / "printchar.o"
-    printstring_o = workdir / "printstring.o"
     out_bin = workdir / "out"
 
-    rt_dir = source_root / "src" / "rt" / "x86_64"
-    start_asm = rt_dir / "start.asm"
-    printint_asm = rt_dir / "printint.asm"
-    printchar_asm = rt_dir / "printchar.asm"
-    printstring_asm = rt_dir / "printstring.asm"
-
-    # 1) Compile to assembly (keccc writes out.s in cwd)
+    # 1) Compile to assembly
     ok, _, _ = run_command(
         [str(keccc_path), "--output", "out.asm", "--target", "nasm", str(test_case.source)],
         cwd=workdir,
@@ -150,9 +157,8 @@ def run_single_test_nasm(
     if not ok:
         return False, ""
 
-    # keccc wrote "out.s" into workdir; keep it as out.s already
-    if not (workdir / "out.asm").exists():
-        print(f"[FAIL] {test_case.name}: keccc did not produce out.s in {workdir}")
+    if not out_asm.exists():
+        print(f"[FAIL] {test_case.name}: keccc did not produce out.asm in {workdir}")
         return False, ""
 
     # 2) Assemble program
@@ -164,49 +170,16 @@ def run_single_test_nasm(
     if not ok:
         return False, ""
 
-    # 3) Assemble runtime objects
-    ok, _, _ = run_command(
-        [nasm, "-felf64", str(start_asm), "-o", str(start_o)],
-        cwd=workdir,
-        description=f"{test_case.name}: nasm start.asm",
-    )
-    if not ok:
-        return False, ""
-
-    ok, _, _ = run_command(
-        [nasm, "-felf64", str(printint_asm), "-o", str(printint_o)],
-        cwd=workdir,
-        description=f"{test_case.name}: nasm printint.asm",
-    )
-    if not ok:
-        return False, ""
-
-    ok, _, _ = run_command(
-        [nasm, "-felf64", str(printchar_asm), "-o", str(printchar_o)],
-        cwd=workdir,
-        description=f"{test_case.name}: nasm printchar.asm",
-    )
-    if not ok:
-        return False, ""
-
+    # 3) Link against the prebuilt runtime (no libc)
     ok, _, _ = run_command(
-        [nasm, "-felf64", str(printstring_asm), "-o", str(printstring_o)],
-        cwd=workdir,
-        description=f"{test_case.name}: nasm printstring.asm",
-    )
-    if not ok:
-        return False, ""
-
-    # 4) Link (no libc)
-    ok, _, _ = run_command(
-        [ld, "-o", str(out_bin), str(out_o), str(start_o), str(printint_o), str(printchar_o), str(printstring_o)],
+        [ld, "-o", str(out_bin), str(out_o), str(runtime_lib)],
         cwd=workdir,
         description=f"{test_case.name}: ld",
     )
     if not ok:
         return False, ""
 
-    # 5) Run
+    # 4) Run
     ok, stdout, _ = run_command(
         [str(out_bin)],
         cwd=workdir,
@@ -220,7 +193,7 @@ def run_single_test_aarch64(
     test_case: TestCase,
     workdir: Path,
     keccc_path: Path,
-    source_root: Path,
+    runtime_lib: Path,
     as_path: str,
     ld_path: str,
     qemu: str,
@@ -232,19 +205,9 @@ def run_single_test_aarch64(
     """
     out_s = workdir / "out.s"
     out_o = workdir / "out.o"
-    start_o = workdir / "start.o"
-    printint_o = workdir / "printint.o"
-    printchar_o = workdir / "printchar.o"
-    printstring_o = workdir / "printstring.o"
     out_bin = workdir / "out_aarch64"
 
-    rt_dir = source_root / "src" / "rt" / "aarch64"
-    start_s = rt_dir / "start.s"
-    printint_s = rt_dir / "printint.s"
-    printchar_s = rt_dir / "printchar.s"
-    printstring_s = rt_dir / "printstring.s"
-
-    # 1) Compile to assembly (keccc writes out.s in cwd)
+    # 1) Compile to assembly
     ok, _, _ = run_command(
         [str(keccc_path), "--output", "out.s", "--target", "aarch64", str(test_case.source)],
         cwd=workdir,
@@ -253,7 +216,7 @@ def run_single_test_aarch64(
     if not ok:
         return False, ""
 
-    if not (workdir / "out.s").exists():
+    if not out_s.exists():
         print(f"[FAIL] {test_case.name}: keccc did not produce out.s in {workdir}")
         return False, ""
 
@@ -266,49 +229,16 @@ def run_single_test_aarch64(
     if not ok:
         return False, ""
 
-    # 3) Assemble runtime objects
+    # 3) Link against the prebuilt runtime (no libc)
     ok, _, _ = run_command(
-        [as_path, str(start_s), "-o", str(start_o)],
-        cwd=workdir,
-        description=f"{test_case.name}: aarch64 as start.asm",
-    )
-    if not ok:
-        return False, ""
-
-    ok, _, _ = run_command(
-        [as_path, str(printint_s), "-o", str(printint_o)],
-        cwd=workdir,
-        description=f"{test_case.name}: aarch64 as printint.s",
-    )
-    if not ok:
-        return False, ""
-
-    ok, _, _ = run_command(
-        [as_path, str(printchar_s), "-o", str(printchar_o)],
-        cwd=workdir,
-        description=f"{test_case.name}: aarch64 as printchar.s",
-    )
-    if not ok:
-        return False, ""
-
-    ok, _, _ = run_command(
-        [as_path, str(printstring_s), "-o", str(printstring_o)],
-        cwd=workdir,
-        description=f"{test_case.name}: aarch64 as printstring.s",
-    )
-    if not ok:
-        return False, ""
-
-    # 4) Link (no libc)
-    ok, _, _ = run_command(
-        [ld_path, "-o", str(out_bin), str(out_o), str(start_o), str(printint_o), str(printchar_o), str(printstring_o)],
+        [ld_path, "-o", str(out_bin), str(out_o), str(runtime_lib)],
         cwd=workdir,
         description=f"{test_case.name}: aarch64 ld",
     )
     if not ok:
         return False, ""
 
-    # 5) Run via qemu-user
+    # 4) Run via qemu-user
     ok, stdout, _ = run_command(
         [qemu, str(out_bin)],
         cwd=workdir,
@@ -318,15 +248,116 @@ def run_single_test_aarch64(
     return True, stdout
 
 
+def find_tools(target: str) -> dict[str, str]:
+    """
+    Looks up the assembler, linker and (for aarch64) emulator of a target.
+    """
+    if target == "nasm":
+        return {"nasm": find_required_executable("nasm"),
+                "ld": find_required_executable("ld")}
+    return {"as": find_required_executable("aarch64-linux-gnu-as"),
+            "ld": find_required_executable("aarch64-linux-gnu-ld"),
+            "qemu": find_required_executable("qemu-aarch64")}
+
+
+def run_error_test(
+    test_case: TestCase,
+    target: str,
+    workdir: Path,
+    keccc_path: Path,
+) -> bool:
+    """
+    Runs a test case that keccc must reject: compiling it has to fail, with
+    the message of the .error file on stderr.
+    Returns True if it does.
+    """
+    process = subprocess.run(
+        [str(keccc_path), "--output", "out.s", "--target", target, str(test_case.source)],
+        cwd=workdir,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        text=True,
+    )
+    message = test_case.expected.read_text().strip()
+    if process.returncode == 0:
+        print(f"[FAIL] {test_case.name} ({target}): keccc accepted the program")
+        return False
+    if message not in process.stderr:
+        print(f"[FAIL] {test_case.name} ({target}): expected the error: {message}")
+        print("  STDERR:\n" + process.stderr)
+        return False
+    print(f"[PASS] {test_case.name} ({target})")
+    return True
+
+
+def run_test_job(
+    test_case: TestCase,
+    target: str,
+    workdir: Path,
+    keccc_path: Path,
+    runtime_lib: Path,
+    tools: dict[str, str],
+) -> Tuple[bool, str]:
+    """
+    Builds, runs and checks one test case for one target in a worker process.
+    Everything the test prints is captured and returned so that the reports
+    of concurrent tests don't interleave.
+    Returns a tuple of (passed: bool, report: str).
+    """
+    report = io.StringIO()
+    with contextlib.redirect_stdout(report):
+        print(f"== Running {target} test: {test_case.name}")
+        ensure_empty_dir(workdir)
+
+        if test_case.expected.suffix == ".error":
+            ok = run_error_test(test_case, target, workdir, keccc_path)
+            return ok, report.getvalue()
+
+        if target == "nasm":
+            ok, stdout = run_single_test_nasm(
+                test_case=test_case,
+                workdir=workdir,
+                keccc_path=keccc_path,
+                runtime_lib=runtime_lib,
+                nasm=tools["nasm"],
+                ld=tools["ld"],
+            )
+        else:
+            ok, stdout = run_single_test_aarch64(
+                test_case=test_case,
+                workdir=workdir,
+                keccc_path=keccc_path,
+                runtime_lib=runtime_lib,
+                as_path=tools["as"],
+                ld_path=tools["ld"],
+                qemu=tools["qemu"],
+            )
+
+        if ok:
+            expected_text = test_case.expected.read_text()
+            if stdout.strip() != expected_text.strip():
+                print_output_diff(expected_text, stdout, f"{test_case.name} ({target})")
+                ok = False
+            else:
+                print(f"[PASS] {test_case.name} ({target})")
+
+    return ok, report.getvalue()
+
+
 def main(argv: Sequence[str]) -> int:
     parser = argparse.ArgumentParser()
-    parser.add_argument("--target", required=True, choices=["nasm", "aarch64"])
+    parser.add_argument("--target", required=True, action="append",
+                        choices=["nasm", "aarch64"],
+                        help="target to test; repeat to test several at once")
+    parser.add_argument("--jobs", "-j", type=int, default=os.cpu_count() or 1,
+                        help="number of test cases run in parallel")
     parser.add_argument("source_root")
     parser.add_argument("build_root")
     args = parser.parse_args(list(argv))
 
     source_root = Path(args.source_root).resolve()
     build_root = Path(args.build_root).resolve()
+    targets = list(dict.fromkeys(args.target))
 
     tests_dir = source_root / "tests" / "testcases"
     keccc_path = build_root / "src" / "keccc"
@@ -337,73 +368,56 @@ def main(argv: Sequence[str]) -> int:
 
     test_cases = discover_tests(tests_dir)
     if not test_cases:
-        print(f"No *.kc tests found under {tests_dir}")
+        print(f"No *.c tests found under {tests_dir}")
         return 1
 
-    # Workspace per target to avoid filename clashes
-    work_root = build_root / "tests-work" / args.target
-    work_root.mkdir(parents=True, exist_ok=True)
-
-    # Tool discovery
-    if args.target == "nasm":
-        nasm = find_required_executable("nasm")
-        ld = find_required_executable("ld")
-    else:
-        as_path = find_required_executable("aarch64-linux-gnu-as")
-        ld_path = find_required_executable("aarch64-linux-gnu-ld")
-        qemu = find_required_executable("qemu-aarch64")
+    for tc in test_cases:
+        if not tc.expected.exists():
+            print(f"[FATAL] Missing expected output or error file: {tc.expected}")
+            return 1
 
-    all_ok = True
+    # meson only builds a target's libkecrt.a when it finds the target's
+    # assembler (src/rt/<arch>/meson.build); skip the targets without one
+    tools: dict[str, dict[str, str]] = {}
+    for target in targets:
+        runtime_lib = build_root / RUNTIME_LIBRARY[target]
+        if not runtime_lib.exists():
+            print(f"[SKIP] {target}: runtime library not built at {runtime_lib}")
+            continue
+        tools[target] = find_tools(target)
+    targets = [target for target in targets if target in tools]
+    if not targets:
+        return EXIT_SKIPPED
 
     """
-    For each test case:
+    For each target and test case, in a pool of worker processes:
     1) Compile with keccc to assembly
     2) Assemble with nasm/as
-    3) Link with ld
+    3) Link with ld against libkecrt.a
     4) Run the binary (directly or via qemu)
     5) Compare output to expected
-    6) Report results
+    Reports are printed in submission order once each job finishes.
     """
-    for tc in test_cases:
-        print(f"== Running {args.target} test: {tc.name}")
-
-        if not tc.expected.exists():
-            print(f"[FATAL] Missing expected output file: {tc.expected}")
-            return 1
-
-        workdir = work_root / tc.name
-        ensure_empty_dir(workdir)
-
-        if args.target == "nasm":
-            ok, stdout = run_single_test_nasm(
-                test_case=tc,
-                workdir=workdir,
-                keccc_path=keccc_path,
-                source_root=source_root,
-                nasm=nasm, # type: ignore
-                ld=ld, # type: ignore
-            )
-        else:
-            ok, stdout = run_single_test_aarch64(
-                test_case=tc,
-                workdir=workdir,
-                keccc_path=keccc_path,
-                source_root=source_root,
-                as_path=as_path, # type: ignore
-                ld_path=ld_path, # type: ignore
-                qemu=qemu, # type: ignore
+    all_ok = True
+    with ProcessPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        jobs = [
+            pool.submit(
+                run_test_job,
+                tc,
+                target,
+                # Workspace per target and test case to avoid filename clashes
+                build_root / "tests-work" / target / tc.name,
+                keccc_path,
+                build_root / RUNTIME_LIBRARY[target],
+                tools[target],
             )
-
-        if not ok:
-            all_ok = False
-            continue
-
-        expected_text = tc.expected.read_text()
-        if stdout.strip() != expected_text.strip():
-            print_output_diff(expected_text, stdout, f"{tc.name} ({args.target})")
-            all_ok = False
-        else:
-            print(f"[PASS] {tc.name} ({args.target})")
+            for target in targets
+            for tc in test_cases
+        ]
+        for job in jobs:
+            ok, report = job.result()
+            print(report, end="")
+            all_ok = all_ok and ok
 
     return 0 if all_ok else 1
 
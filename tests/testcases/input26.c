@@ -0,0 +1,20 @@
+int fred() {
+    int i;
+    int j;
+    i = 1;
+    j = 2;
+    return (i + j);
+}
+
+int main() {
+    int j;
+    int i;
+    int k;
+    i = 10;
+    j = 20;
+    k = fred(0);
+    printint(i);
+    printint(j);
+    printint(k);
+    return (0);
+}
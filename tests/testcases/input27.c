@@ -0,0 +1,13 @@
+int main() {
+    int x;
+    long y;
+    x = 100000;
+    printint(x);
+    x = 0 - 100000;
+    printint(x);
+    y = 1103515245;
+    printint(y);
+    y = y * 65536;
+    printint(y);
+    return (0);
+}
@@ -0,0 +1,55 @@
+unsigned int u;
+unsigned long h;
+
+int main() {
+    int i;
+    int *q;
+    unsigned *p;
+    unsigned char buf[4];
+    unsigned char uc;
+    unsigned int ua;
+
+    u = 0 - 1;
+    printint(u);
+    printint(u / 2);
+    printint(u >> 28);
+
+    i = 0 - 16;
+    printint(i >> 2);
+    printint(i / 4);
+    q = &i;
+    printint(*q);
+
+    if (u > 5) {
+        printint(1);
+    } else {
+        printint(0);
+    }
+    if (i < u) {
+        printint(1);
+    } else {
+        printint(0);
+    }
+
+    h = 0 - 1;
+    printint(h >> 60);
+    h = u * 3;
+    printint(h);
+
+    u = 7;
+    printint((u - 8) / 2);
+    printint(u - 8 > u);
+    p = &u;
+    printint(*p + 1);
+
+    buf[0] = 255;
+    printint(buf[0] + 1);
+
+    uc = 5;
+    printint((uc - 10) / 5);
+    printint((uc - 10) >> 1);
+    printint(uc - 10 < 0);
+    ua = 4000000000;
+    printint(ua + ua);
+    return (0);
+}
@@ -0,0 +1,56 @@
+struct point {
+    int x;
+    int y;
+};
+
+struct rec {
+    char tag;
+    long value;
+    struct point pos;
+    struct rec *next;
+};
+
+struct point origin;
+struct point pts[4];
+struct rec r1;
+struct rec r2;
+
+int main() {
+    struct point p;
+    struct point *pp;
+    struct rec *rp;
+    int i;
+
+    p.x = 3;
+    p.y = 4;
+    printint(p.x + p.y);
+    pp = &p;
+    pp->y = 10;
+    printint(p.y);
+    origin.x = 0 - 7;
+    printint(origin.x);
+
+    for (i = 0; i < 4; i++) {
+        pts[i].x = i;
+        pts[i].y = i * i;
+    }
+    printint(pts[3].x + pts[3].y);
+    pp = &origin;
+    printint(pp->x * pts[2].y);
+
+    r1.tag = 'a';
+    r1.value = 100000;
+    r1.pos.x = 1;
+    r1.pos.y = 2;
+    r1.next = &r2;
+    r2.tag = 'b';
+    r2.value = 7;
+    r2.pos.y = 9;
+    rp = &r1;
+    printint(rp->next->value);
+    printint(rp->next->pos.y);
+    printint(rp->tag);
+    printint(rp->value);
+    printint(rp->pos.x + rp->pos.y);
+    return (0);
+}
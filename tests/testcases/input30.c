@@ -0,0 +1,45 @@
+struct node {
+    long value;
+    struct node *next;
+};
+
+int a;
+int *p;
+int **pp;
+int ***ppp;
+struct node n1;
+struct node n2;
+struct node *np;
+struct node **npp;
+char *s;
+char **strp;
+
+int main() {
+    a = 7;
+    p = &a;
+    pp = &p;
+    ppp = &pp;
+    printint(**pp);
+    printint(***ppp);
+
+    **pp = 42;
+    printint(a);
+    ***ppp = **pp + 1;
+    printint(*p);
+
+    n1.value = 1000;
+    n1.next = &n2;
+    n2.value = 2000;
+    np = &n1;
+    npp = &np;
+    printint(np->next->value);
+    *npp = n1.next;
+    printint(np->value);
+
+    s = "pointers";
+    strp = &s;
+    printstring(*strp);
+    printchar(**strp);
+    printchar(10);
+    return (0);
+}
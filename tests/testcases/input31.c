@@ -0,0 +1,101 @@
+struct counter {
+    char tag;
+    int hits;
+    long total;
+};
+
+int g;
+unsigned int ug;
+char c;
+int a[8];
+struct counter ctr;
+
+int main() {
+    int i;
+    int x;
+    int y;
+    long l;
+    int *p;
+    struct counter *cp;
+
+    x = 10;
+    x += 5;
+    x -= 3;
+    x *= 4;
+    x /= 6;
+    printint(x);
+
+    g = 1;
+    g <<= 10;
+    g |= 5;
+    g &= 1029;
+    g ^= 1;
+    g >>= 2;
+    printint(g);
+
+    y = 0 - 100;
+    y >>= 2;
+    printint(y);
+    y /= 5;
+    printint(y);
+
+    ug = 4000000000;
+    ug >>= 4;
+    printint(ug);
+    ug /= 3;
+    printint(ug);
+
+    c = 250;
+    c += 10;
+    printint(c);
+    c = 200;
+    c >>= 1;
+    printint(c);
+
+    for (i = 0; i < 8; i += 1) {
+        a[i] = i;
+    }
+    for (i = 0; i < 8; i += 1) {
+        a[i] *= a[i];
+        a[i] += 1000;
+        a[i] -= i;
+    }
+    printint(a[7]);
+    printint(a[3]);
+
+    i = 2;
+    y = 3;
+    a[i] <<= y;
+    printint(a[i]);
+
+    p = &g;
+    p += 2;
+    p -= 2;
+    *p += 7;
+    printint(g);
+
+    cp = &ctr;
+    cp->hits = 40;
+    cp->hits += 2;
+    cp->total = 100000;
+    cp->total *= 300;
+    cp->tag = 'a';
+    cp->tag += 1;
+    printint(ctr.hits);
+    printint(ctr.total);
+    printchar(ctr.tag);
+    printchar(10);
+
+    l = 5;
+    x = 1;
+    x += l;
+    printint(x);
+
+    y = 10;
+    x = (y += 5);
+    printint(x);
+    printint(y);
+    x = (a[1] += 1);
+    printint(x);
+    return (0);
+}
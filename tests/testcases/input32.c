@@ -0,0 +1,74 @@
+int main() {
+    int i;
+    int j;
+    int n;
+    int sum;
+
+    i = 0;
+    while (1) {
+        if (i == 5) {
+            break;
+        }
+        i = i + 1;
+    }
+    printint(i);
+
+    sum = 0;
+    for (i = 0; i < 10; i++) {
+        if (i & 1) {
+            continue;
+        }
+        sum += i;
+    }
+    printint(sum);
+    printint(i);
+
+    n = 0;
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 100; j++) {
+            if (j == i) {
+                break;
+            }
+            n += 1;
+        }
+        if (i == 2) {
+            continue;
+        }
+        n += 100;
+    }
+    printint(n);
+
+    i = 0;
+    sum = 0;
+    do {
+        sum += i;
+        i += 1;
+    } while (i < 5);
+    printint(sum);
+
+    i = 7;
+    do {
+        i += 1;
+    } while (i < 3);
+    printint(i);
+
+    i = 3;
+    do {
+        i -= 1;
+        if (i == 1) {
+            continue;
+        }
+        printint(i);
+    } while (i);
+
+    i = 0;
+    do {
+        i += 2;
+        if (i > 7) {
+            break;
+        }
+    } while (1);
+    printint(i);
+
+    return (0);
+}
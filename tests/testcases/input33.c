@@ -0,0 +1,69 @@
+int grid[5][3];
+long cube[2][3][4];
+char board[3][10];
+
+int main() {
+    int i;
+    int j;
+    int k;
+    int sum;
+    int m[4][4];
+    long total;
+
+    for (i = 0; i < 5; i++) {
+        for (j = 0; j < 3; j++) {
+            grid[i][j] = i * 10 + j;
+        }
+    }
+    printint(grid[0][0]);
+    printint(grid[2][1]);
+    printint(grid[4][2]);
+
+    sum = 0;
+    for (i = 4; i >= 0; i--) {
+        if (i == 3) {
+            continue;
+        }
+        sum += grid[i][2] * 3;
+    }
+    printint(sum);
+
+    for (i = 0; i < 2; i = i + 1) {
+        for (j = 0; j < 3; j += 1) {
+            for (k = 0; k < 4; ++k) {
+                cube[i][j][k] = i * 100 + j * 10 + k;
+            }
+        }
+    }
+    total = 0;
+    for (i = 0; i < 2; i++) {
+        for (j = 0; j < 3; j++) {
+            for (k = 0; k < 4; k++) {
+                total += cube[i][j][k];
+            }
+        }
+    }
+    printint(total);
+    printint(cube[1][2][3]);
+
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 4; j++) {
+            m[i][j] = i * 4 + j;
+        }
+    }
+    m[3][3] = 99;
+    printint(m[1][2] + m[2][1]);
+    printint(m[3][3]);
+
+    for (i = 0; i < 10; i += 3) {
+        board[1][i] = 65;
+    }
+    printint(board[1][0]);
+    printint(board[1][9]);
+    printint(board[1][8]);
+    board[2][0] = 7;
+    i = 2;
+    printint(board[i][0]);
+
+    return (0);
+}
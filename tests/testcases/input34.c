@@ -0,0 +1,46 @@
+struct pair {
+    char tag;
+    long value;
+};
+
+int table[4 * 8 - 2];
+long wide[sizeof(int)][2 + 1];
+int limit = 100 * 3 + 7;
+long mask = (1 << 20) - 1;
+char small = -3;
+int flags = (5 > 3) + (2 == 2) * 2;
+int *nowhere = 0;
+
+int main() {
+    int i;
+    int n = sizeof(table) / sizeof(int);
+    long total = 0;
+    int local[sizeof(struct pair) / 4];
+
+    printint(n);
+    printint(sizeof(wide));
+    printint(sizeof(char) + sizeof(int) + sizeof(long));
+    printint(sizeof(struct pair));
+    printint(sizeof(struct pair *));
+    printint(sizeof(local));
+    printint(sizeof(limit + 1));
+    printint(sizeof(total));
+    printint(limit);
+    printint(mask);
+    printint(small);
+    printint(flags);
+
+    for (i = 0; i < sizeof(table) / 4; i++) {
+        table[i] = i;
+    }
+    table[3 * 9 + 1] = 100;
+    for (i = 0; i < 30; i++) {
+        total += table[i];
+    }
+    printint(total);
+    printint(table[28]);
+
+    limit = limit - 7;
+    printint(limit);
+    return (0);
+}
@@ -0,0 +1,71 @@
+struct sample {
+    char channel;
+    short level;
+    unsigned short count;
+};
+
+short bias = -300;
+unsigned short peak = 65535;
+short history[6];
+
+short tripled() {
+    return (bias * 3);
+}
+
+int main() {
+    int i;
+    short s = 1000;
+    unsigned short u = 2;
+    short *p;
+    struct sample reading;
+    long sum = 0;
+    short t = -3;
+    unsigned short us = 5;
+
+    printint(sizeof(short));
+    printint(sizeof(unsigned short));
+    printint(sizeof(history));
+    printint(sizeof(struct sample));
+    printint(bias);
+    printint(peak);
+
+    s -= 1500;
+    printint(s);
+    printint(s++);
+    printint(--s);
+    printint(--s);
+    u -= 3;
+    printint(u);
+    printint(++peak);
+
+    for (i = 0; i < 6; i++) {
+        history[i] = bias;
+        history[i] += i * 100;
+    }
+    for (i = 0; i < 6; i++) {
+        sum += history[i];
+    }
+    printint(sum);
+    printint(history[5]);
+
+    p = &s;
+    *p = *p * 2;
+    printint(s);
+    printint(tripled(0));
+
+    reading.channel = 7;
+    reading.level = bias;
+    reading.count = 30000;
+    reading.count += 10000;
+    reading.level += 1;
+    printint(reading.channel);
+    printint(reading.level);
+    printint(reading.count);
+
+    printint(t < us);
+    printint((us - 10) / 5);
+    us = 65535;
+    printint(us);
+    printint(us + 1);
+    return (0);
+}
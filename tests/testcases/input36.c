@@ -0,0 +1,49 @@
+static int calls;
+static long total = 1000;
+static int unusedCounter;
+static char unusedTable[64];
+int visible;
+
+static int helper() {
+    unusedCounter = 5;
+    return (unusedTable[1]);
+}
+
+static int unusedCaller() {
+    return (helper(0));
+}
+
+static int tick() {
+    static int count;
+    count += 1;
+    calls += 1;
+    return (count);
+}
+
+int ticket() {
+    static int count = 100;
+    static char seen[4];
+    seen[count - 100] = 1;
+    count += 1;
+    return (count + seen[0] + seen[3]);
+}
+
+int main() {
+    int i;
+    static long memo = 7;
+
+    for (i = 0; i < 3; i++) {
+        printint(tick(0));
+    }
+    for (i = 0; i < 4; i++) {
+        printint(ticket(0));
+    }
+    total += calls;
+    printint(total);
+    printint(calls);
+    memo = memo * 2;
+    printint(memo);
+    visible = 1;
+    printint(visible);
+    return (0);
+}
@@ -0,0 +1,64 @@
+int in[8];
+int out[8];
+int scale;
+const int bias = 5;
+volatile int ticks;
+int source;
+int sink;
+int *restrict src;
+int *restrict dst;
+
+int fill() {
+    int i;
+    for (i = 0; i < 8; i++) {
+        in[i] = i;
+    }
+    return (0);
+}
+
+int main() {
+    const int limit = 8;
+    const int *view = &source;
+    int *const fixed = &sink;
+    int *p;
+    long sum;
+    int i;
+
+    fill(0);
+    scale = 3;
+    for (i = 0; i < limit; i++) {
+        out[i] = in[2] * scale + bias;
+    }
+    printint(out[0]);
+    printint(out[7]);
+
+    source = 7;
+    src = &source;
+    dst = &sink;
+    for (i = 0; i < 4; i++) {
+        *dst = *src * i;
+        ticks += 1;
+    }
+    printint(sink);
+    printint(ticks);
+
+    p = &scale;
+    sum = 0;
+    for (i = 0; i < 4; i++) {
+        sum += scale;
+        *p = *p + 1;
+    }
+    printint(sum);
+    printint(scale);
+
+    i = 0;
+    do {
+        sum += in[i] * bias;
+        i += 1;
+    } while (i < limit);
+    printint(sum);
+
+    *fixed = *view + sizeof(const int);
+    printint(sink);
+    return (0);
+}
@@ -0,0 +1,98 @@
+double total = 2.5;
+float ratio = 0.1f;
+double samples[4];
+float weights[4];
+double peak;
+double *cursor;
+int count;
+
+double average() {
+    double sum;
+    int i;
+    sum = 0.0;
+    for (i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    return (sum / count);
+}
+
+float shrink() {
+    return (ratio * 3);
+}
+
+double pair() {
+    return (0.25);
+}
+
+int main() {
+    double d;
+    float f;
+    long l;
+    int i;
+    unsigned long u;
+
+    printdouble(total);
+    printdouble(ratio);
+    printdouble(-1.25e2);
+    printdouble(.5 + 3 * 2.0);
+
+    d = 10.0;
+    f = d / 3;
+    printdouble(f);
+    printdouble(d / 3);
+
+    l = 7;
+    d = l / 2.0;
+    printdouble(d);
+    i = d * 3;
+    printint(i);
+    i = -d;
+    printint(i);
+    u = 1;
+    u = u << 63;
+    d = u;
+    printdouble(d / 4);
+    d = 3.5;
+
+    for (i = 0; i < 4; i++) {
+        samples[i] = i * 1.5;
+        weights[i] = samples[i] / 4;
+    }
+    count = 4;
+    printdouble(average(0));
+    printdouble(weights[3]);
+    printdouble(shrink(0));
+    printdouble(pair(d * 2.0, d));
+    printdouble(pair(pair(d, 0.5), d));
+
+    peak = samples[2];
+    cursor = &peak;
+    *cursor *= 2;
+    *cursor -= 0.5;
+    printdouble(peak);
+    printdouble(*cursor + 1);
+    total /= 4;
+    printdouble(total);
+
+    if (d > 3.0) {
+        printint(1);
+    }
+    if (d <= 3.5) {
+        printint(2);
+    }
+    if (d != 3.5) {
+        printint(0);
+    }
+    printint(d == 3.5);
+    printint(ratio < 0.1);
+    printint(!d);
+    d = 0.0;
+    while (d < 1.0) {
+        d += 0.25;
+    }
+    printdouble(d);
+    if (d) {
+        printint(3);
+    }
+    return (0);
+}
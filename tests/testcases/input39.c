@@ -0,0 +1,100 @@
+typedef int v4si __attribute__((vector_size(16)));
+typedef unsigned short v8hu __attribute__((vector_size(16)));
+typedef float v4sf __attribute__((vector_size(16)));
+typedef double v2df __attribute__((vector_size(16)));
+typedef long v2di __attribute__((vector_size(16)));
+typedef char v16qi __attribute__((vector_size(16)));
+
+v4si gv;
+v4si rows[4];
+
+void printv4si() {
+    printint(gv[0]);
+    printint(gv[1]);
+    printint(gv[2]);
+    printint(gv[3]);
+}
+
+int main() {
+    v4si a;
+    v4si b;
+    v8hu h;
+    v4sf f;
+    v2df d;
+    v2di l;
+    v16qi c;
+    int i;
+    int n;
+
+    for (i = 0; i < 4; i++) {
+        a[i] = i + 1;
+        b[i] = 10 * (i + 1);
+    }
+    gv = a + b;
+    printv4si(0);
+    gv = b - a;
+    printv4si(0);
+    gv = a * b;
+    printv4si(0);
+    gv = (a | 8) & 13;
+    printv4si(0);
+    gv = a ^ b;
+    printv4si(0);
+    n = 3;
+    gv = a << n;
+    printv4si(0);
+    gv = b >> 1;
+    printv4si(0);
+    gv = a + 100;
+    printv4si(0);
+    gv += a;
+    printv4si(0);
+    gv *= b;
+    printv4si(0);
+
+    for (i = 0; i < 4; i++) {
+        rows[i] = a * i;
+    }
+    for (i = 0; i < 4; i++) {
+        printint(rows[i][3]);
+    }
+    rows[2][1] = 77;
+    printint(rows[2][1]);
+
+    h = h ^ h;
+    h = h + 30000;
+    h[7] = 32000;
+    h >>= 4;
+    printint(h[0]);
+    printint(h[7]);
+    h = h * 3;
+    printint(h[1]);
+
+    for (i = 0; i < 4; i++) {
+        f[i] = i + 0.5;
+    }
+    f = f * 2 + f / 4;
+    printdouble(f[0]);
+    printdouble(f[3]);
+
+    d[0] = 1.5;
+    d[1] = -2.25;
+    d = d * d - 1;
+    printdouble(d[0]);
+    printdouble(d[1]);
+
+    l[0] = 1;
+    l[1] = -8;
+    l = l << 40;
+    l += l;
+    printint(l[0] >> 40);
+    printint(l[1] >> 40);
+
+    for (i = 0; i < 16; i++) {
+        c[i] = 2;
+    }
+    c = c + c + 1;
+    printint(c[15]);
+    printint(sizeof(v4si));
+    return (0);
+}
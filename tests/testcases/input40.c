@@ -0,0 +1,62 @@
+int counter;
+long total;
+unsigned int flags;
+
+int main() {
+    int old;
+    int expected;
+    long lexpected;
+    long big;
+    int *p;
+    int i;
+
+    counter = 5;
+    old = __atomic_fetch_add(&counter, 3, __ATOMIC_RELAXED);
+    printint(old);
+    printint(counter);
+    printint(__atomic_load_n(&counter, __ATOMIC_ACQUIRE));
+
+    __atomic_store_n(&counter, -7, __ATOMIC_SEQ_CST);
+    printint(__atomic_load_n(&counter, __ATOMIC_SEQ_CST));
+    old = __atomic_exchange_n(&counter, 42, __ATOMIC_ACQ_REL);
+    printint(old);
+    printint(counter);
+
+    p = &counter;
+    expected = 41;
+    printint(__atomic_compare_exchange_n(p, &expected, 100, 0,
+                                         __ATOMIC_SEQ_CST,
+                                         __ATOMIC_RELAXED));
+    printint(expected);
+    printint(counter);
+    if (__atomic_compare_exchange_n(p, &expected, 100, 1, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_ACQUIRE)) {
+        printint(counter);
+    }
+    printint(expected);
+
+    big = 1;
+    big = big << 40;
+    total = big;
+    printint(__atomic_fetch_add(&total, big, __ATOMIC_RELEASE) >> 40);
+    printint(total >> 40);
+    lexpected = big;
+    printint(__atomic_compare_exchange_n(&total, &lexpected, 7, 0,
+                                         __ATOMIC_RELAXED,
+                                         __ATOMIC_RELAXED));
+    printint(lexpected >> 40);
+    printint(__atomic_exchange_n(&total, 9, __ATOMIC_RELAXED) >> 40);
+    printint(total);
+
+    flags = 0;
+    for (i = 0; i < 10; i++) {
+        __atomic_fetch_add(&flags, i, __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    printint(__atomic_load_n(&flags, __ATOMIC_RELAXED));
+    old = __atomic_fetch_add(&counter, -1, __ATOMIC_SEQ_CST);
+    printint(old);
+    printint(counter);
+    return (0);
+}
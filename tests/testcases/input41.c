@@ -0,0 +1,35 @@
+long counter;
+long shared;
+
+long worker() {
+    int i;
+    for (i = 0; i < 100000; i++) {
+        __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED);
+    }
+    return (7);
+}
+
+long publisher() {
+    printint(99);
+    __atomic_store_n(&shared, 1234, __ATOMIC_RELEASE);
+    return (__atomic_load_n(&counter, __ATOMIC_ACQUIRE) + 1);
+}
+
+int main() {
+    long a;
+    long b;
+    long c;
+
+    a = thread_spawn(worker, 0);
+    b = thread_spawn(&worker, 1);
+    c = thread_spawn(worker, 2);
+    printint(thread_join(a));
+    printint(thread_join(b));
+    printint(thread_join(c));
+    printint(counter);
+
+    a = thread_spawn(publisher, 0);
+    printint(thread_join(a));
+    printint(shared);
+    return (0);
+}
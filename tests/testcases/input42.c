@@ -0,0 +1,41 @@
+long total;
+
+int main() {
+    long a;
+    long b;
+    int c;
+    int i;
+
+    asm("nop");
+    __asm__ __volatile__("nop\n\tnop" : : : "memory", "cc");
+
+    asm("mov %0, %1" : "=r"(a) : "i"(42));
+    printint(a);
+
+    b = 1000;
+    asm volatile("mov %0, %1"
+                 : "=r"(total)
+                 : "r"(b + 234));
+    printint(total);
+
+    c = 7;
+    asm("" : "+r"(c));
+    printint(c);
+
+    asm("mov %0, %2\n"
+        "mov %1, %3"
+        : "=r"(a), "=&r"(b)
+        : "r"(c), "i"(-5));
+    printint(a);
+    printint(b);
+
+    total = 0;
+    i = 0;
+    while (i < 5) {
+        asm("mov %0, %1" : "=r"(a) : "r"(total));
+        total = a + i;
+        i = i + 1;
+    }
+    printint(total);
+    return (0);
+}
@@ -0,0 +1,50 @@
+long errors;
+
+__attribute__((cold)) int fail() {
+    errors = errors + 1;
+    printint(-1);
+    return (0);
+}
+
+__attribute__((hot)) long work() {
+    long i;
+    long s;
+    s = 0;
+    i = 0;
+    while (i < 100) {
+        if (__builtin_expect(i == 1000, 0)) {
+            fail(0);
+        }
+        if (i > 200) {
+            fail(0);
+        } else {
+            s = s + i;
+        }
+        if (__builtin_expect(s, 1)) {
+            s = s + 1;
+        } else {
+            s = s - 1;
+        }
+        i = i + 1;
+    }
+    return (s);
+}
+
+int main() {
+    long x;
+    printint(work(0));
+    x = 5;
+    if (x == 5) {
+        printint(5);
+    } else {
+        __builtin_unreachable();
+    }
+    if (__builtin_expect(x != 5, 0)) {
+        printint(0);
+    } else {
+        printint(__builtin_expect(x, 5));
+    }
+    fail(0);
+    printint(errors);
+    return (0);
+}
@@ -0,0 +1,36 @@
+int a[512];
+long b[512];
+
+long sumStrided() {
+    int i;
+    long s;
+    int *p;
+    p = &a[0];
+    s = 0;
+    for (i = 0; i < 512; i = i + 2) {
+        __builtin_prefetch(p + 64);
+        __builtin_prefetch(p + 100000, 0, 0);
+        __builtin_prefetch(p - 3, 1);
+        __builtin_prefetch(p, 1, 1);
+        __builtin_prefetch(p + 8, 0, 2);
+        s = s + a[i];
+        p = p + 2;
+    }
+    return (s);
+}
+
+int main() {
+    int i;
+    long *q;
+    for (i = 0; i < 512; i++) {
+        a[i] = i;
+    }
+    printint(sumStrided(0));
+    q = &b[511];
+    for (i = 511; i >= 0; i--) {
+        __builtin_prefetch(q, 1, 3);
+        b[i] = a[i] * 3;
+    }
+    printint(b[0] + b[511]);
+    return (0);
+}
@@ -0,0 +1,77 @@
+int g[20][30];
+int h[20][30];
+int a[100];
+int b[100];
+int c[100];
+
+int columnSum() {
+    int i;
+    int j;
+    int sum;
+    sum = 0;
+    for (j = 0; j < 30; j++) {
+        for (i = 0; i < 20; i++) {
+            sum += g[i][j];
+            sum = sum - 1;
+        }
+    }
+    return (sum);
+}
+
+int skew() {
+    int i;
+    int j;
+    for (j = 0; j < 29; j++) {
+        for (i = 1; i < 20; i++) {
+            h[i][j] = h[i - 1][j + 1] + 1;
+        }
+    }
+    return (h[19][0]);
+}
+
+int main() {
+    int i;
+    int j;
+    int n;
+    for (i = 0; i < 20; i++) {
+        for (j = 0; j < 30; j++) {
+            g[i][j] = i * 30 + j;
+        }
+    }
+    for (j = 0; j < 30; j++) {
+        for (i = 0; i < 20; i++) {
+            h[i][j] = g[i][j] - j;
+        }
+    }
+    printint(columnSum(0));
+    printint(skew(0));
+
+    n = 100;
+    for (i = 0; i < n; i++) {
+        a[i] = i;
+    }
+    for (i = 0; i < n; i++) {
+        b[i] = a[i] * 2;
+    }
+    for (i = 0; i < n; i++) {
+        c[i] = b[i] + a[i];
+    }
+    printint(c[99]);
+
+    for (i = 0; i < 99; i++) {
+        a[i] = a[i + 1];
+    }
+    for (i = 0; i < 99; i++) {
+        a[i + 1] = a[i] + 1;
+    }
+    printint(a[98]);
+    for (i = 0; i < 50; i++) {
+        b[i] = 0;
+    }
+    for (i = 0; i < 99; i++) {
+        b[i] = b[i] + 1;
+    }
+    printint(b[0] + b[98]);
+    printint(i + j);
+    return (0);
+}
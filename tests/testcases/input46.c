@@ -0,0 +1,56 @@
+int verbose;
+const int size = 10;
+int limit = 50;
+int counter = 5;
+int escaped = 3;
+long big = 3000000000;
+char negative = -3;
+int shadow = 1;
+static int hidden = 4;
+int parenthesized = 1;
+int compound = 2;
+int a[64];
+
+int shadowed() {
+    int shadow;
+    shadow = 2;
+    return (shadow);
+}
+
+int sum() {
+    int i;
+    int s;
+    s = 0;
+    for (i = 0; i < limit; i++) {
+        s = s + a[i] * hidden;
+    }
+    return (s);
+}
+
+int main() {
+    int i;
+    int *p;
+    limit = 50;
+    for (i = 0; i < 64; i++) {
+        a[i] = i;
+    }
+    if (verbose) {
+        printint(0 - 1);
+    }
+    printint(size * limit);
+    printint(sum(0));
+    counter = 7;
+    printint(counter);
+    p = &escaped;
+    *p = 9;
+    printint(escaped);
+    printint(big - 2999999999);
+    printint(negative);
+    printint(shadowed(0));
+    printint(shadow);
+    (parenthesized) = 9;
+    printint(parenthesized);
+    (compound) += 3;
+    printint(compound);
+    return (0);
+}
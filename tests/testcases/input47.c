@@ -0,0 +1,35 @@
+int g;
+double h;
+
+int square() {
+    return (g * g);
+}
+
+int sumOfSquares() {
+    return (square(0) + square(0) * 2);
+}
+
+double half() {
+    return (h / 2.0);
+}
+
+int main() {
+    int i;
+    int s;
+    double d;
+
+    s = 0;
+    for (i = 0; i < 10; i++) {
+        g = i;
+        s = s + i * 3 + square(0);
+    }
+    printint(s);
+    g = 3;
+    printint(1 + (2 + sumOfSquares(0)));
+    printint(g * 100 + (square(0) * 10 + sumOfSquares(0)));
+    h = 5.0;
+    d = 1.5;
+    printdouble(d + half(0));
+    printdouble(d * 2.0 + (d + half(0) * 4.0));
+    return (0);
+}
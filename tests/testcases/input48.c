@@ -0,0 +1,40 @@
+typedef int v4si __attribute__((vector_size(16)));
+
+long worker() {
+    char pad;
+    v4si v;
+    int i;
+    for (i = 0; i < 4; i++) {
+        v[i] = 3 * i;
+    }
+    v = v + v;
+    return (v[3]);
+}
+
+int squares() {
+    char pad;
+    v4si v;
+    v4si w;
+    v[0] = 1;
+    v[1] = 2;
+    v[2] = 3;
+    v[3] = 4;
+    w = v * v;
+    return (w[0] + w[1] + w[2] + w[3]);
+}
+
+int main() {
+    v4si a;
+    v4si b;
+    long t;
+    a[0] = 5;
+    a[1] = 6;
+    a[2] = 7;
+    a[3] = 8;
+    b = a - 4;
+    printint(b[0] + b[1] + b[2] + b[3]);
+    printint(squares(0));
+    t = thread_spawn(worker, 0);
+    printint(thread_join(t));
+    return (0);
+}
@@ -0,0 +1,11 @@
+typedef int v4si __attribute__((vector_size(16)));
+
+int main() {
+    v4si a;
+    v4si b;
+    a[0] = 8;
+    b[0] = 2;
+    a = a / b;
+    printint(a[0]);
+    return (0);
+}
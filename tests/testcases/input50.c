@@ -0,0 +1,9 @@
+typedef char v16qi __attribute__((vector_size(16)));
+
+int main() {
+    v16qi c;
+    c[0] = 3;
+    c = c << 1;
+    printint(c[0]);
+    return (0);
+}